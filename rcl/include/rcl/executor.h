@@ -0,0 +1,398 @@
+// Copyright 2018 Open Source Robotics Foundation, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef RCL__EXECUTOR_H_
+#define RCL__EXECUTOR_H_
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+#include <stddef.h>
+
+#include "rcl/allocator.h"
+#include "rcl/client.h"
+#include "rcl/guard_condition.h"
+#include "rcl/macros.h"
+#include "rcl/service.h"
+#include "rcl/subscription.h"
+#include "rcl/timer.h"
+#include "rcl/types.h"
+#include "rcl/visibility_control.h"
+#include "rmw/types.h"
+
+/// Callback for a message taken from a subscription of the executor.
+/**
+ * The message is the storage given to rcl_executor_add_subscription(), which
+ * is reused for the next message, so it must not be kept after returning.
+ */
+typedef void (* rcl_executor_subscription_callback_t)(const void * message, void * context);
+
+/// Callback for a request taken by a service of the executor.
+/**
+ * The callback fills in the response, which the executor then sends back.
+ */
+typedef void (* rcl_executor_service_callback_t)(
+  const rmw_request_id_t * request_header, const void * request, void * response,
+  void * context);
+
+/// Callback for a response taken by a client of the executor.
+typedef void (* rcl_executor_client_callback_t)(
+  const rmw_request_id_t * request_header, const void * response, void * context);
+
+/// Callback for a triggered guard condition of the executor.
+typedef void (* rcl_executor_guard_condition_callback_t)(void * context);
+
+struct rcl_executor_impl_t;
+
+/// Single-threaded executor for a fixed set of rcl entities and C callbacks.
+/**
+ * The executor owns a persistent wait set, built once as entities are added,
+ * and a table which maps each slot of the wait set to its callback, context
+ * and message storage.
+ * Spinning only waits and then visits the ready entities reported by
+ * rcl_wait(), so it does not allocate memory itself once all entities are
+ * added, although taking a message may still allocate in the middleware.
+ */
+typedef struct rcl_executor_t
+{
+  struct rcl_executor_impl_t * impl;
+} rcl_executor_t;
+
+/// Return a rcl_executor_t struct with members set to `NULL`.
+RCL_PUBLIC
+RCL_WARN_UNUSED
+rcl_executor_t
+rcl_get_zero_initialized_executor(void);
+
+/// Initialize an executor with space for the given number of entities.
+/**
+ * The executor can hold at most the given number of entities of each type,
+ * and entities cannot be removed once added.
+ * The entities are not owned by the executor and must outlive it, or at least
+ * must not be used by it anymore once finalized.
+ *
+ * Expected usage:
+ *
+ * ```c
+ * #include <rcl/executor.h>
+ *
+ * rcl_executor_t executor = rcl_get_zero_initialized_executor();
+ * rcl_ret_t ret = rcl_executor_init(&executor, 1, 0, 1, 0, 0, rcl_get_default_allocator());
+ * // ... error handling
+ * ret = rcl_executor_add_subscription(&executor, &subscription, &msg, on_msg, &context);
+ * // ... error handling
+ * ret = rcl_executor_add_timer(&executor, &timer);
+ * // ... error handling
+ * while (rcl_ok()) {
+ *   ret = rcl_executor_spin_some(&executor, RCL_MS_TO_NS(100));
+ *   // ... error handling, RCL_RET_TIMEOUT just means nothing was ready
+ * }
+ * ret = rcl_executor_fini(&executor);
+ * // ... error handling
+ * ```
+ *
+ * <hr>
+ * Attribute          | Adherence
+ * ------------------ | -------------
+ * Allocates Memory   | Yes
+ * Thread-Safe        | No
+ * Uses Atomics       | No
+ * Lock-Free          | Yes
+ *
+ * \param[inout] executor the executor struct to be initialized
+ * \param[in] number_of_subscriptions maximum number of subscriptions
+ * \param[in] number_of_guard_conditions maximum number of guard conditions
+ * \param[in] number_of_timers maximum number of timers
+ * \param[in] number_of_clients maximum number of clients
+ * \param[in] number_of_services maximum number of services
+ * \param[in] allocator the allocator to use for the executor and its wait set
+ * \return `RCL_RET_OK` if the executor was initialized successfully, or
+ * \return `RCL_RET_ALREADY_INIT` if the executor is not zero initialized, or
+ * \return `RCL_RET_INVALID_ARGUMENT` if any arguments are invalid, or
+ * \return `RCL_RET_BAD_ALLOC` if allocating memory failed, or
+ * \return `RCL_RET_ERROR` if an unspecified error occurs.
+ */
+RCL_PUBLIC
+RCL_WARN_UNUSED
+rcl_ret_t
+rcl_executor_init(
+  rcl_executor_t * executor,
+  size_t number_of_subscriptions,
+  size_t number_of_guard_conditions,
+  size_t number_of_timers,
+  size_t number_of_clients,
+  size_t number_of_services,
+  rcl_allocator_t allocator);
+
+/// Finalize an executor.
+/**
+ * The entities of the executor are left untouched.
+ * Calling this function on a zero initialized executor does nothing.
+ *
+ * <hr>
+ * Attribute          | Adherence
+ * ------------------ | -------------
+ * Allocates Memory   | Yes
+ * Thread-Safe        | No
+ * Uses Atomics       | No
+ * Lock-Free          | Yes
+ *
+ * \param[inout] executor the executor struct to be finalized
+ * \return `RCL_RET_OK` if the finalization was successful, or
+ * \return `RCL_RET_INVALID_ARGUMENT` if any arguments are invalid, or
+ * \return `RCL_RET_ERROR` if an unspecified error occurs.
+ */
+RCL_PUBLIC
+RCL_WARN_UNUSED
+rcl_ret_t
+rcl_executor_fini(rcl_executor_t * executor);
+
+/// Add a subscription and the storage for the messages it takes.
+/**
+ * The message must be an initialized message of the type of the subscription,
+ * it is taken into every time the subscription is ready and then passed to the
+ * callback.
+ * The executor does not own the message, which must stay valid for as long as
+ * the executor is spun.
+ *
+ * <hr>
+ * Attribute          | Adherence
+ * ------------------ | -------------
+ * Allocates Memory   | No
+ * Thread-Safe        | No
+ * Uses Atomics       | No
+ * Lock-Free          | Yes
+ *
+ * \param[inout] executor the executor to add the subscription to
+ * \param[in] subscription the subscription to be added
+ * \param[in] message storage for the messages taken from the subscription
+ * \param[in] callback the function called with each message
+ * \param[in] context opaque pointer passed to the callback, may be `NULL`
+ * \return `RCL_RET_OK` if the subscription was added successfully, or
+ * \return `RCL_RET_INVALID_ARGUMENT` if any arguments are invalid, or
+ * \return `RCL_RET_EXECUTOR_INVALID` if the executor is zero initialized, or
+ * \return `RCL_RET_WAIT_SET_FULL` if the executor holds the maximum number of subscriptions, or
+ * \return `RCL_RET_ERROR` if an unspecified error occurs.
+ */
+RCL_PUBLIC
+RCL_WARN_UNUSED
+rcl_ret_t
+rcl_executor_add_subscription(
+  rcl_executor_t * executor,
+  const rcl_subscription_t * subscription,
+  void * message,
+  rcl_executor_subscription_callback_t callback,
+  void * context);
+
+/// Add a timer.
+/**
+ * The callback of a ready timer is called through rcl_timer_call().
+ *
+ * <hr>
+ * Attribute          | Adherence
+ * ------------------ | -------------
+ * Allocates Memory   | No
+ * Thread-Safe        | No
+ * Uses Atomics       | No
+ * Lock-Free          | Yes
+ *
+ * \param[inout] executor the executor to add the timer to
+ * \param[in] timer the timer to be added
+ * \return `RCL_RET_OK` if the timer was added successfully, or
+ * \return `RCL_RET_INVALID_ARGUMENT` if any arguments are invalid, or
+ * \return `RCL_RET_EXECUTOR_INVALID` if the executor is zero initialized, or
+ * \return `RCL_RET_WAIT_SET_FULL` if the executor holds the maximum number of timers, or
+ * \return `RCL_RET_ERROR` if an unspecified error occurs.
+ */
+RCL_PUBLIC
+RCL_WARN_UNUSED
+rcl_ret_t
+rcl_executor_add_timer(rcl_executor_t * executor, const rcl_timer_t * timer);
+
+/// Add a guard condition.
+/**
+ * The callback may be `NULL`, if the guard condition is only used to wake up
+ * the executor.
+ *
+ * <hr>
+ * Attribute          | Adherence
+ * ------------------ | -------------
+ * Allocates Memory   | No
+ * Thread-Safe        | No
+ * Uses Atomics       | No
+ * Lock-Free          | Yes
+ *
+ * \param[inout] executor the executor to add the guard condition to
+ * \param[in] guard_condition the guard condition to be added
+ * \param[in] callback the function called when the guard condition is triggered, or `NULL`
+ * \param[in] context opaque pointer passed to the callback, may be `NULL`
+ * \return `RCL_RET_OK` if the guard condition was added successfully, or
+ * \return `RCL_RET_INVALID_ARGUMENT` if any arguments are invalid, or
+ * \return `RCL_RET_EXECUTOR_INVALID` if the executor is zero initialized, or
+ * \return `RCL_RET_WAIT_SET_FULL` if the executor holds the maximum number of guard
+ *   conditions, or
+ * \return `RCL_RET_ERROR` if an unspecified error occurs.
+ */
+RCL_PUBLIC
+RCL_WARN_UNUSED
+rcl_ret_t
+rcl_executor_add_guard_condition(
+  rcl_executor_t * executor,
+  const rcl_guard_condition_t * guard_condition,
+  rcl_executor_guard_condition_callback_t callback,
+  void * context);
+
+/// Add a client and the storage for the responses it takes.
+/**
+ * Like the message of a subscription, the response must be an initialized
+ * message of the response type of the client, owned by the caller.
+ *
+ * <hr>
+ * Attribute          | Adherence
+ * ------------------ | -------------
+ * Allocates Memory   | No
+ * Thread-Safe        | No
+ * Uses Atomics       | No
+ * Lock-Free          | Yes
+ *
+ * \param[inout] executor the executor to add the client to
+ * \param[in] client the client to be added
+ * \param[in] response storage for the responses taken by the client
+ * \param[in] callback the function called with each response
+ * \param[in] context opaque pointer passed to the callback, may be `NULL`
+ * \return `RCL_RET_OK` if the client was added successfully, or
+ * \return `RCL_RET_INVALID_ARGUMENT` if any arguments are invalid, or
+ * \return `RCL_RET_EXECUTOR_INVALID` if the executor is zero initialized, or
+ * \return `RCL_RET_WAIT_SET_FULL` if the executor holds the maximum number of clients, or
+ * \return `RCL_RET_ERROR` if an unspecified error occurs.
+ */
+RCL_PUBLIC
+RCL_WARN_UNUSED
+rcl_ret_t
+rcl_executor_add_client(
+  rcl_executor_t * executor,
+  const rcl_client_t * client,
+  void * response,
+  rcl_executor_client_callback_t callback,
+  void * context);
+
+/// Add a service and the storage for its requests and responses.
+/**
+ * Each request taken by the service is passed to the callback together with
+ * the response storage, and the response is sent once the callback returns.
+ * Both messages are owned by the caller.
+ *
+ * <hr>
+ * Attribute          | Adherence
+ * ------------------ | -------------
+ * Allocates Memory   | No
+ * Thread-Safe        | No
+ * Uses Atomics       | No
+ * Lock-Free          | Yes
+ *
+ * \param[inout] executor the executor to add the service to
+ * \param[in] service the service to be added
+ * \param[in] request storage for the requests taken by the service
+ * \param[in] response storage for the responses sent by the service
+ * \param[in] callback the function called with each request
+ * \param[in] context opaque pointer passed to the callback, may be `NULL`
+ * \return `RCL_RET_OK` if the service was added successfully, or
+ * \return `RCL_RET_INVALID_ARGUMENT` if any arguments are invalid, or
+ * \return `RCL_RET_EXECUTOR_INVALID` if the executor is zero initialized, or
+ * \return `RCL_RET_WAIT_SET_FULL` if the executor holds the maximum number of services, or
+ * \return `RCL_RET_ERROR` if an unspecified error occurs.
+ */
+RCL_PUBLIC
+RCL_WARN_UNUSED
+rcl_ret_t
+rcl_executor_add_service(
+  rcl_executor_t * executor,
+  const rcl_service_t * service,
+  void * request,
+  void * response,
+  rcl_executor_service_callback_t callback,
+  void * context);
+
+/// Wait once for work and dispatch everything which is ready.
+/**
+ * Ready entities are dispatched in a deterministic order: first timers, then
+ * subscriptions, services, clients and guard conditions, and within each type
+ * in the order in which they were added.
+ * Each ready subscription, service and client is taken from once, so a burst
+ * of messages is spread over several calls.
+ * A take which finds nothing, e.g. because the message was taken elsewhere,
+ * is skipped silently, as is a timer canceled after the wait.
+ *
+ * The timeout has the same meaning as for rcl_wait().
+ * If dispatching fails, the error is returned right away and the remaining
+ * ready entities are left for the next call.
+ *
+ * <hr>
+ * Attribute          | Adherence
+ * ------------------ | -------------
+ * Allocates Memory   | No [1]
+ * Thread-Safe        | No
+ * Uses Atomics       | No
+ * Lock-Free          | Yes
+ * <i>[1] the middleware may allocate while taking messages</i>
+ *
+ * \param[inout] executor the executor to be spun
+ * \param[in] timeout the duration to wait for work, in nanoseconds
+ * \return `RCL_RET_OK` if something was dispatched, or
+ * \return `RCL_RET_TIMEOUT` if nothing became ready before the timeout, or
+ * \return `RCL_RET_INVALID_ARGUMENT` if any arguments are invalid, or
+ * \return `RCL_RET_EXECUTOR_INVALID` if the executor is zero initialized, or
+ * \return `RCL_RET_WAIT_SET_EMPTY` if no entity was added, or
+ * \return `RCL_RET_ERROR` if an unspecified error occurs.
+ */
+RCL_PUBLIC
+RCL_WARN_UNUSED
+rcl_ret_t
+rcl_executor_spin_some(rcl_executor_t * executor, int64_t timeout);
+
+/// Spin the executor until rcl is shut down.
+/**
+ * This calls rcl_executor_spin_some() with the given timeout for as long as
+ * rcl_ok() returns true, so the timeout bounds how long a shutdown may go
+ * unnoticed.
+ *
+ * <hr>
+ * Attribute          | Adherence
+ * ------------------ | -------------
+ * Allocates Memory   | No [1]
+ * Thread-Safe        | No
+ * Uses Atomics       | No
+ * Lock-Free          | Yes
+ * <i>[1] the middleware may allocate while taking messages</i>
+ *
+ * \param[inout] executor the executor to be spun
+ * \param[in] timeout the duration of each wait for work, in nanoseconds
+ * \return `RCL_RET_OK` if rcl was shut down, or
+ * \return `RCL_RET_INVALID_ARGUMENT` if any arguments are invalid, or
+ * \return `RCL_RET_EXECUTOR_INVALID` if the executor is zero initialized, or
+ * \return `RCL_RET_WAIT_SET_EMPTY` if no entity was added, or
+ * \return `RCL_RET_ERROR` if an unspecified error occurs.
+ */
+RCL_PUBLIC
+RCL_WARN_UNUSED
+rcl_ret_t
+rcl_executor_spin(rcl_executor_t * executor, int64_t timeout);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif  // RCL__EXECUTOR_H_
@@ -39,6 +39,20 @@ typedef struct rcl_guard_condition_options_t
 {
   /// Custom allocator for the guard condition, used for internal allocations.
   rcl_allocator_t allocator;
+  /// If true, the guard condition is only triggered from within this process.
+  /**
+   * Such a guard condition is backed by an atomic flag, and on Linux an
+   * eventfd, instead of a middleware guard condition.
+   * rcl_wait() checks the flag directly, so waiting on local guard conditions
+   * and timers only does not involve the middleware at all.
+   * A middleware guard condition is still created on demand the first time it
+   * is needed, i.e. when the guard condition is waited on together with
+   * middleware entities or when rcl_guard_condition_get_rmw_handle() is called.
+   *
+   * Triggering a local guard condition which is already triggered is a no-op,
+   * so repeated triggers before the next wait are coalesced into one.
+   */
+  bool local_only;
 } rcl_guard_condition_options_t;
 
 /// Return a rcl_guard_condition_t struct with members set to `NULL`.
@@ -96,6 +110,9 @@ rcl_guard_condition_init(
  * `rmw_guard_condition` parameter must not be `NULL` and must point to a valid
  * rmw guard condition.
  *
+ * The `local_only` option cannot be used together with an existing rmw guard
+ * condition.
+ *
  * Also the life time of the rcl guard condition is tied to the life time of
  * the rmw guard condition.
  * So if the rmw guard condition is destroyed before the rcl guard condition,
@@ -156,6 +173,7 @@ rcl_guard_condition_fini(rcl_guard_condition_t * guard_condition);
  * The defaults are:
  *
  * - allocator = rcl_get_default_allocator()
+ * - local_only = false
  */
 RCL_PUBLIC
 RCL_WARN_UNUSED
@@ -170,14 +188,20 @@ rcl_guard_condition_get_default_options(void);
  *
  * A guard condition can be triggered from any thread.
  *
+ * For a guard condition created with the `local_only` option this only sets
+ * an atomic flag, and signals its eventfd or middleware guard condition if
+ * the flag was not already set.
+ *
  * <hr>
  * Attribute          | Adherence
  * ------------------ | -------------
  * Allocates Memory   | Yes
  * Thread-Safe        | No [1]
- * Uses Atomics       | No
- * Lock-Free          | Yes
+ * Uses Atomics       | Yes [2]
+ * Lock-Free          | Yes [3]
  * <i>[1] it can be called concurrently with itself, even on the same guard condition</i>
+ * <i>[2] only for guard conditions created with the `local_only` option</i>
+ * <i>[3] if `atomic_is_lock_free()` returns true for `atomic_bool`</i>
  *
  * \param[in] guard_condition handle to the guard_condition to be triggered
  * \return `RCL_RET_OK` if the guard condition was triggered, or
@@ -229,13 +253,20 @@ rcl_guard_condition_get_options(const rcl_guard_condition_t * guard_condition);
  * this function each time it is needed and avoid use of the handle
  * concurrently with functions that might change it.
  *
+ * For a guard condition created with the `local_only` option, the rmw guard
+ * condition is created by the first call to this function.
+ * It is triggered by rcl_trigger_guard_condition() from then on, but waiting
+ * on it directly does not consume the trigger of the rcl guard condition.
+ *
  * <hr>
  * Attribute          | Adherence
  * ------------------ | -------------
- * Allocates Memory   | No
+ * Allocates Memory   | No [1]
  * Thread-Safe        | No
- * Uses Atomics       | No
+ * Uses Atomics       | Yes [2]
  * Lock-Free          | Yes
+ * <i>[1] except on the first call for a guard condition with the `local_only` option</i>
+ * <i>[2] only for guard conditions created with the `local_only` option</i>
  *
  * \param[in] guard_condition pointer to the rcl guard_condition
  * \return rmw guard condition handle if successful, otherwise `NULL`
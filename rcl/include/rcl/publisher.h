@@ -35,6 +35,32 @@ typedef struct rcl_publisher_t
   struct rcl_publisher_impl_t * impl;
 } rcl_publisher_t;
 
+/// Number of buckets of the publish interval histogram of a publisher.
+#define RCL_PUBLISHER_INTERVAL_HISTOGRAM_SIZE 32
+
+/// Statistics about the messages published by a publisher.
+/**
+ * The interval of a published message is the steady time elapsed since the
+ * previous one was published.
+ * The messages of a batch after the first one have an interval of zero.
+ *
+ * Bucket `0` of the histogram counts intervals of less than a microsecond.
+ * Bucket `i` counts intervals of at least `2^(i - 1)` and less than `2^i`
+ * microseconds, except for the last bucket which counts all the intervals
+ * beyond that.
+ */
+typedef struct rcl_publisher_statistics_t
+{
+  /// Number of messages published, serialized and loaned messages included.
+  uint64_t number_of_messages;
+  /// Number of bytes of the serialized messages published.
+  uint64_t serialized_bytes;
+  /// Number of messages which could not be published, e.g. when the middleware failed.
+  uint64_t number_of_failed_publishes;
+  /// Number of published messages by interval, see above for the bucket bounds.
+  uint64_t interval_histogram[RCL_PUBLISHER_INTERVAL_HISTOGRAM_SIZE];
+} rcl_publisher_statistics_t;
+
 /// Options available for a rcl publisher.
 typedef struct rcl_publisher_options_t
 {
@@ -43,6 +69,40 @@ typedef struct rcl_publisher_options_t
   /// Custom allocator for the publisher, used for incidental allocations.
   /** For default behavior (malloc/free), use: rcl_get_default_allocator() */
   rcl_allocator_t allocator;
+  /// Number of messages preallocated for rcl_borrow_loaned_message().
+  /** The messages are allocated with the publisher's allocator in rcl_publisher_init(),
+   * and are only used when the middleware cannot loan messages itself.
+   * Zero, the default, disables loaned messages in that case.
+   * Publishers with the `intra_process` option do not use it.
+   */
+  size_t loaned_message_pool_size;
+  /// If true, messages are passed by pointer to the subscriptions with the same option.
+  /** The publisher is linked to the subscriptions of the same process, created
+   * since the last rcl_init(), with the `intra_process` option on the same
+   * remapped topic name and with the same type support.
+   * Those subscriptions receive the published messages without serialization,
+   * and the middleware is only used to publish if it reports other subscribers.
+   * Loaned messages come from a pool shared by the topic, and are delivered to
+   * those subscriptions without any copy by rcl_publish_loaned_message().
+   *
+   * The message type needs an introspection type support.
+   * Serialized messages are deserialized once for those subscriptions, which
+   * ignore the copies of the messages of linked publishers they take from the
+   * middleware.
+   */
+  bool intra_process;
+  /// If true, the publisher counts its messages, see rcl_publisher_get_statistics().
+  /** The counters are lock-free, but each publish call then reads the steady clock. */
+  bool enable_statistics;
+  /// If true, the `header.stamp` of loaned messages is set when they are published.
+  /** The message type must have a `header` field with a `stamp` field, like
+   * std_msgs/Header has, which rcl_publish_loaned_message() sets to the
+   * current system time, so subscriptions can measure the latency of the
+   * messages, see rcl_subscription_options_t.measure_header_stamp.
+   * Messages given to rcl_publish() are not modified, so they keep the stamp
+   * set by the caller.
+   */
+  bool stamp_header;
 } rcl_publisher_options_t;
 
 /// Return a rcl_publisher_t struct with members set to `NULL`.
@@ -159,6 +219,9 @@ rcl_publisher_init(
  * After calling, calls to rcl_publish will fail when using this publisher.
  * However, the given node handle is still valid.
  *
+ * All the messages loaned by rcl_borrow_loaned_message() must be given back
+ * before, otherwise the publisher is not finalized and an error is returned.
+ *
  * <hr>
  * Attribute          | Adherence
  * ------------------ | -------------
@@ -185,6 +248,10 @@ rcl_publisher_fini(rcl_publisher_t * publisher, rcl_node_t * node);
  *
  * - qos = rmw_qos_profile_default
  * - allocator = rcl_get_default_allocator()
+ * - loaned_message_pool_size = 0
+ * - intra_process = false
+ * - enable_statistics = false
+ * - stamp_header = false
  */
 RCL_PUBLIC
 RCL_WARN_UNUSED
@@ -231,6 +298,11 @@ rcl_publisher_get_default_options(void);
  * rcl_publish() simultaneously, even if the publishers differ.
  * The `ros_message` is unmodified by rcl_publish().
  *
+ * On success rcl_publish() does not allocate, log, or touch the publisher
+ * options; it only checks the handles and calls the middleware.
+ * Debug logging of each published message can be compiled in with the
+ * `RCL_ENABLE_HOT_PATH_LOGGING` CMake option.
+ *
  * <hr>
  * Attribute          | Adherence
  * ------------------ | -------------
@@ -288,6 +360,187 @@ rcl_ret_t
 rcl_publish_serialized_message(
   const rcl_publisher_t * publisher, const rcl_serialized_message_t * serialized_message);
 
+/// Publish several ROS messages on a topic using a publisher.
+/**
+ * The publisher is checked once, then each message is published in order,
+ * with the same behavior and requirements as rcl_publish().
+ * The middleware has no batch publish function, so the messages are handed to
+ * it one at a time.
+ *
+ * Publishing stops at the first message that fails.
+ * The `published` parameter is set to the number of messages which were
+ * published before the failure, which is also the index of the failed message,
+ * and the error message is set for that failure.
+ * Calling this function again with `ros_messages + *published` resumes at the
+ * failed message.
+ * On success `published` is set to `count`.
+ *
+ * <hr>
+ * Attribute          | Adherence
+ * ------------------ | -------------
+ * Allocates Memory   | No
+ * Thread-Safe        | Yes [1]
+ * Uses Atomics       | No
+ * Lock-Free          | Yes
+ * <i>[1] for unique pairs of publishers and messages, see rcl_publish()</i>
+ *
+ * \param[in] publisher handle to the publisher which will do the publishing
+ * \param[in] ros_messages array of `count` type-erased pointers to ROS messages
+ * \param[in] count number of messages to publish
+ * \param[out] published number of messages published
+ * \return `RCL_RET_OK` if all the messages were published successfully, or
+ * \return `RCL_RET_INVALID_ARGUMENT` if any arguments are invalid, or
+ * \return `RCL_RET_PUBLISHER_INVALID` if the publisher is invalid, or
+ * \return `RCL_RET_BAD_ALLOC` if publishing a message failed to allocate memory, or
+ * \return `RCL_RET_ERROR` if an unspecified error occurs.
+ */
+RCL_PUBLIC
+RCL_WARN_UNUSED
+rcl_ret_t
+rcl_publish_batch(
+  const rcl_publisher_t * publisher,
+  const void * const * ros_messages,
+  size_t count,
+  size_t * published);
+
+/// Publish several serialized messages on a topic using a publisher.
+/**
+ * This is the serialized equivalent of rcl_publish_batch(), with the same
+ * behavior for the `published` parameter, and the same requirements for each
+ * message as rcl_publish_serialized_message().
+ *
+ * <hr>
+ * Attribute          | Adherence
+ * ------------------ | -------------
+ * Allocates Memory   | No
+ * Thread-Safe        | Yes [1]
+ * Uses Atomics       | No
+ * Lock-Free          | Yes
+ * <i>[1] for unique pairs of publishers and messages, see rcl_publish()</i>
+ *
+ * \param[in] publisher handle to the publisher which will do the publishing
+ * \param[in] serialized_messages array of `count` serialized messages
+ * \param[in] count number of messages to publish
+ * \param[out] published number of messages published
+ * \return `RCL_RET_OK` if all the messages were published successfully, or
+ * \return `RCL_RET_INVALID_ARGUMENT` if any arguments are invalid, or
+ * \return `RCL_RET_PUBLISHER_INVALID` if the publisher is invalid, or
+ * \return `RCL_RET_BAD_ALLOC` if publishing a message failed to allocate memory, or
+ * \return `RCL_RET_ERROR` if an unspecified error occurs.
+ */
+RCL_PUBLIC
+RCL_WARN_UNUSED
+rcl_ret_t
+rcl_publish_serialized_message_batch(
+  const rcl_publisher_t * publisher,
+  const rcl_serialized_message_t * serialized_messages,
+  size_t count,
+  size_t * published);
+
+/// Borrow a ROS message which can be filled and published without allocating.
+/**
+ * The loaned message is an initialized ROS message of the publisher's type,
+ * which is owned by the publisher until it is given back with either
+ * rcl_publish_loaned_message() or rcl_return_loaned_message_from_publisher().
+ *
+ * The middleware in use cannot loan messages, so they come from the pool of
+ * `loaned_message_pool_size` messages which rcl preallocates in
+ * rcl_publisher_init().
+ * The pool does not grow, so borrowing fails once all its messages are loaned.
+ * A message from the pool has the strings and sequences it had when it was
+ * last given back, so every field should be set before it is published, but
+ * memory of the strings and sequences is reused.
+ * The fields of a message which was never published are zero, except for
+ * strings which are empty.
+ *
+ * Loaned messages use the introspection type support of the message type,
+ * and the pool cannot be created for types without one.
+ *
+ * A publisher with the `intra_process` option borrows from the pool of the
+ * topic instead, which is shared with the linked publishers and subscriptions
+ * and grows when all its messages are loaned.
+ *
+ * <hr>
+ * Attribute          | Adherence
+ * ------------------ | -------------
+ * Allocates Memory   | Maybe [1]
+ * Thread-Safe        | Yes
+ * Uses Atomics       | Yes
+ * Lock-Free          | No [2]
+ * <i>[1] only with the `intra_process` option, if no message of the topic is free</i>
+ * <i>[2] borrowing and giving back messages briefly locks the pool</i>
+ *
+ * \param[in] publisher handle to the publisher which loans the message
+ * \param[out] ros_message type-erased pointer to the loaned ROS message
+ * \return `RCL_RET_OK` if a message was loaned, or
+ * \return `RCL_RET_INVALID_ARGUMENT` if any arguments are invalid, or
+ * \return `RCL_RET_PUBLISHER_INVALID` if the publisher is invalid, or
+ * \return `RCL_RET_PUBLISHER_LOAN_FAILED` if no message is available, or
+ * \return `RCL_RET_ERROR` if an unspecified error occurs.
+ */
+RCL_PUBLIC
+RCL_WARN_UNUSED
+rcl_ret_t
+rcl_borrow_loaned_message(const rcl_publisher_t * publisher, void ** ros_message);
+
+/// Give a loaned message back to the publisher without publishing it.
+/**
+ * <hr>
+ * Attribute          | Adherence
+ * ------------------ | -------------
+ * Allocates Memory   | No
+ * Thread-Safe        | Yes
+ * Uses Atomics       | Yes
+ * Lock-Free          | No [1]
+ * <i>[1] see rcl_borrow_loaned_message()</i>
+ *
+ * \param[in] publisher handle to the publisher which loaned the message
+ * \param[in] loaned_message message loaned by rcl_borrow_loaned_message()
+ * \return `RCL_RET_OK` if the message was given back, or
+ * \return `RCL_RET_INVALID_ARGUMENT` if any arguments are invalid, including
+ *         a message which is not currently loaned by this publisher, or
+ * \return `RCL_RET_PUBLISHER_INVALID` if the publisher is invalid, or
+ * \return `RCL_RET_ERROR` if an unspecified error occurs.
+ */
+RCL_PUBLIC
+RCL_WARN_UNUSED
+rcl_ret_t
+rcl_return_loaned_message_from_publisher(
+  const rcl_publisher_t * publisher, void * loaned_message);
+
+/// Publish a loaned message and give it back to the publisher.
+/**
+ * This behaves like rcl_publish(), except that the message must be loaned by
+ * rcl_borrow_loaned_message() from the same publisher, and that the message
+ * belongs to the publisher again after the call, even if publishing fails.
+ *
+ * With the `intra_process` option, the message itself is queued for each
+ * linked subscription, and only goes back to the pool once all of them
+ * gave it back, so it must not be used anymore after the call.
+ *
+ * <hr>
+ * Attribute          | Adherence
+ * ------------------ | -------------
+ * Allocates Memory   | No
+ * Thread-Safe        | Yes [1]
+ * Uses Atomics       | Yes
+ * Lock-Free          | No [2]
+ * <i>[1] for unique pairs of publishers and messages, see rcl_publish()</i>
+ * <i>[2] see rcl_borrow_loaned_message(), linked subscriptions are also briefly locked</i>
+ *
+ * \param[in] publisher handle to the publisher which loaned the message
+ * \param[in] ros_message message loaned by rcl_borrow_loaned_message()
+ * \return `RCL_RET_OK` if the message was published successfully, or
+ * \return `RCL_RET_INVALID_ARGUMENT` if any arguments are invalid, including
+ *         a message which is not currently loaned by this publisher, or
+ * \return `RCL_RET_PUBLISHER_INVALID` if the publisher is invalid, or
+ * \return `RCL_RET_ERROR` if an unspecified error occurs.
+ */
+RCL_PUBLIC
+RCL_WARN_UNUSED
+rcl_ret_t
+rcl_publish_loaned_message(const rcl_publisher_t * publisher, void * ros_message);
+
 /// Get the topic name for the publisher.
 /**
  * This function returns the publisher's internal topic name string.
@@ -373,6 +626,60 @@ RCL_WARN_UNUSED
 rmw_publisher_t *
 rcl_publisher_get_rmw_handle(const rcl_publisher_t * publisher);
 
+/// Retrieve the traffic statistics of a publisher.
+/**
+ * The publisher must have been created with the `enable_statistics` option.
+ * The statistics are updated with lock-free counters by each successful
+ * publish call, and this function only reads them, so it is cheap enough to
+ * be polled periodically.
+ * The fields are read one by one, so a snapshot taken while messages are
+ * being published may mix the state from before and after a publish call.
+ *
+ * <hr>
+ * Attribute          | Adherence
+ * ------------------ | -------------
+ * Allocates Memory   | No
+ * Thread-Safe        | Yes
+ * Uses Atomics       | Yes
+ * Lock-Free          | Yes [1]
+ * <i>[1] if `atomic_is_lock_free()` returns true for `atomic_uint_least64_t`</i>
+ *
+ * \param[in] publisher the publisher which is being queried
+ * \param[out] statistics the statistics of the publisher
+ * \return `RCL_RET_OK` if the statistics were retrieved successfully, or
+ * \return `RCL_RET_INVALID_ARGUMENT` if any arguments are invalid, or
+ * \return `RCL_RET_PUBLISHER_INVALID` if the publisher is invalid, or
+ * \return `RCL_RET_ERROR` if the publisher does not keep statistics.
+ */
+RCL_PUBLIC
+RCL_WARN_UNUSED
+rcl_ret_t
+rcl_publisher_get_statistics(
+  const rcl_publisher_t * publisher, rcl_publisher_statistics_t * statistics);
+
+/// Reset the traffic statistics of a publisher to zero.
+/**
+ * Publish calls which happen concurrently may be counted or lost.
+ *
+ * <hr>
+ * Attribute          | Adherence
+ * ------------------ | -------------
+ * Allocates Memory   | No
+ * Thread-Safe        | Yes
+ * Uses Atomics       | Yes
+ * Lock-Free          | Yes [1]
+ * <i>[1] if `atomic_is_lock_free()` returns true for `atomic_uint_least64_t`</i>
+ *
+ * \param[in] publisher the publisher whose statistics are reset
+ * \return `RCL_RET_OK` if the statistics were reset successfully, or
+ * \return `RCL_RET_PUBLISHER_INVALID` if the publisher is invalid, or
+ * \return `RCL_RET_ERROR` if the publisher does not keep statistics.
+ */
+RCL_PUBLIC
+RCL_WARN_UNUSED
+rcl_ret_t
+rcl_publisher_reset_statistics(const rcl_publisher_t * publisher);
+
 /// Check that the publisher is valid
 /**
  * The bool returned is `false` if `publisher` is invalid.
@@ -35,6 +35,52 @@ typedef struct rcl_subscription_t
   struct rcl_subscription_impl_t * impl;
 } rcl_subscription_t;
 
+/// Number of buckets of the take interval histogram of a subscription.
+#define RCL_SUBSCRIPTION_INTERVAL_HISTOGRAM_SIZE 32
+
+/// Statistics about the messages taken from a subscription.
+/**
+ * The interval of a taken message is the steady time elapsed since the
+ * previous one was taken.
+ * The messages of a batch after the first one have an interval of zero.
+ *
+ * Bucket `0` of the histogram counts intervals of less than a microsecond.
+ * Bucket `i` counts intervals of at least `2^(i - 1)` and less than `2^i`
+ * microseconds, except for the last bucket which counts all the intervals
+ * beyond that.
+ */
+typedef struct rcl_subscription_statistics_t
+{
+  /// Number of messages taken, serialized and loaned messages included.
+  uint64_t number_of_messages;
+  /// Number of bytes of the serialized messages taken.
+  uint64_t serialized_bytes;
+  /// Number of take calls which returned `RCL_RET_SUBSCRIPTION_TAKE_FAILED`.
+  uint64_t number_of_failed_takes;
+  /// Number of intra-process messages dropped from the full queue before being taken.
+  /** See rcl_subscription_options_t.intra_process, messages dropped by the
+   * middleware are not counted.
+   */
+  uint64_t number_of_dropped_messages;
+  /// Number of taken messages by interval, see above for the bucket bounds.
+  uint64_t interval_histogram[RCL_SUBSCRIPTION_INTERVAL_HISTOGRAM_SIZE];
+} rcl_subscription_statistics_t;
+
+/// Summary of the latencies measured by a subscription, in nanoseconds.
+typedef struct rcl_subscription_latency_statistics_t
+{
+  /// Number of messages whose latency was measured.
+  uint64_t number_of_samples;
+  /// Number of messages taken without a timestamp to measure their latency from.
+  uint64_t number_of_unstamped_messages;
+  /// Smallest latency, or zero without samples.
+  int64_t min_latency;
+  /// Largest latency, or zero without samples.
+  int64_t max_latency;
+  /// Mean latency, or zero without samples.
+  int64_t mean_latency;
+} rcl_subscription_latency_statistics_t;
+
 /// Options available for a rcl subscription.
 typedef struct rcl_subscription_options_t
 {
@@ -45,6 +91,50 @@ typedef struct rcl_subscription_options_t
   /// Custom allocator for the subscription, used for incidental allocations.
   /** For default behavior (malloc/free), see: rcl_get_default_allocator() */
   rcl_allocator_t allocator;
+  /// Number of messages preallocated for rcl_take_loaned_message().
+  /** If not zero, the messages are allocated with the subscription's allocator in
+   * rcl_subscription_init(), and no more are ever allocated, so that taking loaned
+   * messages does not use the allocator.
+   * Zero, the default, lets the messages be allocated when they are first needed.
+   */
+  size_t message_pool_size;
+  /// If true, messages are received by pointer from the publishers with the same option.
+  /** See rcl_publisher_options_t.intra_process for how they are linked.
+   * The messages of those publishers are queued by rcl, as many as the history
+   * depth of the qos rounded up to a power of two, after which the oldest
+   * queued message is dropped, and make the subscription ready in rcl_wait().
+   * Their copies received through the middleware are dropped.
+   *
+   * rcl_take_loaned_message() returns the queued messages without copying
+   * them, shared with the other linked subscriptions.
+   * Serialized takes only return the messages of other publishers.
+   */
+  bool intra_process;
+  /// If true, the subscription counts its messages, see rcl_subscription_get_statistics().
+  /** The counters are lock-free, but each successful take then reads the steady clock. */
+  bool enable_statistics;
+  /// If true, the subscription measures the latency of the messages it takes.
+  /** The latency is the time from publishing to taking a message.
+   * Messages published with the `intra_process` option carry the steady time
+   * they were published at.
+   * Other messages are only measured with the `measure_header_stamp` option,
+   * and are otherwise counted as unstamped.
+   * Serialized messages are not measured.
+   *
+   * The latencies are recorded into a histogram allocated with the
+   * subscription's allocator, see rcl_subscription_get_latency_statistics().
+   */
+  bool measure_latency;
+  /// If true, the latency of messages from the middleware is measured from their header stamp.
+  /** The message type must have a `header` field with a `stamp` field, like
+   * std_msgs/Header has, which the publishers set to the system time they
+   * publish at, e.g. with the `stamp_header` option of rcl_publisher_options_t.
+   * Messages whose stamp is zero are counted as unstamped.
+   * Stamps set for other purposes, e.g. to the time a sensor sampled the data,
+   * or from another clock, give meaningless latencies.
+   * It has no effect without the `measure_latency` option.
+   */
+  bool measure_header_stamp;
 } rcl_subscription_options_t;
 
 /// Return a rcl_subscription_t struct with members set to `NULL`.
@@ -192,6 +282,11 @@ rcl_subscription_fini(rcl_subscription_t * subscription, rcl_node_t * node);
  * - ignore_local_publications = false
  * - qos = rmw_qos_profile_default
  * - allocator = rcl_get_default_allocator()
+ * - message_pool_size = 0
+ * - intra_process = false
+ * - enable_statistics = false
+ * - measure_latency = false
+ * - measure_header_stamp = false
  */
 RCL_PUBLIC
 RCL_WARN_UNUSED
@@ -299,6 +394,179 @@ rcl_take_serialized_message(
   rcl_serialized_message_t * serialized_message,
   rmw_message_info_t * message_info);
 
+/// Take a ROS message from a topic into a message loaned by the subscription.
+/**
+ * This behaves like rcl_take(), except that the message is stored in a
+ * message which the subscription loans to the caller, until it is given back
+ * with rcl_return_loaned_message_from_subscription().
+ *
+ * The middleware in use cannot loan messages, so they come from a pool which
+ * rcl keeps for the subscription.
+ * If the `message_pool_size` option is not zero, the pool is preallocated with
+ * that many messages in rcl_subscription_init() and has a fixed size, so that
+ * this function fails with `RCL_RET_SUBSCRIPTION_LOAN_FAILED` while all of
+ * them are loaned, before anything is taken.
+ * Otherwise the pool is created on the first call and grows, using the
+ * subscription's allocator, when all its messages are loaned.
+ * A message given back is reused as is by the next take, so once the pool holds
+ * as many messages as are loaned at the same time, and their strings and
+ * sequences are large enough, taking does not allocate.
+ *
+ * Loaned messages use the introspection type support of the message type,
+ * and the pool cannot be created for types without one.
+ *
+ * With the `intra_process` option, the messages queued by the linked
+ * publishers are taken first, without any copy.
+ * Such a message is shared with the other linked subscriptions, so it must
+ * not be modified, and its `message_info` has `from_intra_process` set.
+ *
+ * <hr>
+ * Attribute          | Adherence
+ * ------------------ | -------------
+ * Allocates Memory   | Maybe [1]
+ * Thread-Safe        | No
+ * Uses Atomics       | Yes
+ * Lock-Free          | No [2]
+ * <i>[1] only if no loaned message is free and the pool can grow, or as rcl_take() does</i>
+ * <i>[2] loaning and giving back messages briefly locks the pool</i>
+ *
+ * \param[in] subscription the handle to the subscription from which to take
+ * \param[out] loaned_message type-erased pointer to the loaned ROS message
+ * \param[out] message_info rmw struct which contains meta-data for the message
+ * \return `RCL_RET_OK` if a message was taken, or
+ * \return `RCL_RET_INVALID_ARGUMENT` if any arguments are invalid, or
+ * \return `RCL_RET_SUBSCRIPTION_INVALID` if the subscription is invalid, or
+ * \return `RCL_RET_BAD_ALLOC` if allocating memory failed, or
+ * \return `RCL_RET_SUBSCRIPTION_LOAN_FAILED` if the pool has a fixed size and
+ *         all its messages are loaned, or
+ * \return `RCL_RET_SUBSCRIPTION_TAKE_FAILED` if take failed but no error
+ *         occurred in the middleware, or
+ * \return `RCL_RET_ERROR` if an unspecified error occurs.
+ */
+RCL_PUBLIC
+RCL_WARN_UNUSED
+rcl_ret_t
+rcl_take_loaned_message(
+  const rcl_subscription_t * subscription,
+  void ** loaned_message,
+  rmw_message_info_t * message_info);
+
+/// Give a message loaned by rcl_take_loaned_message() back to the subscription.
+/**
+ * All the loaned messages must be given back before the subscription is
+ * finalized.
+ *
+ * <hr>
+ * Attribute          | Adherence
+ * ------------------ | -------------
+ * Allocates Memory   | No
+ * Thread-Safe        | Yes
+ * Uses Atomics       | Yes
+ * Lock-Free          | No [1]
+ * <i>[1] see rcl_take_loaned_message()</i>
+ *
+ * \param[in] subscription the handle to the subscription which loaned the message
+ * \param[in] loaned_message message loaned by rcl_take_loaned_message()
+ * \return `RCL_RET_OK` if the message was given back, or
+ * \return `RCL_RET_INVALID_ARGUMENT` if any arguments are invalid, including
+ *         a message which is not currently loaned by this subscription, or
+ * \return `RCL_RET_SUBSCRIPTION_INVALID` if the subscription is invalid, or
+ * \return `RCL_RET_ERROR` if an unspecified error occurs.
+ */
+RCL_PUBLIC
+RCL_WARN_UNUSED
+rcl_ret_t
+rcl_return_loaned_message_from_subscription(
+  const rcl_subscription_t * subscription,
+  void * loaned_message);
+
+/// Take up to `capacity` ROS messages from a topic using a rcl subscription.
+/**
+ * The subscription is checked once, then messages are taken in order, with
+ * the same behavior and requirements as rcl_take(), until either no message
+ * is available or `capacity` messages were taken.
+ * The middleware has no batch take function, so the messages are taken from it
+ * one at a time, but a subscription with many queued messages can be drained
+ * with a single call after each wait.
+ *
+ * Each of the `capacity` pointers in `ros_messages` should point to an already
+ * allocated ROS message struct of the correct type.
+ * The first `taken` of them are filled, the others are unmodified.
+ * If `message_infos` is not `NULL`, it should point to an array of `capacity`
+ * message info structs, and the first `taken` of them are filled.
+ *
+ * If the middleware fails after some messages were taken, the error is
+ * returned, `taken` is set to the number of messages taken before the failure,
+ * and those messages are valid.
+ *
+ * <hr>
+ * Attribute          | Adherence
+ * ------------------ | -------------
+ * Allocates Memory   | Maybe [1]
+ * Thread-Safe        | No
+ * Uses Atomics       | No
+ * Lock-Free          | Yes
+ * <i>[1] only if required when filling the messages, avoided for fixed sizes</i>
+ *
+ * \param[in] subscription the handle to the subscription from which to take
+ * \param[inout] ros_messages array of `capacity` type-erased ptrs to allocated ROS messages
+ * \param[out] message_infos array of `capacity` rmw message infos, or `NULL`
+ * \param[in] capacity maximum number of messages to take
+ * \param[out] taken number of messages taken
+ * \return `RCL_RET_OK` if at least one message was taken, or
+ * \return `RCL_RET_INVALID_ARGUMENT` if any arguments are invalid, or
+ * \return `RCL_RET_SUBSCRIPTION_INVALID` if the subscription is invalid, or
+ * \return `RCL_RET_BAD_ALLOC` if allocating memory failed, or
+ * \return `RCL_RET_SUBSCRIPTION_TAKE_FAILED` if no message was available, or
+ * \return `RCL_RET_ERROR` if an unspecified error occurs.
+ */
+RCL_PUBLIC
+RCL_WARN_UNUSED
+rcl_ret_t
+rcl_take_batch(
+  const rcl_subscription_t * subscription,
+  void * const * ros_messages,
+  rmw_message_info_t * message_infos,
+  size_t capacity,
+  size_t * taken);
+
+/// Take up to `capacity` serialized messages from a topic using a rcl subscription.
+/**
+ * This is the serialized equivalent of rcl_take_batch(), with the same
+ * behavior for the `taken` parameter, and the same requirements for each
+ * message as rcl_take_serialized_message().
+ *
+ * <hr>
+ * Attribute          | Adherence
+ * ------------------ | -------------
+ * Allocates Memory   | Maybe [1]
+ * Thread-Safe        | No
+ * Uses Atomics       | No
+ * Lock-Free          | Yes
+ * <i>[1] only if storage in the serialized messages is insufficient</i>
+ *
+ * \param[in] subscription the handle to the subscription from which to take
+ * \param[inout] serialized_messages array of `capacity` (pre-allocated) serialized messages
+ * \param[out] message_infos array of `capacity` rmw message infos, or `NULL`
+ * \param[in] capacity maximum number of messages to take
+ * \param[out] taken number of messages taken
+ * \return `RCL_RET_OK` if at least one message was taken, or
+ * \return `RCL_RET_INVALID_ARGUMENT` if any arguments are invalid, or
+ * \return `RCL_RET_SUBSCRIPTION_INVALID` if the subscription is invalid, or
+ * \return `RCL_RET_BAD_ALLOC` if allocating memory failed, or
+ * \return `RCL_RET_SUBSCRIPTION_TAKE_FAILED` if no message was available, or
+ * \return `RCL_RET_ERROR` if an unspecified error occurs.
+ */
+RCL_PUBLIC
+RCL_WARN_UNUSED
+rcl_ret_t
+rcl_take_serialized_message_batch(
+  const rcl_subscription_t * subscription,
+  rcl_serialized_message_t * serialized_messages,
+  rmw_message_info_t * message_infos,
+  size_t capacity,
+  size_t * taken);
+
 /// Get the topic name for the subscription.
 /**
  * This function returns the subscription's internal topic name string.
@@ -384,6 +652,144 @@ RCL_WARN_UNUSED
 rmw_subscription_t *
 rcl_subscription_get_rmw_handle(const rcl_subscription_t * subscription);
 
+/// Retrieve the traffic statistics of a subscription.
+/**
+ * The subscription must have been created with the `enable_statistics` option.
+ * The statistics are updated with lock-free counters by each take call, and
+ * this function only reads them, so it is cheap enough to be polled
+ * periodically.
+ * The fields are read one by one, so a snapshot taken while messages are
+ * being taken may mix the state from before and after a take call.
+ *
+ * <hr>
+ * Attribute          | Adherence
+ * ------------------ | -------------
+ * Allocates Memory   | No
+ * Thread-Safe        | Yes
+ * Uses Atomics       | Yes
+ * Lock-Free          | Yes [1]
+ * <i>[1] if `atomic_is_lock_free()` returns true for `atomic_uint_least64_t`</i>
+ *
+ * \param[in] subscription the subscription which is being queried
+ * \param[out] statistics the statistics of the subscription
+ * \return `RCL_RET_OK` if the statistics were retrieved successfully, or
+ * \return `RCL_RET_INVALID_ARGUMENT` if any arguments are invalid, or
+ * \return `RCL_RET_SUBSCRIPTION_INVALID` if the subscription is invalid, or
+ * \return `RCL_RET_ERROR` if the subscription does not keep statistics.
+ */
+RCL_PUBLIC
+RCL_WARN_UNUSED
+rcl_ret_t
+rcl_subscription_get_statistics(
+  const rcl_subscription_t * subscription, rcl_subscription_statistics_t * statistics);
+
+/// Reset the traffic statistics of a subscription to zero.
+/**
+ * Take calls which happen concurrently may be counted or lost.
+ *
+ * <hr>
+ * Attribute          | Adherence
+ * ------------------ | -------------
+ * Allocates Memory   | No
+ * Thread-Safe        | Yes
+ * Uses Atomics       | Yes
+ * Lock-Free          | Yes [1]
+ * <i>[1] if `atomic_is_lock_free()` returns true for `atomic_uint_least64_t`</i>
+ *
+ * \param[in] subscription the subscription whose statistics are reset
+ * \return `RCL_RET_OK` if the statistics were reset successfully, or
+ * \return `RCL_RET_SUBSCRIPTION_INVALID` if the subscription is invalid, or
+ * \return `RCL_RET_ERROR` if the subscription does not keep statistics.
+ */
+RCL_PUBLIC
+RCL_WARN_UNUSED
+rcl_ret_t
+rcl_subscription_reset_statistics(const rcl_subscription_t * subscription);
+
+/// Retrieve a summary of the message latencies measured by a subscription.
+/**
+ * The subscription must have been created with the `measure_latency` option.
+ * The latencies are recorded with lock-free counters by each take call, and
+ * the fields are read one by one, so a summary taken while messages are
+ * being taken may mix the state from before and after a take call.
+ *
+ * <hr>
+ * Attribute          | Adherence
+ * ------------------ | -------------
+ * Allocates Memory   | No
+ * Thread-Safe        | Yes
+ * Uses Atomics       | Yes
+ * Lock-Free          | Yes [1]
+ * <i>[1] if `atomic_is_lock_free()` returns true for `atomic_uint_least64_t`</i>
+ *
+ * \param[in] subscription the subscription which is being queried
+ * \param[out] statistics the summary of the latencies
+ * \return `RCL_RET_OK` if the summary was retrieved successfully, or
+ * \return `RCL_RET_INVALID_ARGUMENT` if any arguments are invalid, or
+ * \return `RCL_RET_SUBSCRIPTION_INVALID` if the subscription is invalid, or
+ * \return `RCL_RET_ERROR` if the subscription does not measure latencies.
+ */
+RCL_PUBLIC
+RCL_WARN_UNUSED
+rcl_ret_t
+rcl_subscription_get_latency_statistics(
+  const rcl_subscription_t * subscription,
+  rcl_subscription_latency_statistics_t * statistics);
+
+/// Retrieve a percentile of the message latencies measured by a subscription.
+/**
+ * The subscription must have been created with the `measure_latency` option.
+ * The latencies are kept in a histogram whose buckets are about 6% wide, so
+ * the returned latency is the upper bound of the bucket of the percentile,
+ * and is at most 6% above the measured one.
+ * It is zero if no latency was measured.
+ *
+ * <hr>
+ * Attribute          | Adherence
+ * ------------------ | -------------
+ * Allocates Memory   | No
+ * Thread-Safe        | Yes
+ * Uses Atomics       | Yes
+ * Lock-Free          | Yes [1]
+ * <i>[1] if `atomic_is_lock_free()` returns true for `atomic_uint_least64_t`</i>
+ *
+ * \param[in] subscription the subscription which is being queried
+ * \param[in] percentile the percentile, from 0 to 100, e.g. 99.9
+ * \param[out] latency the latency which the percentile does not exceed, in nanoseconds
+ * \return `RCL_RET_OK` if the latency was retrieved successfully, or
+ * \return `RCL_RET_INVALID_ARGUMENT` if any arguments are invalid, or
+ * \return `RCL_RET_SUBSCRIPTION_INVALID` if the subscription is invalid, or
+ * \return `RCL_RET_ERROR` if the subscription does not measure latencies.
+ */
+RCL_PUBLIC
+RCL_WARN_UNUSED
+rcl_ret_t
+rcl_subscription_get_latency_percentile(
+  const rcl_subscription_t * subscription, double percentile, int64_t * latency);
+
+/// Reset the message latencies measured by a subscription.
+/**
+ * Messages taken concurrently may be counted or lost.
+ *
+ * <hr>
+ * Attribute          | Adherence
+ * ------------------ | -------------
+ * Allocates Memory   | No
+ * Thread-Safe        | Yes
+ * Uses Atomics       | Yes
+ * Lock-Free          | Yes [1]
+ * <i>[1] if `atomic_is_lock_free()` returns true for `atomic_uint_least64_t`</i>
+ *
+ * \param[in] subscription the subscription whose latencies are reset
+ * \return `RCL_RET_OK` if the latencies were reset successfully, or
+ * \return `RCL_RET_SUBSCRIPTION_INVALID` if the subscription is invalid, or
+ * \return `RCL_RET_ERROR` if the subscription does not measure latencies.
+ */
+RCL_PUBLIC
+RCL_WARN_UNUSED
+rcl_ret_t
+rcl_subscription_reset_latency_statistics(const rcl_subscription_t * subscription);
+
 /// Check that the subscription is valid.
 /**
  * The bool returned is `false` if `subscription` is invalid.
@@ -117,8 +117,8 @@ typedef struct rcl_jump_callback_info_t
 typedef struct rcl_clock_t
 {
   enum rcl_clock_type_t type;
-  /// An array of added jump callbacks.
-  rcl_jump_callback_info_t * jump_callbacks;
+  /// The added jump callbacks, private to the implementation.
+  struct rcl_jump_callback_list_t * jump_callbacks;
   /// Number of callbacks in jump_callbacks.
   size_t num_jump_callbacks;
   rcl_ret_t (* get_now)(void * data, rcl_time_point_value_t * now);
@@ -127,6 +127,15 @@ typedef struct rcl_clock_t
   rcl_allocator_t allocator;
 } rcl_clock_t;
 
+/// Source of the time of `RCL_STEADY_TIME` clocks.
+typedef enum rcl_steady_time_source_t
+{
+  /// The steady clock of the operating system, e.g. `CLOCK_MONOTONIC`.
+  RCL_STEADY_TIME_SOURCE_SYSTEM = 0,
+  /// The invariant time stamp counter of the processor, calibrated at rcl_init().
+  RCL_STEADY_TIME_SOURCE_TSC
+} rcl_steady_time_source_t;
+
 /// A single point in time, measured in nanoseconds, the reference point is based on the source.
 typedef struct rcl_time_point_t
 {
@@ -400,6 +409,8 @@ rcl_is_enabled_ros_time_override(
  * time source.
  * If queried and override enabled the time source will return this value,
  * otherwise it will return the system time.
+ * This fails for clocks which read a shared time, see
+ * rcl_ros_clock_attach_shared_time().
  *
  * \param[in] clock The clock to update.
  * \param[in] time_value The new current time.
@@ -413,6 +424,36 @@ rcl_ret_t
 rcl_set_ros_time_override(
   rcl_clock_t * clock, rcl_time_point_value_t time_value);
 
+/// Make the ROS time override of a `RCL_ROS_TIME` clock move between updates.
+/**
+ * While enabled, rcl_set_ros_time_override() records the time set along with
+ * the steady time at which it is set, and the rate of the time since the
+ * previous update.
+ * The override then moves at that rate, for at most the steady duration
+ * between the two last updates, so that sparse updates, e.g. of a simulated
+ * time, still give a fine grained time.
+ * The extrapolated time never goes backward, except when set backward:
+ * an update behind the extrapolated time, but ahead of the previous update,
+ * keeps the time where it is, and the time then moves slower, or not at all,
+ * until it is back on the updates, so that it never leads them by more than
+ * the largest step between two updates.
+ *
+ * Timers of the clock are woken up when their time is extrapolated, in
+ * addition to when it is set.
+ * The extrapolation has no effect on clocks which read a shared time, see
+ * rcl_ros_clock_attach_shared_time().
+ *
+ * \param[in] clock The `RCL_ROS_TIME` clock to change.
+ * \param[in] enabled Whether to extrapolate the time override.
+ * \return `RCL_RET_OK` if the extrapolation was changed successfully, or
+ * \return `RCL_RET_INVALID_ARGUMENT` if any arguments are invalid, or
+ * \return `RCL_RET_ERROR` an unspecified error occur.
+ */
+RCL_PUBLIC
+RCL_WARN_UNUSED
+rcl_ret_t
+rcl_ros_clock_set_extrapolation(rcl_clock_t * clock, bool enabled);
+
 /// Add a callback to be called when a time jump exceeds a threshold.
 /**
  * The callback is called twice when the threshold is exceeded: once before the clock is
@@ -420,6 +461,10 @@ rcl_set_ros_time_override(
  * The user_data pointer is passed to the callback as the last argument.
  * A callback and user_data pair must be unique among the callbacks added to a clock.
  *
+ * Callbacks can be added and removed while other threads change the time of the clock.
+ * Calling the callbacks never waits for these changes, and adding a callback does not
+ * copy the ones already added.
+ *
  * \param[in] clock A clock to add a jump callback to.
  * \param[in] threshold Criteria indicating when to call the callback.
  * \param[in] callback A callback to call.
@@ -437,6 +482,12 @@ rcl_clock_add_jump_callback(
 
 /// Remove a previously added time jump callback.
 /**
+ * The callback is not called anymore once this function returns, which waits for the calls of
+ * the callbacks of the clock already started in other threads, if any.
+ * Called from a jump callback of the same clock, it returns without waiting, as the calls of
+ * this thread would never end, and the callback may still be called by calls already started
+ * in other threads.
+ *
  * \param[in] clock The clock to remove a jump callback from.
  * \param[in] threshold Criteria indicating when to call callback.
  * \param[in] callback The callback to call.
@@ -451,6 +502,145 @@ rcl_ret_t
 rcl_clock_remove_jump_callback(
   rcl_clock_t * clock, rcl_jump_callback_t callback, void * user_data);
 
+/// Return the source of the time of `RCL_STEADY_TIME` clocks.
+/**
+ * The time stamp counter of the processor is used when the environment
+ * variable `RCL_STEADY_TIME_SOURCE` is set to `tsc` at the first call to
+ * rcl_init(), which calibrates it against the steady clock of the operating
+ * system.
+ * Reading it takes a single instruction instead of a system call, or a vDSO
+ * call.
+ *
+ * The steady clock of the operating system is used otherwise, and as a
+ * fallback when the processor has no invariant time stamp counter, when the
+ * operating system does not trust it, or when the calibration fails.
+ *
+ * Steady times from different sources, or from calibrations in different
+ * processes, may drift apart by a few microseconds per second, so they should
+ * only be compared within a process.
+ *
+ * <hr>
+ * Attribute          | Adherence
+ * ------------------ | -------------
+ * Allocates Memory   | No
+ * Thread-Safe        | Yes
+ * Uses Atomics       | Yes
+ * Lock-Free          | Yes
+ *
+ * \return the source used by `RCL_STEADY_TIME` clocks.
+ */
+RCL_PUBLIC
+RCL_WARN_UNUSED
+rcl_steady_time_source_t
+rcl_get_steady_time_source(void);
+
+/// Encapsulation of the time authority which writes a shared ROS time.
+/**
+ * The time is stored as an atomic 64 bit value in a memory mapped file, which
+ * any number of processes can read through a `RCL_ROS_TIME` clock, see
+ * rcl_ros_clock_attach_shared_time().
+ */
+typedef struct rcl_shared_time_authority_t
+{
+  /// Private implementation pointer.
+  struct rcl_shared_time_authority_impl_t * impl;
+} rcl_shared_time_authority_t;
+
+/// Return a rcl_shared_time_authority_t struct with members set to `NULL`.
+RCL_PUBLIC
+RCL_WARN_UNUSED
+rcl_shared_time_authority_t
+rcl_get_zero_initialized_shared_time_authority(void);
+
+/// Become the time authority of the shared time stored in the given file.
+/**
+ * The file is created if needed, and its time is set to `0`, which means that
+ * the time has not been set yet.
+ * There can only be a single authority per file at a time, which is enforced
+ * with an advisory lock on the file.
+ *
+ * Shared time is not supported on Windows.
+ *
+ * \param[inout] authority the zero initialized authority to be initialized
+ * \param[in] path the path of the file holding the shared time
+ * \param[in] allocator the allocator to use for allocations
+ * \return `RCL_RET_OK` if the authority was initialized successfully, or
+ * \return `RCL_RET_INVALID_ARGUMENT` if any arguments are invalid, or
+ * \return `RCL_RET_ALREADY_INIT` if the authority is already initialized, or
+ * \return `RCL_RET_BAD_ALLOC` if allocating memory failed, or
+ * \return `RCL_RET_ERROR` if another authority holds the file, or an
+ *   unspecified error occurs.
+ */
+RCL_PUBLIC
+RCL_WARN_UNUSED
+rcl_ret_t
+rcl_shared_time_authority_init(
+  rcl_shared_time_authority_t * authority,
+  const char * path,
+  rcl_allocator_t allocator);
+
+/// Give up the shared time, so that another authority can take over.
+/**
+ * The file is left in place, with the last time set, for the clocks which
+ * still read it.
+ *
+ * \param[inout] authority the authority to be finalized
+ * \return `RCL_RET_OK` if the authority was finalized successfully, or
+ * \return `RCL_RET_INVALID_ARGUMENT` if any arguments are invalid, or
+ * \return `RCL_RET_ERROR` an unspecified error occurs.
+ */
+RCL_PUBLIC
+RCL_WARN_UNUSED
+rcl_ret_t
+rcl_shared_time_authority_fini(rcl_shared_time_authority_t * authority);
+
+/// Set the shared time, with a single atomic store.
+/**
+ * The clocks reading the shared time notice the change the next time they
+ * are queried, and call their jump callbacks then.
+ *
+ * \param[in] authority the authority of the shared time
+ * \param[in] time_value the new shared time
+ * \return `RCL_RET_OK` if the time was set successfully, or
+ * \return `RCL_RET_INVALID_ARGUMENT` if any arguments are invalid.
+ */
+RCL_PUBLIC
+RCL_WARN_UNUSED
+rcl_ret_t
+rcl_shared_time_authority_set(
+  rcl_shared_time_authority_t * authority, rcl_time_point_value_t time_value);
+
+/// Make a `RCL_ROS_TIME` clock read its override time from a shared time file.
+/**
+ * While the ROS time override is enabled, the clock then reports the time
+ * written by the authority of the file, see rcl_shared_time_authority_init(),
+ * instead of the time set with rcl_set_ros_time_override(), which fails.
+ * Reading the time takes two atomic loads and no system call.
+ *
+ * Since the time is set by another process, a change of the time is noticed
+ * when the clock is queried with rcl_clock_get_now().
+ * The jump callbacks of the clock are called then, by the thread noticing the
+ * change, while concurrent queries keep reporting the previous time.
+ *
+ * The clock must be attached before the override is enabled, and stays
+ * attached until it is finalized.
+ * The file must have been created by an authority, but the authority does not
+ * need to be alive.
+ *
+ * Shared time is not supported on Windows.
+ *
+ * \param[in] clock the `RCL_ROS_TIME` clock to attach
+ * \param[in] path the path of the file holding the shared time
+ * \return `RCL_RET_OK` if the clock was attached successfully, or
+ * \return `RCL_RET_INVALID_ARGUMENT` if any arguments are invalid, or
+ * \return `RCL_RET_ERROR` if the clock is already attached or its override
+ *   enabled, if the file cannot be mapped, or an unspecified error occurs.
+ */
+RCL_PUBLIC
+RCL_WARN_UNUSED
+rcl_ret_t
+rcl_ros_clock_attach_shared_time(rcl_clock_t * clock, const char * path);
+
 #ifdef __cplusplus
 }
 #endif
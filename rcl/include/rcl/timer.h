@@ -23,6 +23,7 @@ extern "C"
 #include <stdbool.h>
 
 #include "rcl/allocator.h"
+#include "rcl/guard_condition.h"
 #include "rcl/macros.h"
 #include "rcl/time.h"
 #include "rcl/types.h"
@@ -53,6 +54,55 @@ typedef struct rcl_timer_t
  */
 typedef void (* rcl_timer_callback_t)(rcl_timer_t *, int64_t);
 
+/// Number of buckets of the lateness histogram of a timer.
+#define RCL_TIMER_LATENESS_HISTOGRAM_SIZE 20
+
+/// Statistics about the activations of a timer.
+/**
+ * The lateness of a call is the time it was called at minus the time it was
+ * scheduled for, in nanoseconds of the timer's clock.
+ * Calls made before the scheduled time count as on time.
+ *
+ * Bucket `0` of the histogram counts calls less than a microsecond late.
+ * Bucket `i` counts calls at least `2^(i - 1)` and less than `2^i`
+ * microseconds late, except for the last bucket which counts all the calls
+ * beyond that.
+ */
+typedef struct rcl_timer_statistics_t
+{
+  /// Number of times the timer was called.
+  uint64_t number_of_calls;
+  /// Number of periods which were skipped because the timer was called too late.
+  uint64_t missed_periods;
+  /// Lateness of the latest call, in nanoseconds.
+  int64_t last_lateness;
+  /// Largest lateness of any call, in nanoseconds.
+  int64_t max_lateness;
+  /// Number of calls by lateness, see above for the bucket bounds.
+  uint64_t lateness_histogram[RCL_TIMER_LATENESS_HISTOGRAM_SIZE];
+} rcl_timer_statistics_t;
+
+/// Options available for a rcl timer.
+typedef struct rcl_timer_options_t
+{
+  /// If true, waits on the timer are woken up at an absolute expiration time.
+  /**
+   * Only timers on a clock of type `RCL_STEADY_TIME` can use this option.
+   *
+   * On Linux the timer is then backed by a timerfd, which rcl_wait() arms with
+   * the absolute next call time (`TFD_TIMER_ABSTIME`) and waits on directly,
+   * instead of turning the next call time into a relative timeout.
+   * This avoids the timer slack added to relative timeouts, and so reduces the
+   * activation jitter of fast periodic timers.
+   * The timerfd is only waited on when rcl_wait() does not need to go through
+   * the middleware, i.e. when the wait set only holds timers and local guard
+   * conditions.
+   *
+   * On other platforms this option has no effect.
+   */
+  bool high_precision;
+} rcl_timer_options_t;
+
 /// Return a zero initialized timer.
 RCL_PUBLIC
 RCL_WARN_UNUSED
@@ -80,6 +130,12 @@ rcl_get_zero_initialized_timer(void);
  *
  * The clock handle must be a pointer to an initialized rcl_clock_t struct.
  * The life time of the clock must exceed the life time of the timer.
+ * The timer is scheduled on the time of this clock.
+ * For a clock of type `RCL_ROS_TIME`, the timer registers a jump callback on
+ * the clock and initializes a guard condition with the `local_only` option,
+ * see rcl_timer_get_guard_condition(), so rcl_init() must have been called.
+ * When the clock is activated, deactivated or jumps backwards, the time left
+ * until the next call is kept.
  *
  * The period is a non-negative duration (rather an absolute time in the
  * future).
@@ -153,6 +209,58 @@ rcl_timer_init(
   const rcl_timer_callback_t callback,
   rcl_allocator_t allocator);
 
+/// Initialize a timer with the given options.
+/**
+ * This function behaves like rcl_timer_init(), except that the options
+ * customize the timer, see rcl_timer_options_t.
+ *
+ * <hr>
+ * Attribute          | Adherence
+ * ------------------ | -------------
+ * Allocates Memory   | Yes
+ * Thread-Safe        | No
+ * Uses Atomics       | Yes
+ * Lock-Free          | Yes [1][2][3]
+ * <i>[1] if `atomic_is_lock_free()` returns true for `atomic_uintptr_t`</i>
+ *
+ * <i>[2] if `atomic_is_lock_free()` returns true for `atomic_uint_least64_t`</i>
+ *
+ * <i>[3] if `atomic_is_lock_free()` returns true for `atomic_bool`</i>
+ *
+ * \param[inout] timer the timer handle to be initialized
+ * \param[in] clock the clock providing the current time
+ * \param[in] period the duration between calls to the callback in nanoseconds
+ * \param[in] callback the user defined function to be called every period
+ * \param[in] allocator the allocator to use for allocations
+ * \param[in] options the options of the timer
+ * \return `RCL_RET_OK` if the timer was initialized successfully, or
+ * \return `RCL_RET_INVALID_ARGUMENT` if any arguments are invalid, or
+ * \return `RCL_RET_ALREADY_INIT` if the timer was already initialized, or
+ * \return `RCL_RET_BAD_ALLOC` if allocating memory failed, or
+ * \return `RCL_RET_ERROR` an unspecified error occur.
+ */
+RCL_PUBLIC
+RCL_WARN_UNUSED
+rcl_ret_t
+rcl_timer_init_with_options(
+  rcl_timer_t * timer,
+  rcl_clock_t * clock,
+  int64_t period,
+  const rcl_timer_callback_t callback,
+  rcl_allocator_t allocator,
+  const rcl_timer_options_t * options);
+
+/// Return the default timer options in a rcl_timer_options_t.
+/**
+ * The defaults are:
+ *
+ * - high_precision = false
+ */
+RCL_PUBLIC
+RCL_WARN_UNUSED
+rcl_timer_options_t
+rcl_timer_get_default_options(void);
+
 /// Finalize a timer.
 /**
  * This function will deallocate any memory and make the timer invalid.
@@ -197,7 +305,9 @@ rcl_timer_fini(rcl_timer_t * timer);
  * The order of operations in this command are as follows:
  *
  *  - Ensure the timer has not been canceled.
- *  - Get the current time into a temporary rcl_steady_time_point_t.
+ *  - Get the current time of the clock of the timer.
+ *  - Advance the next call time by a compare and exchange, so that concurrent
+ *    calls each account for a period.
  *  - Exchange the current time with the last call time of the timer.
  *  - Call the callback, passing this timer and the time since the last call.
  *  - Return after the callback has completed.
@@ -228,6 +338,44 @@ RCL_WARN_UNUSED
 rcl_ret_t
 rcl_timer_call(rcl_timer_t * timer);
 
+/// Call the timer's callback only if the timer is ready, claiming exactly one period.
+/**
+ * This function behaves like rcl_timer_call(), except that it first checks
+ * that the next call time of the timer has been reached, and advances it with
+ * a single compare and exchange.
+ * If several threads call this function for the same ready timer, for example
+ * because each of them saw the timer ready in rcl_wait(), exactly one of them
+ * claims the period and calls the callback, the others set `called` to
+ * `false` and return `RCL_RET_OK`.
+ * This allows multi-threaded executors to dispatch timers without guarding
+ * them with a mutex.
+ *
+ * Timers with a period of zero are always ready, so every call claims them.
+ *
+ * <hr>
+ * Attribute          | Adherence
+ * ------------------ | -------------
+ * Allocates Memory   | No
+ * Thread-Safe        | Yes [1]
+ * Uses Atomics       | Yes
+ * Lock-Free          | Yes [2]
+ * <i>[1] user callback might not be thread-safe</i>
+ *
+ * <i>[2] if `atomic_is_lock_free()` returns true for `atomic_int_least64_t`</i>
+ *
+ * \param[inout] timer the handle to the timer to call
+ * \param[out] called set to true if this call claimed the timer and called it
+ * \return `RCL_RET_OK` if the timer was called or was not ready, or
+ * \return `RCL_RET_INVALID_ARGUMENT` if any arguments are invalid, or
+ * \return `RCL_RET_TIMER_INVALID` if the timer is invalid, or
+ * \return `RCL_RET_TIMER_CANCELED` if the timer has been canceled, or
+ * \return `RCL_RET_ERROR` an unspecified error occur.
+ */
+RCL_PUBLIC
+RCL_WARN_UNUSED
+rcl_ret_t
+rcl_timer_call_if_ready(rcl_timer_t * timer, bool * called);
+
 /// Retrieve the clock of the timer.
 /**
  * This function retrieves the clock pointer and copies it into the given variable.
@@ -284,6 +432,38 @@ RCL_WARN_UNUSED
 rcl_ret_t
 rcl_timer_is_ready(const rcl_timer_t * timer, bool * is_ready);
 
+/// Calculate if the timer is ready to be called at the given time.
+/**
+ * This function behaves like rcl_timer_is_ready(), except that it uses the
+ * given time instead of reading the current time.
+ * This allows a caller which checks many timers, like rcl_wait(), to read the
+ * time once and use that snapshot for all of them.
+ *
+ * The given time must be on the same time line as the next call time of the
+ * timer, see rcl_timer_get_next_call_time().
+ *
+ * <hr>
+ * Attribute          | Adherence
+ * ------------------ | -------------
+ * Allocates Memory   | No
+ * Thread-Safe        | Yes
+ * Uses Atomics       | Yes
+ * Lock-Free          | Yes [1]
+ * <i>[1] if `atomic_is_lock_free()` returns true for `atomic_int_least64_t`</i>
+ *
+ * \param[in] timer the handle to the timer which is being checked
+ * \param[in] now the time at which the timer is checked, in nanoseconds
+ * \param[out] is_ready the bool used to store the result of the calculation
+ * \return `RCL_RET_OK` if the last call time was retrieved successfully, or
+ * \return `RCL_RET_INVALID_ARGUMENT` if any arguments are invalid, or
+ * \return `RCL_RET_TIMER_INVALID` if the timer is invalid, or
+ * \return `RCL_RET_ERROR` an unspecified error occur.
+ */
+RCL_PUBLIC
+RCL_WARN_UNUSED
+rcl_ret_t
+rcl_timer_is_ready_at(const rcl_timer_t * timer, rcl_time_point_value_t now, bool * is_ready);
+
 /// Calculate and retrieve the time until the next call in nanoseconds.
 /**
  * This function calculates the time until the next call by adding the timer's
@@ -319,6 +499,71 @@ RCL_WARN_UNUSED
 rcl_ret_t
 rcl_timer_get_time_until_next_call(const rcl_timer_t * timer, int64_t * time_until_next_call);
 
+/// Calculate the time until the next call from the given time, in nanoseconds.
+/**
+ * This function behaves like rcl_timer_get_time_until_next_call(), except that
+ * it uses the given time instead of reading the current time.
+ *
+ * The given time must be on the same time line as the next call time of the
+ * timer, see rcl_timer_get_next_call_time().
+ *
+ * <hr>
+ * Attribute          | Adherence
+ * ------------------ | -------------
+ * Allocates Memory   | No
+ * Thread-Safe        | Yes
+ * Uses Atomics       | Yes
+ * Lock-Free          | Yes [1]
+ * <i>[1] if `atomic_is_lock_free()` returns true for `atomic_int_least64_t`</i>
+ *
+ * \param[in] timer the handle to the timer that is being queried
+ * \param[in] now the time from which the time until the next call is calculated
+ * \param[out] time_until_next_call the output variable for the result
+ * \return `RCL_RET_OK` if the timer until next call was successfully calculated, or
+ * \return `RCL_RET_INVALID_ARGUMENT` if any arguments are invalid, or
+ * \return `RCL_RET_TIMER_INVALID` if the timer is invalid, or
+ * \return `RCL_RET_ERROR` an unspecified error occur.
+ */
+RCL_PUBLIC
+RCL_WARN_UNUSED
+rcl_ret_t
+rcl_timer_get_time_until_next_call_at(
+  const rcl_timer_t * timer,
+  rcl_time_point_value_t now,
+  int64_t * time_until_next_call);
+
+/// Retrieve the time at which the timer is next due, in nanoseconds.
+/**
+ * The returned time point is on the same time line as the time which is used
+ * to calculate the time until the next call, see
+ * rcl_timer_get_time_until_next_call().
+ * Unlike the time until the next call, it does not change as time passes, so
+ * it can be used to order timers, e.g. to find the timer which is due first.
+ *
+ * The `next_call_time` argument must point to an allocated int64_t, as the
+ * next call time is copied into that instance.
+ *
+ * <hr>
+ * Attribute          | Adherence
+ * ------------------ | -------------
+ * Allocates Memory   | No
+ * Thread-Safe        | Yes
+ * Uses Atomics       | Yes
+ * Lock-Free          | Yes [1]
+ * <i>[1] if `atomic_is_lock_free()` returns true for `atomic_int_least64_t`</i>
+ *
+ * \param[in] timer the handle to the timer that is being queried
+ * \param[out] next_call_time the output variable for the result
+ * \return `RCL_RET_OK` if the next call time was successfully retrieved, or
+ * \return `RCL_RET_INVALID_ARGUMENT` if any arguments are invalid, or
+ * \return `RCL_RET_TIMER_INVALID` if the timer is invalid, or
+ * \return `RCL_RET_ERROR` an unspecified error occur.
+ */
+RCL_PUBLIC
+RCL_WARN_UNUSED
+rcl_ret_t
+rcl_timer_get_next_call_time(const rcl_timer_t * timer, int64_t * next_call_time);
+
 /// Retrieve the time since the previous call to rcl_timer_call() occurred.
 /**
  * This function calculates the time since the last call and copies it into
@@ -542,6 +787,152 @@ RCL_WARN_UNUSED
 rcl_ret_t
 rcl_timer_reset(rcl_timer_t * timer);
 
+/// Retrieve the slack of a timer.
+/**
+ * \see rcl_timer_set_slack
+ *
+ * <hr>
+ * Attribute          | Adherence
+ * ------------------ | -------------
+ * Allocates Memory   | No
+ * Thread-Safe        | Yes
+ * Uses Atomics       | Yes
+ * Lock-Free          | Yes [1]
+ * <i>[1] if `atomic_is_lock_free()` returns true for `atomic_int_least64_t`</i>
+ *
+ * \param[in] timer the handle to the timer which is being queried
+ * \param[out] slack the slack of the timer in nanoseconds
+ * \return `RCL_RET_OK` if the slack was retrieved successfully, or
+ * \return `RCL_RET_INVALID_ARGUMENT` if any arguments are invalid, or
+ * \return `RCL_RET_TIMER_INVALID` if the timer is invalid, or
+ * \return `RCL_RET_ERROR` an unspecified error occur.
+ */
+RCL_PUBLIC
+RCL_WARN_UNUSED
+rcl_ret_t
+rcl_timer_get_slack(const rcl_timer_t * timer, int64_t * slack);
+
+/// Set how late a timer may be woken up, so that it can share a wake up with other timers.
+/**
+ * By default the slack of a timer is zero, and rcl_wait() wakes up at the
+ * next call time of the earliest timer.
+ * With a slack, rcl_wait() may wake up as late as the next call time plus the
+ * slack, and it picks the earliest such deadline over all timers in the wait
+ * set.
+ * Every timer whose next call time has passed by then is ready after that
+ * single wake up, instead of each of them waking up the wait set on its own.
+ *
+ * The slack only delays wake ups caused by timers: a wait set which wakes up
+ * for another reason reports all the timers which are due at that time.
+ *
+ * <hr>
+ * Attribute          | Adherence
+ * ------------------ | -------------
+ * Allocates Memory   | No
+ * Thread-Safe        | Yes
+ * Uses Atomics       | Yes
+ * Lock-Free          | Yes [1]
+ * <i>[1] if `atomic_is_lock_free()` returns true for `atomic_int_least64_t`</i>
+ *
+ * \param[inout] timer the handle to the timer to be configured
+ * \param[in] slack the slack in nanoseconds, which must be non-negative
+ * \return `RCL_RET_OK` if the slack was set successfully, or
+ * \return `RCL_RET_INVALID_ARGUMENT` if any arguments are invalid, or
+ * \return `RCL_RET_TIMER_INVALID` if the timer is invalid, or
+ * \return `RCL_RET_ERROR` an unspecified error occur.
+ */
+RCL_PUBLIC
+RCL_WARN_UNUSED
+rcl_ret_t
+rcl_timer_set_slack(rcl_timer_t * timer, int64_t slack);
+
+/// Move the next call time of a timer onto a grid of periods starting at a common epoch.
+/**
+ * rcl_timer_init() schedules the first call one period after the timer was
+ * initialized, so timers created a few microseconds apart stay a few
+ * microseconds apart forever.
+ * This function moves the next call time to the first time of the form
+ * `epoch + k * period` which is not before the current time of the timer's
+ * clock.
+ * Timers aligned to the same epoch, whose periods are multiples of each
+ * other, then fall due at exactly the same times, and share wake ups.
+ *
+ * The next call time can move backwards, up to almost a period.
+ * Timers with a period of zero are left unchanged.
+ *
+ * <hr>
+ * Attribute          | Adherence
+ * ------------------ | -------------
+ * Allocates Memory   | No
+ * Thread-Safe        | Yes
+ * Uses Atomics       | Yes
+ * Lock-Free          | Yes [1]
+ * <i>[1] if `atomic_is_lock_free()` returns true for `atomic_int_least64_t`</i>
+ *
+ * \param[inout] timer the handle to the timer to be aligned
+ * \param[in] epoch the common reference time, on the timer's clock, e.g. `0`
+ * \return `RCL_RET_OK` if the timer was aligned successfully, or
+ * \return `RCL_RET_INVALID_ARGUMENT` if any arguments are invalid, or
+ * \return `RCL_RET_TIMER_INVALID` if the timer is invalid, or
+ * \return `RCL_RET_ERROR` an unspecified error occur.
+ */
+RCL_PUBLIC
+RCL_WARN_UNUSED
+rcl_ret_t
+rcl_timer_align_phase(rcl_timer_t * timer, rcl_time_point_value_t epoch);
+
+/// Retrieve the activation statistics of a timer.
+/**
+ * The statistics are updated by rcl_timer_call() and rcl_timer_call_if_ready()
+ * with lock-free counters, before the callback is called.
+ * The fields are read one by one, so a snapshot taken while the timer is
+ * being called may mix the state from before and after that call.
+ *
+ * <hr>
+ * Attribute          | Adherence
+ * ------------------ | -------------
+ * Allocates Memory   | No
+ * Thread-Safe        | Yes
+ * Uses Atomics       | Yes
+ * Lock-Free          | Yes [1]
+ * <i>[1] if `atomic_is_lock_free()` returns true for `atomic_int_least64_t`</i>
+ *
+ * \param[in] timer the handle to the timer which is being queried
+ * \param[out] statistics the statistics of the timer
+ * \return `RCL_RET_OK` if the statistics were retrieved successfully, or
+ * \return `RCL_RET_INVALID_ARGUMENT` if any arguments are invalid, or
+ * \return `RCL_RET_TIMER_INVALID` if the timer is invalid, or
+ * \return `RCL_RET_ERROR` an unspecified error occur.
+ */
+RCL_PUBLIC
+RCL_WARN_UNUSED
+rcl_ret_t
+rcl_timer_get_statistics(const rcl_timer_t * timer, rcl_timer_statistics_t * statistics);
+
+/// Reset the activation statistics of a timer to zero.
+/**
+ * Calls which happen concurrently may be counted or lost.
+ *
+ * <hr>
+ * Attribute          | Adherence
+ * ------------------ | -------------
+ * Allocates Memory   | No
+ * Thread-Safe        | Yes
+ * Uses Atomics       | Yes
+ * Lock-Free          | Yes [1]
+ * <i>[1] if `atomic_is_lock_free()` returns true for `atomic_int_least64_t`</i>
+ *
+ * \param[inout] timer the timer whose statistics are reset
+ * \return `RCL_RET_OK` if the statistics were reset successfully, or
+ * \return `RCL_RET_INVALID_ARGUMENT` if any arguments are invalid, or
+ * \return `RCL_RET_TIMER_INVALID` if the timer is invalid, or
+ * \return `RCL_RET_ERROR` an unspecified error occur.
+ */
+RCL_PUBLIC
+RCL_WARN_UNUSED
+rcl_ret_t
+rcl_timer_reset_statistics(rcl_timer_t * timer);
+
 /// Return the allocator for the timer.
 /**
  * This function can fail, and therefore return `NULL`, if:
@@ -564,6 +955,39 @@ rcl_timer_reset(rcl_timer_t * timer);
 const rcl_allocator_t *
 rcl_timer_get_allocator(const rcl_timer_t * timer);
 
+/// Return the guard condition which is triggered when the time of the timer's clock jumps.
+/**
+ * Only timers on a clock of type `RCL_ROS_TIME` have such a guard condition.
+ * While the ROS time override of the clock is enabled, the time only moves
+ * when it is set, so a wait on the timer would never time out.
+ * Instead the guard condition is triggered whenever setting the time makes
+ * the timer ready, and whenever the clock is activated, deactivated or jumps
+ * backwards.
+ * Wait sets attach it automatically for the timers added to them.
+ *
+ * This function can fail, and therefore return `NULL`, if:
+ *   - timer is `NULL`
+ *   - timer has not been initialized (the implementation is invalid)
+ *   - the clock of the timer is not of type `RCL_ROS_TIME`
+ *
+ * The returned pointer is only valid as long as the timer object is valid.
+ *
+ * <hr>
+ * Attribute          | Adherence
+ * ------------------ | -------------
+ * Allocates Memory   | No
+ * Thread-Safe        | Yes
+ * Uses Atomics       | No
+ * Lock-Free          | Yes
+ *
+ * \param[in] timer handle to the timer object
+ * \return pointer to the guard condition, or `NULL` if there is none
+ */
+RCL_PUBLIC
+RCL_WARN_UNUSED
+rcl_guard_condition_t *
+rcl_timer_get_guard_condition(const rcl_timer_t * timer);
+
 #ifdef __cplusplus
 }
 #endif
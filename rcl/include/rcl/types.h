@@ -52,12 +52,16 @@ typedef rmw_ret_t rcl_ret_t;
 // rcl publisher specific ret codes in 3XX
 /// Invalid rcl_publisher_t given return code.
 #define RCL_RET_PUBLISHER_INVALID 300
+/// No message could be loaned from the publisher return code.
+#define RCL_RET_PUBLISHER_LOAN_FAILED 301
 
 // rcl subscription specific ret codes in 4XX
 /// Invalid rcl_subscription_t given return code.
 #define RCL_RET_SUBSCRIPTION_INVALID 400
 /// Failed to take a message from the subscription return code.
 #define RCL_RET_SUBSCRIPTION_TAKE_FAILED 401
+/// No message could be loaned from the subscription return code.
+#define RCL_RET_SUBSCRIPTION_LOAN_FAILED 402
 
 // rcl service client specific ret codes in 5XX
 /// Invalid rcl_client_t given return code.
@@ -97,6 +101,10 @@ typedef rmw_ret_t rcl_ret_t;
 /// Argument is not a valid log level rule
 #define RCL_RET_INVALID_LOG_LEVEL_RULE 1020
 
+// rcl executor specific ret codes in 2XXX
+/// Invalid rcl_executor_t given return code.
+#define RCL_RET_EXECUTOR_INVALID 2000
+
 /// typedef for rmw_serialized_message_t;
 typedef rmw_serialized_message_t rcl_serialized_message_t;
 
@@ -34,6 +34,55 @@ extern "C"
 
 struct rcl_wait_set_impl_t;
 
+/// Readiness of the entities in a wait set, as reported by the last call to rcl_wait().
+/**
+ * Each array has one flag per slot of the matching entity set in the wait set,
+ * i.e. `ready.subscriptions[i]` tells whether `subscriptions[i]` is ready.
+ * The flags are written by every call to rcl_wait() and are kept separate from
+ * the entity sets so that the membership of a persistent wait set survives a
+ * call to rcl_wait().
+ *
+ * In addition, the indexes of the ready entities of each type are collected,
+ * in ascending order, into a compact list, so that an executor can visit only
+ * the ready entities instead of scanning every slot of the wait set:
+ *
+ * ```c
+ * for (size_t i = 0; i < wait_set.ready.number_of_ready_subscriptions; ++i) {
+ *   const rcl_subscription_t * sub =
+ *     wait_set.subscriptions[wait_set.ready.subscription_indices[i]];
+ *   // take from sub...
+ * }
+ * ```
+ */
+typedef struct rcl_wait_set_ready_t
+{
+  /// Ready flags for the subscriptions.
+  bool * subscriptions;
+  /// Indexes of the ready subscriptions.
+  size_t * subscription_indices;
+  size_t number_of_ready_subscriptions;
+  /// Ready flags for the guard conditions.
+  bool * guard_conditions;
+  /// Indexes of the ready guard conditions.
+  size_t * guard_condition_indices;
+  size_t number_of_ready_guard_conditions;
+  /// Ready flags for the timers.
+  bool * timers;
+  /// Indexes of the ready timers.
+  size_t * timer_indices;
+  size_t number_of_ready_timers;
+  /// Ready flags for the clients.
+  bool * clients;
+  /// Indexes of the ready clients.
+  size_t * client_indices;
+  size_t number_of_ready_clients;
+  /// Ready flags for the services.
+  bool * services;
+  /// Indexes of the ready services.
+  size_t * service_indices;
+  size_t number_of_ready_services;
+} rcl_wait_set_ready_t;
+
 /// Container for subscription's, guard condition's, etc to be waited on.
 typedef struct rcl_wait_set_t
 {
@@ -52,10 +101,25 @@ typedef struct rcl_wait_set_t
   /// Storage for service pointers.
   const rcl_service_t ** services;
   size_t size_of_services;
+  /// Which of the entities above were ready after the last call to rcl_wait().
+  rcl_wait_set_ready_t ready;
   /// Implementation specific storage.
   struct rcl_wait_set_impl_t * impl;
 } rcl_wait_set_t;
 
+/// Counters showing how often timers shared the wake ups of a wait set.
+typedef struct rcl_wait_set_timer_statistics_t
+{
+  /// Number of calls to rcl_wait() which found at least one ready timer.
+  uint64_t number_of_timer_wake_ups;
+  /// Number of ready timers beyond the first one, summed over those calls.
+  /**
+   * Each of these timers could have needed a wake up of its own, had it not
+   * been coalesced with the others through its slack or phase alignment.
+   */
+  uint64_t number_of_timer_wake_ups_saved;
+} rcl_wait_set_timer_statistics_t;
+
 /// Return a rcl_wait_set_t struct with members set to `NULL`.
 RCL_PUBLIC
 RCL_WARN_UNUSED
@@ -333,6 +397,340 @@ rcl_wait_set_add_service(
   rcl_wait_set_t * wait_set,
   const rcl_service_t * service);
 
+/// Set whether or not the membership of the wait set survives calls to rcl_wait().
+/**
+ * By default rcl_wait() sets the entries of the wait set which are not ready
+ * to `NULL`, so the wait set must be cleared and filled again before every
+ * call to rcl_wait().
+ *
+ * A persistent wait set instead leaves its entity sets untouched and reports
+ * readiness only through the `ready` member of the wait set.
+ * Entities are added once with the rcl_wait_set_add_*() functions and stay in
+ * the wait set until they are explicitly removed with the matching
+ * rcl_wait_set_remove_*() function, or until the wait set is cleared, resized
+ * or finalized.
+ * They can also be left out of the waits for a while, without changing their
+ * index, with the rcl_wait_set_disable_*() and rcl_wait_set_enable_*()
+ * functions.
+ *
+ * Changing this setting does not change the entities in the wait set.
+ *
+ * <hr>
+ * Attribute          | Adherence
+ * ------------------ | -------------
+ * Allocates Memory   | No
+ * Thread-Safe        | No
+ * Uses Atomics       | No
+ * Lock-Free          | Yes
+ *
+ * \param[inout] wait_set the wait set to be configured
+ * \param[in] persistent true to keep the membership across calls to rcl_wait()
+ * \return `RCL_RET_OK` if the setting was changed successfully, or
+ * \return `RCL_RET_INVALID_ARGUMENT` if any arguments are invalid, or
+ * \return `RCL_RET_WAIT_SET_INVALID` if the wait set is zero initialized, or
+ * \return `RCL_RET_ERROR` if an unspecified error occurs.
+ */
+RCL_PUBLIC
+RCL_WARN_UNUSED
+rcl_ret_t
+rcl_wait_set_set_persistent(rcl_wait_set_t * wait_set, bool persistent);
+
+/// Return true if the wait set keeps its membership across calls to rcl_wait().
+/**
+ * \see rcl_wait_set_set_persistent
+ *
+ * <hr>
+ * Attribute          | Adherence
+ * ------------------ | -------------
+ * Allocates Memory   | No
+ * Thread-Safe        | No
+ * Uses Atomics       | No
+ * Lock-Free          | Yes
+ *
+ * \param[in] wait_set the wait set to be queried
+ * \return `true` if the wait set is valid and persistent, otherwise `false`
+ */
+RCL_PUBLIC
+RCL_WARN_UNUSED
+bool
+rcl_wait_set_is_persistent(const rcl_wait_set_t * wait_set);
+
+/// Retrieve the counters of timer wake ups of the wait set.
+/**
+ * The counters start at zero when the wait set is initialized, and are
+ * updated by every call to rcl_wait().
+ * \see rcl_timer_set_slack
+ * \see rcl_timer_align_phase
+ *
+ * <hr>
+ * Attribute          | Adherence
+ * ------------------ | -------------
+ * Allocates Memory   | No
+ * Thread-Safe        | No
+ * Uses Atomics       | No
+ * Lock-Free          | Yes
+ *
+ * \param[in] wait_set the wait set to be queried
+ * \param[out] statistics the counters of the wait set
+ * \return `RCL_RET_OK` if the counters were retrieved successfully, or
+ * \return `RCL_RET_INVALID_ARGUMENT` if any arguments are invalid, or
+ * \return `RCL_RET_WAIT_SET_INVALID` if the wait set is zero initialized, or
+ * \return `RCL_RET_ERROR` if an unspecified error occurs.
+ */
+RCL_PUBLIC
+RCL_WARN_UNUSED
+rcl_ret_t
+rcl_wait_set_get_timer_statistics(
+  const rcl_wait_set_t * wait_set,
+  rcl_wait_set_timer_statistics_t * statistics);
+
+/// Remove the given subscription from the wait set.
+/**
+ * The subscription must have been added to the wait set before with
+ * rcl_wait_set_add_subscription().
+ * To keep the set dense, the last subscription in the set is moved into the
+ * slot of the removed subscription, so indexes into the set which were
+ * obtained before this call may refer to a different subscription after it.
+ *
+ * The rmw representation is removed from the underlying rmw array in the same
+ * way and the rmw array count is decremented.
+ *
+ * This is meant to be used with persistent wait sets, see
+ * rcl_wait_set_set_persistent(), where entities stay in the wait set until
+ * they are removed.
+ * For a non-persistent wait set only subscriptions which were not pruned by
+ * the last call to rcl_wait() can be found and removed.
+ *
+ * <hr>
+ * Attribute          | Adherence
+ * ------------------ | -------------
+ * Allocates Memory   | No
+ * Thread-Safe        | No
+ * Uses Atomics       | No
+ * Lock-Free          | Yes
+ *
+ * \param[inout] wait_set struct from which the subscription is to be removed
+ * \param[in] subscription the subscription to be removed from the wait set
+ * \return `RCL_RET_OK` if removed successfully, or
+ * \return `RCL_RET_INVALID_ARGUMENT` if any arguments are invalid, or if the
+ *   subscription is not in the wait set, or
+ * \return `RCL_RET_WAIT_SET_INVALID` if the wait set is zero initialized, or
+ * \return `RCL_RET_ERROR` if an unspecified error occurs.
+ */
+RCL_PUBLIC
+RCL_WARN_UNUSED
+rcl_ret_t
+rcl_wait_set_remove_subscription(
+  rcl_wait_set_t * wait_set,
+  const rcl_subscription_t * subscription);
+
+/// Remove the given guard condition from the wait set.
+/**
+ * This function behaves exactly the same as for subscriptions.
+ * \see rcl_wait_set_remove_subscription
+ */
+RCL_PUBLIC
+RCL_WARN_UNUSED
+rcl_ret_t
+rcl_wait_set_remove_guard_condition(
+  rcl_wait_set_t * wait_set,
+  const rcl_guard_condition_t * guard_condition);
+
+/// Remove the given timer from the wait set.
+/**
+ * This function behaves exactly the same as for subscriptions.
+ * \see rcl_wait_set_remove_subscription
+ */
+RCL_PUBLIC
+RCL_WARN_UNUSED
+rcl_ret_t
+rcl_wait_set_remove_timer(
+  rcl_wait_set_t * wait_set,
+  const rcl_timer_t * timer);
+
+/// Remove the given client from the wait set.
+/**
+ * This function behaves exactly the same as for subscriptions.
+ * \see rcl_wait_set_remove_subscription
+ */
+RCL_PUBLIC
+RCL_WARN_UNUSED
+rcl_ret_t
+rcl_wait_set_remove_client(
+  rcl_wait_set_t * wait_set,
+  const rcl_client_t * client);
+
+/// Remove the given service from the wait set.
+/**
+ * This function behaves exactly the same as for subscriptions.
+ * \see rcl_wait_set_remove_subscription
+ */
+RCL_PUBLIC
+RCL_WARN_UNUSED
+rcl_ret_t
+rcl_wait_set_remove_service(
+  rcl_wait_set_t * wait_set,
+  const rcl_service_t * service);
+
+/// Stop waiting on the subscription at the given index of a persistent wait set.
+/**
+ * Unlike rcl_wait_set_remove_subscription(), the subscription keeps its slot,
+ * so no other subscription is moved and the indexes of the ready list stay
+ * valid.
+ * The entry of the slot is set to `NULL` until the subscription is enabled
+ * again with rcl_wait_set_enable_subscription(), and in between rcl_wait()
+ * neither waits on it nor reports it as ready.
+ * This is meant for an executor which hands a ready entity to another thread,
+ * and waits on it again once it has been handled.
+ *
+ * A disabled subscription must be enabled again before it can be removed.
+ *
+ * <hr>
+ * Attribute          | Adherence
+ * ------------------ | -------------
+ * Allocates Memory   | No
+ * Thread-Safe        | No
+ * Uses Atomics       | No
+ * Lock-Free          | Yes
+ *
+ * \param[inout] wait_set persistent wait set holding the subscription
+ * \param[in] index the index of the subscription in the wait set
+ * \return `RCL_RET_OK` if disabled successfully, or
+ * \return `RCL_RET_INVALID_ARGUMENT` if any arguments are invalid, if the
+ *   wait set is not persistent, or if there is no enabled subscription at the
+ *   index, or
+ * \return `RCL_RET_WAIT_SET_INVALID` if the wait set is zero initialized, or
+ * \return `RCL_RET_ERROR` if an unspecified error occurs.
+ */
+RCL_PUBLIC
+RCL_WARN_UNUSED
+rcl_ret_t
+rcl_wait_set_disable_subscription(rcl_wait_set_t * wait_set, size_t index);
+
+/// Wait again on a subscription disabled with rcl_wait_set_disable_subscription().
+/**
+ * The subscription must be the one which was disabled at this index.
+ *
+ * <hr>
+ * Attribute          | Adherence
+ * ------------------ | -------------
+ * Allocates Memory   | No
+ * Thread-Safe        | No
+ * Uses Atomics       | No
+ * Lock-Free          | Yes
+ *
+ * \param[inout] wait_set persistent wait set holding the subscription
+ * \param[in] subscription the subscription which was disabled
+ * \param[in] index the index of the subscription in the wait set
+ * \return `RCL_RET_OK` if enabled successfully, or
+ * \return `RCL_RET_INVALID_ARGUMENT` if any arguments are invalid, if the
+ *   wait set is not persistent, or if there is no disabled subscription at
+ *   the index, or
+ * \return `RCL_RET_WAIT_SET_INVALID` if the wait set is zero initialized, or
+ * \return `RCL_RET_ERROR` if an unspecified error occurs.
+ */
+RCL_PUBLIC
+RCL_WARN_UNUSED
+rcl_ret_t
+rcl_wait_set_enable_subscription(
+  rcl_wait_set_t * wait_set,
+  const rcl_subscription_t * subscription,
+  size_t index);
+
+/// Stop waiting on the guard condition at the given index of a persistent wait set.
+/**
+ * This function behaves exactly the same as for subscriptions.
+ * \see rcl_wait_set_disable_subscription
+ */
+RCL_PUBLIC
+RCL_WARN_UNUSED
+rcl_ret_t
+rcl_wait_set_disable_guard_condition(rcl_wait_set_t * wait_set, size_t index);
+
+/// Wait again on a guard condition disabled with rcl_wait_set_disable_guard_condition().
+/**
+ * This function behaves exactly the same as for subscriptions.
+ * \see rcl_wait_set_enable_subscription
+ */
+RCL_PUBLIC
+RCL_WARN_UNUSED
+rcl_ret_t
+rcl_wait_set_enable_guard_condition(
+  rcl_wait_set_t * wait_set,
+  const rcl_guard_condition_t * guard_condition,
+  size_t index);
+
+/// Stop waiting on the timer at the given index of a persistent wait set.
+/**
+ * This function behaves exactly the same as for subscriptions.
+ * Disabling and enabling a timer updates the timer queue of the wait set in
+ * O(log n), instead of rebuilding it like removing and adding the timer does.
+ * \see rcl_wait_set_disable_subscription
+ */
+RCL_PUBLIC
+RCL_WARN_UNUSED
+rcl_ret_t
+rcl_wait_set_disable_timer(rcl_wait_set_t * wait_set, size_t index);
+
+/// Wait again on a timer disabled with rcl_wait_set_disable_timer().
+/**
+ * This function behaves exactly the same as for subscriptions.
+ * \see rcl_wait_set_enable_subscription
+ */
+RCL_PUBLIC
+RCL_WARN_UNUSED
+rcl_ret_t
+rcl_wait_set_enable_timer(
+  rcl_wait_set_t * wait_set,
+  const rcl_timer_t * timer,
+  size_t index);
+
+/// Stop waiting on the client at the given index of a persistent wait set.
+/**
+ * This function behaves exactly the same as for subscriptions.
+ * \see rcl_wait_set_disable_subscription
+ */
+RCL_PUBLIC
+RCL_WARN_UNUSED
+rcl_ret_t
+rcl_wait_set_disable_client(rcl_wait_set_t * wait_set, size_t index);
+
+/// Wait again on a client disabled with rcl_wait_set_disable_client().
+/**
+ * This function behaves exactly the same as for subscriptions.
+ * \see rcl_wait_set_enable_subscription
+ */
+RCL_PUBLIC
+RCL_WARN_UNUSED
+rcl_ret_t
+rcl_wait_set_enable_client(
+  rcl_wait_set_t * wait_set,
+  const rcl_client_t * client,
+  size_t index);
+
+/// Stop waiting on the service at the given index of a persistent wait set.
+/**
+ * This function behaves exactly the same as for subscriptions.
+ * \see rcl_wait_set_disable_subscription
+ */
+RCL_PUBLIC
+RCL_WARN_UNUSED
+rcl_ret_t
+rcl_wait_set_disable_service(rcl_wait_set_t * wait_set, size_t index);
+
+/// Wait again on a service disabled with rcl_wait_set_disable_service().
+/**
+ * This function behaves exactly the same as for subscriptions.
+ * \see rcl_wait_set_enable_subscription
+ */
+RCL_PUBLIC
+RCL_WARN_UNUSED
+rcl_ret_t
+rcl_wait_set_enable_service(
+  rcl_wait_set_t * wait_set,
+  const rcl_service_t * service,
+  size_t index);
+
 /// Block until the wait set is ready or until the timeout has been exceeded.
 /**
  * This function will collect the items in the rcl_wait_set_t and pass them
@@ -345,6 +743,26 @@ rcl_wait_set_add_service(
  * For subscriptions this means there are messages that can be taken.
  * For guard conditions this means the guard condition was triggered.
  *
+ * The readiness of each item is also written to the matching flag in the
+ * `ready` member of the wait set.
+ * If the wait set is persistent, see rcl_wait_set_set_persistent(), the items
+ * are always left untouched and the `ready` flags are the only output, so the
+ * wait set can be passed to this function again without being cleared and
+ * filled again:
+ *
+ * ```c
+ * ret = rcl_wait_set_set_persistent(&wait_set, true);
+ * // ... error handling, then add the entities only once
+ * do {
+ *   ret = rcl_wait(&wait_set, RCL_MS_TO_NS(1000));
+ *   // ... error handling
+ *   for (size_t i = 0; i < wait_set.ready.number_of_ready_subscriptions; ++i) {
+ *     size_t index = wait_set.ready.subscription_indices[i];
+ *     // wait_set.subscriptions[index] is ready...
+ *   }
+ * } while(check_some_condition());
+ * ```
+ *
  * Expected usage:
  *
  * ```c
@@ -408,6 +826,18 @@ rcl_wait_set_add_service(
  * comes first.
  * Passing a timeout struct with uninitialized memory is undefined behavior.
  *
+ * Timers end the wait at the earliest next call time plus slack of any of
+ * them, see rcl_timer_set_slack(), and every timer due by then is ready.
+ *
+ * If the wait set contains only timers and a timeout applies, nothing but the
+ * timeout can end the wait, so this function sleeps without calling into the
+ * middleware on platforms which support it.
+ * Likewise, on Linux, guard conditions created with the `local_only` option
+ * are waited on through their eventfd when the wait set holds nothing but
+ * such guard conditions and timers.
+ * The pending trigger of a local guard condition is consumed by the call to
+ * rcl_wait() which reports it as ready.
+ *
  * This function is thread-safe for unique wait sets with unique contents.
  * This function cannot operate on the same wait set in multiple threads, and
  * the wait sets may not share content.
@@ -0,0 +1,379 @@
+// Copyright 2018 Open Source Robotics Foundation, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef RCL__WORK_STEALING_EXECUTOR_H_
+#define RCL__WORK_STEALING_EXECUTOR_H_
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+#include <stddef.h>
+
+#include "rcl/allocator.h"
+#include "rcl/executor.h"
+#include "rcl/macros.h"
+#include "rcl/types.h"
+#include "rcl/visibility_control.h"
+
+struct rcl_work_stealing_executor_impl_t;
+
+/// Multi-threaded executor which spreads work over several worker threads.
+/**
+ * The entities are assigned round-robin, per type, to one shard per worker.
+ * Each shard has its own persistent wait set, which only its worker waits on,
+ * and a lock-free deque into which the worker pushes the entities found ready.
+ * A worker takes work from the bottom of its own deque, and when it runs out
+ * it steals from the top of the deques of the other workers before waiting.
+ *
+ * An entity is removed from the wait set of its shard as soon as it is found
+ * ready, and only added back by its worker after its callback has returned.
+ * Together with the deques handing each entity to a single worker, this means
+ * that an entity is never handled by two workers at the same time, so each
+ * message, request, response and timer tick is handled at most once, and the
+ * message storage of an entity is never shared between workers.
+ *
+ * rcl does not create threads, the caller runs each worker by calling
+ * rcl_work_stealing_executor_spin() or rcl_work_stealing_executor_spin_some()
+ * with a distinct worker index from its own thread.
+ */
+typedef struct rcl_work_stealing_executor_t
+{
+  struct rcl_work_stealing_executor_impl_t * impl;
+} rcl_work_stealing_executor_t;
+
+/// Return a rcl_work_stealing_executor_t struct with members set to `NULL`.
+RCL_PUBLIC
+RCL_WARN_UNUSED
+rcl_work_stealing_executor_t
+rcl_get_zero_initialized_work_stealing_executor(void);
+
+/// Initialize a work stealing executor.
+/**
+ * The numbers of entities are the maximum for the whole executor, and are
+ * divided evenly between the workers.
+ * Like rcl_executor_t, entities cannot be removed once added.
+ *
+ * Expected usage:
+ *
+ * ```c
+ * #include <rcl/work_stealing_executor.h>
+ *
+ * rcl_work_stealing_executor_t executor = rcl_get_zero_initialized_work_stealing_executor();
+ * rcl_ret_t ret = rcl_work_stealing_executor_init(
+ *   &executor, number_of_workers, 16, 0, 0, 0, 0, rcl_get_default_allocator());
+ * // ... error handling, then add entities
+ * ret = rcl_work_stealing_executor_add_subscription(&executor, &sub, &msg, on_msg, NULL);
+ * // ... then in each of the number_of_workers threads, with its own worker_index:
+ * ret = rcl_work_stealing_executor_spin(&executor, worker_index, RCL_MS_TO_NS(100));
+ * // ... once all threads have been joined:
+ * ret = rcl_work_stealing_executor_fini(&executor);
+ * ```
+ *
+ * <hr>
+ * Attribute          | Adherence
+ * ------------------ | -------------
+ * Allocates Memory   | Yes
+ * Thread-Safe        | No
+ * Uses Atomics       | Yes
+ * Lock-Free          | Yes
+ *
+ * \param[inout] executor the executor struct to be initialized
+ * \param[in] number_of_workers number of worker threads, at least one
+ * \param[in] number_of_subscriptions maximum number of subscriptions
+ * \param[in] number_of_guard_conditions maximum number of guard conditions
+ * \param[in] number_of_timers maximum number of timers
+ * \param[in] number_of_clients maximum number of clients
+ * \param[in] number_of_services maximum number of services
+ * \param[in] allocator the allocator to use for the executor and its wait sets
+ * \return `RCL_RET_OK` if the executor was initialized successfully, or
+ * \return `RCL_RET_ALREADY_INIT` if the executor is not zero initialized, or
+ * \return `RCL_RET_NOT_INIT` if rcl_init() has not been called, or
+ * \return `RCL_RET_INVALID_ARGUMENT` if any arguments are invalid, or
+ * \return `RCL_RET_BAD_ALLOC` if allocating memory failed, or
+ * \return `RCL_RET_ERROR` if an unspecified error occurs.
+ */
+RCL_PUBLIC
+RCL_WARN_UNUSED
+rcl_ret_t
+rcl_work_stealing_executor_init(
+  rcl_work_stealing_executor_t * executor,
+  size_t number_of_workers,
+  size_t number_of_subscriptions,
+  size_t number_of_guard_conditions,
+  size_t number_of_timers,
+  size_t number_of_clients,
+  size_t number_of_services,
+  rcl_allocator_t allocator);
+
+/// Finalize a work stealing executor.
+/**
+ * No worker may be spinning the executor anymore.
+ * Calling this function on a zero initialized executor does nothing.
+ *
+ * <hr>
+ * Attribute          | Adherence
+ * ------------------ | -------------
+ * Allocates Memory   | Yes
+ * Thread-Safe        | No
+ * Uses Atomics       | No
+ * Lock-Free          | Yes
+ *
+ * \param[inout] executor the executor struct to be finalized
+ * \return `RCL_RET_OK` if the finalization was successful, or
+ * \return `RCL_RET_INVALID_ARGUMENT` if any arguments are invalid, or
+ * \return `RCL_RET_ERROR` if an unspecified error occurs.
+ */
+RCL_PUBLIC
+RCL_WARN_UNUSED
+rcl_ret_t
+rcl_work_stealing_executor_fini(rcl_work_stealing_executor_t * executor);
+
+/// Add a subscription, see rcl_executor_add_subscription().
+/**
+ * Entities must be added before any worker starts spinning.
+ *
+ * <hr>
+ * Attribute          | Adherence
+ * ------------------ | -------------
+ * Allocates Memory   | No
+ * Thread-Safe        | No
+ * Uses Atomics       | Yes
+ * Lock-Free          | Yes
+ *
+ * \param[inout] executor the executor to add the subscription to
+ * \param[in] subscription the subscription to be added
+ * \param[in] message storage for the messages taken from the subscription
+ * \param[in] callback the function called with each message
+ * \param[in] context opaque pointer passed to the callback, may be `NULL`
+ * \return `RCL_RET_OK` if the subscription was added successfully, or
+ * \return `RCL_RET_INVALID_ARGUMENT` if any arguments are invalid, or
+ * \return `RCL_RET_EXECUTOR_INVALID` if the executor is zero initialized, or
+ * \return `RCL_RET_WAIT_SET_FULL` if the executor holds the maximum number of subscriptions, or
+ * \return `RCL_RET_ERROR` if an unspecified error occurs.
+ */
+RCL_PUBLIC
+RCL_WARN_UNUSED
+rcl_ret_t
+rcl_work_stealing_executor_add_subscription(
+  rcl_work_stealing_executor_t * executor,
+  const rcl_subscription_t * subscription,
+  void * message,
+  rcl_executor_subscription_callback_t callback,
+  void * context);
+
+/// Add a timer, see rcl_executor_add_timer().
+/**
+ * Entities must be added before any worker starts spinning.
+ *
+ * <hr>
+ * Attribute          | Adherence
+ * ------------------ | -------------
+ * Allocates Memory   | No
+ * Thread-Safe        | No
+ * Uses Atomics       | Yes
+ * Lock-Free          | Yes
+ *
+ * \param[inout] executor the executor to add the timer to
+ * \param[in] timer the timer to be added
+ * \return `RCL_RET_OK` if the timer was added successfully, or
+ * \return `RCL_RET_INVALID_ARGUMENT` if any arguments are invalid, or
+ * \return `RCL_RET_EXECUTOR_INVALID` if the executor is zero initialized, or
+ * \return `RCL_RET_WAIT_SET_FULL` if the executor holds the maximum number of timers, or
+ * \return `RCL_RET_ERROR` if an unspecified error occurs.
+ */
+RCL_PUBLIC
+RCL_WARN_UNUSED
+rcl_ret_t
+rcl_work_stealing_executor_add_timer(
+  rcl_work_stealing_executor_t * executor,
+  const rcl_timer_t * timer);
+
+/// Add a guard condition, see rcl_executor_add_guard_condition().
+/**
+ * Entities must be added before any worker starts spinning.
+ *
+ * <hr>
+ * Attribute          | Adherence
+ * ------------------ | -------------
+ * Allocates Memory   | No
+ * Thread-Safe        | No
+ * Uses Atomics       | Yes
+ * Lock-Free          | Yes
+ *
+ * \param[inout] executor the executor to add the guard condition to
+ * \param[in] guard_condition the guard condition to be added
+ * \param[in] callback the function called when the guard condition is triggered, or `NULL`
+ * \param[in] context opaque pointer passed to the callback, may be `NULL`
+ * \return `RCL_RET_OK` if the guard condition was added successfully, or
+ * \return `RCL_RET_INVALID_ARGUMENT` if any arguments are invalid, or
+ * \return `RCL_RET_EXECUTOR_INVALID` if the executor is zero initialized, or
+ * \return `RCL_RET_WAIT_SET_FULL` if the executor holds the maximum number of guard
+ *   conditions, or
+ * \return `RCL_RET_ERROR` if an unspecified error occurs.
+ */
+RCL_PUBLIC
+RCL_WARN_UNUSED
+rcl_ret_t
+rcl_work_stealing_executor_add_guard_condition(
+  rcl_work_stealing_executor_t * executor,
+  const rcl_guard_condition_t * guard_condition,
+  rcl_executor_guard_condition_callback_t callback,
+  void * context);
+
+/// Add a client, see rcl_executor_add_client().
+/**
+ * Entities must be added before any worker starts spinning.
+ *
+ * <hr>
+ * Attribute          | Adherence
+ * ------------------ | -------------
+ * Allocates Memory   | No
+ * Thread-Safe        | No
+ * Uses Atomics       | Yes
+ * Lock-Free          | Yes
+ *
+ * \param[inout] executor the executor to add the client to
+ * \param[in] client the client to be added
+ * \param[in] response storage for the responses taken by the client
+ * \param[in] callback the function called with each response
+ * \param[in] context opaque pointer passed to the callback, may be `NULL`
+ * \return `RCL_RET_OK` if the client was added successfully, or
+ * \return `RCL_RET_INVALID_ARGUMENT` if any arguments are invalid, or
+ * \return `RCL_RET_EXECUTOR_INVALID` if the executor is zero initialized, or
+ * \return `RCL_RET_WAIT_SET_FULL` if the executor holds the maximum number of clients, or
+ * \return `RCL_RET_ERROR` if an unspecified error occurs.
+ */
+RCL_PUBLIC
+RCL_WARN_UNUSED
+rcl_ret_t
+rcl_work_stealing_executor_add_client(
+  rcl_work_stealing_executor_t * executor,
+  const rcl_client_t * client,
+  void * response,
+  rcl_executor_client_callback_t callback,
+  void * context);
+
+/// Add a service, see rcl_executor_add_service().
+/**
+ * Entities must be added before any worker starts spinning.
+ *
+ * <hr>
+ * Attribute          | Adherence
+ * ------------------ | -------------
+ * Allocates Memory   | No
+ * Thread-Safe        | No
+ * Uses Atomics       | Yes
+ * Lock-Free          | Yes
+ *
+ * \param[inout] executor the executor to add the service to
+ * \param[in] service the service to be added
+ * \param[in] request storage for the requests taken by the service
+ * \param[in] response storage for the responses sent by the service
+ * \param[in] callback the function called with each request
+ * \param[in] context opaque pointer passed to the callback, may be `NULL`
+ * \return `RCL_RET_OK` if the service was added successfully, or
+ * \return `RCL_RET_INVALID_ARGUMENT` if any arguments are invalid, or
+ * \return `RCL_RET_EXECUTOR_INVALID` if the executor is zero initialized, or
+ * \return `RCL_RET_WAIT_SET_FULL` if the executor holds the maximum number of services, or
+ * \return `RCL_RET_ERROR` if an unspecified error occurs.
+ */
+RCL_PUBLIC
+RCL_WARN_UNUSED
+rcl_ret_t
+rcl_work_stealing_executor_add_service(
+  rcl_work_stealing_executor_t * executor,
+  const rcl_service_t * service,
+  void * request,
+  void * response,
+  rcl_executor_service_callback_t callback,
+  void * context);
+
+/// Handle one piece of work as the given worker, waiting for some if needed.
+/**
+ * The worker first takes work from its own deque, then tries to steal from
+ * the other workers, and only if there is no work at all it waits on the wait
+ * set of its shard, with the given timeout.
+ * The entities found ready are queued in its deque, and if there are several
+ * of them, idle workers are woken up so they can steal some.
+ *
+ * A callback which fails to take its message, e.g. because there was none
+ * after all, is skipped silently.
+ *
+ * <hr>
+ * Attribute          | Adherence
+ * ------------------ | -------------
+ * Allocates Memory   | No [1]
+ * Thread-Safe        | Yes [2]
+ * Uses Atomics       | Yes
+ * Lock-Free          | Yes [3]
+ * <i>[1] the middleware may allocate while taking messages</i>
+ * <i>[2] for distinct worker indexes only</i>
+ * <i>[3] except for the wait itself, if `atomic_is_lock_free()` returns true for
+ *   `atomic_int_least64_t` and `atomic_uintptr_t`</i>
+ *
+ * \param[inout] executor the executor to be spun
+ * \param[in] worker_index index of the calling worker, less than the number of workers
+ * \param[in] timeout the duration to wait for work, in nanoseconds
+ * \return `RCL_RET_OK` if some work was handled or the worker was woken up, or
+ * \return `RCL_RET_TIMEOUT` if nothing became ready before the timeout, or
+ * \return `RCL_RET_INVALID_ARGUMENT` if any arguments are invalid, or
+ * \return `RCL_RET_EXECUTOR_INVALID` if the executor is zero initialized, or
+ * \return `RCL_RET_ERROR` if an unspecified error occurs.
+ */
+RCL_PUBLIC
+RCL_WARN_UNUSED
+rcl_ret_t
+rcl_work_stealing_executor_spin_some(
+  rcl_work_stealing_executor_t * executor,
+  size_t worker_index,
+  int64_t timeout);
+
+/// Run the given worker until rcl is shut down.
+/**
+ * This calls rcl_work_stealing_executor_spin_some() with the given timeout for
+ * as long as rcl_ok() returns true.
+ *
+ * <hr>
+ * Attribute          | Adherence
+ * ------------------ | -------------
+ * Allocates Memory   | No [1]
+ * Thread-Safe        | Yes [2]
+ * Uses Atomics       | Yes
+ * Lock-Free          | Yes
+ * <i>[1] the middleware may allocate while taking messages</i>
+ * <i>[2] for distinct worker indexes only</i>
+ *
+ * \param[inout] executor the executor to be spun
+ * \param[in] worker_index index of the calling worker, less than the number of workers
+ * \param[in] timeout the duration of each wait for work, in nanoseconds
+ * \return `RCL_RET_OK` if rcl was shut down, or
+ * \return `RCL_RET_INVALID_ARGUMENT` if any arguments are invalid, or
+ * \return `RCL_RET_EXECUTOR_INVALID` if the executor is zero initialized, or
+ * \return `RCL_RET_ERROR` if an unspecified error occurs.
+ */
+RCL_PUBLIC
+RCL_WARN_UNUSED
+rcl_ret_t
+rcl_work_stealing_executor_spin(
+  rcl_work_stealing_executor_t * executor,
+  size_t worker_index,
+  int64_t timeout);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif  // RCL__WORK_STEALING_EXECUTOR_H_
@@ -22,6 +22,18 @@ extern "C"
 
 #include "rcl/types.h"
 
+/// Log a debug message from a path that runs once per published or taken message.
+/* Per message logging costs a severity check on every call even when it is
+ * disabled, so it is compiled out unless RCL_ENABLE_HOT_PATH_LOGGING is set.
+ * This covers publishing and taking, including the batch and loaned message calls.
+ */
+#ifdef RCL_ENABLE_HOT_PATH_LOGGING
+# include "rcutils/logging_macros.h"
+# define RCL_HOT_PATH_LOG_DEBUG(...) RCUTILS_LOG_DEBUG_NAMED(ROS_PACKAGE_NAME, __VA_ARGS__)
+#else
+# define RCL_HOT_PATH_LOG_DEBUG(...)
+#endif
+
 /// Retrieve the value of the given environment variable if it exists, or "".
 /* The returned cstring is only valid until the next time this function is
  * called, because it is a direct pointer to the static storage.
@@ -0,0 +1,392 @@
+// Copyright 2018 Open Source Robotics Foundation, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+#include "rcl/executor.h"
+
+#include <string.h>
+
+#include "rcl/error_handling.h"
+#include "rcl/rcl.h"
+#include "rcl/wait.h"
+#include "rcutils/logging_macros.h"
+
+typedef struct rcl_executor_subscription_entry_t
+{
+  void * message;
+  rcl_executor_subscription_callback_t callback;
+  void * context;
+} rcl_executor_subscription_entry_t;
+
+typedef struct rcl_executor_guard_condition_entry_t
+{
+  rcl_executor_guard_condition_callback_t callback;
+  void * context;
+} rcl_executor_guard_condition_entry_t;
+
+typedef struct rcl_executor_client_entry_t
+{
+  void * response;
+  rcl_executor_client_callback_t callback;
+  void * context;
+} rcl_executor_client_entry_t;
+
+typedef struct rcl_executor_service_entry_t
+{
+  void * request;
+  void * response;
+  rcl_executor_service_callback_t callback;
+  void * context;
+} rcl_executor_service_entry_t;
+
+typedef struct rcl_executor_impl_t
+{
+  // persistent wait set, its slots are indexed like the dispatch tables below
+  rcl_wait_set_t wait_set;
+  rcl_executor_subscription_entry_t * subscriptions;
+  size_t number_of_subscriptions;
+  rcl_executor_guard_condition_entry_t * guard_conditions;
+  size_t number_of_guard_conditions;
+  rcl_executor_client_entry_t * clients;
+  size_t number_of_clients;
+  rcl_executor_service_entry_t * services;
+  size_t number_of_services;
+  rcl_allocator_t allocator;
+} rcl_executor_impl_t;
+
+rcl_executor_t
+rcl_get_zero_initialized_executor()
+{
+  static rcl_executor_t null_executor = {0};
+  return null_executor;
+}
+
+static void
+__executor_clean_up(rcl_executor_t * executor)
+{
+  rcl_executor_impl_t * impl = executor->impl;
+  rcl_allocator_t allocator = impl->allocator;
+  allocator.deallocate(impl->subscriptions, allocator.state);
+  allocator.deallocate(impl->guard_conditions, allocator.state);
+  allocator.deallocate(impl->clients, allocator.state);
+  allocator.deallocate(impl->services, allocator.state);
+  allocator.deallocate(impl, allocator.state);
+  executor->impl = NULL;
+}
+
+// Allocate a dispatch table, returning true on success or if none is needed.
+static bool
+__executor_allocate_table(void ** table, size_t entry_size, size_t count, rcl_allocator_t allocator)
+{
+  *table = NULL;
+  if (0 == count) {
+    return true;
+  }
+  *table = allocator.allocate(entry_size * count, allocator.state);
+  if (!*table) {
+    return false;
+  }
+  memset(*table, 0, entry_size * count);
+  return true;
+}
+
+rcl_ret_t
+rcl_executor_init(
+  rcl_executor_t * executor,
+  size_t number_of_subscriptions,
+  size_t number_of_guard_conditions,
+  size_t number_of_timers,
+  size_t number_of_clients,
+  size_t number_of_services,
+  rcl_allocator_t allocator)
+{
+  RCL_CHECK_ALLOCATOR_WITH_MSG(&allocator, "invalid allocator", return RCL_RET_INVALID_ARGUMENT);
+  RCL_CHECK_ARGUMENT_FOR_NULL(executor, RCL_RET_INVALID_ARGUMENT, allocator);
+  if (executor->impl) {
+    RCL_SET_ERROR_MSG("executor already initialized, or memory was uninitialized", allocator);
+    return RCL_RET_ALREADY_INIT;
+  }
+  RCUTILS_LOG_DEBUG_NAMED(
+    ROS_PACKAGE_NAME, "Initializing executor with "
+    "'%zu' subscriptions, '%zu' guard conditions, '%zu' timers, '%zu' clients, '%zu' services",
+    number_of_subscriptions, number_of_guard_conditions, number_of_timers, number_of_clients,
+    number_of_services)
+  rcl_executor_impl_t * impl = (rcl_executor_impl_t *)allocator.allocate(
+    sizeof(rcl_executor_impl_t), allocator.state);
+  RCL_CHECK_FOR_NULL_WITH_MSG(
+    impl, "allocating memory failed", return RCL_RET_BAD_ALLOC, allocator);
+  memset(impl, 0, sizeof(rcl_executor_impl_t));
+  impl->allocator = allocator;
+  executor->impl = impl;
+  if (
+    !__executor_allocate_table(
+      (void **)&impl->subscriptions, sizeof(rcl_executor_subscription_entry_t),
+      number_of_subscriptions, allocator) ||
+    !__executor_allocate_table(
+      (void **)&impl->guard_conditions, sizeof(rcl_executor_guard_condition_entry_t),
+      number_of_guard_conditions, allocator) ||
+    !__executor_allocate_table(
+      (void **)&impl->clients, sizeof(rcl_executor_client_entry_t),
+      number_of_clients, allocator) ||
+    !__executor_allocate_table(
+      (void **)&impl->services, sizeof(rcl_executor_service_entry_t),
+      number_of_services, allocator))
+  {
+    __executor_clean_up(executor);
+    RCL_SET_ERROR_MSG("allocating memory failed", allocator);
+    return RCL_RET_BAD_ALLOC;
+  }
+  impl->wait_set = rcl_get_zero_initialized_wait_set();
+  rcl_ret_t ret = rcl_wait_set_init(
+    &impl->wait_set, number_of_subscriptions, number_of_guard_conditions, number_of_timers,
+    number_of_clients, number_of_services, allocator);
+  if (ret != RCL_RET_OK) {
+    __executor_clean_up(executor);
+    return ret;  // The rcl error state should already be set.
+  }
+  // The wait set is only ever added to, so it can keep its entities between waits.
+  ret = rcl_wait_set_set_persistent(&impl->wait_set, true);
+  if (ret != RCL_RET_OK) {
+    rcl_ret_t fini_ret = rcl_wait_set_fini(&impl->wait_set);
+    (void)fini_ret;
+    __executor_clean_up(executor);
+    return ret;  // The rcl error state should already be set.
+  }
+  return RCL_RET_OK;
+}
+
+rcl_ret_t
+rcl_executor_fini(rcl_executor_t * executor)
+{
+  RCL_CHECK_ARGUMENT_FOR_NULL(executor, RCL_RET_INVALID_ARGUMENT, rcl_get_default_allocator());
+  if (!executor->impl) {
+    return RCL_RET_OK;
+  }
+  rcl_ret_t ret = rcl_wait_set_fini(&executor->impl->wait_set);
+  __executor_clean_up(executor);
+  return ret;
+}
+
+#define EXECUTOR_CHECK(executor) \
+  RCL_CHECK_ARGUMENT_FOR_NULL(executor, RCL_RET_INVALID_ARGUMENT, rcl_get_default_allocator()); \
+  if (!executor->impl) { \
+    RCL_SET_ERROR_MSG("executor is invalid", rcl_get_default_allocator()); \
+    return RCL_RET_EXECUTOR_INVALID; \
+  }
+
+rcl_ret_t
+rcl_executor_add_subscription(
+  rcl_executor_t * executor,
+  const rcl_subscription_t * subscription,
+  void * message,
+  rcl_executor_subscription_callback_t callback,
+  void * context)
+{
+  EXECUTOR_CHECK(executor)
+  rcl_executor_impl_t * impl = executor->impl;
+  RCL_CHECK_ARGUMENT_FOR_NULL(message, RCL_RET_INVALID_ARGUMENT, impl->allocator);
+  RCL_CHECK_ARGUMENT_FOR_NULL(callback, RCL_RET_INVALID_ARGUMENT, impl->allocator);
+  // Entities are never removed, so the next free slot of the wait set is the
+  // index of the entry in the dispatch table.
+  size_t index = impl->number_of_subscriptions;
+  rcl_ret_t ret = rcl_wait_set_add_subscription(&impl->wait_set, subscription);
+  if (ret != RCL_RET_OK) {
+    return ret;  // The rcl error state should already be set.
+  }
+  impl->subscriptions[index].message = message;
+  impl->subscriptions[index].callback = callback;
+  impl->subscriptions[index].context = context;
+  impl->number_of_subscriptions++;
+  return RCL_RET_OK;
+}
+
+rcl_ret_t
+rcl_executor_add_timer(rcl_executor_t * executor, const rcl_timer_t * timer)
+{
+  EXECUTOR_CHECK(executor)
+  // The callback is held by the timer itself.
+  return rcl_wait_set_add_timer(&executor->impl->wait_set, timer);
+}
+
+rcl_ret_t
+rcl_executor_add_guard_condition(
+  rcl_executor_t * executor,
+  const rcl_guard_condition_t * guard_condition,
+  rcl_executor_guard_condition_callback_t callback,
+  void * context)
+{
+  EXECUTOR_CHECK(executor)
+  rcl_executor_impl_t * impl = executor->impl;
+  size_t index = impl->number_of_guard_conditions;
+  rcl_ret_t ret = rcl_wait_set_add_guard_condition(&impl->wait_set, guard_condition);
+  if (ret != RCL_RET_OK) {
+    return ret;  // The rcl error state should already be set.
+  }
+  impl->guard_conditions[index].callback = callback;
+  impl->guard_conditions[index].context = context;
+  impl->number_of_guard_conditions++;
+  return RCL_RET_OK;
+}
+
+rcl_ret_t
+rcl_executor_add_client(
+  rcl_executor_t * executor,
+  const rcl_client_t * client,
+  void * response,
+  rcl_executor_client_callback_t callback,
+  void * context)
+{
+  EXECUTOR_CHECK(executor)
+  rcl_executor_impl_t * impl = executor->impl;
+  RCL_CHECK_ARGUMENT_FOR_NULL(response, RCL_RET_INVALID_ARGUMENT, impl->allocator);
+  RCL_CHECK_ARGUMENT_FOR_NULL(callback, RCL_RET_INVALID_ARGUMENT, impl->allocator);
+  size_t index = impl->number_of_clients;
+  rcl_ret_t ret = rcl_wait_set_add_client(&impl->wait_set, client);
+  if (ret != RCL_RET_OK) {
+    return ret;  // The rcl error state should already be set.
+  }
+  impl->clients[index].response = response;
+  impl->clients[index].callback = callback;
+  impl->clients[index].context = context;
+  impl->number_of_clients++;
+  return RCL_RET_OK;
+}
+
+rcl_ret_t
+rcl_executor_add_service(
+  rcl_executor_t * executor,
+  const rcl_service_t * service,
+  void * request,
+  void * response,
+  rcl_executor_service_callback_t callback,
+  void * context)
+{
+  EXECUTOR_CHECK(executor)
+  rcl_executor_impl_t * impl = executor->impl;
+  RCL_CHECK_ARGUMENT_FOR_NULL(request, RCL_RET_INVALID_ARGUMENT, impl->allocator);
+  RCL_CHECK_ARGUMENT_FOR_NULL(response, RCL_RET_INVALID_ARGUMENT, impl->allocator);
+  RCL_CHECK_ARGUMENT_FOR_NULL(callback, RCL_RET_INVALID_ARGUMENT, impl->allocator);
+  size_t index = impl->number_of_services;
+  rcl_ret_t ret = rcl_wait_set_add_service(&impl->wait_set, service);
+  if (ret != RCL_RET_OK) {
+    return ret;  // The rcl error state should already be set.
+  }
+  impl->services[index].request = request;
+  impl->services[index].response = response;
+  impl->services[index].callback = callback;
+  impl->services[index].context = context;
+  impl->number_of_services++;
+  return RCL_RET_OK;
+}
+
+static rcl_ret_t
+__executor_dispatch(rcl_executor_t * executor)
+{
+  rcl_executor_impl_t * impl = executor->impl;
+  const rcl_wait_set_t * wait_set = &impl->wait_set;
+  const rcl_wait_set_ready_t * ready = &wait_set->ready;
+  rcl_ret_t ret = RCL_RET_OK;
+  size_t i;
+  for (i = 0; i < ready->number_of_ready_timers; ++i) {
+    ret = rcl_timer_call((rcl_timer_t *)wait_set->timers[ready->timer_indices[i]]);
+    if (ret != RCL_RET_OK && ret != RCL_RET_TIMER_CANCELED) {
+      return ret;  // The rcl error state should already be set.
+    }
+  }
+  for (i = 0; i < ready->number_of_ready_subscriptions; ++i) {
+    size_t index = ready->subscription_indices[i];
+    const rcl_executor_subscription_entry_t * entry = &impl->subscriptions[index];
+    ret = rcl_take(wait_set->subscriptions[index], entry->message, NULL);
+    if (ret == RCL_RET_SUBSCRIPTION_TAKE_FAILED) {
+      continue;
+    }
+    if (ret != RCL_RET_OK) {
+      return ret;  // The rcl error state should already be set.
+    }
+    entry->callback(entry->message, entry->context);
+  }
+  for (i = 0; i < ready->number_of_ready_services; ++i) {
+    size_t index = ready->service_indices[i];
+    const rcl_executor_service_entry_t * entry = &impl->services[index];
+    rmw_request_id_t request_header;
+    ret = rcl_take_request(wait_set->services[index], &request_header, entry->request);
+    if (ret == RCL_RET_SERVICE_TAKE_FAILED) {
+      continue;
+    }
+    if (ret != RCL_RET_OK) {
+      return ret;  // The rcl error state should already be set.
+    }
+    entry->callback(&request_header, entry->request, entry->response, entry->context);
+    ret = rcl_send_response(wait_set->services[index], &request_header, entry->response);
+    if (ret != RCL_RET_OK) {
+      return ret;  // The rcl error state should already be set.
+    }
+  }
+  for (i = 0; i < ready->number_of_ready_clients; ++i) {
+    size_t index = ready->client_indices[i];
+    const rcl_executor_client_entry_t * entry = &impl->clients[index];
+    rmw_request_id_t request_header;
+    ret = rcl_take_response(wait_set->clients[index], &request_header, entry->response);
+    if (ret == RCL_RET_CLIENT_TAKE_FAILED) {
+      continue;
+    }
+    if (ret != RCL_RET_OK) {
+      return ret;  // The rcl error state should already be set.
+    }
+    entry->callback(&request_header, entry->response, entry->context);
+  }
+  for (i = 0; i < ready->number_of_ready_guard_conditions; ++i) {
+    const rcl_executor_guard_condition_entry_t * entry =
+      &impl->guard_conditions[ready->guard_condition_indices[i]];
+    if (entry->callback) {
+      entry->callback(entry->context);
+    }
+  }
+  return RCL_RET_OK;
+}
+
+rcl_ret_t
+rcl_executor_spin_some(rcl_executor_t * executor, int64_t timeout)
+{
+  EXECUTOR_CHECK(executor)
+  rcl_ret_t ret = rcl_wait(&executor->impl->wait_set, timeout);
+  if (ret != RCL_RET_OK) {
+    return ret;  // The rcl error state should already be set.
+  }
+  return __executor_dispatch(executor);
+}
+
+rcl_ret_t
+rcl_executor_spin(rcl_executor_t * executor, int64_t timeout)
+{
+  EXECUTOR_CHECK(executor)
+  while (rcl_ok()) {
+    rcl_ret_t ret = rcl_executor_spin_some(executor, timeout);
+    if (ret == RCL_RET_TIMEOUT) {
+      continue;
+    }
+    if (ret != RCL_RET_OK) {
+      return ret;  // The rcl error state should already be set.
+    }
+  }
+  return RCL_RET_OK;
+}
+
+#ifdef __cplusplus
+}
+#endif
@@ -19,6 +19,14 @@ extern "C"
 
 #include "rcl/guard_condition.h"
 
+#include <stdint.h>
+#if defined(__linux__)
+#include <sys/eventfd.h>
+#include <unistd.h>
+#endif  // defined(__linux__)
+
+#include "./guard_condition_impl.h"
+#include "./stdatomic_helper.h"
 #include "rcl/error_handling.h"
 #include "rcl/rcl.h"
 #include "rmw/error_handling.h"
@@ -29,6 +37,12 @@ typedef struct rcl_guard_condition_impl_t
   rmw_guard_condition_t * rmw_handle;
   bool allocated_rmw_guard_condition;
   rcl_guard_condition_options_t options;
+  // set by a trigger and cleared by the wait which reports it, local_only only
+  atomic_bool triggered;
+  // eventfd signaled when the flag gets set, or -1
+  int event_fd;
+  // rmw guard condition created on demand for a local_only guard condition
+  atomic_uintptr_t rmw_bridge;
 } rcl_guard_condition_impl_t;
 
 rcl_guard_condition_t
@@ -61,6 +75,10 @@ __rcl_guard_condition_init_from_rmw_impl(
     RCL_SET_ERROR_MSG("rcl_init() has not been called", *allocator);
     return RCL_RET_NOT_INIT;
   }
+  if (rmw_guard_condition && options.local_only) {
+    RCL_SET_ERROR_MSG("a local only guard condition cannot use an rmw guard condition", *allocator);
+    return RCL_RET_INVALID_ARGUMENT;
+  }
   // Allocate space for the guard condition impl.
   guard_condition->impl = (rcl_guard_condition_impl_t *)allocator->allocate(
     sizeof(rcl_guard_condition_impl_t), allocator->state);
@@ -68,8 +86,24 @@ __rcl_guard_condition_init_from_rmw_impl(
     RCL_SET_ERROR_MSG("allocating memory failed", *allocator);
     return RCL_RET_BAD_ALLOC;
   }
+  atomic_init(&guard_condition->impl->triggered, false);
+  atomic_init(&guard_condition->impl->rmw_bridge, (uintptr_t)0);
+  guard_condition->impl->event_fd = -1;
   // Create the rmw guard condition.
-  if (rmw_guard_condition) {
+  if (options.local_only) {
+    // The rmw guard condition is only created when it is needed.
+    guard_condition->impl->rmw_handle = NULL;
+    guard_condition->impl->allocated_rmw_guard_condition = false;
+#if defined(__linux__)
+    guard_condition->impl->event_fd = eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK);
+    if (guard_condition->impl->event_fd < 0) {
+      allocator->deallocate(guard_condition->impl, allocator->state);
+      guard_condition->impl = NULL;
+      RCL_SET_ERROR_MSG("failed to create eventfd", *allocator);
+      return RCL_RET_ERROR;
+    }
+#endif  // defined(__linux__)
+  } else if (rmw_guard_condition) {
     // If given, just assign (cast away const).
     guard_condition->impl->rmw_handle = (rmw_guard_condition_t *)rmw_guard_condition;
     guard_condition->impl->allocated_rmw_guard_condition = false;
@@ -123,6 +157,17 @@ rcl_guard_condition_fini(rcl_guard_condition_t * guard_condition)
         result = RCL_RET_ERROR;
       }
     }
+    rmw_guard_condition_t * rmw_bridge =
+      (rmw_guard_condition_t *)rcl_atomic_load_uintptr_t(&guard_condition->impl->rmw_bridge);
+    if (rmw_bridge && rmw_destroy_guard_condition(rmw_bridge) != RMW_RET_OK) {
+      RCL_SET_ERROR_MSG(rmw_get_error_string_safe(), allocator);
+      result = RCL_RET_ERROR;
+    }
+#if defined(__linux__)
+    if (guard_condition->impl->event_fd >= 0) {
+      close(guard_condition->impl->event_fd);
+    }
+#endif  // defined(__linux__)
     allocator.deallocate(guard_condition->impl, allocator.state);
     guard_condition->impl = NULL;
   }
@@ -135,9 +180,43 @@ rcl_guard_condition_get_default_options()
   // !!! MAKE SURE THAT CHANGES TO THESE DEFAULTS ARE REFLECTED IN THE HEADER DOC STRING
   static rcl_guard_condition_options_t default_options;
   default_options.allocator = rcl_get_default_allocator();
+  default_options.local_only = false;
   return default_options;
 }
 
+// Return the rmw guard condition of a local guard condition, creating it if needed.
+static rmw_guard_condition_t *
+__rcl_guard_condition_get_rmw_bridge(const rcl_guard_condition_t * guard_condition)
+{
+  rcl_guard_condition_impl_t * impl = guard_condition->impl;
+  uintptr_t rmw_bridge = rcl_atomic_load_uintptr_t(&impl->rmw_bridge);
+  if (rmw_bridge) {
+    return (rmw_guard_condition_t *)rmw_bridge;
+  }
+  rmw_guard_condition_t * new_rmw_bridge = rmw_create_guard_condition();
+  if (!new_rmw_bridge) {
+    RCL_SET_ERROR_MSG(rmw_get_error_string_safe(), impl->options.allocator);
+    return NULL;
+  }
+  if (!rcl_atomic_compare_exchange_strong_uintptr_t(
+      &impl->rmw_bridge, &rmw_bridge, (uintptr_t)new_rmw_bridge))
+  {
+    // Another thread was faster, use its rmw guard condition instead.
+    rmw_ret_t ret = rmw_destroy_guard_condition(new_rmw_bridge);
+    (void)ret;
+    return (rmw_guard_condition_t *)rmw_bridge;
+  }
+  // A trigger which happened before the rmw guard condition was published may
+  // not have reached it, so it is triggered here on behalf of a pending trigger.
+  if (rcl_atomic_load_bool(&impl->triggered)) {
+    if (rmw_trigger_guard_condition(new_rmw_bridge) != RMW_RET_OK) {
+      RCL_SET_ERROR_MSG(rmw_get_error_string_safe(), impl->options.allocator);
+      return NULL;
+    }
+  }
+  return new_rmw_bridge;
+}
+
 rcl_ret_t
 rcl_trigger_guard_condition(rcl_guard_condition_t * guard_condition)
 {
@@ -145,6 +224,27 @@ rcl_trigger_guard_condition(rcl_guard_condition_t * guard_condition)
   if (!options) {
     return RCL_RET_INVALID_ARGUMENT;  // error already set
   }
+  if (options->local_only) {
+    rcl_guard_condition_impl_t * impl = guard_condition->impl;
+    if (rcl_atomic_exchange_bool(&impl->triggered, true)) {
+      return RCL_RET_OK;  // Already pending, coalesce with the previous trigger.
+    }
+#if defined(__linux__)
+    uint64_t increment = 1;
+    if (write(impl->event_fd, &increment, sizeof(increment)) < 0) {
+      RCL_SET_ERROR_MSG("failed to signal eventfd", options->allocator);
+      return RCL_RET_ERROR;
+    }
+#endif  // defined(__linux__)
+    // The rmw guard condition is only signaled if a wait set ever needed it.
+    rmw_guard_condition_t * rmw_bridge =
+      (rmw_guard_condition_t *)rcl_atomic_load_uintptr_t(&impl->rmw_bridge);
+    if (rmw_bridge && rmw_trigger_guard_condition(rmw_bridge) != RMW_RET_OK) {
+      RCL_SET_ERROR_MSG(rmw_get_error_string_safe(), options->allocator);
+      return RCL_RET_ERROR;
+    }
+    return RCL_RET_OK;
+  }
   // Trigger the guard condition.
   if (rmw_trigger_guard_condition(guard_condition->impl->rmw_handle) != RMW_RET_OK) {
     RCL_SET_ERROR_MSG(rmw_get_error_string_safe(), options->allocator);
@@ -173,9 +273,59 @@ rcl_guard_condition_get_rmw_handle(const rcl_guard_condition_t * guard_condition
   if (!options) {
     return NULL;  // error already set
   }
+  if (options->local_only) {
+    return __rcl_guard_condition_get_rmw_bridge(guard_condition);
+  }
   return guard_condition->impl->rmw_handle;
 }
 
+bool
+rcl_guard_condition_is_local(const rcl_guard_condition_t * guard_condition)
+{
+  return guard_condition->impl->options.local_only;
+}
+
+bool
+rcl_guard_condition_is_triggered(const rcl_guard_condition_t * guard_condition)
+{
+  return rcl_atomic_load_bool(&guard_condition->impl->triggered);
+}
+
+bool
+rcl_guard_condition_take_trigger(const rcl_guard_condition_t * guard_condition)
+{
+  rcl_guard_condition_impl_t * impl = guard_condition->impl;
+  if (!rcl_atomic_exchange_bool(&impl->triggered, false)) {
+    return false;
+  }
+#if defined(__linux__)
+  // Nonblocking, it fails with EAGAIN if a concurrent wait drained it already.
+  uint64_t count = 0;
+  ssize_t ret = read(impl->event_fd, &count, sizeof(count));
+  (void)ret;
+#endif  // defined(__linux__)
+  return true;
+}
+
+void
+rcl_guard_condition_drain_event_fd(const rcl_guard_condition_t * guard_condition)
+{
+#if defined(__linux__)
+  // Nonblocking, it fails with EAGAIN if there is nothing left to drain.
+  uint64_t count = 0;
+  ssize_t ret = read(guard_condition->impl->event_fd, &count, sizeof(count));
+  (void)ret;
+#else
+  (void)guard_condition;
+#endif  // defined(__linux__)
+}
+
+int
+rcl_guard_condition_get_event_fd(const rcl_guard_condition_t * guard_condition)
+{
+  return guard_condition->impl->event_fd;
+}
+
 #ifdef __cplusplus
 }
 #endif
@@ -0,0 +1,67 @@
+// Copyright 2018 Open Source Robotics Foundation, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef RCL__GUARD_CONDITION_IMPL_H_
+#define RCL__GUARD_CONDITION_IMPL_H_
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+#include <stdbool.h>
+
+#include "rcl/guard_condition.h"
+
+/// Return true if the guard condition was created with the `local_only` option.
+/* The guard condition must be valid. */
+bool
+rcl_guard_condition_is_local(const rcl_guard_condition_t * guard_condition);
+
+/// Return true if the local guard condition has a pending trigger.
+/* The trigger is left pending, see rcl_guard_condition_take_trigger(). */
+bool
+rcl_guard_condition_is_triggered(const rcl_guard_condition_t * guard_condition);
+
+/// Consume the pending trigger of a local guard condition.
+/* Return true if the guard condition was triggered since the last call.
+ * The eventfd of the guard condition is drained after the flag is cleared.
+ * A trigger racing with this call may still signal the eventfd after the
+ * drain, with the flag already cleared, see rcl_guard_condition_drain_event_fd().
+ */
+bool
+rcl_guard_condition_take_trigger(const rcl_guard_condition_t * guard_condition);
+
+/// Drain the eventfd of a local guard condition which polled readable.
+/* The eventfd can be left readable without a pending trigger, by a trigger
+ * racing with rcl_guard_condition_take_trigger(), so a wait which saw it
+ * readable drains it before taking the trigger, instead of being woken up
+ * by it again and again.
+ * A trigger which is drained here still has its flag set, so it is not lost.
+ */
+void
+rcl_guard_condition_drain_event_fd(const rcl_guard_condition_t * guard_condition);
+
+/// Return the eventfd signaled when the local guard condition is triggered.
+/* Return -1 if the platform has no eventfd, in which case the guard condition
+ * can only be waited on through its on demand rmw guard condition.
+ */
+int
+rcl_guard_condition_get_event_fd(const rcl_guard_condition_t * guard_condition);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif  // RCL__GUARD_CONDITION_IMPL_H_
@@ -0,0 +1,674 @@
+// Copyright 2018 Open Source Robotics Foundation, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+#include "./intra_process.h"
+
+#include <string.h>
+
+#include "rcl/error_handling.h"
+#include "rcl/rcl.h"
+#include "rcutils/logging_macros.h"
+#include "rcutils/strdup.h"
+#include "rcutils/time.h"
+#include "rmw/error_handling.h"
+#include "rmw/rmw.h"
+
+#include "./message_pool.h"
+#include "./mutex.h"
+#include "./stdatomic_helper.h"
+
+// Depth of the ring of a subscription whose history does not bound it.
+#define RCL_INTRA_PROCESS_UNBOUNDED_DEPTH 1024u
+// Period after which a publisher counts the subscribers of the middleware again.
+#define RCL_INTRA_PROCESS_SUBSCRIBER_COUNT_PERIOD RCUTILS_MS_TO_NS(100)
+
+typedef struct rcl_intra_process_topic_t rcl_intra_process_topic_t;
+
+typedef struct rcl_intra_process_slot_t
+{
+  // position of the slot in the ring while it is free, and one more once it holds a message
+  atomic_uint_least64_t sequence;
+  atomic_uintptr_t message;
+} rcl_intra_process_slot_t;
+
+struct rcl_intra_process_subscription_t
+{
+  rcl_intra_process_topic_t * topic;
+  // bounded ring of shared messages, after Dmitry Vyukov's multi-producer multi-consumer queue
+  rcl_intra_process_slot_t * slots;
+  uint64_t mask;
+  atomic_uint_least64_t enqueue_position;
+  atomic_uint_least64_t dequeue_position;
+  // messages dropped from the full ring before being taken
+  atomic_uint_least64_t number_of_dropped_messages;
+  // local guard condition, triggered for each queued message
+  rcl_guard_condition_t guard_condition;
+  rcl_allocator_t allocator;
+  rcl_intra_process_subscription_t * next;
+};
+
+struct rcl_intra_process_publisher_t
+{
+  rcl_intra_process_topic_t * topic;
+  rmw_publisher_t * rmw_handle;
+  const rmw_node_t * rmw_node;
+  rmw_gid_t gid;
+  // result of the last count of the subscribers of the middleware, which holds until the
+  // linked subscriptions change or the count expires
+  atomic_bool has_other_subscribers;
+  atomic_uint_least64_t counted_generation;
+  atomic_int_least64_t count_expiry;
+  rcl_allocator_t allocator;
+  rcl_intra_process_publisher_t * next;
+};
+
+struct rcl_intra_process_topic_t
+{
+  uint64_t instance_id;
+  const rosidl_message_type_support_t * type_support;
+  char * name;
+  // messages exchanged on the topic, which can outlive the publisher of each of them
+  rcl_message_pool_t messages;
+  rcl_intra_process_publisher_t * publishers;
+  rcl_intra_process_subscription_t * subscriptions;
+  size_t number_of_subscriptions;
+  // incremented each time a subscription is linked or unlinked
+  uint64_t subscriptions_generation;
+  // held while a thread uses or changes the publishers and subscriptions
+  rcl_mutex_t lock;
+  rcl_allocator_t allocator;
+  rcl_intra_process_topic_t * next;
+};
+
+// Topics with intra-process publishers or subscriptions, which are only changed
+// while __rcl_intra_process_topics_lock is held.
+static rcl_intra_process_topic_t * __rcl_intra_process_topics = NULL;
+static rcl_mutex_t __rcl_intra_process_topics_lock = RCL_MUTEX_INITIALIZER;
+
+// Find or create the topic, with the topics locked.
+static rcl_intra_process_topic_t *
+_intra_process_get_topic(
+  const char * topic_name,
+  const rosidl_message_type_support_t * type_support,
+  const rcl_allocator_t * allocator,
+  rcl_ret_t * ret)
+{
+  uint64_t instance_id = rcl_get_instance_id();
+  rcl_intra_process_topic_t * topic;
+  for (topic = __rcl_intra_process_topics; NULL != topic; topic = topic->next) {
+    if (
+      topic->instance_id == instance_id && topic->type_support == type_support &&
+      strcmp(topic->name, topic_name) == 0)
+    {
+      return topic;
+    }
+  }
+  topic = (rcl_intra_process_topic_t *)allocator->zero_allocate(
+    1u, sizeof(rcl_intra_process_topic_t), allocator->state);
+  RCL_CHECK_FOR_NULL_WITH_MSG(
+    topic, "allocating memory failed", *ret = RCL_RET_BAD_ALLOC; return NULL, *allocator);
+  topic->name = rcutils_strdup(topic_name, *allocator);
+  if (NULL == topic->name) {
+    RCL_SET_ERROR_MSG("allocating memory failed", *allocator)
+    allocator->deallocate(topic, allocator->state);
+    *ret = RCL_RET_BAD_ALLOC;
+    return NULL;
+  }
+  *ret = rcl_message_pool_init(&(topic->messages), type_support, 0u, true, allocator);
+  if (RCL_RET_OK != *ret) {
+    // The rcl error state should already be set.
+    allocator->deallocate(topic->name, allocator->state);
+    allocator->deallocate(topic, allocator->state);
+    return NULL;
+  }
+  if (rcl_mutex_init(&(topic->lock)) != RCL_RET_OK) {
+    RCL_SET_ERROR_MSG("initializing the topic lock failed", *allocator)
+    rcl_ret_t fini_ret = rcl_message_pool_fini(&(topic->messages));
+    (void)fini_ret;
+    allocator->deallocate(topic->name, allocator->state);
+    allocator->deallocate(topic, allocator->state);
+    *ret = RCL_RET_ERROR;
+    return NULL;
+  }
+  topic->instance_id = instance_id;
+  topic->type_support = type_support;
+  topic->allocator = *allocator;
+  topic->next = __rcl_intra_process_topics;
+  __rcl_intra_process_topics = topic;
+  return topic;
+}
+
+// Remove the topic if nothing uses it anymore, with the topics locked.
+static void
+_intra_process_put_topic(rcl_intra_process_topic_t * topic)
+{
+  if (NULL != topic->publishers || NULL != topic->subscriptions) {
+    return;
+  }
+  rcl_intra_process_topic_t ** link = &__rcl_intra_process_topics;
+  while (*link != topic) {
+    link = &((*link)->next);
+  }
+  *link = topic->next;
+  if (rcl_message_pool_fini(&(topic->messages)) != RCL_RET_OK) {
+    // The topic is leaked with its pool, so the messages can still be released.
+    RCUTILS_LOG_ERROR_NAMED(
+      ROS_PACKAGE_NAME, "intra-process messages of topic '%s' are still loaned", topic->name)
+    rcl_reset_error();
+    return;
+  }
+  rcl_mutex_fini(&(topic->lock));
+  rcl_allocator_t allocator = topic->allocator;
+  allocator.deallocate(topic->name, allocator.state);
+  allocator.deallocate(topic, allocator.state);
+}
+
+// Push a message to the ring of the subscription, or return false if it is full.
+static bool
+_intra_process_push(rcl_intra_process_subscription_t * subscription, void * message)
+{
+  uint64_t position = rcl_atomic_load_uint64_t(&(subscription->enqueue_position));
+  for (;;) {
+    rcl_intra_process_slot_t * slot = &(subscription->slots[position & subscription->mask]);
+    int64_t difference = (int64_t)(rcl_atomic_load_uint64_t(&(slot->sequence)) - position);
+    if (0 == difference) {
+      // On failure, the exchange loads the current position.
+      if (rcl_atomic_compare_exchange_strong_uint_least64_t(
+          &(subscription->enqueue_position), &position, position + 1u))
+      {
+        rcl_atomic_store(&(slot->message), (uintptr_t)message);
+        rcl_atomic_store(&(slot->sequence), position + 1u);
+        return true;
+      }
+    } else if (difference < 0) {
+      return false;
+    } else {
+      position = rcl_atomic_load_uint64_t(&(subscription->enqueue_position));
+    }
+  }
+}
+
+// Pop the oldest message from the ring of the subscription, or return NULL if it is empty.
+static void *
+_intra_process_pop(rcl_intra_process_subscription_t * subscription)
+{
+  uint64_t position = rcl_atomic_load_uint64_t(&(subscription->dequeue_position));
+  for (;;) {
+    rcl_intra_process_slot_t * slot = &(subscription->slots[position & subscription->mask]);
+    int64_t difference =
+      (int64_t)(rcl_atomic_load_uint64_t(&(slot->sequence)) - (position + 1u));
+    if (0 == difference) {
+      if (rcl_atomic_compare_exchange_strong_uint_least64_t(
+          &(subscription->dequeue_position), &position, position + 1u))
+      {
+        void * message = (void *)rcl_atomic_load_uintptr_t(&(slot->message));
+        rcl_atomic_store(&(slot->sequence), position + subscription->mask + 1u);
+        return message;
+      }
+    } else if (difference < 0) {
+      return NULL;
+    } else {
+      position = rcl_atomic_load_uint64_t(&(subscription->dequeue_position));
+    }
+  }
+}
+
+// Queue a message for the subscription, dropping the oldest one if the ring is full.
+static void
+_intra_process_deliver(rcl_intra_process_subscription_t * subscription, void * message)
+{
+  rcl_message_pool_retain(message);
+  while (!_intra_process_push(subscription, message)) {
+    void * oldest = _intra_process_pop(subscription);
+    if (NULL != oldest) {
+      rcl_message_pool_release(oldest);
+      rcl_atomic_fetch_add_uint64_t(&(subscription->number_of_dropped_messages), 1u);
+    }
+  }
+  if (rcl_trigger_guard_condition(&(subscription->guard_condition)) != RCL_RET_OK) {
+    // The message is still queued, and is seen by the next wait which does not block.
+    rcl_reset_error();
+  }
+}
+
+// Return true if the middleware reports subscribers besides the linked subscriptions.
+/* The middleware is only asked again once the linked subscriptions changed, or
+ * the last count expired, which is when subscribers it discovered since then,
+ * e.g. in other processes, are taken into account.
+ */
+static bool
+_intra_process_has_other_subscribers(
+  rcl_intra_process_publisher_t * publisher,
+  size_t number_of_subscriptions,
+  uint64_t generation,
+  rcutils_time_point_value_t now)
+{
+  if (0u == number_of_subscriptions) {
+    return true;
+  }
+  // The stored generation is offset by one, so that zero means never counted.
+  if (
+    rcl_atomic_load_uint64_t(&(publisher->counted_generation)) == generation + 1u &&
+    now < rcl_atomic_load_int64_t(&(publisher->count_expiry)))
+  {
+    return rcl_atomic_load_bool(&(publisher->has_other_subscribers));
+  }
+  size_t count = 0u;
+  if (
+    rmw_count_subscribers(publisher->rmw_node, publisher->rmw_handle->topic_name, &count) !=
+    RMW_RET_OK)
+  {
+    // Publish through the middleware too, rather than risk losing messages.
+    rcl_reset_error();
+    return true;
+  }
+  bool has_other_subscribers = count > number_of_subscriptions;
+  rcl_atomic_store(&(publisher->has_other_subscribers), has_other_subscribers);
+  rcl_atomic_store(&(publisher->count_expiry), now + RCL_INTRA_PROCESS_SUBSCRIBER_COUNT_PERIOD);
+  rcl_atomic_store(&(publisher->counted_generation), generation + 1u);
+  return has_other_subscribers;
+}
+
+rcl_ret_t
+rcl_intra_process_publisher_init(
+  rcl_intra_process_publisher_t ** publisher,
+  const rcl_node_t * node,
+  rmw_publisher_t * rmw_publisher,
+  const rosidl_message_type_support_t * type_support,
+  const rcl_allocator_t * allocator)
+{
+  rcl_intra_process_publisher_t * local_publisher =
+    (rcl_intra_process_publisher_t *)allocator->zero_allocate(
+    1u, sizeof(rcl_intra_process_publisher_t), allocator->state);
+  RCL_CHECK_FOR_NULL_WITH_MSG(
+    local_publisher, "allocating memory failed", return RCL_RET_BAD_ALLOC, *allocator);
+  if (rmw_get_gid_for_publisher(rmw_publisher, &(local_publisher->gid)) != RMW_RET_OK) {
+    RCL_SET_ERROR_MSG(rmw_get_error_string_safe(), *allocator)
+    allocator->deallocate(local_publisher, allocator->state);
+    return RCL_RET_ERROR;
+  }
+  local_publisher->rmw_handle = rmw_publisher;
+  local_publisher->rmw_node = rcl_node_get_rmw_handle(node);
+  atomic_init(&(local_publisher->has_other_subscribers), true);
+  atomic_init(&(local_publisher->counted_generation), 0u);
+  atomic_init(&(local_publisher->count_expiry), 0);
+  local_publisher->allocator = *allocator;
+  rcl_ret_t ret = RCL_RET_OK;
+  rcl_mutex_lock(&__rcl_intra_process_topics_lock);
+  rcl_intra_process_topic_t * topic =
+    _intra_process_get_topic(rmw_publisher->topic_name, type_support, allocator, &ret);
+  if (NULL != topic) {
+    rcl_mutex_lock(&(topic->lock));
+    local_publisher->topic = topic;
+    local_publisher->next = topic->publishers;
+    topic->publishers = local_publisher;
+    rcl_mutex_unlock(&(topic->lock));
+  }
+  rcl_mutex_unlock(&__rcl_intra_process_topics_lock);
+  if (NULL == topic) {
+    allocator->deallocate(local_publisher, allocator->state);
+    return ret;  // The rcl error state should already be set.
+  }
+  *publisher = local_publisher;
+  return RCL_RET_OK;
+}
+
+void
+rcl_intra_process_publisher_fini(rcl_intra_process_publisher_t * publisher)
+{
+  rcl_intra_process_topic_t * topic = publisher->topic;
+  rcl_mutex_lock(&__rcl_intra_process_topics_lock);
+  rcl_mutex_lock(&(topic->lock));
+  rcl_intra_process_publisher_t ** link = &(topic->publishers);
+  while (*link != publisher) {
+    link = &((*link)->next);
+  }
+  *link = publisher->next;
+  rcl_mutex_unlock(&(topic->lock));
+  _intra_process_put_topic(topic);
+  rcl_mutex_unlock(&__rcl_intra_process_topics_lock);
+  rcl_allocator_t allocator = publisher->allocator;
+  allocator.deallocate(publisher, allocator.state);
+}
+
+rcl_ret_t
+rcl_intra_process_publisher_loan(rcl_intra_process_publisher_t * publisher, void ** message)
+{
+  return rcl_message_pool_loan(&(publisher->topic->messages), message);
+}
+
+rcl_ret_t
+rcl_intra_process_publisher_return(rcl_intra_process_publisher_t * publisher, void * message)
+{
+  return rcl_message_pool_return(&(publisher->topic->messages), message);
+}
+
+rcl_ret_t
+rcl_intra_process_publish(rcl_intra_process_publisher_t * publisher, void * message)
+{
+  rcl_intra_process_topic_t * topic = publisher->topic;
+  if (!rcl_message_pool_owns(&(topic->messages), message)) {
+    RCL_SET_ERROR_MSG("message is not loaned from this pool", rcl_get_default_allocator())
+    return RCL_RET_INVALID_ARGUMENT;
+  }
+  rmw_message_info_t * message_info = rcl_message_pool_get_message_info(message);
+  message_info->publisher_gid = publisher->gid;
+  message_info->from_intra_process = true;
+  // Lets the subscriptions measure the latency of the message.
+  rcutils_time_point_value_t now = 0;
+  if (rcutils_steady_time_now(&now) != RCUTILS_RET_OK) {
+    rcl_reset_error();
+    now = 0;
+  }
+  *rcl_message_pool_get_source_timestamp(message) = now;
+  // Subscriptions are not finalized while the topic is locked, so they can be triggered.
+  rcl_mutex_lock(&(topic->lock));
+  size_t number_of_subscriptions = topic->number_of_subscriptions;
+  uint64_t generation = topic->subscriptions_generation;
+  rcl_intra_process_subscription_t * subscription = topic->subscriptions;
+  for (; NULL != subscription; subscription = subscription->next) {
+    _intra_process_deliver(subscription, message);
+  }
+  rcl_mutex_unlock(&(topic->lock));
+  rcl_ret_t ret = RCL_RET_OK;
+  if (_intra_process_has_other_subscribers(publisher, number_of_subscriptions, generation, now)) {
+    if (rmw_publish(publisher->rmw_handle, message) != RMW_RET_OK) {
+      RCL_SET_ERROR_MSG(rmw_get_error_string_safe(), rcl_get_default_allocator());
+      ret = RCL_RET_ERROR;
+    }
+  }
+  rcl_message_pool_release(message);
+  return ret;
+}
+
+rcl_ret_t
+rcl_intra_process_publish_copy(rcl_intra_process_publisher_t * publisher, const void * message)
+{
+  rcl_intra_process_topic_t * topic = publisher->topic;
+  rcl_mutex_lock(&(topic->lock));
+  bool has_subscriptions = NULL != topic->subscriptions;
+  rcl_mutex_unlock(&(topic->lock));
+  if (!has_subscriptions) {
+    if (rmw_publish(publisher->rmw_handle, message) != RMW_RET_OK) {
+      RCL_SET_ERROR_MSG(rmw_get_error_string_safe(), rcl_get_default_allocator());
+      return RCL_RET_ERROR;
+    }
+    return RCL_RET_OK;
+  }
+  void * copy = NULL;
+  rcl_ret_t ret = rcl_message_pool_loan(&(topic->messages), &copy);
+  if (RCL_RET_OK != ret) {
+    RCL_SET_ERROR_MSG("allocating memory failed", rcl_get_default_allocator())
+    return ret;
+  }
+  ret = rcl_message_pool_copy(&(topic->messages), message, copy);
+  if (RCL_RET_OK != ret) {
+    // The rcl error state should already be set.
+    rcl_message_pool_release(copy);
+    return ret;
+  }
+  return rcl_intra_process_publish(publisher, copy);
+}
+
+rcl_ret_t
+rcl_intra_process_publish_serialized(
+  rcl_intra_process_publisher_t * publisher, const rmw_serialized_message_t * serialized_message)
+{
+  rcl_intra_process_topic_t * topic = publisher->topic;
+  rcl_mutex_lock(&(topic->lock));
+  bool has_subscriptions = NULL != topic->subscriptions;
+  rcl_mutex_unlock(&(topic->lock));
+  if (!has_subscriptions) {
+    rmw_ret_t ret = rmw_publish_serialized_message(publisher->rmw_handle, serialized_message);
+    if (ret != RMW_RET_OK) {
+      RCL_SET_ERROR_MSG(rmw_get_error_string_safe(), rcl_get_default_allocator());
+      return ret == RMW_RET_BAD_ALLOC ? RCL_RET_BAD_ALLOC : RCL_RET_ERROR;
+    }
+    return RCL_RET_OK;
+  }
+  // The linked subscriptions drop the messages of their publishers taken from the middleware.
+  void * message = NULL;
+  rcl_ret_t ret = rcl_message_pool_loan(&(topic->messages), &message);
+  if (RCL_RET_OK != ret) {
+    RCL_SET_ERROR_MSG("allocating memory failed", rcl_get_default_allocator())
+    return ret;
+  }
+  if (rmw_deserialize(serialized_message, topic->type_support, message) != RMW_RET_OK) {
+    RCL_SET_ERROR_MSG(rmw_get_error_string_safe(), rcl_get_default_allocator());
+    rcl_message_pool_release(message);
+    return RCL_RET_ERROR;
+  }
+  return rcl_intra_process_publish(publisher, message);
+}
+
+rcl_ret_t
+rcl_intra_process_subscription_init(
+  rcl_intra_process_subscription_t ** subscription,
+  rmw_subscription_t * rmw_subscription,
+  const rosidl_message_type_support_t * type_support,
+  const rmw_qos_profile_t * qos,
+  const rcl_allocator_t * allocator)
+{
+  size_t depth = qos->depth;
+  if (RMW_QOS_POLICY_HISTORY_KEEP_ALL == qos->history || 0u == depth) {
+    depth = RCL_INTRA_PROCESS_UNBOUNDED_DEPTH;
+  }
+  uint64_t size = 1u;
+  while (size < depth) {
+    size <<= 1u;
+  }
+  rcl_intra_process_subscription_t * local_subscription =
+    (rcl_intra_process_subscription_t *)allocator->zero_allocate(
+    1u, sizeof(rcl_intra_process_subscription_t), allocator->state);
+  RCL_CHECK_FOR_NULL_WITH_MSG(
+    local_subscription, "allocating memory failed", return RCL_RET_BAD_ALLOC, *allocator);
+  local_subscription->allocator = *allocator;
+  local_subscription->slots = (rcl_intra_process_slot_t *)allocator->allocate(
+    (size_t)size * sizeof(rcl_intra_process_slot_t), allocator->state);
+  if (NULL == local_subscription->slots) {
+    RCL_SET_ERROR_MSG("allocating memory failed", *allocator)
+    allocator->deallocate(local_subscription, allocator->state);
+    return RCL_RET_BAD_ALLOC;
+  }
+  uint64_t i;
+  for (i = 0; i < size; ++i) {
+    atomic_init(&(local_subscription->slots[i].sequence), i);
+    atomic_init(&(local_subscription->slots[i].message), (uintptr_t)NULL);
+  }
+  local_subscription->mask = size - 1u;
+  atomic_init(&(local_subscription->enqueue_position), 0u);
+  atomic_init(&(local_subscription->dequeue_position), 0u);
+  atomic_init(&(local_subscription->number_of_dropped_messages), 0u);
+  local_subscription->guard_condition = rcl_get_zero_initialized_guard_condition();
+  rcl_guard_condition_options_t guard_condition_options = rcl_guard_condition_get_default_options();
+  guard_condition_options.allocator = *allocator;
+  guard_condition_options.local_only = true;
+  rcl_ret_t ret =
+    rcl_guard_condition_init(&(local_subscription->guard_condition), guard_condition_options);
+  if (RCL_RET_OK != ret) {
+    // The rcl error state should already be set.
+    allocator->deallocate(local_subscription->slots, allocator->state);
+    allocator->deallocate(local_subscription, allocator->state);
+    return ret;
+  }
+  rcl_mutex_lock(&__rcl_intra_process_topics_lock);
+  rcl_intra_process_topic_t * topic =
+    _intra_process_get_topic(rmw_subscription->topic_name, type_support, allocator, &ret);
+  if (NULL != topic) {
+    rcl_mutex_lock(&(topic->lock));
+    local_subscription->topic = topic;
+    local_subscription->next = topic->subscriptions;
+    topic->subscriptions = local_subscription;
+    ++topic->number_of_subscriptions;
+    ++topic->subscriptions_generation;
+    rcl_mutex_unlock(&(topic->lock));
+  }
+  rcl_mutex_unlock(&__rcl_intra_process_topics_lock);
+  if (NULL == topic) {
+    // The rcl error state should already be set.
+    if (rcl_guard_condition_fini(&(local_subscription->guard_condition)) != RCL_RET_OK) {
+      RCUTILS_LOG_ERROR_NAMED(
+        ROS_PACKAGE_NAME, "failed to fini guard condition during error handling")
+    }
+    allocator->deallocate(local_subscription->slots, allocator->state);
+    allocator->deallocate(local_subscription, allocator->state);
+    return ret;
+  }
+  *subscription = local_subscription;
+  return RCL_RET_OK;
+}
+
+void
+rcl_intra_process_subscription_fini(rcl_intra_process_subscription_t * subscription)
+{
+  rcl_intra_process_topic_t * topic = subscription->topic;
+  rcl_mutex_lock(&__rcl_intra_process_topics_lock);
+  rcl_mutex_lock(&(topic->lock));
+  rcl_intra_process_subscription_t ** link = &(topic->subscriptions);
+  while (*link != subscription) {
+    link = &((*link)->next);
+  }
+  *link = subscription->next;
+  --topic->number_of_subscriptions;
+  ++topic->subscriptions_generation;
+  rcl_mutex_unlock(&(topic->lock));
+  void * message;
+  while (NULL != (message = _intra_process_pop(subscription))) {
+    rcl_message_pool_release(message);
+  }
+  _intra_process_put_topic(topic);
+  rcl_mutex_unlock(&__rcl_intra_process_topics_lock);
+  if (rcl_guard_condition_fini(&(subscription->guard_condition)) != RCL_RET_OK) {
+    RCUTILS_LOG_ERROR_NAMED(
+      ROS_PACKAGE_NAME, "failed to fini intra-process guard condition: %s",
+      rcl_get_error_string_safe())
+    rcl_reset_error();
+  }
+  rcl_allocator_t allocator = subscription->allocator;
+  allocator.deallocate(subscription->slots, allocator.state);
+  allocator.deallocate(subscription, allocator.state);
+}
+
+bool
+rcl_intra_process_subscription_take(
+  rcl_intra_process_subscription_t * subscription,
+  void ** message,
+  rmw_message_info_t * message_info,
+  int64_t * source_timestamp)
+{
+  void * taken = _intra_process_pop(subscription);
+  if (NULL == taken) {
+    return false;
+  }
+  if (NULL != message_info) {
+    *message_info = *rcl_message_pool_get_message_info(taken);
+  }
+  if (NULL != source_timestamp) {
+    *source_timestamp = *rcl_message_pool_get_source_timestamp(taken);
+  }
+  *message = taken;
+  return true;
+}
+
+rcl_ret_t
+rcl_intra_process_subscription_take_copy(
+  rcl_intra_process_subscription_t * subscription,
+  void * ros_message,
+  rmw_message_info_t * message_info,
+  int64_t * source_timestamp)
+{
+  void * message = NULL;
+  if (!rcl_intra_process_subscription_take(
+      subscription, &message, message_info, source_timestamp))
+  {
+    return RCL_RET_SUBSCRIPTION_TAKE_FAILED;
+  }
+  rcl_ret_t ret = rcl_message_pool_copy(&(subscription->topic->messages), message, ros_message);
+  rcl_message_pool_release(message);
+  return ret;
+}
+
+bool
+rcl_intra_process_subscription_owns(
+  const rcl_intra_process_subscription_t * subscription, const void * message)
+{
+  return rcl_message_pool_owns(&(subscription->topic->messages), message);
+}
+
+rcl_ret_t
+rcl_intra_process_subscription_return(
+  rcl_intra_process_subscription_t * subscription, void * message)
+{
+  return rcl_message_pool_return(&(subscription->topic->messages), message);
+}
+
+bool
+rcl_intra_process_subscription_is_duplicate(
+  const rcl_intra_process_subscription_t * subscription,
+  const rmw_message_info_t * message_info)
+{
+  rcl_intra_process_topic_t * topic = subscription->topic;
+  bool is_duplicate = false;
+  rcl_mutex_lock(&(topic->lock));
+  const rcl_intra_process_publisher_t * publisher = topic->publishers;
+  for (; NULL != publisher && !is_duplicate; publisher = publisher->next) {
+    if (
+      rmw_compare_gids_equal(&(publisher->gid), &(message_info->publisher_gid), &is_duplicate) !=
+      RMW_RET_OK)
+    {
+      // The gids are from different middlewares.
+      rcl_reset_error();
+      is_duplicate = false;
+    }
+  }
+  rcl_mutex_unlock(&(topic->lock));
+  return is_duplicate;
+}
+
+uint64_t
+rcl_intra_process_subscription_get_number_of_dropped_messages(
+  rcl_intra_process_subscription_t * subscription)
+{
+  return rcl_atomic_load_uint64_t(&(subscription->number_of_dropped_messages));
+}
+
+void
+rcl_intra_process_subscription_reset_number_of_dropped_messages(
+  rcl_intra_process_subscription_t * subscription)
+{
+  rcl_atomic_store(&(subscription->number_of_dropped_messages), 0u);
+}
+
+bool
+rcl_intra_process_subscription_has_messages(rcl_intra_process_subscription_t * subscription)
+{
+  return rcl_atomic_load_uint64_t(&(subscription->enqueue_position)) !=
+         rcl_atomic_load_uint64_t(&(subscription->dequeue_position));
+}
+
+const rcl_guard_condition_t *
+rcl_intra_process_subscription_get_guard_condition(
+  const rcl_intra_process_subscription_t * subscription)
+{
+  return &(subscription->guard_condition);
+}
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,181 @@
+// Copyright 2018 Open Source Robotics Foundation, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef RCL__INTRA_PROCESS_H_
+#define RCL__INTRA_PROCESS_H_
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "rcl/allocator.h"
+#include "rcl/guard_condition.h"
+#include "rcl/node.h"
+#include "rcl/types.h"
+#include "rmw/types.h"
+#include "rosidl_generator_c/message_type_support_struct.h"
+
+/// Intra-process side of a publisher created with the `intra_process` option.
+/* Publishers and subscriptions with the `intra_process` option are linked when
+ * they are created during the same rcl_init(), on the same remapped topic name
+ * and with the same type support.
+ * The messages they exchange come from a message pool shared by the topic, and
+ * a published message is handed to every linked subscription by pointer, with
+ * a reference count, instead of being serialized by the middleware.
+ */
+typedef struct rcl_intra_process_publisher_t rcl_intra_process_publisher_t;
+
+/// Intra-process side of a subscription created with the `intra_process` option.
+/* The subscription queues the messages of the linked publishers in a lock-free
+ * ring as deep as its history depth, rounded up to a power of two, which drops
+ * the oldest message when full, and counts it.
+ * Its local guard condition is triggered for each queued message.
+ */
+typedef struct rcl_intra_process_subscription_t rcl_intra_process_subscription_t;
+
+/// Link a publisher to the intra-process subscriptions of its topic.
+rcl_ret_t
+rcl_intra_process_publisher_init(
+  rcl_intra_process_publisher_t ** publisher,
+  const rcl_node_t * node,
+  rmw_publisher_t * rmw_publisher,
+  const rosidl_message_type_support_t * type_support,
+  const rcl_allocator_t * allocator);
+
+/// Unlink and free the publisher.
+void
+rcl_intra_process_publisher_fini(rcl_intra_process_publisher_t * publisher);
+
+/// Loan a message from the message pool of the topic.
+/* Fails with RCL_RET_BAD_ALLOC if memory cannot be allocated.
+ */
+rcl_ret_t
+rcl_intra_process_publisher_loan(rcl_intra_process_publisher_t * publisher, void ** message);
+
+/// Return a message loaned with rcl_intra_process_publisher_loan() without publishing it.
+/* Fails with RCL_RET_INVALID_ARGUMENT if the message is not loaned from the topic.
+ */
+rcl_ret_t
+rcl_intra_process_publisher_return(rcl_intra_process_publisher_t * publisher, void * message);
+
+/// Publish a message loaned with rcl_intra_process_publisher_loan(), which is released.
+/* The message is queued for each linked subscription, and is only published
+ * through the middleware if it reports more subscribers than the linked ones.
+ * That count is cached by the publisher until the linked subscriptions change,
+ * or for at most 100 milliseconds, so subscribers discovered by the middleware
+ * may miss the messages published meanwhile.
+ * Fails with RCL_RET_INVALID_ARGUMENT if the message is not from the topic.
+ */
+rcl_ret_t
+rcl_intra_process_publish(rcl_intra_process_publisher_t * publisher, void * message);
+
+/// Publish a copy of a message, the same way as rcl_intra_process_publish().
+/* The message is only copied if there are linked subscriptions.
+ */
+rcl_ret_t
+rcl_intra_process_publish_copy(rcl_intra_process_publisher_t * publisher, const void * message);
+
+/// Publish a serialized message, deserialized the same way as rcl_intra_process_publish().
+/* The message is only deserialized if there are linked subscriptions, and is
+ * then published through the middleware as a deserialized message, if at all.
+ */
+rcl_ret_t
+rcl_intra_process_publish_serialized(
+  rcl_intra_process_publisher_t * publisher, const rmw_serialized_message_t * serialized_message);
+
+/// Link a subscription to the intra-process publishers of its topic.
+rcl_ret_t
+rcl_intra_process_subscription_init(
+  rcl_intra_process_subscription_t ** subscription,
+  rmw_subscription_t * rmw_subscription,
+  const rosidl_message_type_support_t * type_support,
+  const rmw_qos_profile_t * qos,
+  const rcl_allocator_t * allocator);
+
+/// Unlink and free the subscription, releasing the messages it did not take.
+void
+rcl_intra_process_subscription_fini(rcl_intra_process_subscription_t * subscription);
+
+/// Take the oldest queued message, which is shared with the other subscriptions.
+/* Return false if no message is queued.
+ * The message must not be modified, and is released with
+ * rcl_intra_process_subscription_return().
+ * The optional source_timestamp is the steady time the message was published
+ * at, or 0 if the steady clock could not be read.
+ */
+bool
+rcl_intra_process_subscription_take(
+  rcl_intra_process_subscription_t * subscription,
+  void ** message,
+  rmw_message_info_t * message_info,
+  int64_t * source_timestamp);
+
+/// Take a copy of the oldest queued message.
+/* Fails with RCL_RET_SUBSCRIPTION_TAKE_FAILED if no message is queued.
+ */
+rcl_ret_t
+rcl_intra_process_subscription_take_copy(
+  rcl_intra_process_subscription_t * subscription,
+  void * ros_message,
+  rmw_message_info_t * message_info,
+  int64_t * source_timestamp);
+
+/// Return true if the message comes from the message pool of the topic.
+bool
+rcl_intra_process_subscription_owns(
+  const rcl_intra_process_subscription_t * subscription, const void * message);
+
+/// Release a message taken with rcl_intra_process_subscription_take().
+/* Fails with RCL_RET_INVALID_ARGUMENT if the message is not loaned from the topic.
+ */
+rcl_ret_t
+rcl_intra_process_subscription_return(
+  rcl_intra_process_subscription_t * subscription, void * message);
+
+/// Return true if a message taken from the middleware was published by a linked publisher.
+/* Such a message was already queued for the subscription.
+ */
+bool
+rcl_intra_process_subscription_is_duplicate(
+  const rcl_intra_process_subscription_t * subscription,
+  const rmw_message_info_t * message_info);
+
+/// Return the number of messages dropped from the full ring of the subscription.
+uint64_t
+rcl_intra_process_subscription_get_number_of_dropped_messages(
+  rcl_intra_process_subscription_t * subscription);
+
+/// Set the number of dropped messages back to zero.
+void
+rcl_intra_process_subscription_reset_number_of_dropped_messages(
+  rcl_intra_process_subscription_t * subscription);
+
+/// Return true if a message is queued for the subscription.
+bool
+rcl_intra_process_subscription_has_messages(rcl_intra_process_subscription_t * subscription);
+
+/// Return the local guard condition triggered when a message is queued.
+const rcl_guard_condition_t *
+rcl_intra_process_subscription_get_guard_condition(
+  const rcl_intra_process_subscription_t * subscription);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif  // RCL__INTRA_PROCESS_H_
@@ -0,0 +1,269 @@
+// Copyright 2018 Open Source Robotics Foundation, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+#include "./message_latency.h"
+
+#include <string.h>
+
+#include "rcl/error_handling.h"
+#include "rcl/time.h"
+#include "rcutils/time.h"
+#include "rosidl_typesupport_introspection_c/field_types.h"
+#include "rosidl_typesupport_introspection_c/identifier.h"
+#include "rosidl_typesupport_introspection_c/message_introspection.h"
+
+typedef rosidl_typesupport_introspection_c__MessageMembers rcl_message_members_t;
+typedef rosidl_typesupport_introspection_c__MessageMember rcl_message_member_t;
+
+#define RCL_LATENCY_HISTOGRAM_SUB_BUCKETS (1 << RCL_LATENCY_HISTOGRAM_SIGNIFICANT_BITS)
+#define RCL_LATENCY_HISTOGRAM_HALF_SUB_BUCKETS (RCL_LATENCY_HISTOGRAM_SUB_BUCKETS / 2)
+
+// Return the field with the given name and type, or NULL if there is none.
+static const rcl_message_member_t *
+_find_member(const rcl_message_members_t * members, const char * name, uint8_t type_id)
+{
+  uint32_t i;
+  for (i = 0; i < members->member_count_; ++i) {
+    const rcl_message_member_t * member = &(members->members_[i]);
+    if (type_id == member->type_id_ && !member->is_array_ && 0 == strcmp(name, member->name_)) {
+      return member;
+    }
+  }
+  return NULL;
+}
+
+rcl_ret_t
+rcl_header_stamp_init(
+  rcl_header_stamp_t * header_stamp, const rosidl_message_type_support_t * type_support)
+{
+  header_stamp->is_valid = false;
+  const rosidl_message_type_support_t * introspection = get_message_typesupport_handle(
+    type_support, rosidl_typesupport_introspection_c__identifier);
+  if (NULL == introspection) {
+    RCL_SET_ERROR_MSG(
+      "message type has no introspection type support", rcl_get_default_allocator())
+    return RCL_RET_ERROR;
+  }
+  const rcl_message_member_t * header = _find_member(
+    (const rcl_message_members_t *)introspection->data, "header",
+    rosidl_typesupport_introspection_c__ROS_TYPE_MESSAGE);
+  if (NULL == header) {
+    return RCL_RET_OK;
+  }
+  const rcl_message_member_t * stamp = _find_member(
+    (const rcl_message_members_t *)header->members_->data, "stamp",
+    rosidl_typesupport_introspection_c__ROS_TYPE_MESSAGE);
+  if (NULL == stamp) {
+    return RCL_RET_OK;
+  }
+  const rcl_message_members_t * time = (const rcl_message_members_t *)stamp->members_->data;
+  const rcl_message_member_t * sec =
+    _find_member(time, "sec", rosidl_typesupport_introspection_c__ROS_TYPE_INT32);
+  const rcl_message_member_t * nanosec =
+    _find_member(time, "nanosec", rosidl_typesupport_introspection_c__ROS_TYPE_UINT32);
+  if (NULL == sec || NULL == nanosec) {
+    return RCL_RET_OK;
+  }
+  header_stamp->sec_offset = header->offset_ + stamp->offset_ + sec->offset_;
+  header_stamp->nanosec_offset = header->offset_ + stamp->offset_ + nanosec->offset_;
+  header_stamp->is_valid = true;
+  return RCL_RET_OK;
+}
+
+void
+rcl_header_stamp_set(const rcl_header_stamp_t * header_stamp, void * message, int64_t time)
+{
+  int32_t sec = (int32_t)RCL_NS_TO_S(time);
+  uint32_t nanosec = (uint32_t)(time % (1000LL * 1000LL * 1000LL));
+  memcpy((char *)message + header_stamp->sec_offset, &sec, sizeof(sec));
+  memcpy((char *)message + header_stamp->nanosec_offset, &nanosec, sizeof(nanosec));
+}
+
+bool
+rcl_header_stamp_get(const rcl_header_stamp_t * header_stamp, const void * message, int64_t * time)
+{
+  int32_t sec;
+  uint32_t nanosec;
+  memcpy(&sec, (const char *)message + header_stamp->sec_offset, sizeof(sec));
+  memcpy(&nanosec, (const char *)message + header_stamp->nanosec_offset, sizeof(nanosec));
+  if (0 == sec && 0u == nanosec) {
+    return false;
+  }
+  *time = RCL_S_TO_NS((int64_t)sec) + nanosec;
+  return true;
+}
+
+void
+rcl_message_latency_init(
+  rcl_message_latency_t * latency, const rcl_header_stamp_t * header_stamp)
+{
+  latency->header_stamp = *header_stamp;
+  atomic_init(&latency->number_of_samples, 0);
+  atomic_init(&latency->number_of_unstamped_messages, 0);
+  atomic_init(&latency->sum, 0);
+  atomic_init(&latency->min, INT64_MAX);
+  atomic_init(&latency->max, 0);
+  size_t i;
+  for (i = 0; i < RCL_LATENCY_HISTOGRAM_SIZE; ++i) {
+    atomic_init(&latency->histogram[i], 0);
+  }
+}
+
+// Return the histogram bucket of the given latency.
+static size_t
+_latency_bucket(int64_t latency)
+{
+  uint64_t value = (uint64_t)latency;
+  if (value < RCL_LATENCY_HISTOGRAM_SUB_BUCKETS) {
+    return (size_t)value;
+  }
+  // Shift the value until only the significant bits are left.
+  size_t shift = 0;
+  while (value >= RCL_LATENCY_HISTOGRAM_SUB_BUCKETS) {
+    value >>= 1;
+    ++shift;
+  }
+  size_t bucket = RCL_LATENCY_HISTOGRAM_SUB_BUCKETS +
+    (shift - 1) * RCL_LATENCY_HISTOGRAM_HALF_SUB_BUCKETS +
+    ((size_t)value - RCL_LATENCY_HISTOGRAM_HALF_SUB_BUCKETS);
+  return bucket < RCL_LATENCY_HISTOGRAM_SIZE ? bucket : RCL_LATENCY_HISTOGRAM_SIZE - 1;
+}
+
+// Return the largest latency which falls in the given bucket.
+static int64_t
+_latency_bucket_upper_bound(size_t bucket)
+{
+  if (bucket < RCL_LATENCY_HISTOGRAM_SUB_BUCKETS) {
+    return (int64_t)bucket;
+  }
+  size_t index = bucket - RCL_LATENCY_HISTOGRAM_SUB_BUCKETS;
+  size_t shift = index / RCL_LATENCY_HISTOGRAM_HALF_SUB_BUCKETS + 1;
+  int64_t value = (int64_t)(
+    index % RCL_LATENCY_HISTOGRAM_HALF_SUB_BUCKETS + RCL_LATENCY_HISTOGRAM_HALF_SUB_BUCKETS);
+  return ((value + 1) << shift) - 1;
+}
+
+void
+rcl_message_latency_record(
+  rcl_message_latency_t * latency, const void * message, int64_t source_timestamp)
+{
+  rcutils_time_point_value_t now;
+  int64_t stamp = source_timestamp;
+  rcutils_ret_t ret;
+  if (0 != stamp) {
+    ret = rcutils_steady_time_now(&now);
+  } else if (
+    latency->header_stamp.is_valid &&
+    rcl_header_stamp_get(&(latency->header_stamp), message, &stamp))
+  {
+    ret = rcutils_system_time_now(&now);
+  } else {
+    rcl_atomic_fetch_add_uint64_t(&latency->number_of_unstamped_messages, 1);
+    return;
+  }
+  if (RCUTILS_RET_OK != ret) {
+    rcl_reset_error();
+    rcl_atomic_fetch_add_uint64_t(&latency->number_of_unstamped_messages, 1);
+    return;
+  }
+  int64_t value = now > stamp ? now - stamp : 0;
+  rcl_atomic_fetch_add_uint64_t(&latency->number_of_samples, 1);
+  rcl_atomic_fetch_add_uint64_t(&latency->sum, (uint64_t)value);
+  int64_t min = rcl_atomic_load_int64_t(&latency->min);
+  while (value < min &&
+    !rcl_atomic_compare_exchange_strong_int_least64_t(&latency->min, &min, value))
+  {
+  }
+  int64_t max = rcl_atomic_load_int64_t(&latency->max);
+  while (value > max &&
+    !rcl_atomic_compare_exchange_strong_int_least64_t(&latency->max, &max, value))
+  {
+  }
+  rcl_atomic_fetch_add_uint64_t(&latency->histogram[_latency_bucket(value)], 1);
+}
+
+void
+rcl_message_latency_get(
+  rcl_message_latency_t * latency, rcl_subscription_latency_statistics_t * statistics)
+{
+  statistics->number_of_samples = rcl_atomic_load_uint64_t(&latency->number_of_samples);
+  statistics->number_of_unstamped_messages =
+    rcl_atomic_load_uint64_t(&latency->number_of_unstamped_messages);
+  uint64_t sum = rcl_atomic_load_uint64_t(&latency->sum);
+  if (0u == statistics->number_of_samples) {
+    statistics->min_latency = 0;
+    statistics->max_latency = 0;
+    statistics->mean_latency = 0;
+    return;
+  }
+  statistics->min_latency = rcl_atomic_load_int64_t(&latency->min);
+  statistics->max_latency = rcl_atomic_load_int64_t(&latency->max);
+  statistics->mean_latency = (int64_t)(sum / statistics->number_of_samples);
+}
+
+int64_t
+rcl_message_latency_get_percentile(rcl_message_latency_t * latency, double percentile)
+{
+  // The buckets are read once, so that the total matches the counts walked through.
+  uint64_t histogram[RCL_LATENCY_HISTOGRAM_SIZE];
+  uint64_t total = 0;
+  size_t i;
+  for (i = 0; i < RCL_LATENCY_HISTOGRAM_SIZE; ++i) {
+    histogram[i] = rcl_atomic_load_uint64_t(&latency->histogram[i]);
+    total += histogram[i];
+  }
+  if (0u == total) {
+    return 0;
+  }
+  uint64_t rank = (uint64_t)(percentile / 100.0 * (double)total + 0.5);
+  if (rank < 1u) {
+    rank = 1u;
+  } else if (rank > total) {
+    rank = total;
+  }
+  uint64_t count = 0;
+  for (i = 0; i < RCL_LATENCY_HISTOGRAM_SIZE - 1; ++i) {
+    count += histogram[i];
+    if (count >= rank) {
+      break;
+    }
+  }
+  // The bounds of the bucket are narrowed down by the extreme latencies.
+  int64_t value = _latency_bucket_upper_bound(i);
+  int64_t max = rcl_atomic_load_int64_t(&latency->max);
+  return value < max ? value : max;
+}
+
+void
+rcl_message_latency_reset(rcl_message_latency_t * latency)
+{
+  rcl_atomic_store(&latency->number_of_samples, 0);
+  rcl_atomic_store(&latency->number_of_unstamped_messages, 0);
+  rcl_atomic_store(&latency->sum, 0);
+  rcl_atomic_store(&latency->min, INT64_MAX);
+  rcl_atomic_store(&latency->max, 0);
+  size_t i;
+  for (i = 0; i < RCL_LATENCY_HISTOGRAM_SIZE; ++i) {
+    rcl_atomic_store(&latency->histogram[i], 0);
+  }
+}
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,119 @@
+// Copyright 2018 Open Source Robotics Foundation, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef RCL__MESSAGE_LATENCY_H_
+#define RCL__MESSAGE_LATENCY_H_
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "rcl/subscription.h"
+#include "rcl/types.h"
+#include "rosidl_generator_c/message_type_support_struct.h"
+
+#include "./stdatomic_helper.h"
+
+/// Location of the `header.stamp` field of a message type, like std_msgs/Header has.
+typedef struct rcl_header_stamp_t
+{
+  /// False if the message type has no such field.
+  bool is_valid;
+  size_t sec_offset;
+  size_t nanosec_offset;
+} rcl_header_stamp_t;
+
+/// Find the `header.stamp` field of a message type.
+/* The field is a builtin_interfaces/Time, with an int32 `sec` and an uint32
+ * `nanosec`, in a `header` field at the top level of the message.
+ * Fails with RCL_RET_ERROR if the type has no introspection type support.
+ */
+rcl_ret_t
+rcl_header_stamp_init(
+  rcl_header_stamp_t * header_stamp, const rosidl_message_type_support_t * type_support);
+
+/// Set the stamp of a message to a system time, in nanoseconds.
+void
+rcl_header_stamp_set(const rcl_header_stamp_t * header_stamp, void * message, int64_t time);
+
+/// Get the stamp of a message as a system time, in nanoseconds.
+/* Return false if the message is not stamped, i.e. its stamp is zero.
+ */
+bool
+rcl_header_stamp_get(const rcl_header_stamp_t * header_stamp, const void * message, int64_t * time);
+
+// The histogram keeps 5 significant bits: latencies under 32ns have a bucket
+// each, and every power of two above that is split in 16 buckets, up to 2^41ns.
+#define RCL_LATENCY_HISTOGRAM_SIGNIFICANT_BITS 5
+#define RCL_LATENCY_HISTOGRAM_SIZE 608
+
+/// Publish to take latencies of the messages of a subscription.
+/* Like an HDR histogram, the buckets have a constant relative width, so the
+ * percentiles are within about 6% of the recorded latencies at any scale,
+ * and recording is a few lock-free atomic operations.
+ */
+typedef struct rcl_message_latency_t
+{
+  /// Where to find the stamp in the messages, used when they have no source timestamp.
+  /** Only valid if the stamps are set by the publishers to the time they publish at. */
+  rcl_header_stamp_t header_stamp;
+  atomic_uint_least64_t number_of_samples;
+  atomic_uint_least64_t number_of_unstamped_messages;
+  atomic_uint_least64_t sum;
+  atomic_int_least64_t min;
+  atomic_int_least64_t max;
+  atomic_uint_least64_t histogram[RCL_LATENCY_HISTOGRAM_SIZE];
+} rcl_message_latency_t;
+
+/// Initialize the histogram, measuring messages from the given header stamp if it is valid.
+void
+rcl_message_latency_init(
+  rcl_message_latency_t * latency, const rcl_header_stamp_t * header_stamp);
+
+/// Record the latency of a message which was just taken.
+/* The latency is measured from the source timestamp, a steady time in
+ * nanoseconds, or if it is zero from the stamp of the message header, if the
+ * histogram was given one.
+ * Messages with neither are counted as unstamped.
+ * Negative latencies, with a stamp from a clock ahead of this one, count as zero.
+ */
+void
+rcl_message_latency_record(
+  rcl_message_latency_t * latency, const void * message, int64_t source_timestamp);
+
+/// Copy the counters, one by one.
+void
+rcl_message_latency_get(
+  rcl_message_latency_t * latency, rcl_subscription_latency_statistics_t * statistics);
+
+/// Return the smallest latency which the given percentage of the samples do not exceed.
+/* Return 0 if there are no samples.
+ */
+int64_t
+rcl_message_latency_get_percentile(rcl_message_latency_t * latency, double percentile);
+
+/// Set all the counters back to zero, messages taken concurrently may be counted or lost.
+void
+rcl_message_latency_reset(rcl_message_latency_t * latency);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif  // RCL__MESSAGE_LATENCY_H_
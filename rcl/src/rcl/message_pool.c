@@ -0,0 +1,581 @@
+// Copyright 2018 Open Source Robotics Foundation, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+#include "./message_pool.h"
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "rcl/error_handling.h"
+#include "rosidl_generator_c/string_functions.h"
+#include "rosidl_typesupport_introspection_c/field_types.h"
+#include "rosidl_typesupport_introspection_c/identifier.h"
+#include "rosidl_typesupport_introspection_c/message_introspection.h"
+
+typedef rosidl_typesupport_introspection_c__MessageMembers rcl_message_members_t;
+typedef rosidl_typesupport_introspection_c__MessageMember rcl_message_member_t;
+
+// Stored in front of each message, aligned for any message type.
+typedef union rcl_message_pool_header_t
+{
+  struct
+  {
+    rcl_message_pool_t * pool;
+    bool is_loaned;
+    // owners of the loaned message, which goes back to the pool when the last one releases it
+    atomic_uint_least64_t references;
+    // filled in by the owner which sets the content of the message
+    rmw_message_info_t message_info;
+    int64_t source_timestamp;
+  } info;
+  long double align_long_double;
+  void * align_pointer;
+  int64_t align_int64;
+} rcl_message_pool_header_t;
+
+#define _message_header(message) \
+  ((rcl_message_pool_header_t *)((char *)(message) - sizeof(rcl_message_pool_header_t)))
+
+// Layout shared by all the generated sequence types.
+typedef struct rcl_message_sequence_t
+{
+  void * data;
+  size_t size;
+  size_t capacity;
+} rcl_message_sequence_t;
+
+static bool
+_member_is_sequence(const rcl_message_member_t * member)
+{
+  return member->is_array_ && (0u == member->array_size_ || member->is_upper_bound_);
+}
+
+static const rcl_message_members_t *
+_member_get_members(const rcl_message_member_t * member)
+{
+  return (const rcl_message_members_t *)member->members_->data;
+}
+
+// Size of one element of the field, or 0 if the field type is not supported.
+static size_t
+_member_get_element_size(const rcl_message_member_t * member)
+{
+  switch (member->type_id_) {
+    case rosidl_typesupport_introspection_c__ROS_TYPE_FLOAT:
+      return sizeof(float);
+    case rosidl_typesupport_introspection_c__ROS_TYPE_DOUBLE:
+      return sizeof(double);
+    case rosidl_typesupport_introspection_c__ROS_TYPE_LONG_DOUBLE:
+      return sizeof(long double);
+    case rosidl_typesupport_introspection_c__ROS_TYPE_BOOLEAN:
+      return sizeof(bool);
+    case rosidl_typesupport_introspection_c__ROS_TYPE_CHAR:
+    case rosidl_typesupport_introspection_c__ROS_TYPE_OCTET:
+    case rosidl_typesupport_introspection_c__ROS_TYPE_UINT8:
+    case rosidl_typesupport_introspection_c__ROS_TYPE_INT8:
+      return sizeof(uint8_t);
+    case rosidl_typesupport_introspection_c__ROS_TYPE_UINT16:
+    case rosidl_typesupport_introspection_c__ROS_TYPE_INT16:
+      return sizeof(uint16_t);
+    case rosidl_typesupport_introspection_c__ROS_TYPE_UINT32:
+    case rosidl_typesupport_introspection_c__ROS_TYPE_INT32:
+      return sizeof(uint32_t);
+    case rosidl_typesupport_introspection_c__ROS_TYPE_UINT64:
+    case rosidl_typesupport_introspection_c__ROS_TYPE_INT64:
+      return sizeof(uint64_t);
+    case rosidl_typesupport_introspection_c__ROS_TYPE_STRING:
+      return sizeof(rosidl_generator_c__String);
+    case rosidl_typesupport_introspection_c__ROS_TYPE_MESSAGE:
+      return _member_get_members(member)->size_of_;
+    default:
+      return 0u;
+  }
+}
+
+static bool
+_message_init(const rcl_message_members_t * members, char * message);
+
+static void
+_message_fini(const rcl_message_members_t * members, char * message);
+
+// Initialize zeroed elements of a field, only strings and nested messages need it.
+static bool
+_elements_init(const rcl_message_member_t * member, char * elements, size_t count)
+{
+  size_t j;
+  if (rosidl_typesupport_introspection_c__ROS_TYPE_STRING == member->type_id_) {
+    rosidl_generator_c__String * strings = (rosidl_generator_c__String *)elements;
+    for (j = 0; j < count; ++j) {
+      if (!rosidl_generator_c__String__init(&strings[j])) {
+        return false;
+      }
+    }
+  } else if (rosidl_typesupport_introspection_c__ROS_TYPE_MESSAGE == member->type_id_) {
+    const rcl_message_members_t * nested = _member_get_members(member);
+    for (j = 0; j < count; ++j) {
+      if (!_message_init(nested, elements + j * nested->size_of_)) {
+        return false;
+      }
+    }
+  }
+  return true;
+}
+
+// Free what the elements of a field allocated, which is also safe on zeroed elements.
+static void
+_elements_fini(const rcl_message_member_t * member, char * elements, size_t count)
+{
+  size_t j;
+  if (rosidl_typesupport_introspection_c__ROS_TYPE_STRING == member->type_id_) {
+    rosidl_generator_c__String * strings = (rosidl_generator_c__String *)elements;
+    for (j = 0; j < count; ++j) {
+      rosidl_generator_c__String__fini(&strings[j]);
+    }
+  } else if (rosidl_typesupport_introspection_c__ROS_TYPE_MESSAGE == member->type_id_) {
+    const rcl_message_members_t * nested = _member_get_members(member);
+    for (j = 0; j < count; ++j) {
+      _message_fini(nested, elements + j * nested->size_of_);
+    }
+  }
+}
+
+// The generated code initializes all the elements up to the capacity of a sequence,
+// and allocates them with malloc().
+static void
+_sequence_fini(const rcl_message_member_t * member, rcl_message_sequence_t * sequence)
+{
+  if (NULL != sequence->data) {
+    _elements_fini(member, (char *)sequence->data, sequence->capacity);
+    free(sequence->data);
+  }
+  sequence->data = NULL;
+  sequence->size = 0u;
+  sequence->capacity = 0u;
+}
+
+// Initialize the strings, including those of nested messages, of a zeroed message.
+// Sequences are zero when empty, and so are all the other fields.
+static bool
+_message_init(const rcl_message_members_t * members, char * message)
+{
+  uint32_t i;
+  for (i = 0; i < members->member_count_; ++i) {
+    const rcl_message_member_t * member = &members->members_[i];
+    if (_member_is_sequence(member)) {
+      continue;
+    }
+    size_t count = member->is_array_ ? member->array_size_ : 1u;
+    if (!_elements_init(member, message + member->offset_, count)) {
+      return false;
+    }
+  }
+  return true;
+}
+
+// Free what the generated code and the middleware allocated for the fields of a message.
+static void
+_message_fini(const rcl_message_members_t * members, char * message)
+{
+  uint32_t i;
+  for (i = 0; i < members->member_count_; ++i) {
+    const rcl_message_member_t * member = &members->members_[i];
+    char * field = message + member->offset_;
+    if (_member_is_sequence(member)) {
+      _sequence_fini(member, (rcl_message_sequence_t *)field);
+      continue;
+    }
+    _elements_fini(member, field, member->is_array_ ? member->array_size_ : 1u);
+  }
+}
+
+static bool
+_message_copy(const rcl_message_members_t * members, const char * source, char * destination);
+
+// Copy elements of a field over initialized elements.
+static bool
+_elements_copy(
+  const rcl_message_member_t * member, const char * source, char * destination, size_t count)
+{
+  size_t j;
+  if (rosidl_typesupport_introspection_c__ROS_TYPE_STRING == member->type_id_) {
+    const rosidl_generator_c__String * source_strings = (const rosidl_generator_c__String *)source;
+    rosidl_generator_c__String * destination_strings = (rosidl_generator_c__String *)destination;
+    for (j = 0; j < count; ++j) {
+      const char * data = source_strings[j].data ? source_strings[j].data : "";
+      if (!rosidl_generator_c__String__assignn(
+          &destination_strings[j], data, source_strings[j].size))
+      {
+        return false;
+      }
+    }
+  } else if (rosidl_typesupport_introspection_c__ROS_TYPE_MESSAGE == member->type_id_) {
+    const rcl_message_members_t * nested = _member_get_members(member);
+    for (j = 0; j < count; ++j) {
+      size_t offset = j * nested->size_of_;
+      if (!_message_copy(nested, source + offset, destination + offset)) {
+        return false;
+      }
+    }
+  } else {
+    size_t element_size = _member_get_element_size(member);
+    if (0u == element_size) {
+      return false;
+    }
+    if (count > 0u) {
+      memcpy(destination, source, count * element_size);
+    }
+  }
+  return true;
+}
+
+// Deep copy a message over an initialized message, reusing the capacity of its sequences.
+static bool
+_message_copy(const rcl_message_members_t * members, const char * source, char * destination)
+{
+  uint32_t i;
+  for (i = 0; i < members->member_count_; ++i) {
+    const rcl_message_member_t * member = &members->members_[i];
+    const char * source_field = source + member->offset_;
+    char * destination_field = destination + member->offset_;
+    if (!_member_is_sequence(member)) {
+      size_t count = member->is_array_ ? member->array_size_ : 1u;
+      if (!_elements_copy(member, source_field, destination_field, count)) {
+        return false;
+      }
+      continue;
+    }
+    const rcl_message_sequence_t * source_sequence = (const rcl_message_sequence_t *)source_field;
+    rcl_message_sequence_t * destination_sequence = (rcl_message_sequence_t *)destination_field;
+    if (destination_sequence->capacity < source_sequence->size) {
+      // Grow the buffer, the elements which were already there are overwritten below.
+      size_t element_size = _member_get_element_size(member);
+      if (0u == element_size) {
+        return false;
+      }
+      char * data = (char *)realloc(
+        destination_sequence->data, source_sequence->size * element_size);
+      if (NULL == data) {
+        return false;
+      }
+      size_t capacity = destination_sequence->capacity;
+      memset(
+        data + capacity * element_size, 0, (source_sequence->size - capacity) * element_size);
+      destination_sequence->data = data;
+      destination_sequence->capacity = source_sequence->size;
+      if (!_elements_init(
+          member, data + capacity * element_size, source_sequence->size - capacity))
+      {
+        return false;
+      }
+    }
+    // The elements past the size stay initialized, as the generated code expects.
+    destination_sequence->size = source_sequence->size;
+    if (!_elements_copy(
+        member, (const char *)source_sequence->data, (char *)destination_sequence->data,
+        source_sequence->size))
+    {
+      return false;
+    }
+  }
+  return true;
+}
+
+// Allocate and initialize a message owned by the pool, or return NULL.
+static void *
+_message_pool_create_message(rcl_message_pool_t * pool)
+{
+  const rcl_message_members_t * members = (const rcl_message_members_t *)pool->members;
+  rcl_message_pool_header_t * header = (rcl_message_pool_header_t *)pool->allocator.zero_allocate(
+    1u, sizeof(rcl_message_pool_header_t) + members->size_of_, pool->allocator.state);
+  if (NULL == header) {
+    return NULL;
+  }
+  header->info.pool = pool;
+  header->info.is_loaned = false;
+  atomic_init(&(header->info.references), 0u);
+  void * message = header + 1;
+  if (!_message_init(members, (char *)message)) {
+    _message_fini(members, (char *)message);
+    pool->allocator.deallocate(header, pool->allocator.state);
+    return NULL;
+  }
+  return message;
+}
+
+static void
+_message_pool_destroy_message(rcl_message_pool_t * pool, void * message)
+{
+  _message_fini((const rcl_message_members_t *)pool->members, (char *)message);
+  pool->allocator.deallocate(_message_header(message), pool->allocator.state);
+}
+
+// Return the index of the first message of the pool not below the address, with the pool locked.
+static size_t
+_message_pool_find(const rcl_message_pool_t * pool, const void * message)
+{
+  size_t low = 0u;
+  size_t high = pool->size;
+  while (low < high) {
+    size_t middle = low + (high - low) / 2u;
+    if ((uintptr_t)pool->messages[middle] < (uintptr_t)message) {
+      low = middle + 1u;
+    } else {
+      high = middle;
+    }
+  }
+  return low;
+}
+
+// Return true if the message was created by the pool, with the pool locked.
+/* Only the address is compared, so the message is not read.
+ */
+static bool
+_message_pool_contains(const rcl_message_pool_t * pool, const void * message)
+{
+  size_t index = _message_pool_find(pool, message);
+  return index < pool->size && pool->messages[index] == message;
+}
+
+// Add a message created by the pool, with the pool locked and room for it.
+static void
+_message_pool_add(rcl_message_pool_t * pool, void * message)
+{
+  size_t index = _message_pool_find(pool, message);
+  memmove(
+    &(pool->messages[index + 1u]), &(pool->messages[index]),
+    (pool->size - index) * sizeof(void *));
+  pool->messages[index] = message;
+  ++pool->size;
+}
+
+rcl_message_pool_t
+rcl_get_zero_initialized_message_pool(void)
+{
+  static rcl_message_pool_t null_pool;
+  return null_pool;
+}
+
+rcl_ret_t
+rcl_message_pool_init(
+  rcl_message_pool_t * pool,
+  const rosidl_message_type_support_t * type_support,
+  size_t size,
+  bool can_grow,
+  const rcl_allocator_t * allocator)
+{
+  RCL_CHECK_ARGUMENT_FOR_NULL(allocator, RCL_RET_INVALID_ARGUMENT, rcl_get_default_allocator());
+  RCL_CHECK_ALLOCATOR_WITH_MSG(allocator, "invalid allocator", return RCL_RET_INVALID_ARGUMENT);
+  RCL_CHECK_ARGUMENT_FOR_NULL(pool, RCL_RET_INVALID_ARGUMENT, *allocator);
+  RCL_CHECK_ARGUMENT_FOR_NULL(type_support, RCL_RET_INVALID_ARGUMENT, *allocator);
+  const rosidl_message_type_support_t * introspection = get_message_typesupport_handle(
+    type_support, rosidl_typesupport_introspection_c__identifier);
+  if (NULL == introspection) {
+    RCL_SET_ERROR_MSG("message type has no introspection type support", *allocator)
+    return RCL_RET_ERROR;
+  }
+  if (rcl_mutex_init(&(pool->lock)) != RCL_RET_OK) {
+    RCL_SET_ERROR_MSG("initializing the pool lock failed", *allocator)
+    return RCL_RET_ERROR;
+  }
+  pool->members = introspection->data;
+  pool->allocator = *allocator;
+  pool->can_grow = can_grow;
+  pool->size = 0u;
+  pool->free_count = 0u;
+  pool->capacity = size;
+  pool->free_messages = NULL;
+  pool->messages = NULL;
+  if (size > 0u) {
+    pool->free_messages = (void **)allocator->allocate(size * sizeof(void *), allocator->state);
+    pool->messages = (void **)allocator->allocate(size * sizeof(void *), allocator->state);
+    if (NULL == pool->free_messages || NULL == pool->messages) {
+      RCL_SET_ERROR_MSG("allocating memory failed", *allocator)
+      if (NULL != pool->free_messages) {
+        allocator->deallocate(pool->free_messages, allocator->state);
+      }
+      if (NULL != pool->messages) {
+        allocator->deallocate(pool->messages, allocator->state);
+      }
+      rcl_mutex_fini(&(pool->lock));
+      pool->members = NULL;
+      return RCL_RET_BAD_ALLOC;
+    }
+  }
+  while (pool->size < size) {
+    void * message = _message_pool_create_message(pool);
+    if (NULL == message) {
+      RCL_SET_ERROR_MSG("allocating memory failed", *allocator)
+      rcl_ret_t ret = rcl_message_pool_fini(pool);
+      (void)ret;
+      return RCL_RET_BAD_ALLOC;
+    }
+    pool->free_messages[pool->free_count++] = message;
+    _message_pool_add(pool, message);
+  }
+  return RCL_RET_OK;
+}
+
+rcl_ret_t
+rcl_message_pool_fini(rcl_message_pool_t * pool)
+{
+  RCL_CHECK_ARGUMENT_FOR_NULL(pool, RCL_RET_INVALID_ARGUMENT, rcl_get_default_allocator());
+  if (NULL == pool->members) {
+    return RCL_RET_OK;
+  }
+  if (pool->free_count != pool->size) {
+    RCL_SET_ERROR_MSG("messages are still loaned from the pool", pool->allocator)
+    return RCL_RET_ERROR;
+  }
+  size_t i;
+  for (i = 0; i < pool->free_count; ++i) {
+    _message_pool_destroy_message(pool, pool->free_messages[i]);
+  }
+  if (NULL != pool->free_messages) {
+    pool->allocator.deallocate(pool->free_messages, pool->allocator.state);
+  }
+  if (NULL != pool->messages) {
+    pool->allocator.deallocate(pool->messages, pool->allocator.state);
+  }
+  rcl_mutex_fini(&(pool->lock));
+  *pool = rcl_get_zero_initialized_message_pool();
+  return RCL_RET_OK;
+}
+
+rcl_ret_t
+rcl_message_pool_loan(rcl_message_pool_t * pool, void ** message)
+{
+  void * loaned = NULL;
+  rcl_mutex_lock(&(pool->lock));
+  if (pool->free_count > 0u) {
+    loaned = pool->free_messages[--pool->free_count];
+  } else if (pool->can_grow) {
+    // Make room to hold every message when they are all returned.
+    if (pool->size == pool->capacity) {
+      size_t capacity = pool->capacity > 0u ? 2u * pool->capacity : 4u;
+      void ** free_messages = (void **)pool->allocator.reallocate(
+        pool->free_messages, capacity * sizeof(void *), pool->allocator.state);
+      if (NULL != free_messages) {
+        pool->free_messages = free_messages;
+      }
+      void ** messages = (void **)pool->allocator.reallocate(
+        pool->messages, capacity * sizeof(void *), pool->allocator.state);
+      if (NULL != messages) {
+        pool->messages = messages;
+      }
+      if (NULL != free_messages && NULL != messages) {
+        pool->capacity = capacity;
+      }
+    }
+    if (pool->size < pool->capacity) {
+      loaned = _message_pool_create_message(pool);
+      if (NULL != loaned) {
+        _message_pool_add(pool, loaned);
+      }
+    }
+  }
+  if (NULL != loaned) {
+    _message_header(loaned)->info.is_loaned = true;
+    rcl_atomic_store(&(_message_header(loaned)->info.references), 1u);
+  }
+  rcl_mutex_unlock(&(pool->lock));
+  if (NULL == loaned) {
+    return RCL_RET_BAD_ALLOC;
+  }
+  *message = loaned;
+  return RCL_RET_OK;
+}
+
+rcl_ret_t
+rcl_message_pool_return(rcl_message_pool_t * pool, void * message)
+{
+  bool is_loaned = false;
+  if (NULL != pool->members) {
+    rcl_mutex_lock(&(pool->lock));
+    // The header is only read once the message is known to be one of the pool.
+    is_loaned = _message_pool_contains(pool, message) && _message_header(message)->info.is_loaned;
+    rcl_mutex_unlock(&(pool->lock));
+  }
+  if (!is_loaned) {
+    RCL_SET_ERROR_MSG("message is not loaned from this pool", pool->allocator)
+    return RCL_RET_INVALID_ARGUMENT;
+  }
+  rcl_message_pool_release(message);
+  return RCL_RET_OK;
+}
+
+bool
+rcl_message_pool_owns(rcl_message_pool_t * pool, const void * message)
+{
+  if (NULL == pool->members) {
+    return false;
+  }
+  rcl_mutex_lock(&(pool->lock));
+  bool owns = _message_pool_contains(pool, message);
+  rcl_mutex_unlock(&(pool->lock));
+  return owns;
+}
+
+void
+rcl_message_pool_retain(void * message)
+{
+  rcl_atomic_fetch_add_uint64_t(&(_message_header(message)->info.references), 1u);
+}
+
+void
+rcl_message_pool_release(void * message)
+{
+  rcl_message_pool_header_t * header = _message_header(message);
+  if (rcl_atomic_fetch_sub_uint64_t(&(header->info.references), 1u) != 1u) {
+    return;
+  }
+  rcl_message_pool_t * pool = header->info.pool;
+  rcl_mutex_lock(&(pool->lock));
+  header->info.is_loaned = false;
+  pool->free_messages[pool->free_count++] = message;
+  rcl_mutex_unlock(&(pool->lock));
+}
+
+rmw_message_info_t *
+rcl_message_pool_get_message_info(void * message)
+{
+  return &(_message_header(message)->info.message_info);
+}
+
+int64_t *
+rcl_message_pool_get_source_timestamp(void * message)
+{
+  return &(_message_header(message)->info.source_timestamp);
+}
+
+rcl_ret_t
+rcl_message_pool_copy(const rcl_message_pool_t * pool, const void * source, void * destination)
+{
+  if (!_message_copy(
+      (const rcl_message_members_t *)pool->members, (const char *)source, (char *)destination))
+  {
+    RCL_SET_ERROR_MSG("failed to copy message", pool->allocator)
+    return RCL_RET_ERROR;
+  }
+  return RCL_RET_OK;
+}
+
+#ifdef __cplusplus
+}
+#endif
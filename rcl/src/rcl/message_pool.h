@@ -0,0 +1,141 @@
+// Copyright 2018 Open Source Robotics Foundation, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef RCL__MESSAGE_POOL_H_
+#define RCL__MESSAGE_POOL_H_
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+#include "rcl/allocator.h"
+#include "rcl/types.h"
+#include "rmw/types.h"
+#include "rosidl_generator_c/message_type_support_struct.h"
+
+#include "./mutex.h"
+#include "./stdatomic_helper.h"
+
+/// Pool of initialized ROS messages of one type, which are loaned out and returned.
+/* The messages are initialized like the generated init function does, except
+ * that fields with a default value are zero, and are finalized when the pool
+ * is finalized, using the introspection type support of the message type.
+ * A returned message is not finalized, so it keeps the memory of its strings
+ * and sequences for the next loan.
+ *
+ * Loaning and returning messages is thread-safe, and only allocates when the
+ * pool can grow and no message is free.
+ *
+ * A loaned message can be shared, see rcl_message_pool_retain(), in which case
+ * it only goes back to the pool once every owner released it.
+ */
+typedef struct rcl_message_pool_t
+{
+  /// Introspection of the message type, or NULL if the pool is not initialized.
+  const void * members;
+  /// Messages which are not loaned, a stack of free_count messages.
+  void ** free_messages;
+  size_t free_count;
+  /// Messages owned by the pool, loaned or not, sorted by address.
+  void ** messages;
+  /// Number of messages owned by the pool, loaned or not.
+  size_t size;
+  /// Number of messages free_messages and messages can hold.
+  size_t capacity;
+  /// If true, a message is allocated when none is free, otherwise loaning fails.
+  bool can_grow;
+  /// Held while a thread changes the free messages.
+  rcl_mutex_t lock;
+  rcl_allocator_t allocator;
+} rcl_message_pool_t;
+
+/// Return a pool which is not initialized.
+rcl_message_pool_t
+rcl_get_zero_initialized_message_pool(void);
+
+/// Initialize a pool of `size` messages of the given type.
+/* Fails with RCL_RET_ERROR if the type has no introspection type support.
+ */
+rcl_ret_t
+rcl_message_pool_init(
+  rcl_message_pool_t * pool,
+  const rosidl_message_type_support_t * type_support,
+  size_t size,
+  bool can_grow,
+  const rcl_allocator_t * allocator);
+
+/// Finalize the pool and all its messages, none of which may still be loaned.
+rcl_ret_t
+rcl_message_pool_fini(rcl_message_pool_t * pool);
+
+/// Loan a message from the pool.
+/* Fails with RCL_RET_BAD_ALLOC if no message is free and none can be added.
+ */
+rcl_ret_t
+rcl_message_pool_loan(rcl_message_pool_t * pool, void ** message);
+
+/// Return a message loaned from the pool.
+/* Fails with RCL_RET_INVALID_ARGUMENT if the message is not loaned from this pool,
+ * including when it was already returned or is any other pointer.
+ * Same as rcl_message_pool_release() otherwise.
+ */
+rcl_ret_t
+rcl_message_pool_return(rcl_message_pool_t * pool, void * message);
+
+/// Return true if the message, loaned or not, was created by the initialized pool.
+/* Only the address of the message is compared to the messages of the pool, so it
+ * can be any pointer.
+ */
+bool
+rcl_message_pool_owns(rcl_message_pool_t * pool, const void * message);
+
+/// Add an owner to a loaned message.
+/* The message is only returned to its pool once every owner released it.
+ */
+void
+rcl_message_pool_retain(void * message);
+
+/// Release a loaned message, which returns it to its pool if it was the last owner.
+/* Unlike rcl_message_pool_return(), the message is not checked.
+ */
+void
+rcl_message_pool_release(void * message);
+
+/// Return the message info stored along with a message of a message pool.
+/* It is not touched by the pool, but by the owner which fills in the message.
+ */
+rmw_message_info_t *
+rcl_message_pool_get_message_info(void * message);
+
+/// Return the steady time at which a message of a message pool was published, or 0.
+/* Like the message info, it is not touched by the pool.
+ */
+int64_t *
+rcl_message_pool_get_source_timestamp(void * message);
+
+/// Deep copy a message of the type of the pool over an initialized message.
+/* The destination does not need to come from the pool.
+ * Its sequences keep their buffers when they are large enough, and only grow
+ * otherwise, so copying into a reused message does not allocate.
+ * Fails with RCL_RET_ERROR if memory cannot be allocated or a field type is not supported.
+ */
+rcl_ret_t
+rcl_message_pool_copy(const rcl_message_pool_t * pool, const void * source, void * destination);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif  // RCL__MESSAGE_POOL_H_
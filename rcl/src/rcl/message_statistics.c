@@ -0,0 +1,118 @@
+// Copyright 2018 Open Source Robotics Foundation, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+#include "./message_statistics.h"
+
+#include "rcutils/time.h"
+
+void
+rcl_message_statistics_init(rcl_message_statistics_t * statistics)
+{
+  atomic_init(&statistics->number_of_messages, 0);
+  atomic_init(&statistics->serialized_bytes, 0);
+  atomic_init(&statistics->number_of_failures, 0);
+  atomic_init(&statistics->last_time, 0);
+  size_t i;
+  for (i = 0; i < RCL_MESSAGE_STATISTICS_HISTOGRAM_SIZE; ++i) {
+    atomic_init(&statistics->interval_histogram[i], 0);
+  }
+}
+
+// Return the interval histogram bucket of the given interval.
+static size_t
+__message_statistics_interval_bucket(int64_t interval)
+{
+  uint64_t interval_us = (uint64_t)interval / 1000;
+  size_t bucket = 0;
+  while (interval_us > 0 && bucket < RCL_MESSAGE_STATISTICS_HISTOGRAM_SIZE - 1) {
+    interval_us >>= 1;
+    ++bucket;
+  }
+  return bucket;
+}
+
+void
+rcl_message_statistics_record(
+  rcl_message_statistics_t * statistics,
+  uint64_t number_of_messages,
+  uint64_t serialized_bytes)
+{
+  if (0 == number_of_messages) {
+    return;
+  }
+  rcl_atomic_fetch_add_uint64_t(&statistics->number_of_messages, number_of_messages);
+  if (serialized_bytes > 0) {
+    rcl_atomic_fetch_add_uint64_t(&statistics->serialized_bytes, serialized_bytes);
+  }
+  rcutils_time_point_value_t now;
+  if (rcutils_steady_time_now(&now) != RCUTILS_RET_OK) {
+    return;
+  }
+  // Exchanging the time orders concurrent calls, so each interval is counted once.
+  int64_t last_time = rcl_atomic_exchange_int64_t(&statistics->last_time, now);
+  if (0 != last_time) {
+    int64_t interval = now > last_time ? now - last_time : 0;
+    rcl_atomic_fetch_add_uint64_t(
+      &statistics->interval_histogram[__message_statistics_interval_bucket(interval)], 1);
+  }
+  // The other messages of the call follow the first one without any interval.
+  if (number_of_messages > 1) {
+    rcl_atomic_fetch_add_uint64_t(&statistics->interval_histogram[0], number_of_messages - 1);
+  }
+}
+
+void
+rcl_message_statistics_record_failure(rcl_message_statistics_t * statistics)
+{
+  rcl_atomic_fetch_add_uint64_t(&statistics->number_of_failures, 1);
+}
+
+void
+rcl_message_statistics_get(
+  rcl_message_statistics_t * statistics,
+  uint64_t * number_of_messages,
+  uint64_t * serialized_bytes,
+  uint64_t * number_of_failures,
+  uint64_t * interval_histogram)
+{
+  *number_of_messages = rcl_atomic_load_uint64_t(&statistics->number_of_messages);
+  *serialized_bytes = rcl_atomic_load_uint64_t(&statistics->serialized_bytes);
+  *number_of_failures = rcl_atomic_load_uint64_t(&statistics->number_of_failures);
+  size_t i;
+  for (i = 0; i < RCL_MESSAGE_STATISTICS_HISTOGRAM_SIZE; ++i) {
+    interval_histogram[i] = rcl_atomic_load_uint64_t(&statistics->interval_histogram[i]);
+  }
+}
+
+void
+rcl_message_statistics_reset(rcl_message_statistics_t * statistics)
+{
+  rcl_atomic_store(&statistics->number_of_messages, 0);
+  rcl_atomic_store(&statistics->serialized_bytes, 0);
+  rcl_atomic_store(&statistics->number_of_failures, 0);
+  rcl_atomic_store(&statistics->last_time, 0);
+  size_t i;
+  for (i = 0; i < RCL_MESSAGE_STATISTICS_HISTOGRAM_SIZE; ++i) {
+    rcl_atomic_store(&statistics->interval_histogram[i], 0);
+  }
+}
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,91 @@
+// Copyright 2018 Open Source Robotics Foundation, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef RCL__MESSAGE_STATISTICS_H_
+#define RCL__MESSAGE_STATISTICS_H_
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+#include <stdint.h>
+
+#include "rcl/publisher.h"
+#include "rcl/subscription.h"
+
+#include "./stdatomic_helper.h"
+
+#define RCL_MESSAGE_STATISTICS_HISTOGRAM_SIZE RCL_PUBLISHER_INTERVAL_HISTOGRAM_SIZE
+
+#if RCL_PUBLISHER_INTERVAL_HISTOGRAM_SIZE != RCL_SUBSCRIPTION_INTERVAL_HISTOGRAM_SIZE
+#error "publishers and subscriptions must have interval histograms of the same size"
+#endif
+
+/// Lock-free traffic counters of a publisher or a subscription.
+/* Bucket `0` of the histogram counts intervals of less than a microsecond
+ * between two recorded messages, and bucket `i` those of at least `2^(i - 1)` and
+ * less than `2^i` microseconds, except for the last bucket which counts all
+ * the intervals beyond that.
+ */
+typedef struct rcl_message_statistics_t
+{
+  atomic_uint_least64_t number_of_messages;
+  atomic_uint_least64_t serialized_bytes;
+  atomic_uint_least64_t number_of_failures;
+  /// Steady time of the last recorded message, or 0 if there was none.
+  atomic_int_least64_t last_time;
+  atomic_uint_least64_t interval_histogram[RCL_MESSAGE_STATISTICS_HISTOGRAM_SIZE];
+} rcl_message_statistics_t;
+
+/// Set all the counters to zero.
+void
+rcl_message_statistics_init(rcl_message_statistics_t * statistics);
+
+/// Count messages handled by one call, and the interval before each of them.
+/* The first message follows the last one of the previous call, the others
+ * count as following it without any interval.
+ * serialized_bytes is zero for calls which do not handle serialized messages.
+ * The intervals are not recorded if the steady clock cannot be read.
+ */
+void
+rcl_message_statistics_record(
+  rcl_message_statistics_t * statistics,
+  uint64_t number_of_messages,
+  uint64_t serialized_bytes);
+
+/// Count a call which did not handle any message.
+void
+rcl_message_statistics_record_failure(rcl_message_statistics_t * statistics);
+
+/// Copy the counters, one by one.
+/* interval_histogram must hold RCL_MESSAGE_STATISTICS_HISTOGRAM_SIZE values.
+ */
+void
+rcl_message_statistics_get(
+  rcl_message_statistics_t * statistics,
+  uint64_t * number_of_messages,
+  uint64_t * serialized_bytes,
+  uint64_t * number_of_failures,
+  uint64_t * interval_histogram);
+
+/// Set all the counters back to zero, calls made concurrently may be counted or lost.
+void
+rcl_message_statistics_reset(rcl_message_statistics_t * statistics);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif  // RCL__MESSAGE_STATISTICS_H_
@@ -0,0 +1,107 @@
+// Copyright 2018 Open Source Robotics Foundation, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef RCL__MUTEX_H_
+#define RCL__MUTEX_H_
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+#if defined(_WIN32)
+#include <windows.h>
+#else
+#include <pthread.h>
+#include <unistd.h>
+#endif
+
+#include "rcl/types.h"
+
+/// Mutex guarding short critical sections of rcl internals.
+/* A thread waiting for the mutex sleeps instead of spinning, so the thread
+ * holding it can run even when the waiting thread has a higher real-time
+ * priority. Where the platform supports it, the holder inherits the priority
+ * of the waiting threads.
+ *
+ * The mutex is not recursive and must not be copied once initialized.
+ */
+#if defined(_WIN32)
+typedef SRWLOCK rcl_mutex_t;
+/// Initializer of a mutex with static storage, which needs no rcl_mutex_init().
+#define RCL_MUTEX_INITIALIZER SRWLOCK_INIT
+#else
+typedef pthread_mutex_t rcl_mutex_t;
+/// Initializer of a mutex with static storage, which needs no rcl_mutex_init().
+#define RCL_MUTEX_INITIALIZER PTHREAD_MUTEX_INITIALIZER
+#endif
+
+/// Initialize the mutex, returning RCL_RET_ERROR on failure.
+static inline rcl_ret_t
+rcl_mutex_init(rcl_mutex_t * mutex)
+{
+#if defined(_WIN32)
+  InitializeSRWLock(mutex);
+  return RCL_RET_OK;
+#else
+  pthread_mutexattr_t attributes;
+  if (pthread_mutexattr_init(&attributes) != 0) {
+    return RCL_RET_ERROR;
+  }
+#if defined(_POSIX_THREAD_PRIO_INHERIT) && _POSIX_THREAD_PRIO_INHERIT > 0
+  // Best effort, the mutex still works without priority inheritance.
+  (void)pthread_mutexattr_setprotocol(&attributes, PTHREAD_PRIO_INHERIT);
+#endif
+  int error = pthread_mutex_init(mutex, &attributes);
+  (void)pthread_mutexattr_destroy(&attributes);
+  return 0 == error ? RCL_RET_OK : RCL_RET_ERROR;
+#endif  // defined(_WIN32)
+}
+
+/// Finalize the mutex, which must not be locked.
+static inline void
+rcl_mutex_fini(rcl_mutex_t * mutex)
+{
+#if defined(_WIN32)
+  (void)mutex;
+#else
+  (void)pthread_mutex_destroy(mutex);
+#endif
+}
+
+static inline void
+rcl_mutex_lock(rcl_mutex_t * mutex)
+{
+#if defined(_WIN32)
+  AcquireSRWLockExclusive(mutex);
+#else
+  (void)pthread_mutex_lock(mutex);
+#endif
+}
+
+static inline void
+rcl_mutex_unlock(rcl_mutex_t * mutex)
+{
+#if defined(_WIN32)
+  ReleaseSRWLockExclusive(mutex);
+#else
+  (void)pthread_mutex_unlock(mutex);
+#endif
+}
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif  // RCL__MUTEX_H_
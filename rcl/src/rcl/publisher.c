@@ -27,14 +27,29 @@ extern "C"
 #include "rcl/expand_topic_name.h"
 #include "rcl/remap.h"
 #include "rcutils/logging_macros.h"
+#include "rcutils/time.h"
 #include "rmw/error_handling.h"
 #include "rmw/rmw.h"
 #include "rmw/validate_full_topic_name.h"
 
+#include "./common.h"
+#include "./intra_process.h"
+#include "./message_latency.h"
+#include "./message_pool.h"
+#include "./message_statistics.h"
+
 typedef struct rcl_publisher_impl_t
 {
   rcl_publisher_options_t options;
   rmw_publisher_t * rmw_handle;
+  // messages loaned when the middleware cannot loan them
+  rcl_message_pool_t loaned_messages;
+  // link to the intra-process subscriptions, or NULL without the intra_process option
+  rcl_intra_process_publisher_t * intra_process;
+  // only updated with the enable_statistics option
+  rcl_message_statistics_t statistics;
+  // only valid with the stamp_header option
+  rcl_header_stamp_t header_stamp;
 } rcl_publisher_impl_t;
 
 rcl_publisher_t
@@ -73,6 +88,17 @@ rcl_publisher_init(
   RCL_CHECK_ARGUMENT_FOR_NULL(topic_name, RCL_RET_INVALID_ARGUMENT, *allocator);
   RCUTILS_LOG_DEBUG_NAMED(
     ROS_PACKAGE_NAME, "Initializing publisher for topic name '%s'", topic_name)
+  rcl_header_stamp_t header_stamp;
+  header_stamp.is_valid = false;
+  if (options->stamp_header) {
+    if (rcl_header_stamp_init(&header_stamp, type_support) != RCL_RET_OK) {
+      return RCL_RET_ERROR;  // error message already set
+    }
+    if (!header_stamp.is_valid) {
+      RCL_SET_ERROR_MSG("message type has no header stamp", *allocator)
+      return RCL_RET_INVALID_ARGUMENT;
+    }
+  }
   // Expand the given topic name.
   rcutils_allocator_t rcutils_allocator = *allocator;  // implicit conversion to rcutils version
   rcutils_string_map_t substitutions_map = rcutils_get_zero_initialized_string_map();
@@ -171,8 +197,36 @@ rcl_publisher_init(
     &(options->qos));
   RCL_CHECK_FOR_NULL_WITH_MSG(publisher->impl->rmw_handle,
     rmw_get_error_string_safe(), goto fail, *allocator);
+  // loaned messages, which are only preallocated if requested,
+  // and come from the topic for intra-process publishers
+  publisher->impl->loaned_messages = rcl_get_zero_initialized_message_pool();
+  publisher->impl->intra_process = NULL;
+  ret = RCL_RET_OK;
+  if (options->intra_process) {
+    ret = rcl_intra_process_publisher_init(
+      &(publisher->impl->intra_process), node, publisher->impl->rmw_handle, type_support,
+      allocator);
+  } else if (options->loaned_message_pool_size > 0u) {
+    ret = rcl_message_pool_init(
+      &(publisher->impl->loaned_messages), type_support,
+      options->loaned_message_pool_size, false, allocator);
+  }
+  if (RCL_RET_OK != ret) {
+    // The rcl error state should already be set.
+    if (rmw_destroy_publisher(rcl_node_get_rmw_handle(node), publisher->impl->rmw_handle) !=
+      RMW_RET_OK)
+    {
+      RCUTILS_LOG_ERROR_NAMED(
+        ROS_PACKAGE_NAME, "failed to destroy publisher during error handling: %s",
+        rmw_get_error_string_safe())
+    }
+    fail_ret = ret;
+    goto fail;
+  }
   // options
   publisher->impl->options = *options;
+  rcl_message_statistics_init(&(publisher->impl->statistics));
+  publisher->impl->header_stamp = header_stamp;
   RCUTILS_LOG_DEBUG_NAMED(ROS_PACKAGE_NAME, "Publisher initialized");
   goto cleanup;
 fail:
@@ -207,13 +261,22 @@ rcl_publisher_fini(rcl_publisher_t * publisher, rcl_node_t * node)
     if (!rmw_node) {
       return RCL_RET_INVALID_ARGUMENT;
     }
+    if (publisher->impl->intra_process) {
+      rcl_intra_process_publisher_fini(publisher->impl->intra_process);
+    }
     rmw_ret_t ret =
       rmw_destroy_publisher(rmw_node, publisher->impl->rmw_handle);
     if (ret != RMW_RET_OK) {
       RCL_SET_ERROR_MSG(rmw_get_error_string_safe(), allocator);
       result = RCL_RET_ERROR;
     }
-    allocator.deallocate(publisher->impl, allocator.state);
+    if (rcl_message_pool_fini(&(publisher->impl->loaned_messages)) != RCL_RET_OK) {
+      // The error message is already set.
+      // The implementation is leaked with its pool, so the loaned messages can still be returned.
+      result = RCL_RET_ERROR;
+    } else {
+      allocator.deallocate(publisher->impl, allocator.state);
+    }
   }
   RCUTILS_LOG_DEBUG_NAMED(ROS_PACKAGE_NAME, "Publisher finalized")
   return result;
@@ -227,20 +290,53 @@ rcl_publisher_get_default_options()
   // Must set the allocator and qos after because they are not a compile time constant.
   default_options.qos = rmw_qos_profile_default;
   default_options.allocator = rcl_get_default_allocator();
+  default_options.loaned_message_pool_size = 0u;
+  default_options.intra_process = false;
+  default_options.enable_statistics = false;
+  default_options.stamp_header = false;
   return default_options;
 }
 
+// Same as rcl_publisher_is_valid(), but without an allocator or an error message.
+// The full check only runs once this one fails, to set the error message.
+#define _publisher_can_publish(pub) \
+  (NULL != (pub) && NULL != (pub)->impl && NULL != (pub)->impl->rmw_handle)
+
+// Count published messages, if the publisher keeps statistics.
+#define _publisher_record(pub, number_of_messages, serialized_bytes) \
+  if ((pub)->impl->options.enable_statistics) { \
+    rcl_message_statistics_record( \
+      &(pub)->impl->statistics, number_of_messages, serialized_bytes); \
+  }
+
+// Count a message which could not be published, if the publisher keeps statistics.
+#define _publisher_record_failure(pub) \
+  if ((pub)->impl->options.enable_statistics) { \
+    rcl_message_statistics_record_failure(&(pub)->impl->statistics); \
+  }
+
 rcl_ret_t
 rcl_publish(const rcl_publisher_t * publisher, const void * ros_message)
 {
-  RCUTILS_LOG_DEBUG_NAMED(ROS_PACKAGE_NAME, "Publisher publishing message")
-  if (!rcl_publisher_is_valid(publisher, NULL)) {
+  RCL_HOT_PATH_LOG_DEBUG("Publisher publishing message")
+  if (!_publisher_can_publish(publisher) && !rcl_publisher_is_valid(publisher, NULL)) {
     return RCL_RET_PUBLISHER_INVALID;
   }
+  if (publisher->impl->intra_process) {
+    rcl_ret_t ret = rcl_intra_process_publish_copy(publisher->impl->intra_process, ros_message);
+    if (RCL_RET_OK == ret) {
+      _publisher_record(publisher, 1, 0)
+    } else {
+      _publisher_record_failure(publisher)
+    }
+    return ret;
+  }
   if (rmw_publish(publisher->impl->rmw_handle, ros_message) != RMW_RET_OK) {
     RCL_SET_ERROR_MSG(rmw_get_error_string_safe(), rcl_get_default_allocator());
+    _publisher_record_failure(publisher)
     return RCL_RET_ERROR;
   }
+  _publisher_record(publisher, 1, 0)
   return RCL_RET_OK;
 }
 
@@ -248,17 +344,216 @@ rcl_ret_t
 rcl_publish_serialized_message(
   const rcl_publisher_t * publisher, const rcl_serialized_message_t * serialized_message)
 {
-  if (!rcl_publisher_is_valid(publisher, NULL)) {
+  RCL_HOT_PATH_LOG_DEBUG("Publisher publishing serialized message")
+  if (!_publisher_can_publish(publisher) && !rcl_publisher_is_valid(publisher, NULL)) {
     return RCL_RET_PUBLISHER_INVALID;
   }
+  if (publisher->impl->intra_process) {
+    rcl_ret_t ret = rcl_intra_process_publish_serialized(
+      publisher->impl->intra_process, serialized_message);
+    if (RCL_RET_OK == ret) {
+      _publisher_record(publisher, 1, serialized_message->buffer_length)
+    } else {
+      _publisher_record_failure(publisher)
+    }
+    return ret;
+  }
   rmw_ret_t ret = rmw_publish_serialized_message(publisher->impl->rmw_handle, serialized_message);
   if (ret != RMW_RET_OK) {
     RCL_SET_ERROR_MSG(rmw_get_error_string_safe(), rcl_get_default_allocator());
+    _publisher_record_failure(publisher)
     if (ret == RMW_RET_BAD_ALLOC) {
       return RCL_RET_BAD_ALLOC;
     }
     return RMW_RET_ERROR;
   }
+  _publisher_record(publisher, 1, serialized_message->buffer_length)
+  return RCL_RET_OK;
+}
+
+rcl_ret_t
+rcl_publish_batch(
+  const rcl_publisher_t * publisher,
+  const void * const * ros_messages,
+  size_t count,
+  size_t * published)
+{
+  RCL_CHECK_ARGUMENT_FOR_NULL(published, RCL_RET_INVALID_ARGUMENT, rcl_get_default_allocator());
+  *published = 0;
+  if (!_publisher_can_publish(publisher) && !rcl_publisher_is_valid(publisher, NULL)) {
+    return RCL_RET_PUBLISHER_INVALID;
+  }
+  if (0 == count) {
+    return RCL_RET_OK;
+  }
+  RCL_CHECK_ARGUMENT_FOR_NULL(ros_messages, RCL_RET_INVALID_ARGUMENT, rcl_get_default_allocator());
+  RCL_HOT_PATH_LOG_DEBUG("Publisher publishing %zu messages", count)
+  rmw_publisher_t * rmw_handle = publisher->impl->rmw_handle;
+  rcl_intra_process_publisher_t * intra_process = publisher->impl->intra_process;
+  size_t i;
+  for (i = 0; i < count; ++i) {
+    if (intra_process) {
+      rcl_ret_t ret = rcl_intra_process_publish_copy(intra_process, ros_messages[i]);
+      if (RCL_RET_OK != ret) {
+        *published = i;
+        if (i > 0) {
+          _publisher_record(publisher, i, 0)
+        }
+        _publisher_record_failure(publisher)
+        return ret;  // error message already set
+      }
+      continue;
+    }
+    rmw_ret_t ret = rmw_publish(rmw_handle, ros_messages[i]);
+    if (ret != RMW_RET_OK) {
+      *published = i;
+      if (i > 0) {
+        _publisher_record(publisher, i, 0)
+      }
+      _publisher_record_failure(publisher)
+      RCL_SET_ERROR_MSG(rmw_get_error_string_safe(), rcl_get_default_allocator());
+      return ret == RMW_RET_BAD_ALLOC ? RCL_RET_BAD_ALLOC : RCL_RET_ERROR;
+    }
+  }
+  *published = count;
+  _publisher_record(publisher, count, 0)
+  return RCL_RET_OK;
+}
+
+rcl_ret_t
+rcl_publish_serialized_message_batch(
+  const rcl_publisher_t * publisher,
+  const rcl_serialized_message_t * serialized_messages,
+  size_t count,
+  size_t * published)
+{
+  RCL_CHECK_ARGUMENT_FOR_NULL(published, RCL_RET_INVALID_ARGUMENT, rcl_get_default_allocator());
+  *published = 0;
+  if (!_publisher_can_publish(publisher) && !rcl_publisher_is_valid(publisher, NULL)) {
+    return RCL_RET_PUBLISHER_INVALID;
+  }
+  if (0 == count) {
+    return RCL_RET_OK;
+  }
+  RCL_CHECK_ARGUMENT_FOR_NULL(
+    serialized_messages, RCL_RET_INVALID_ARGUMENT, rcl_get_default_allocator());
+  RCL_HOT_PATH_LOG_DEBUG("Publisher publishing %zu serialized messages", count)
+  rmw_publisher_t * rmw_handle = publisher->impl->rmw_handle;
+  rcl_intra_process_publisher_t * intra_process = publisher->impl->intra_process;
+  uint64_t serialized_bytes = 0;
+  size_t i;
+  for (i = 0; i < count; ++i) {
+    if (intra_process) {
+      rcl_ret_t ret = rcl_intra_process_publish_serialized(intra_process, &serialized_messages[i]);
+      if (RCL_RET_OK != ret) {
+        *published = i;
+        if (i > 0) {
+          _publisher_record(publisher, i, serialized_bytes)
+        }
+        _publisher_record_failure(publisher)
+        return ret;  // error message already set
+      }
+      serialized_bytes += serialized_messages[i].buffer_length;
+      continue;
+    }
+    rmw_ret_t ret = rmw_publish_serialized_message(rmw_handle, &serialized_messages[i]);
+    if (ret != RMW_RET_OK) {
+      *published = i;
+      if (i > 0) {
+        _publisher_record(publisher, i, serialized_bytes)
+      }
+      _publisher_record_failure(publisher)
+      RCL_SET_ERROR_MSG(rmw_get_error_string_safe(), rcl_get_default_allocator());
+      return ret == RMW_RET_BAD_ALLOC ? RCL_RET_BAD_ALLOC : RCL_RET_ERROR;
+    }
+    serialized_bytes += serialized_messages[i].buffer_length;
+  }
+  *published = count;
+  _publisher_record(publisher, count, serialized_bytes)
+  return RCL_RET_OK;
+}
+
+rcl_ret_t
+rcl_borrow_loaned_message(const rcl_publisher_t * publisher, void ** ros_message)
+{
+  if (!_publisher_can_publish(publisher) && !rcl_publisher_is_valid(publisher, NULL)) {
+    return RCL_RET_PUBLISHER_INVALID;
+  }
+  RCL_CHECK_ARGUMENT_FOR_NULL(ros_message, RCL_RET_INVALID_ARGUMENT, rcl_get_default_allocator());
+  // The middleware cannot loan messages, so they come from the topic or the publisher's pool.
+  rcl_ret_t ret = publisher->impl->intra_process ?
+    rcl_intra_process_publisher_loan(publisher->impl->intra_process, ros_message) :
+    rcl_message_pool_loan(&(publisher->impl->loaned_messages), ros_message);
+  if (RCL_RET_OK != ret) {
+    RCL_SET_ERROR_MSG("no loaned message is available", rcl_get_default_allocator())
+    return RCL_RET_PUBLISHER_LOAN_FAILED;
+  }
+  return RCL_RET_OK;
+}
+
+rcl_ret_t
+rcl_return_loaned_message_from_publisher(
+  const rcl_publisher_t * publisher, void * loaned_message)
+{
+  if (!_publisher_can_publish(publisher) && !rcl_publisher_is_valid(publisher, NULL)) {
+    return RCL_RET_PUBLISHER_INVALID;
+  }
+  RCL_CHECK_ARGUMENT_FOR_NULL(
+    loaned_message, RCL_RET_INVALID_ARGUMENT, rcl_get_default_allocator());
+  if (publisher->impl->intra_process) {
+    return rcl_intra_process_publisher_return(publisher->impl->intra_process, loaned_message);
+  }
+  return rcl_message_pool_return(&(publisher->impl->loaned_messages), loaned_message);
+}
+
+// Set the header stamp of a loaned message to the current system time.
+static void
+_publisher_stamp_header(const rcl_publisher_t * publisher, void * ros_message)
+{
+  rcutils_time_point_value_t now;
+  if (rcutils_system_time_now(&now) != RCUTILS_RET_OK) {
+    // The message is still published, it just cannot be measured.
+    rcl_reset_error();
+    return;
+  }
+  rcl_header_stamp_set(&(publisher->impl->header_stamp), ros_message, now);
+}
+
+rcl_ret_t
+rcl_publish_loaned_message(const rcl_publisher_t * publisher, void * ros_message)
+{
+  RCL_HOT_PATH_LOG_DEBUG("Publisher publishing loaned message")
+  if (!_publisher_can_publish(publisher) && !rcl_publisher_is_valid(publisher, NULL)) {
+    return RCL_RET_PUBLISHER_INVALID;
+  }
+  RCL_CHECK_ARGUMENT_FOR_NULL(ros_message, RCL_RET_INVALID_ARGUMENT, rcl_get_default_allocator());
+  if (publisher->impl->options.stamp_header) {
+    _publisher_stamp_header(publisher, ros_message);
+  }
+  if (publisher->impl->intra_process) {
+    // The message is shared with the intra-process subscriptions, not copied.
+    rcl_ret_t ret = rcl_intra_process_publish(publisher->impl->intra_process, ros_message);
+    if (RCL_RET_OK == ret) {
+      _publisher_record(publisher, 1, 0)
+    } else {
+      _publisher_record_failure(publisher)
+    }
+    return ret;
+  }
+  rmw_ret_t rmw_ret = rmw_publish(publisher->impl->rmw_handle, ros_message);
+  if (rmw_ret != RMW_RET_OK) {
+    RCL_SET_ERROR_MSG(rmw_get_error_string_safe(), rcl_get_default_allocator());
+    _publisher_record_failure(publisher)
+  }
+  // The message is returned even if publishing failed, as documented.
+  rcl_ret_t ret = rcl_message_pool_return(&(publisher->impl->loaned_messages), ros_message);
+  if (RCL_RET_OK != ret) {
+    return ret;
+  }
+  if (rmw_ret != RMW_RET_OK) {
+    return RCL_RET_ERROR;
+  }
+  _publisher_record(publisher, 1, 0)
   return RCL_RET_OK;
 }
 
@@ -291,6 +586,39 @@ rcl_publisher_get_rmw_handle(const rcl_publisher_t * publisher)
   return publisher->impl->rmw_handle;
 }
 
+rcl_ret_t
+rcl_publisher_get_statistics(
+  const rcl_publisher_t * publisher, rcl_publisher_statistics_t * statistics)
+{
+  if (!rcl_publisher_is_valid(publisher, NULL)) {
+    return RCL_RET_PUBLISHER_INVALID;
+  }
+  RCL_CHECK_ARGUMENT_FOR_NULL(statistics, RCL_RET_INVALID_ARGUMENT, rcl_get_default_allocator());
+  if (!publisher->impl->options.enable_statistics) {
+    RCL_SET_ERROR_MSG("publisher does not keep statistics", rcl_get_default_allocator())
+    return RCL_RET_ERROR;
+  }
+  rcl_message_statistics_get(
+    &(publisher->impl->statistics), &(statistics->number_of_messages),
+    &(statistics->serialized_bytes), &(statistics->number_of_failed_publishes),
+    statistics->interval_histogram);
+  return RCL_RET_OK;
+}
+
+rcl_ret_t
+rcl_publisher_reset_statistics(const rcl_publisher_t * publisher)
+{
+  if (!rcl_publisher_is_valid(publisher, NULL)) {
+    return RCL_RET_PUBLISHER_INVALID;
+  }
+  if (!publisher->impl->options.enable_statistics) {
+    RCL_SET_ERROR_MSG("publisher does not keep statistics", rcl_get_default_allocator())
+    return RCL_RET_ERROR;
+  }
+  rcl_message_statistics_reset(&(publisher->impl->statistics));
+  return RCL_RET_OK;
+}
+
 bool
 rcl_publisher_is_valid(
   const rcl_publisher_t * publisher,
@@ -23,6 +23,7 @@ extern "C"
 
 #include "./arguments_impl.h"
 #include "./stdatomic_helper.h"
+#include "./time_impl.h"
 #include "rcl/arguments.h"
 #include "rcl/error_handling.h"
 #include "rcutils/logging_macros.h"
@@ -123,6 +124,9 @@ rcl_init(int argc, char const * const * argv, rcl_allocator_t allocator)
     rcutils_logging_set_default_logger_level(global_args->impl->log_level);
   }
 
+  // Select the source of the steady time once, before anything measures time with it.
+  rcl_steady_time_source_init();
+
   rcl_atomic_store(&__rcl_instance_id, ++__rcl_next_unique_id);
   if (rcl_atomic_load_uint64_t(&__rcl_instance_id) == 0) {
     // Roll over occurred.
@@ -38,6 +38,10 @@
 
 #define rcl_atomic_store(object, desired) atomic_store(object, desired)
 
+#define rcl_atomic_fetch_add(object, out, operand) (out) = atomic_fetch_add(object, operand)
+
+#define rcl_atomic_fetch_sub(object, out, operand) (out) = atomic_fetch_sub(object, operand)
+
 #else  // !defined(_WIN32)
 
 #include "./stdatomic_helper/win32/stdatomic.h"
@@ -51,6 +55,10 @@
 
 #define rcl_atomic_store(object, desired) rcl_win32_atomic_store(object, desired)
 
+#define rcl_atomic_fetch_add(object, out, operand) rcl_win32_atomic_fetch_add(object, out, operand)
+
+#define rcl_atomic_fetch_sub(object, out, operand) rcl_win32_atomic_fetch_sub(object, out, operand)
+
 #endif  // !defined(_WIN32)
 
 static inline bool
@@ -94,6 +102,24 @@ rcl_atomic_compare_exchange_strong_uint_least64_t(
   return result;
 }
 
+static inline bool
+rcl_atomic_compare_exchange_strong_int_least64_t(
+  atomic_int_least64_t * a_int_least64_t, int64_t * expected, int64_t desired)
+{
+  bool result;
+  rcl_atomic_compare_exchange_strong(a_int_least64_t, result, expected, desired);
+  return result;
+}
+
+static inline bool
+rcl_atomic_compare_exchange_strong_uintptr_t(
+  atomic_uintptr_t * a_uintptr_t, uintptr_t * expected, uintptr_t desired)
+{
+  bool result;
+  rcl_atomic_compare_exchange_strong(a_uintptr_t, result, expected, desired);
+  return result;
+}
+
 static inline bool
 rcl_atomic_exchange_bool(atomic_bool * a_bool, bool desired)
 {
@@ -126,4 +152,20 @@ rcl_atomic_exchange_uintptr_t(atomic_uintptr_t * a_uintptr_t, uintptr_t desired)
   return result;
 }
 
+static inline uint64_t
+rcl_atomic_fetch_add_uint64_t(atomic_uint_least64_t * a_uint64_t, uint64_t operand)
+{
+  uint64_t result;
+  rcl_atomic_fetch_add(a_uint64_t, result, operand);
+  return result;
+}
+
+static inline uint64_t
+rcl_atomic_fetch_sub_uint64_t(atomic_uint_least64_t * a_uint64_t, uint64_t operand)
+{
+  uint64_t result;
+  rcl_atomic_fetch_sub(a_uint64_t, result, operand);
+  return result;
+}
+
 #endif  // RCL__STDATOMIC_HELPER_H_
@@ -29,10 +29,26 @@ extern "C"
 #include "rmw/rmw.h"
 #include "rmw/validate_full_topic_name.h"
 
+#include "./common.h"
+#include "./intra_process.h"
+#include "./message_latency.h"
+#include "./message_pool.h"
+#include "./message_statistics.h"
+#include "./subscription_impl.h"
+
 typedef struct rcl_subscription_impl_t
 {
   rcl_subscription_options_t options;
   rmw_subscription_t * rmw_handle;
+  const rosidl_message_type_support_t * type_support;
+  // messages loaned by rcl_take_loaned_message(), created on first use
+  rcl_message_pool_t loaned_messages;
+  // link to the intra-process publishers, or NULL without the intra_process option
+  rcl_intra_process_subscription_t * intra_process;
+  // only updated with the enable_statistics option
+  rcl_message_statistics_t statistics;
+  // only allocated with the measure_latency option
+  rcl_message_latency_t * latency;
 } rcl_subscription_impl_t;
 
 rcl_subscription_t
@@ -70,6 +86,17 @@ rcl_subscription_init(
     RCL_SET_ERROR_MSG("subscription already initialized, or memory was uninitialized", *allocator);
     return RCL_RET_ALREADY_INIT;
   }
+  rcl_header_stamp_t header_stamp;
+  header_stamp.is_valid = false;
+  if (options->measure_latency && options->measure_header_stamp) {
+    if (rcl_header_stamp_init(&header_stamp, type_support) != RCL_RET_OK) {
+      return RCL_RET_ERROR;  // error message already set
+    }
+    if (!header_stamp.is_valid) {
+      RCL_SET_ERROR_MSG("message type has no header stamp", *allocator)
+      return RCL_RET_INVALID_ARGUMENT;
+    }
+  }
   // Expand the given topic name.
   rcutils_allocator_t rcutils_allocator = *allocator;  // implicit conversion to rcutils version
   rcutils_string_map_t substitutions_map = rcutils_get_zero_initialized_string_map();
@@ -159,6 +186,16 @@ rcl_subscription_init(
   RCL_CHECK_FOR_NULL_WITH_MSG(
     subscription->impl, "allocating memory failed", ret = RCL_RET_BAD_ALLOC; goto cleanup,
     *allocator);
+  // latency histogram, which is only allocated if requested
+  subscription->impl->latency = NULL;
+  if (options->measure_latency) {
+    subscription->impl->latency = (rcl_message_latency_t *)allocator->allocate(
+      sizeof(rcl_message_latency_t), allocator->state);
+    RCL_CHECK_FOR_NULL_WITH_MSG(
+      subscription->impl->latency, "allocating memory failed",
+      fail_ret = RCL_RET_BAD_ALLOC; goto fail, *allocator);
+    rcl_message_latency_init(subscription->impl->latency, &header_stamp);
+  }
   // Fill out the implemenation struct.
   // rmw_handle
   // TODO(wjwwood): pass allocator once supported in rmw api.
@@ -172,13 +209,48 @@ rcl_subscription_init(
     RCL_SET_ERROR_MSG(rmw_get_error_string_safe(), *allocator);
     goto fail;
   }
+  subscription->impl->type_support = type_support;
+  // message pool, which is only preallocated and bounded if requested
+  subscription->impl->loaned_messages = rcl_get_zero_initialized_message_pool();
+  subscription->impl->intra_process = NULL;
+  ret = RCL_RET_OK;
+  if (options->message_pool_size > 0u) {
+    ret = rcl_message_pool_init(
+      &(subscription->impl->loaned_messages), type_support,
+      options->message_pool_size, false, allocator);
+  }
+  if (RCL_RET_OK == ret && options->intra_process) {
+    ret = rcl_intra_process_subscription_init(
+      &(subscription->impl->intra_process), subscription->impl->rmw_handle, type_support,
+      &(options->qos), allocator);
+    if (RCL_RET_OK != ret) {
+      rcl_ret_t fini_ret = rcl_message_pool_fini(&(subscription->impl->loaned_messages));
+      (void)fini_ret;
+    }
+  }
+  if (RCL_RET_OK != ret) {
+    // The rcl error state should already be set.
+    if (rmw_destroy_subscription(
+        rcl_node_get_rmw_handle(node), subscription->impl->rmw_handle) != RMW_RET_OK)
+    {
+      RCUTILS_LOG_ERROR_NAMED(
+        ROS_PACKAGE_NAME, "failed to destroy subscription during error handling: %s",
+        rmw_get_error_string_safe())
+    }
+    fail_ret = ret;
+    goto fail;
+  }
   // options
   subscription->impl->options = *options;
+  rcl_message_statistics_init(&(subscription->impl->statistics));
   RCUTILS_LOG_DEBUG_NAMED(ROS_PACKAGE_NAME, "Subscription initialized")
   ret = RCL_RET_OK;
   goto cleanup;
 fail:
   if (subscription->impl) {
+    if (subscription->impl->latency) {
+      allocator->deallocate(subscription->impl->latency, allocator->state);
+    }
     allocator->deallocate(subscription->impl, allocator->state);
   }
   ret = fail_ret;
@@ -209,13 +281,28 @@ rcl_subscription_fini(rcl_subscription_t * subscription, rcl_node_t * node)
     if (!rmw_node) {
       return RCL_RET_INVALID_ARGUMENT;
     }
+    if (subscription->impl->intra_process) {
+      // The queued messages are released, which lets the message pool of the topic go.
+      rcl_intra_process_subscription_fini(subscription->impl->intra_process);
+      subscription->impl->intra_process = NULL;
+    }
     rmw_ret_t ret =
       rmw_destroy_subscription(rmw_node, subscription->impl->rmw_handle);
     if (ret != RMW_RET_OK) {
       RCL_SET_ERROR_MSG(rmw_get_error_string_safe(), allocator);
       result = RCL_RET_ERROR;
     }
-    allocator.deallocate(subscription->impl, allocator.state);
+    if (subscription->impl->latency) {
+      allocator.deallocate(subscription->impl->latency, allocator.state);
+      subscription->impl->latency = NULL;
+    }
+    if (rcl_message_pool_fini(&(subscription->impl->loaned_messages)) != RCL_RET_OK) {
+      // The error message is already set.
+      // The implementation is leaked with its pool, so the loaned messages can still be returned.
+      result = RCL_RET_ERROR;
+    } else {
+      allocator.deallocate(subscription->impl, allocator.state);
+    }
   }
   RCUTILS_LOG_DEBUG_NAMED(ROS_PACKAGE_NAME, "Subscription finalized")
   return result;
@@ -231,38 +318,94 @@ rcl_subscription_get_default_options()
   // Must set the allocator and qos after because they are not a compile time constant.
   default_options.qos = rmw_qos_profile_default;
   default_options.allocator = rcl_get_default_allocator();
+  default_options.message_pool_size = 0u;
+  default_options.intra_process = false;
+  default_options.enable_statistics = false;
+  default_options.measure_latency = false;
+  default_options.measure_header_stamp = false;
   return default_options;
 }
 
+rcl_intra_process_subscription_t *
+rcl_subscription_get_intra_process(const rcl_subscription_t * subscription)
+{
+  return subscription->impl->intra_process;
+}
+
+// Same as rcl_subscription_is_valid(), but without an allocator or an error message.
+// The full check only runs once this one fails, to set the error message.
+#define _subscription_can_take(sub) \
+  (NULL != (sub) && NULL != (sub)->impl && NULL != (sub)->impl->rmw_handle)
+
+// True if a message was taken from the middleware but was already received intra-process.
+#define _subscription_is_duplicate(intra_process, ret, taken, message_info) \
+  (NULL != (intra_process) && RMW_RET_OK == (ret) && (taken) && \
+  rcl_intra_process_subscription_is_duplicate(intra_process, message_info))
+
+// Count taken messages and failed takes, if the subscription keeps statistics.
+#define _subscription_record(sub, number_of_messages, serialized_bytes) \
+  if ((sub)->impl->options.enable_statistics) { \
+    rcl_message_statistics_record( \
+      &(sub)->impl->statistics, number_of_messages, serialized_bytes); \
+  }
+
+#define _subscription_record_failure(sub) \
+  if ((sub)->impl->options.enable_statistics) { \
+    rcl_message_statistics_record_failure(&(sub)->impl->statistics); \
+  }
+
+// Measure the latency of a taken message, if the subscription measures latencies.
+#define _subscription_record_latency(sub, message, source_timestamp) \
+  if (NULL != (sub)->impl->latency) { \
+    rcl_message_latency_record((sub)->impl->latency, message, source_timestamp); \
+  }
+
 rcl_ret_t
 rcl_take(
   const rcl_subscription_t * subscription,
   void * ros_message,
   rmw_message_info_t * message_info)
 {
-  RCUTILS_LOG_DEBUG_NAMED(ROS_PACKAGE_NAME, "Subscription taking message")
-  rcl_allocator_t error_allocator = rcl_get_default_allocator();
-  if (!rcl_subscription_is_valid(subscription, &error_allocator)) {
+  RCL_HOT_PATH_LOG_DEBUG("Subscription taking message")
+  if (!_subscription_can_take(subscription) && !rcl_subscription_is_valid(subscription, NULL)) {
     return RCL_RET_SUBSCRIPTION_INVALID;  // error message already set
   }
   RCL_CHECK_ARGUMENT_FOR_NULL(
-    ros_message, RCL_RET_INVALID_ARGUMENT, error_allocator);
+    ros_message, RCL_RET_INVALID_ARGUMENT, rcl_get_default_allocator());
   // If message_info is NULL, use a place holder which can be discarded.
   rmw_message_info_t dummy_message_info;
   rmw_message_info_t * message_info_local = message_info ? message_info : &dummy_message_info;
+  rcl_intra_process_subscription_t * intra_process = subscription->impl->intra_process;
+  if (intra_process) {
+    int64_t source_timestamp = 0;
+    rcl_ret_t ret = rcl_intra_process_subscription_take_copy(
+      intra_process, ros_message, message_info_local, &source_timestamp);
+    if (RCL_RET_OK == ret) {
+      _subscription_record(subscription, 1, 0)
+      _subscription_record_latency(subscription, ros_message, source_timestamp)
+    }
+    if (RCL_RET_SUBSCRIPTION_TAKE_FAILED != ret) {
+      return ret;  // error message already set, if any
+    }
+  }
   // Call rmw_take_with_info.
   bool taken = false;
-  rmw_ret_t ret =
-    rmw_take_with_info(subscription->impl->rmw_handle, ros_message, &taken, message_info_local);
+  rmw_ret_t ret;
+  do {
+    ret = rmw_take_with_info(
+      subscription->impl->rmw_handle, ros_message, &taken, message_info_local);
+  } while (_subscription_is_duplicate(intra_process, ret, taken, message_info_local));
   if (ret != RMW_RET_OK) {
-    RCL_SET_ERROR_MSG(rmw_get_error_string_safe(), error_allocator);
+    RCL_SET_ERROR_MSG(rmw_get_error_string_safe(), rcl_get_default_allocator());
     return RCL_RET_ERROR;
   }
-  RCUTILS_LOG_DEBUG_NAMED(
-    ROS_PACKAGE_NAME, "Subscription take succeeded: %s", taken ? "true" : "false")
+  RCL_HOT_PATH_LOG_DEBUG("Subscription take succeeded: %s", taken ? "true" : "false")
   if (!taken) {
+    _subscription_record_failure(subscription)
     return RCL_RET_SUBSCRIPTION_TAKE_FAILED;
   }
+  _subscription_record(subscription, 1, 0)
+  _subscription_record_latency(subscription, ros_message, 0)
   return RCL_RET_OK;
 }
 
@@ -272,32 +415,227 @@ rcl_take_serialized_message(
   rcl_serialized_message_t * serialized_message,
   rmw_message_info_t * message_info)
 {
-  RCUTILS_LOG_DEBUG_NAMED(ROS_PACKAGE_NAME, "Subscription taking serialized message")
-  rcl_allocator_t error_allocator = rcl_get_default_allocator();
-  if (!rcl_subscription_is_valid(subscription, &error_allocator)) {
+  RCL_HOT_PATH_LOG_DEBUG("Subscription taking serialized message")
+  if (!_subscription_can_take(subscription) && !rcl_subscription_is_valid(subscription, NULL)) {
     return RCL_RET_SUBSCRIPTION_INVALID;  // error message already set
   }
   RCL_CHECK_ARGUMENT_FOR_NULL(
-    serialized_message, RCL_RET_INVALID_ARGUMENT, error_allocator);
+    serialized_message, RCL_RET_INVALID_ARGUMENT, rcl_get_default_allocator());
   // If message_info is NULL, use a place holder which can be discarded.
   rmw_message_info_t dummy_message_info;
   rmw_message_info_t * message_info_local = message_info ? message_info : &dummy_message_info;
   // Call rmw_take_with_info.
   bool taken = false;
-  rmw_ret_t ret = rmw_take_serialized_message_with_info(
-    subscription->impl->rmw_handle, serialized_message, &taken, message_info_local);
+  rmw_ret_t ret;
+  do {
+    ret = rmw_take_serialized_message_with_info(
+      subscription->impl->rmw_handle, serialized_message, &taken, message_info_local);
+  } while (_subscription_is_duplicate(
+    subscription->impl->intra_process, ret, taken, message_info_local));
   if (ret != RMW_RET_OK) {
-    RCL_SET_ERROR_MSG(rmw_get_error_string_safe(), error_allocator);
+    RCL_SET_ERROR_MSG(rmw_get_error_string_safe(), rcl_get_default_allocator());
     if (ret == RMW_RET_BAD_ALLOC) {
       return RCL_RET_BAD_ALLOC;
     }
     return RCL_RET_ERROR;
   }
-  RCUTILS_LOG_DEBUG_NAMED(
-    ROS_PACKAGE_NAME, "Subscription serialized take succeeded: %s", taken ? "true" : "false")
+  RCL_HOT_PATH_LOG_DEBUG("Subscription serialized take succeeded: %s", taken ? "true" : "false")
   if (!taken) {
+    _subscription_record_failure(subscription)
     return RCL_RET_SUBSCRIPTION_TAKE_FAILED;
   }
+  _subscription_record(subscription, 1, serialized_message->buffer_length)
+  return RCL_RET_OK;
+}
+
+rcl_ret_t
+rcl_take_loaned_message(
+  const rcl_subscription_t * subscription,
+  void ** loaned_message,
+  rmw_message_info_t * message_info)
+{
+  RCL_HOT_PATH_LOG_DEBUG("Subscription taking loaned message")
+  if (!_subscription_can_take(subscription) && !rcl_subscription_is_valid(subscription, NULL)) {
+    return RCL_RET_SUBSCRIPTION_INVALID;  // error message already set
+  }
+  RCL_CHECK_ARGUMENT_FOR_NULL(
+    loaned_message, RCL_RET_INVALID_ARGUMENT, rcl_get_default_allocator());
+  int64_t source_timestamp = 0;
+  if (
+    subscription->impl->intra_process &&
+    rcl_intra_process_subscription_take(
+      subscription->impl->intra_process, loaned_message, message_info, &source_timestamp))
+  {
+    _subscription_record(subscription, 1, 0)
+    _subscription_record_latency(subscription, *loaned_message, source_timestamp)
+    return RCL_RET_OK;
+  }
+  // The middleware cannot loan messages, so they come from the subscription's pool.
+  rcl_message_pool_t * pool = &(subscription->impl->loaned_messages);
+  rcl_ret_t ret;
+  if (NULL == pool->members) {
+    ret = rcl_message_pool_init(
+      pool, subscription->impl->type_support, 0u, true, &(subscription->impl->options.allocator));
+    if (RCL_RET_OK != ret) {
+      return ret;  // error message already set
+    }
+  }
+  void * message = NULL;
+  if (rcl_message_pool_loan(pool, &message) != RCL_RET_OK) {
+    if (pool->can_grow) {
+      RCL_SET_ERROR_MSG("allocating memory failed", rcl_get_default_allocator())
+      return RCL_RET_BAD_ALLOC;
+    }
+    RCL_SET_ERROR_MSG("all the messages of the pool are loaned", rcl_get_default_allocator())
+    return RCL_RET_SUBSCRIPTION_LOAN_FAILED;
+  }
+  // rcl_take() updates the statistics and measures the latency.
+  ret = rcl_take(subscription, message, message_info);
+  if (RCL_RET_OK != ret) {
+    // The rcl error state should already be set, unless nothing was taken.
+    rcl_ret_t return_ret = rcl_message_pool_return(pool, message);
+    (void)return_ret;
+    return ret;
+  }
+  *loaned_message = message;
+  return RCL_RET_OK;
+}
+
+rcl_ret_t
+rcl_return_loaned_message_from_subscription(
+  const rcl_subscription_t * subscription,
+  void * loaned_message)
+{
+  if (!rcl_subscription_is_valid(subscription, NULL)) {
+    return RCL_RET_SUBSCRIPTION_INVALID;  // error message already set
+  }
+  RCL_CHECK_ARGUMENT_FOR_NULL(
+    loaned_message, RCL_RET_INVALID_ARGUMENT, rcl_get_default_allocator());
+  rcl_intra_process_subscription_t * intra_process = subscription->impl->intra_process;
+  if (intra_process && rcl_intra_process_subscription_owns(intra_process, loaned_message)) {
+    return rcl_intra_process_subscription_return(intra_process, loaned_message);
+  }
+  if (NULL == subscription->impl->loaned_messages.members) {
+    RCL_SET_ERROR_MSG("message is not loaned from this subscription", rcl_get_default_allocator())
+    return RCL_RET_INVALID_ARGUMENT;
+  }
+  return rcl_message_pool_return(&(subscription->impl->loaned_messages), loaned_message);
+}
+
+rcl_ret_t
+rcl_take_batch(
+  const rcl_subscription_t * subscription,
+  void * const * ros_messages,
+  rmw_message_info_t * message_infos,
+  size_t capacity,
+  size_t * taken)
+{
+  RCL_CHECK_ARGUMENT_FOR_NULL(taken, RCL_RET_INVALID_ARGUMENT, rcl_get_default_allocator());
+  *taken = 0;
+  if (!_subscription_can_take(subscription) && !rcl_subscription_is_valid(subscription, NULL)) {
+    return RCL_RET_SUBSCRIPTION_INVALID;  // error message already set
+  }
+  RCL_CHECK_ARGUMENT_FOR_NULL(ros_messages, RCL_RET_INVALID_ARGUMENT, rcl_get_default_allocator());
+  // If message_infos is NULL, use a place holder which can be discarded.
+  rmw_message_info_t dummy_message_info;
+  rmw_subscription_t * rmw_handle = subscription->impl->rmw_handle;
+  rcl_intra_process_subscription_t * intra_process = subscription->impl->intra_process;
+  size_t i;
+  for (i = 0; i < capacity; ++i) {
+    rmw_message_info_t * message_info = message_infos ? &message_infos[i] : &dummy_message_info;
+    if (intra_process) {
+      int64_t source_timestamp = 0;
+      rcl_ret_t take_ret = rcl_intra_process_subscription_take_copy(
+        intra_process, ros_messages[i], message_info, &source_timestamp);
+      if (RCL_RET_OK == take_ret) {
+        _subscription_record_latency(subscription, ros_messages[i], source_timestamp)
+        continue;
+      }
+      if (RCL_RET_SUBSCRIPTION_TAKE_FAILED != take_ret) {
+        *taken = i;
+        if (i > 0) {
+          _subscription_record(subscription, i, 0)
+        }
+        return take_ret;  // error message already set
+      }
+    }
+    bool taken_one = false;
+    rmw_ret_t ret;
+    do {
+      ret = rmw_take_with_info(rmw_handle, ros_messages[i], &taken_one, message_info);
+    } while (_subscription_is_duplicate(intra_process, ret, taken_one, message_info));
+    if (ret != RMW_RET_OK) {
+      *taken = i;
+      if (i > 0) {
+        _subscription_record(subscription, i, 0)
+      }
+      RCL_SET_ERROR_MSG(rmw_get_error_string_safe(), rcl_get_default_allocator());
+      return ret == RMW_RET_BAD_ALLOC ? RCL_RET_BAD_ALLOC : RCL_RET_ERROR;
+    }
+    if (!taken_one) {
+      break;
+    }
+    _subscription_record_latency(subscription, ros_messages[i], 0)
+  }
+  *taken = i;
+  RCL_HOT_PATH_LOG_DEBUG("Subscription took %zu messages", i)
+  if (0 == i) {
+    _subscription_record_failure(subscription)
+    return RCL_RET_SUBSCRIPTION_TAKE_FAILED;
+  }
+  _subscription_record(subscription, i, 0)
+  return RCL_RET_OK;
+}
+
+rcl_ret_t
+rcl_take_serialized_message_batch(
+  const rcl_subscription_t * subscription,
+  rcl_serialized_message_t * serialized_messages,
+  rmw_message_info_t * message_infos,
+  size_t capacity,
+  size_t * taken)
+{
+  RCL_CHECK_ARGUMENT_FOR_NULL(taken, RCL_RET_INVALID_ARGUMENT, rcl_get_default_allocator());
+  *taken = 0;
+  if (!_subscription_can_take(subscription) && !rcl_subscription_is_valid(subscription, NULL)) {
+    return RCL_RET_SUBSCRIPTION_INVALID;  // error message already set
+  }
+  RCL_CHECK_ARGUMENT_FOR_NULL(
+    serialized_messages, RCL_RET_INVALID_ARGUMENT, rcl_get_default_allocator());
+  // If message_infos is NULL, use a place holder which can be discarded.
+  rmw_message_info_t dummy_message_info;
+  rmw_subscription_t * rmw_handle = subscription->impl->rmw_handle;
+  rcl_intra_process_subscription_t * intra_process = subscription->impl->intra_process;
+  uint64_t serialized_bytes = 0;
+  size_t i;
+  for (i = 0; i < capacity; ++i) {
+    rmw_message_info_t * message_info = message_infos ? &message_infos[i] : &dummy_message_info;
+    bool taken_one = false;
+    rmw_ret_t ret;
+    do {
+      ret = rmw_take_serialized_message_with_info(
+        rmw_handle, &serialized_messages[i], &taken_one, message_info);
+    } while (_subscription_is_duplicate(intra_process, ret, taken_one, message_info));
+    if (ret != RMW_RET_OK) {
+      *taken = i;
+      if (i > 0) {
+        _subscription_record(subscription, i, serialized_bytes)
+      }
+      RCL_SET_ERROR_MSG(rmw_get_error_string_safe(), rcl_get_default_allocator());
+      return ret == RMW_RET_BAD_ALLOC ? RCL_RET_BAD_ALLOC : RCL_RET_ERROR;
+    }
+    if (!taken_one) {
+      break;
+    }
+    serialized_bytes += serialized_messages[i].buffer_length;
+  }
+  *taken = i;
+  RCL_HOT_PATH_LOG_DEBUG("Subscription took %zu serialized messages", i)
+  if (0 == i) {
+    _subscription_record_failure(subscription)
+    return RCL_RET_SUBSCRIPTION_TAKE_FAILED;
+  }
+  _subscription_record(subscription, i, serialized_bytes)
   return RCL_RET_OK;
 }
 
@@ -330,6 +668,92 @@ rcl_subscription_get_rmw_handle(const rcl_subscription_t * subscription)
   return subscription->impl->rmw_handle;
 }
 
+rcl_ret_t
+rcl_subscription_get_statistics(
+  const rcl_subscription_t * subscription, rcl_subscription_statistics_t * statistics)
+{
+  if (!rcl_subscription_is_valid(subscription, NULL)) {
+    return RCL_RET_SUBSCRIPTION_INVALID;  // error message already set
+  }
+  RCL_CHECK_ARGUMENT_FOR_NULL(statistics, RCL_RET_INVALID_ARGUMENT, rcl_get_default_allocator());
+  if (!subscription->impl->options.enable_statistics) {
+    RCL_SET_ERROR_MSG("subscription does not keep statistics", rcl_get_default_allocator())
+    return RCL_RET_ERROR;
+  }
+  rcl_message_statistics_get(
+    &(subscription->impl->statistics), &(statistics->number_of_messages),
+    &(statistics->serialized_bytes), &(statistics->number_of_failed_takes),
+    statistics->interval_histogram);
+  statistics->number_of_dropped_messages = 0u;
+  if (subscription->impl->intra_process) {
+    statistics->number_of_dropped_messages =
+      rcl_intra_process_subscription_get_number_of_dropped_messages(
+      subscription->impl->intra_process);
+  }
+  return RCL_RET_OK;
+}
+
+rcl_ret_t
+rcl_subscription_reset_statistics(const rcl_subscription_t * subscription)
+{
+  if (!rcl_subscription_is_valid(subscription, NULL)) {
+    return RCL_RET_SUBSCRIPTION_INVALID;  // error message already set
+  }
+  if (!subscription->impl->options.enable_statistics) {
+    RCL_SET_ERROR_MSG("subscription does not keep statistics", rcl_get_default_allocator())
+    return RCL_RET_ERROR;
+  }
+  rcl_message_statistics_reset(&(subscription->impl->statistics));
+  if (subscription->impl->intra_process) {
+    rcl_intra_process_subscription_reset_number_of_dropped_messages(
+      subscription->impl->intra_process);
+  }
+  return RCL_RET_OK;
+}
+
+// Same checks as rcl_subscription_get_statistics(), for the latency functions.
+#define _subscription_check_latency(sub) \
+  if (!rcl_subscription_is_valid(sub, NULL)) { \
+    return RCL_RET_SUBSCRIPTION_INVALID;  /* error message already set */ \
+  } \
+  if (NULL == (sub)->impl->latency) { \
+    RCL_SET_ERROR_MSG("subscription does not measure latencies", rcl_get_default_allocator()) \
+    return RCL_RET_ERROR; \
+  }
+
+rcl_ret_t
+rcl_subscription_get_latency_statistics(
+  const rcl_subscription_t * subscription,
+  rcl_subscription_latency_statistics_t * statistics)
+{
+  _subscription_check_latency(subscription)
+  RCL_CHECK_ARGUMENT_FOR_NULL(statistics, RCL_RET_INVALID_ARGUMENT, rcl_get_default_allocator());
+  rcl_message_latency_get(subscription->impl->latency, statistics);
+  return RCL_RET_OK;
+}
+
+rcl_ret_t
+rcl_subscription_get_latency_percentile(
+  const rcl_subscription_t * subscription, double percentile, int64_t * latency)
+{
+  _subscription_check_latency(subscription)
+  RCL_CHECK_ARGUMENT_FOR_NULL(latency, RCL_RET_INVALID_ARGUMENT, rcl_get_default_allocator());
+  if (!(percentile >= 0.0 && percentile <= 100.0)) {
+    RCL_SET_ERROR_MSG("percentile must be between 0 and 100", rcl_get_default_allocator())
+    return RCL_RET_INVALID_ARGUMENT;
+  }
+  *latency = rcl_message_latency_get_percentile(subscription->impl->latency, percentile);
+  return RCL_RET_OK;
+}
+
+rcl_ret_t
+rcl_subscription_reset_latency_statistics(const rcl_subscription_t * subscription)
+{
+  _subscription_check_latency(subscription)
+  rcl_message_latency_reset(subscription->impl->latency);
+  return RCL_RET_OK;
+}
+
 bool
 rcl_subscription_is_valid(
   const rcl_subscription_t * subscription,
@@ -0,0 +1,36 @@
+// Copyright 2018 Open Source Robotics Foundation, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef RCL__SUBSCRIPTION_IMPL_H_
+#define RCL__SUBSCRIPTION_IMPL_H_
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+#include "rcl/subscription.h"
+
+#include "./intra_process.h"
+
+/// Return the intra-process side of the subscription, or NULL without the `intra_process` option.
+/* The subscription must be valid. */
+rcl_intra_process_subscription_t *
+rcl_subscription_get_intra_process(const rcl_subscription_t * subscription);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif  // RCL__SUBSCRIPTION_IMPL_H_
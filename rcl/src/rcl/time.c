@@ -15,30 +15,314 @@
 #include "rcl/time.h"
 
 #include <stdbool.h>
+#include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
+#if defined(__x86_64__) || defined(__i386__) || defined(_M_X64) || defined(_M_IX86)
+#define RCL_HAS_TSC
+#if defined(_MSC_VER)
+#include <intrin.h>
+#else
+#include <cpuid.h>
+#include <x86intrin.h>
+#endif  // defined(_MSC_VER)
+#endif  // x86
+#if defined(_WIN32)
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sched.h>
+#include <sys/file.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif  // defined(_WIN32)
 
 #include "./common.h"
+#include "./mutex.h"
 #include "./stdatomic_helper.h"
+#include "./time_impl.h"
 #include "rcl/allocator.h"
 #include "rcl/error_handling.h"
+#include "rcutils/get_env.h"
+#include "rcutils/logging_macros.h"
+#include "rcutils/macros.h"
 #include "rcutils/time.h"
 
+#define RCL_STEADY_TIME_SOURCE_VAR_NAME "RCL_STEADY_TIME_SOURCE"
+// Number of fractional bits of the nanoseconds per tick of the time stamp counter.
+#define RCL_TSC_SCALE_SHIFT 24
+#define RCL_TSC_CALIBRATION_DURATION RCUTILS_MS_TO_NS(10)
+
 
 // Internal storage for RCL_ROS_TIME implementation
 typedef struct rcl_ros_clock_storage_t
 {
   atomic_uint_least64_t current_time;
   bool active;
+  // Time written by a shared time authority, mapped from its file, or NULL.
+  atomic_int_least64_t * shared_time;
+  // Shared time reported by the clock, which trails the shared time until the
+  // jump callbacks for a change have been called.
+  atomic_int_least64_t last_shared_time;
+  // True while a thread calls the jump callbacks for a change of the shared time.
+  atomic_bool shared_time_jumping;
+  // Steady time at which the last change of the shared time was seen, or 0.
+  atomic_int_least64_t shared_steady_time;
+  // Bits of the double rate the shared time was seen moving at, or 0 if not known yet.
+  atomic_uint_least64_t shared_rate_bits;
+  // Extrapolation of the override between updates, current_time holding the last update.
+  atomic_bool extrapolate;
+  // Odd while the extrapolation is being updated.
+  atomic_uint_least64_t extrapolation_sequence;
+  atomic_int_least64_t base_time;
+  atomic_int_least64_t base_steady_time;
+  // Bits of the double rate of the time, in nanoseconds per steady nanosecond.
+  atomic_uint_least64_t rate_bits;
+  // Steady duration after which the extrapolation stops.
+  atomic_int_least64_t max_extrapolation;
 } rcl_ros_clock_storage_t;
 
+typedef struct rcl_shared_time_authority_impl_t
+{
+  // The file holding the shared time, locked for as long as the authority lives.
+  int fd;
+  atomic_int_least64_t * shared_time;
+  rcl_allocator_t allocator;
+} rcl_shared_time_authority_impl_t;
+
+// Node of the list of jump callbacks of a clock, immutable once added but for its next node.
+typedef struct rcl_jump_callback_node_t
+{
+  rcl_jump_callback_info_t info;
+  // Next node, as a rcl_jump_callback_node_t pointer, or 0 at the end of the list.
+  atomic_uintptr_t next;
+  // Next node waiting to be freed once unlinked, as next must stay valid for the readers.
+  struct rcl_jump_callback_node_t * retired_next;
+} rcl_jump_callback_node_t;
+
+// List of the jump callbacks of a clock, called without locks while it changes.
+/* Calls walk the list between entering and leaving the reader count of the current phase.
+ * Changes are serialized by a mutex, and a removed node is only freed once the readers
+ * which may still see it have left, as done by sleepable RCU: once the count of the other
+ * phase has drained, the phase is flipped, and the nodes unlinked before are freed when the
+ * count of the previous phase has drained too.
+ * Changes never wait for the readers while holding the mutex, they free the nodes which are
+ * safe to free and leave the others to the next change, so that callbacks can change the
+ * callbacks of their own clock.
+ */
+typedef struct rcl_jump_callback_list_t
+{
+  // First node, as a rcl_jump_callback_node_t pointer, or 0 if the list is empty.
+  atomic_uintptr_t head;
+  // Last node, only used by changes.
+  rcl_jump_callback_node_t * tail;
+  atomic_uint_least64_t phase;
+  atomic_uint_least64_t readers[2];
+  // Nodes unlinked since the last flip of the phase.
+  rcl_jump_callback_node_t * retired;
+  // Nodes unlinked before the last flip, freed once the previous phase has drained.
+  rcl_jump_callback_node_t * flipped;
+  // Numbers of nodes unlinked and freed, telling a removal when its node is freed.
+  uint64_t number_of_retired;
+  uint64_t number_of_freed;
+  // Held by changes, calls of the callbacks never take it.
+  rcl_mutex_t lock;
+} rcl_jump_callback_list_t;
+
+// Call of the callbacks of a list by the current thread, within the calls it is made from.
+typedef struct rcl_jump_callback_call_t
+{
+  const rcl_jump_callback_list_t * list;
+  const struct rcl_jump_callback_call_t * outer;
+} rcl_jump_callback_call_t;
+
+// Innermost call of jump callbacks by the current thread, telling removals made by callbacks.
+static RCUTILS_THREAD_LOCAL const rcl_jump_callback_call_t * _rcl_jump_callback_calls = NULL;
+
+// Conversion of the time stamp counter to steady time, set once by rcl_steady_time_source_init()
+typedef struct rcl_tsc_calibration_t
+{
+  uint64_t base_ticks;
+  rcl_time_point_value_t base_time;
+  // Nanoseconds per tick, as a fixed point number with RCL_TSC_SCALE_SHIFT fractional bits.
+  uint64_t scale;
+} rcl_tsc_calibration_t;
+
+static rcl_tsc_calibration_t __rcl_tsc_calibration;
+static atomic_bool __rcl_use_tsc = ATOMIC_VAR_INIT(false);
+static atomic_bool __rcl_steady_time_source_initialized = ATOMIC_VAR_INIT(false);
+
+// Follow the shared time of a ROS clock, needed by rcl_clock_get_now() ahead of its definition.
+static void
+_rcl_clock_update_shared_time(rcl_clock_t * clock);
+
+#if defined(RCL_HAS_TSC)
+static inline rcl_time_point_value_t
+_rcl_tsc_to_time(const rcl_tsc_calibration_t * calibration, uint64_t ticks)
+{
+  uint64_t elapsed = ticks - calibration->base_ticks;
+  // Split the product so that it cannot overflow.
+  uint64_t high = (elapsed >> RCL_TSC_SCALE_SHIFT) * calibration->scale;
+  uint64_t low = ((elapsed & ((1ull << RCL_TSC_SCALE_SHIFT) - 1)) * calibration->scale) >>
+    RCL_TSC_SCALE_SHIFT;
+  return calibration->base_time + (rcl_time_point_value_t)(high + low);
+}
+#endif  // defined(RCL_HAS_TSC)
+
 // Implementation only
 rcl_ret_t
 rcl_get_steady_time(void * data, rcl_time_point_value_t * current_time)
 {
   (void)data;  // unused
+#if defined(RCL_HAS_TSC)
+  if (rcl_atomic_load_bool(&__rcl_use_tsc)) {
+    *current_time = _rcl_tsc_to_time(&__rcl_tsc_calibration, __rdtsc());
+    return RCL_RET_OK;
+  }
+#endif  // defined(RCL_HAS_TSC)
   return rcutils_steady_time_now(current_time);
 }
 
+#if defined(RCL_HAS_TSC)
+// Check that the time stamp counter ticks at a constant rate, and is trusted by the kernel.
+static bool
+_rcl_tsc_is_reliable(void)
+{
+#if defined(_MSC_VER)
+  int info[4];
+  __cpuid(info, 0x80000000);
+  if ((unsigned int)info[0] < 0x80000007) {
+    return false;
+  }
+  __cpuid(info, 0x80000007);
+  unsigned int edx = (unsigned int)info[3];
+#else
+  unsigned int eax, ebx, ecx, edx;
+  if (!__get_cpuid(0x80000007, &eax, &ebx, &ecx, &edx)) {
+    return false;
+  }
+#endif  // defined(_MSC_VER)
+  // Invariant TSC bit.
+  if (!(edx & (1u << 8))) {
+    return false;
+  }
+#if defined(__linux__)
+  // The kernel stops using the time stamp counter when it finds it unsynchronized across
+  // processors, or unstable, so follow its lead when it can be asked.
+  FILE * file = fopen("/sys/devices/system/clocksource/clocksource0/current_clocksource", "r");
+  if (file) {
+    char clocksource[32] = {0};
+    bool is_tsc = fgets(clocksource, sizeof(clocksource), file) &&
+      0 == strncmp(clocksource, "tsc", 3);
+    fclose(file);
+    return is_tsc;
+  }
+#endif  // defined(__linux__)
+  return true;
+}
+
+// Read the time stamp counter and the steady time of the system at the same instant.
+static bool
+_rcl_tsc_read_pair(uint64_t * ticks, rcl_time_point_value_t * time)
+{
+  // Keep the attempt which is the least disturbed, e.g. by an interrupt.
+  uint64_t best_window = UINT64_MAX;
+  for (int attempt = 0; attempt < 8; ++attempt) {
+    rcl_time_point_value_t now = 0;
+    uint64_t before = __rdtsc();
+    if (RCUTILS_RET_OK != rcutils_steady_time_now(&now)) {
+      return false;
+    }
+    uint64_t after = __rdtsc();
+    if (after - before < best_window) {
+      best_window = after - before;
+      *ticks = before + (after - before) / 2;
+      *time = now;
+    }
+  }
+  return true;
+}
+
+static bool
+_rcl_tsc_calibrate(rcl_tsc_calibration_t * calibration)
+{
+  uint64_t start_ticks = 0;
+  rcl_time_point_value_t start_time = 0;
+  if (!_rcl_tsc_read_pair(&start_ticks, &start_time)) {
+    return false;
+  }
+  rcl_time_point_value_t now = start_time;
+  while (now - start_time < RCL_TSC_CALIBRATION_DURATION) {
+    if (RCUTILS_RET_OK != rcutils_steady_time_now(&now)) {
+      return false;
+    }
+  }
+  uint64_t end_ticks = 0;
+  rcl_time_point_value_t end_time = 0;
+  if (!_rcl_tsc_read_pair(&end_ticks, &end_time)) {
+    return false;
+  }
+  if (end_ticks <= start_ticks || end_time <= start_time) {
+    return false;
+  }
+  calibration->scale =
+    ((uint64_t)(end_time - start_time) << RCL_TSC_SCALE_SHIFT) / (end_ticks - start_ticks);
+  if (0 == calibration->scale) {
+    return false;
+  }
+  // Continue from the time of the system, so that the steady time does not jump.
+  calibration->base_ticks = end_ticks;
+  calibration->base_time = end_time;
+  return true;
+}
+#endif  // defined(RCL_HAS_TSC)
+
+void
+rcl_steady_time_source_init(void)
+{
+  if (rcl_atomic_exchange_bool(&__rcl_steady_time_source_initialized, true)) {
+    return;
+  }
+  const char * source = NULL;
+  if (rcutils_get_env(RCL_STEADY_TIME_SOURCE_VAR_NAME, &source)) {
+    RCUTILS_LOG_WARN_NAMED(ROS_PACKAGE_NAME,
+      "Environment variable " RCL_STEADY_TIME_SOURCE_VAR_NAME " could not be read, "
+      "using the steady clock of the system")
+    return;
+  }
+  if (0 != strcmp(source, "tsc")) {
+    return;
+  }
+#if defined(RCL_HAS_TSC)
+  if (!_rcl_tsc_is_reliable()) {
+    RCUTILS_LOG_WARN_NAMED(ROS_PACKAGE_NAME,
+      "The time stamp counter is not invariant, or not trusted by the system, "
+      "using the steady clock of the system")
+    return;
+  }
+  if (!_rcl_tsc_calibrate(&__rcl_tsc_calibration)) {
+    RCUTILS_LOG_WARN_NAMED(ROS_PACKAGE_NAME,
+      "Failed to calibrate the time stamp counter, using the steady clock of the system")
+    return;
+  }
+  rcl_atomic_store(&__rcl_use_tsc, true);
+  RCUTILS_LOG_DEBUG_NAMED(ROS_PACKAGE_NAME,
+    "Using the time stamp counter as steady time, at %f ns per tick",
+    (double)__rcl_tsc_calibration.scale / (double)(1ull << RCL_TSC_SCALE_SHIFT))
+#else
+  RCUTILS_LOG_WARN_NAMED(ROS_PACKAGE_NAME,
+    "There is no time stamp counter on this platform, using the steady clock of the system")
+#endif  // defined(RCL_HAS_TSC)
+}
+
+rcl_steady_time_source_t
+rcl_get_steady_time_source(void)
+{
+  return rcl_atomic_load_bool(&__rcl_use_tsc) ?
+         RCL_STEADY_TIME_SOURCE_TSC : RCL_STEADY_TIME_SOURCE_SYSTEM;
+}
+
 // Implementation only
 rcl_ret_t
 rcl_get_system_time(void * data, rcl_time_point_value_t * current_time)
@@ -58,6 +342,170 @@ rcl_init_generic_clock(rcl_clock_t * clock)
   clock->data = NULL;
 }
 
+// Internal method allocating the empty list of jump callbacks, assumes clock is valid
+static rcl_ret_t
+_rcl_clock_init_jump_callbacks(rcl_clock_t * clock, rcl_allocator_t * allocator)
+{
+  rcl_jump_callback_list_t * list = (rcl_jump_callback_list_t *)allocator->allocate(
+    sizeof(rcl_jump_callback_list_t), allocator->state);
+  if (!list) {
+    RCL_SET_ERROR_MSG("Failed to allocate jump callbacks", *allocator);
+    return RCL_RET_BAD_ALLOC;
+  }
+  atomic_init(&(list->head), 0);
+  list->tail = NULL;
+  atomic_init(&(list->phase), 0);
+  atomic_init(&(list->readers[0]), 0);
+  atomic_init(&(list->readers[1]), 0);
+  list->retired = NULL;
+  list->flipped = NULL;
+  list->number_of_retired = 0u;
+  list->number_of_freed = 0u;
+  if (rcl_mutex_init(&(list->lock)) != RCL_RET_OK) {
+    RCL_SET_ERROR_MSG("Failed to initialize jump callbacks lock", *allocator);
+    allocator->deallocate(list, allocator->state);
+    return RCL_RET_ERROR;
+  }
+  clock->jump_callbacks = list;
+  return RCL_RET_OK;
+}
+
+// Let the readers holding up a change run, on a busy or single processor.
+static void
+_rcl_jump_callback_list_yield(void)
+{
+#if defined(_WIN32)
+  SwitchToThread();
+#else
+  sched_yield();
+#endif  // defined(_WIN32)
+}
+
+// Free a chain of retired nodes, with the list locked.
+static void
+_rcl_jump_callback_list_free(
+  rcl_jump_callback_list_t * list, rcl_jump_callback_node_t * node, rcl_allocator_t * allocator)
+{
+  while (node) {
+    rcl_jump_callback_node_t * next = node->retired_next;
+    allocator->deallocate(node, allocator->state);
+    ++(list->number_of_freed);
+    node = next;
+  }
+}
+
+// Free the unlinked nodes no call of the callbacks can see anymore, with the list locked.
+/* Never waits for the readers, the nodes still in use are left to a later change.
+ */
+static void
+_rcl_jump_callback_list_reclaim(rcl_jump_callback_list_t * list, rcl_allocator_t * allocator)
+{
+  uint64_t phase = rcl_atomic_load_uint64_t(&(list->phase));
+  // Readers still counted in the other phase read it before the last flip, and may see the
+  // nodes unlinked before it.
+  if (0u != rcl_atomic_load_uint64_t(&(list->readers[(phase + 1u) & 1u]))) {
+    return;
+  }
+  _rcl_jump_callback_list_free(list, list->flipped, allocator);
+  list->flipped = NULL;
+  if (!list->retired) {
+    return;
+  }
+  rcl_atomic_store(&(list->phase), phase + 1u);
+  list->flipped = list->retired;
+  list->retired = NULL;
+  // Readers entering from now on count in the other phase, and cannot see the unlinked nodes.
+  if (0u == rcl_atomic_load_uint64_t(&(list->readers[phase & 1u]))) {
+    _rcl_jump_callback_list_free(list, list->flipped, allocator);
+    list->flipped = NULL;
+  }
+}
+
+// Tell if the current thread is calling the callbacks of the list, from any of them.
+static bool
+_rcl_jump_callback_list_is_called(const rcl_jump_callback_list_t * list)
+{
+  const rcl_jump_callback_call_t * call = _rcl_jump_callback_calls;
+  for (; call; call = call->outer) {
+    if (call->list == list) {
+      return true;
+    }
+  }
+  return false;
+}
+
+static double
+_rcl_ros_clock_get_rate(atomic_uint_least64_t * rate_bits)
+{
+  uint64_t bits = rcl_atomic_load_uint64_t(rate_bits);
+  double rate = 0.0;
+  memcpy(&rate, &bits, sizeof(rate));
+  return rate;
+}
+
+static void
+_rcl_ros_clock_set_rate(atomic_uint_least64_t * rate_bits, double rate)
+{
+  uint64_t bits = 0;
+  memcpy(&bits, &rate, sizeof(bits));
+  rcl_atomic_store(rate_bits, bits);
+}
+
+// Let an update of the extrapolation finish, which only takes a few stores.
+static inline void
+_rcl_ros_clock_extrapolation_pause(void)
+{
+#if defined(RCL_HAS_TSC)
+  _mm_pause();
+#elif defined(__aarch64__) && !defined(_MSC_VER)
+  __asm__ __volatile__ ("yield");
+#elif defined(_WIN32)
+  SwitchToThread();
+#else
+  sched_yield();
+#endif
+}
+
+// Extrapolate the override at the given steady time, from a consistent extrapolation.
+static rcl_time_point_value_t
+_rcl_ros_clock_extrapolate_at(
+  rcl_ros_clock_storage_t * storage, rcl_time_point_value_t steady_time)
+{
+  int64_t elapsed = steady_time - rcl_atomic_load_int64_t(&(storage->base_steady_time));
+  int64_t max_extrapolation = rcl_atomic_load_int64_t(&(storage->max_extrapolation));
+  if (elapsed < 0) {
+    elapsed = 0;
+  } else if (elapsed > max_extrapolation) {
+    elapsed = max_extrapolation;
+  }
+  return rcl_atomic_load_int64_t(&(storage->base_time)) +
+         (rcl_time_point_value_t)(_rcl_ros_clock_get_rate(&(storage->rate_bits)) * (double)elapsed);
+}
+
+static rcl_ret_t
+_rcl_ros_clock_extrapolate(
+  rcl_ros_clock_storage_t * storage, rcl_time_point_value_t * current_time)
+{
+  for (;;) {
+    uint64_t sequence = rcl_atomic_load_uint64_t(&(storage->extrapolation_sequence));
+    if (sequence & 1u) {
+      _rcl_ros_clock_extrapolation_pause();
+      continue;
+    }
+    // Read the steady time within the sequence, so that the time never goes backward.
+    rcl_time_point_value_t steady_now = 0;
+    rcl_ret_t ret = rcl_get_steady_time(NULL, &steady_now);
+    if (ret != RCL_RET_OK) {
+      return ret;
+    }
+    rcl_time_point_value_t time = _rcl_ros_clock_extrapolate_at(storage, steady_now);
+    if (rcl_atomic_load_uint64_t(&(storage->extrapolation_sequence)) == sequence) {
+      *current_time = time;
+      return RCL_RET_OK;
+    }
+  }
+}
+
 // The function used to get the current ros time.
 // This is in the implementation only
 rcl_ret_t
@@ -67,10 +515,101 @@ rcl_get_ros_time(void * data, rcl_time_point_value_t * current_time)
   if (!t->active) {
     return rcl_get_system_time(data, current_time);
   }
+  if (t->shared_time) {
+    *current_time = rcl_atomic_load_int64_t(&(t->last_shared_time));
+    return RCL_RET_OK;
+  }
+  if (rcl_atomic_load_bool(&(t->extrapolate))) {
+    return _rcl_ros_clock_extrapolate(t, current_time);
+  }
   *current_time = rcl_atomic_load_uint64_t(&(t->current_time));
   return RCL_RET_OK;
 }
 
+// Record an update of the override, keeping the extrapolated time from going backward.
+/* The lead the extrapolated time may have over the update is absorbed over the next
+ * interval, so that it stays within one update of the updates.
+ */
+static rcl_ret_t
+_rcl_ros_clock_update_extrapolation(
+  rcl_ros_clock_storage_t * storage, rcl_time_point_value_t time_value)
+{
+  // Read outside of the sequence, which readers spin on while it is odd.
+  // Readers done before the sequence is taken may have extrapolated slightly past the
+  // base set below, by the time it takes to take the sequence.
+  rcl_time_point_value_t steady_now = 0;
+  rcl_ret_t ret = rcl_get_steady_time(NULL, &steady_now);
+  if (ret != RCL_RET_OK) {
+    return ret;
+  }
+  uint64_t sequence = rcl_atomic_load_uint64_t(&(storage->extrapolation_sequence));
+  while ((sequence & 1u) ||
+    !rcl_atomic_compare_exchange_strong_uint_least64_t(
+      &(storage->extrapolation_sequence), &sequence, sequence + 1u))
+  {
+    _rcl_ros_clock_extrapolation_pause();
+    sequence = rcl_atomic_load_uint64_t(&(storage->extrapolation_sequence));
+  }
+  rcl_time_point_value_t last_time = rcl_atomic_load_uint64_t(&(storage->current_time));
+  rcl_time_point_value_t last_steady_time =
+    rcl_atomic_load_int64_t(&(storage->base_steady_time));
+  if (steady_now < last_steady_time) {
+    // A concurrent update read the steady time later, but got in first.
+    steady_now = last_steady_time;
+  }
+  rcl_time_point_value_t base_time = time_value;
+  if (time_value >= last_time) {
+    // Moving forward, possibly behind the time extrapolated so far.
+    rcl_time_point_value_t extrapolated_time =
+      _rcl_ros_clock_extrapolate_at(storage, steady_now);
+    if (extrapolated_time > base_time) {
+      base_time = extrapolated_time;
+    }
+  }
+  int64_t steady_interval = steady_now - last_steady_time;
+  if (steady_interval > 0 && 0 != last_steady_time) {
+    // Slew back to the updates when ahead of them, by moving slower until the time the next
+    // update is expected at, rather than carrying the lead over to every later update.
+    double rate =
+      (double)(time_value - last_time - (base_time - time_value)) / (double)steady_interval;
+    if (rate < 0.0) {
+      rate = 0.0;
+    }
+    _rcl_ros_clock_set_rate(&(storage->rate_bits), rate);
+    rcl_atomic_store(&(storage->max_extrapolation), steady_interval);
+  }
+  rcl_atomic_store(&(storage->current_time), time_value);
+  rcl_atomic_store(&(storage->base_time), base_time);
+  rcl_atomic_store(&(storage->base_steady_time), steady_now);
+  rcl_atomic_store(&(storage->extrapolation_sequence), sequence + 2u);
+  return RCL_RET_OK;
+}
+
+int64_t
+rcl_ros_clock_get_steady_duration(const rcl_clock_t * clock, int64_t duration)
+{
+  rcl_ros_clock_storage_t * storage = (rcl_ros_clock_storage_t *)clock->data;
+  if (storage->shared_time) {
+    // Nothing wakes up the waits when the authority sets the time, so they poll it
+    // at least every duration, sooner if the time was seen moving faster.
+    double rate = _rcl_ros_clock_get_rate(&(storage->shared_rate_bits));
+    if (rate <= 1.0) {
+      return duration;
+    }
+    return (int64_t)((double)duration / rate);
+  }
+  if (!rcl_atomic_load_bool(&(storage->extrapolate))) {
+    return INT64_MAX;
+  }
+  double rate = _rcl_ros_clock_get_rate(&(storage->rate_bits));
+  double steady_duration = (double)duration / rate;
+  if (rate <= 0.0 || steady_duration >= (double)INT64_MAX) {
+    // The time is not extrapolated, or too slowly to wait for it.
+    return INT64_MAX;
+  }
+  return (int64_t)steady_duration;
+}
+
 bool
 rcl_clock_valid(rcl_clock_t * clock)
 {
@@ -111,11 +650,25 @@ _rcl_clock_generic_fini(
   rcl_clock_t * clock)
 {
   // Internal function; assume caller has already checked that clock is valid.
-  if (clock->num_jump_callbacks > 0) {
-    clock->num_jump_callbacks = 0;
-    clock->allocator.deallocate(clock->jump_callbacks, clock->allocator.state);
-    clock->jump_callbacks = NULL;
+  rcl_jump_callback_list_t * list = clock->jump_callbacks;
+  if (!list) {
+    return;
   }
+  // Nothing can call the callbacks of a clock being finalized.
+  rcl_jump_callback_node_t * node =
+    (rcl_jump_callback_node_t *)rcl_atomic_load_uintptr_t(&(list->head));
+  while (node) {
+    rcl_jump_callback_node_t * next =
+      (rcl_jump_callback_node_t *)rcl_atomic_load_uintptr_t(&(node->next));
+    clock->allocator.deallocate(node, clock->allocator.state);
+    node = next;
+  }
+  _rcl_jump_callback_list_free(list, list->retired, &(clock->allocator));
+  _rcl_jump_callback_list_free(list, list->flipped, &(clock->allocator));
+  rcl_mutex_fini(&(list->lock));
+  clock->allocator.deallocate(list, clock->allocator.state);
+  clock->jump_callbacks = NULL;
+  clock->num_jump_callbacks = 0;
 }
 
 rcl_ret_t
@@ -147,11 +700,33 @@ rcl_ros_clock_init(
   RCL_CHECK_ARGUMENT_FOR_NULL(clock, RCL_RET_INVALID_ARGUMENT, rcl_get_default_allocator());
   RCL_CHECK_ARGUMENT_FOR_NULL(allocator, RCL_RET_INVALID_ARGUMENT, rcl_get_default_allocator());
   rcl_init_generic_clock(clock);
+  rcl_ret_t ret = _rcl_clock_init_jump_callbacks(clock, allocator);
+  if (ret != RCL_RET_OK) {
+    return ret;
+  }
   clock->data = allocator->allocate(sizeof(rcl_ros_clock_storage_t), allocator->state);
   rcl_ros_clock_storage_t * storage = (rcl_ros_clock_storage_t *)clock->data;
+  if (!storage) {
+    rcl_mutex_fini(&(clock->jump_callbacks->lock));
+    allocator->deallocate(clock->jump_callbacks, allocator->state);
+    clock->jump_callbacks = NULL;
+    RCL_SET_ERROR_MSG("Failed to allocate ROS clock storage", *allocator);
+    return RCL_RET_BAD_ALLOC;
+  }
   // 0 is a special value meaning time has not been set
   atomic_init(&(storage->current_time), 0);
   storage->active = false;
+  storage->shared_time = NULL;
+  atomic_init(&(storage->last_shared_time), 0);
+  atomic_init(&(storage->shared_time_jumping), false);
+  atomic_init(&(storage->shared_steady_time), 0);
+  atomic_init(&(storage->shared_rate_bits), 0);
+  atomic_init(&(storage->extrapolate), false);
+  atomic_init(&(storage->extrapolation_sequence), 0);
+  atomic_init(&(storage->base_time), 0);
+  atomic_init(&(storage->base_steady_time), 0);
+  atomic_init(&(storage->rate_bits), 0);
+  atomic_init(&(storage->max_extrapolation), 0);
   clock->get_now = rcl_get_ros_time;
   clock->type = RCL_ROS_TIME;
   clock->allocator = *allocator;
@@ -172,6 +747,12 @@ rcl_ros_clock_fini(
     RCL_SET_ERROR_MSG("clock data invalid", rcl_get_default_allocator());
     return RCL_RET_ERROR;
   }
+#if !defined(_WIN32)
+  rcl_ros_clock_storage_t * storage = (rcl_ros_clock_storage_t *)clock->data;
+  if (storage->shared_time) {
+    munmap((void *)storage->shared_time, sizeof(atomic_int_least64_t));
+  }
+#endif  // !defined(_WIN32)
   clock->allocator.deallocate((rcl_ros_clock_storage_t *)clock->data, clock->allocator.state);
   return RCL_RET_OK;
 }
@@ -184,6 +765,10 @@ rcl_steady_clock_init(
   RCL_CHECK_ARGUMENT_FOR_NULL(clock, RCL_RET_INVALID_ARGUMENT, rcl_get_default_allocator());
   RCL_CHECK_ARGUMENT_FOR_NULL(allocator, RCL_RET_INVALID_ARGUMENT, rcl_get_default_allocator());
   rcl_init_generic_clock(clock);
+  rcl_ret_t ret = _rcl_clock_init_jump_callbacks(clock, allocator);
+  if (ret != RCL_RET_OK) {
+    return ret;
+  }
   clock->get_now = rcl_get_steady_time;
   clock->type = RCL_STEADY_TIME;
   clock->allocator = *allocator;
@@ -211,6 +796,10 @@ rcl_system_clock_init(
   RCL_CHECK_ARGUMENT_FOR_NULL(clock, RCL_RET_INVALID_ARGUMENT, rcl_get_default_allocator());
   RCL_CHECK_ARGUMENT_FOR_NULL(allocator, RCL_RET_INVALID_ARGUMENT, rcl_get_default_allocator());
   rcl_init_generic_clock(clock);
+  rcl_ret_t ret = _rcl_clock_init_jump_callbacks(clock, allocator);
+  if (ret != RCL_RET_OK) {
+    return ret;
+  }
   clock->get_now = rcl_get_system_time;
   clock->type = RCL_SYSTEM_TIME;
   clock->allocator = *allocator;
@@ -256,6 +845,10 @@ rcl_clock_get_now(rcl_clock_t * clock, rcl_time_point_value_t * time_point_value
   RCL_CHECK_ARGUMENT_FOR_NULL(
     time_point_value, RCL_RET_INVALID_ARGUMENT, rcl_get_default_allocator());
   if (clock->type && clock->get_now) {
+    if (RCL_ROS_TIME == clock->type) {
+      // Changes of a shared time are only noticed when reading it.
+      _rcl_clock_update_shared_time(clock);
+    }
     return clock->get_now(clock->data, time_point_value);
   }
   RCL_SET_ERROR_MSG(
@@ -269,10 +862,21 @@ _rcl_clock_call_callbacks(
   rcl_clock_t * clock, const rcl_time_jump_t * time_jump, bool before_jump)
 {
   // Internal function; assume parameters are valid.
+  rcl_jump_callback_list_t * list = clock->jump_callbacks;
+  if (!list) {
+    return;
+  }
   bool is_clock_change = time_jump->clock_change == RCL_ROS_TIME_ACTIVATED ||
     time_jump->clock_change == RCL_ROS_TIME_DEACTIVATED;
-  for (size_t cb_idx = 0; cb_idx < clock->num_jump_callbacks; ++cb_idx) {
-    rcl_jump_callback_info_t * info = &(clock->jump_callbacks[cb_idx]);
+  // Wait-free: the nodes reachable once counted as a reader are not freed until it leaves.
+  uint64_t phase = rcl_atomic_load_uint64_t(&(list->phase)) & 1u;
+  rcl_atomic_fetch_add_uint64_t(&(list->readers[phase]), 1u);
+  rcl_jump_callback_call_t call = {list, _rcl_jump_callback_calls};
+  _rcl_jump_callback_calls = &call;
+  rcl_jump_callback_node_t * node =
+    (rcl_jump_callback_node_t *)rcl_atomic_load_uintptr_t(&(list->head));
+  for (; node; node = (rcl_jump_callback_node_t *)rcl_atomic_load_uintptr_t(&(node->next))) {
+    const rcl_jump_callback_info_t * info = &(node->info);
     if (
       (is_clock_change && info->threshold.on_clock_change) ||
       (time_jump->delta.nanoseconds < 0 &&
@@ -283,6 +887,51 @@ _rcl_clock_call_callbacks(
       info->callback(time_jump, before_jump, info->user_data);
     }
   }
+  _rcl_jump_callback_calls = call.outer;
+  // Adding the largest value wraps around, leaving the reader count.
+  rcl_atomic_fetch_add_uint64_t(&(list->readers[phase]), UINT64_MAX);
+}
+
+static void
+_rcl_clock_update_shared_time(rcl_clock_t * clock)
+{
+  // Internal function; assume caller has already checked that clock is valid.
+  rcl_ros_clock_storage_t * storage = (rcl_ros_clock_storage_t *)clock->data;
+  if (!storage || !storage->shared_time || !storage->active) {
+    return;
+  }
+  if (rcl_atomic_load_int64_t(storage->shared_time) ==
+    rcl_atomic_load_int64_t(&(storage->last_shared_time)))
+  {
+    return;
+  }
+  // Only one thread calls the jump callbacks for a change, the others keep
+  // reporting the previous time until it is done.
+  if (rcl_atomic_exchange_bool(&(storage->shared_time_jumping), true)) {
+    return;
+  }
+  int64_t shared_time = rcl_atomic_load_int64_t(storage->shared_time);
+  int64_t last_shared_time = rcl_atomic_load_int64_t(&(storage->last_shared_time));
+  if (shared_time != last_shared_time) {
+    // Measure the rate of the shared time between the changes seen.
+    rcl_time_point_value_t steady_now = 0;
+    if (rcl_get_steady_time(NULL, &steady_now) == RCL_RET_OK) {
+      int64_t last_steady_time = rcl_atomic_load_int64_t(&(storage->shared_steady_time));
+      if (0 != last_steady_time && steady_now > last_steady_time) {
+        double rate =
+          (double)(shared_time - last_shared_time) / (double)(steady_now - last_steady_time);
+        _rcl_ros_clock_set_rate(&(storage->shared_rate_bits), rate < 0.0 ? 0.0 : rate);
+      }
+      rcl_atomic_store(&(storage->shared_steady_time), steady_now);
+    }
+    rcl_time_jump_t time_jump;
+    time_jump.clock_change = RCL_ROS_TIME_NO_CHANGE;
+    time_jump.delta.nanoseconds = shared_time - last_shared_time;
+    _rcl_clock_call_callbacks(clock, &time_jump, true);
+    rcl_atomic_store(&(storage->last_shared_time), shared_time);
+    _rcl_clock_call_callbacks(clock, &time_jump, false);
+  }
+  rcl_atomic_store(&(storage->shared_time_jumping), false);
 }
 
 rcl_ret_t
@@ -305,6 +954,12 @@ rcl_enable_ros_time_override(rcl_clock_t * clock)
     time_jump.delta.nanoseconds = 0;
     time_jump.clock_change = RCL_ROS_TIME_ACTIVATED;
     _rcl_clock_call_callbacks(clock, &time_jump, true);
+    if (storage->shared_time) {
+      // Changes of the shared time before the activation are not jumps.
+      rcl_atomic_store(
+        &(storage->last_shared_time), rcl_atomic_load_int64_t(storage->shared_time));
+      rcl_atomic_store(&(storage->shared_steady_time), 0);
+    }
     storage->active = true;
     _rcl_clock_call_callbacks(clock, &time_jump, false);
   }
@@ -375,6 +1030,13 @@ rcl_set_ros_time_override(
   }
   rcl_time_jump_t time_jump;
   rcl_ros_clock_storage_t * storage = (rcl_ros_clock_storage_t *)clock->data;
+  if (storage->shared_time) {
+    RCL_SET_ERROR_MSG(
+      "Clock reads a shared time, which is set by its time authority.",
+      rcl_get_default_allocator())
+    return RCL_RET_ERROR;
+  }
+  bool extrapolate = rcl_atomic_load_bool(&(storage->extrapolate));
   if (storage->active) {
     time_jump.clock_change = RCL_ROS_TIME_NO_CHANGE;
     rcl_time_point_value_t current_time;
@@ -383,15 +1045,66 @@ rcl_set_ros_time_override(
       return ret;
     }
     time_jump.delta.nanoseconds = time_value - current_time;
+    if (extrapolate && time_jump.delta.nanoseconds < 0 &&
+      time_value >= (rcl_time_point_value_t)rcl_atomic_load_uint64_t(&(storage->current_time)))
+    {
+      // Behind the extrapolated time but ahead of the last update, the time stays put.
+      time_jump.delta.nanoseconds = 0;
+    }
     _rcl_clock_call_callbacks(clock, &time_jump, true);
   }
-  rcl_atomic_store(&(storage->current_time), time_value);
+  if (extrapolate) {
+    rcl_ret_t ret = _rcl_ros_clock_update_extrapolation(storage, time_value);
+    if (RCL_RET_OK != ret) {
+      RCL_SET_ERROR_MSG("Failed to get the steady time", rcl_get_default_allocator())
+      return ret;
+    }
+  } else {
+    rcl_atomic_store(&(storage->current_time), time_value);
+  }
   if (storage->active) {
     _rcl_clock_call_callbacks(clock, &time_jump, false);
   }
   return RCL_RET_OK;
 }
 
+rcl_ret_t
+rcl_ros_clock_set_extrapolation(rcl_clock_t * clock, bool enabled)
+{
+  RCL_CHECK_ARGUMENT_FOR_NULL(clock, RCL_RET_INVALID_ARGUMENT, rcl_get_default_allocator());
+  if (clock->type != RCL_ROS_TIME) {
+    RCL_SET_ERROR_MSG(
+      "Clock is not of type RCL_ROS_TIME, cannot set extrapolation.", rcl_get_default_allocator())
+    return RCL_RET_ERROR;
+  }
+  rcl_ros_clock_storage_t * storage = (rcl_ros_clock_storage_t *)clock->data;
+  if (!storage) {
+    RCL_SET_ERROR_MSG("Clock storage is not initialized, cannot set extrapolation.",
+      rcl_get_default_allocator())
+    return RCL_RET_ERROR;
+  }
+  if (!enabled && rcl_atomic_load_bool(&(storage->extrapolate))) {
+    // Keep the time extrapolated so far.
+    rcl_time_point_value_t current_time = 0;
+    rcl_ret_t ret = _rcl_ros_clock_extrapolate(storage, &current_time);
+    if (ret != RCL_RET_OK) {
+      RCL_SET_ERROR_MSG("Failed to get the steady time", rcl_get_default_allocator())
+      return ret;
+    }
+    rcl_atomic_store(&(storage->current_time), current_time);
+  }
+  if (enabled && !rcl_atomic_load_bool(&(storage->extrapolate))) {
+    // Start from the time set last, without extrapolating it until the next update.
+    rcl_atomic_store(&(storage->base_time),
+      (int64_t)rcl_atomic_load_uint64_t(&(storage->current_time)));
+    rcl_atomic_store(&(storage->base_steady_time), 0);
+    rcl_atomic_store(&(storage->rate_bits), 0);
+    rcl_atomic_store(&(storage->max_extrapolation), 0);
+  }
+  rcl_atomic_store(&(storage->extrapolate), enabled);
+  return RCL_RET_OK;
+}
+
 rcl_ret_t
 rcl_clock_add_jump_callback(
   rcl_clock_t * clock, rcl_jump_threshold_t threshold, rcl_jump_callback_t callback,
@@ -411,28 +1124,44 @@ rcl_clock_add_jump_callback(
     return RCL_RET_INVALID_ARGUMENT;
   }
 
+  rcl_jump_callback_list_t * list = clock->jump_callbacks;
+  RCL_CHECK_FOR_NULL_WITH_MSG(
+    list, "clock is not initialized", return RCL_RET_INVALID_ARGUMENT, clock->allocator);
+  rcl_mutex_lock(&(list->lock));
+
   // Callback/user_data pair must be unique
-  for (size_t cb_idx = 0; cb_idx < clock->num_jump_callbacks; ++cb_idx) {
-    const rcl_jump_callback_info_t * info = &(clock->jump_callbacks[cb_idx]);
-    if (info->callback == callback && info->user_data == user_data) {
+  rcl_jump_callback_node_t * node =
+    (rcl_jump_callback_node_t *)rcl_atomic_load_uintptr_t(&(list->head));
+  for (; node; node = (rcl_jump_callback_node_t *)rcl_atomic_load_uintptr_t(&(node->next))) {
+    if (node->info.callback == callback && node->info.user_data == user_data) {
+      rcl_mutex_unlock(&(list->lock));
       RCL_SET_ERROR_MSG("callback/user_data are already added to this clock", clock->allocator);
       return RCL_RET_ERROR;
     }
   }
 
-  // Add the new callback, increasing the size of the callback list
-  rcl_jump_callback_info_t * callbacks = clock->allocator.reallocate(
-    clock->jump_callbacks, sizeof(rcl_jump_callback_info_t) * (clock->num_jump_callbacks + 1),
-    clock->allocator.state);
-  if (NULL == callbacks) {
-    RCL_SET_ERROR_MSG("Failed to realloc jump callbacks", clock->allocator);
+  // Append the new callback, fully initialized before it can be seen
+  node = (rcl_jump_callback_node_t *)clock->allocator.allocate(
+    sizeof(rcl_jump_callback_node_t), clock->allocator.state);
+  if (NULL == node) {
+    rcl_mutex_unlock(&(list->lock));
+    RCL_SET_ERROR_MSG("Failed to allocate jump callback", clock->allocator);
     return RCL_RET_BAD_ALLOC;
   }
-  clock->jump_callbacks = callbacks;
-  clock->jump_callbacks[clock->num_jump_callbacks].callback = callback;
-  clock->jump_callbacks[clock->num_jump_callbacks].threshold = threshold;
-  clock->jump_callbacks[clock->num_jump_callbacks].user_data = user_data;
+  node->info.callback = callback;
+  node->info.threshold = threshold;
+  node->info.user_data = user_data;
+  atomic_init(&(node->next), 0);
+  node->retired_next = NULL;
+  if (list->tail) {
+    rcl_atomic_store(&(list->tail->next), (uintptr_t)node);
+  } else {
+    rcl_atomic_store(&(list->head), (uintptr_t)node);
+  }
+  list->tail = node;
   ++(clock->num_jump_callbacks);
+  _rcl_jump_callback_list_reclaim(list, &(clock->allocator));
+  rcl_mutex_unlock(&(list->lock));
   return RCL_RET_OK;
 }
 
@@ -446,35 +1175,210 @@ rcl_clock_remove_jump_callback(
     return RCL_RET_INVALID_ARGUMENT);
   RCL_CHECK_ARGUMENT_FOR_NULL(callback, RCL_RET_INVALID_ARGUMENT, clock->allocator);
 
-  // Delete callback if found, moving all callbacks after back one
-  bool found_callback = false;
-  for (size_t cb_idx = 0; cb_idx < clock->num_jump_callbacks; ++cb_idx) {
-    const rcl_jump_callback_info_t * info = &(clock->jump_callbacks[cb_idx]);
-    if (found_callback) {
-      clock->jump_callbacks[cb_idx - 1] = *info;
-    } else if (info->callback == callback && info->user_data == user_data) {
-      found_callback = true;
-    }
+  rcl_jump_callback_list_t * list = clock->jump_callbacks;
+  RCL_CHECK_FOR_NULL_WITH_MSG(
+    list, "clock is not initialized", return RCL_RET_INVALID_ARGUMENT, clock->allocator);
+  rcl_mutex_lock(&(list->lock));
+
+  // Find the callback, and unlink it
+  rcl_jump_callback_node_t * previous = NULL;
+  rcl_jump_callback_node_t * node =
+    (rcl_jump_callback_node_t *)rcl_atomic_load_uintptr_t(&(list->head));
+  while (node && !(node->info.callback == callback && node->info.user_data == user_data)) {
+    previous = node;
+    node = (rcl_jump_callback_node_t *)rcl_atomic_load_uintptr_t(&(node->next));
   }
-  if (!found_callback) {
+  if (!node) {
+    rcl_mutex_unlock(&(list->lock));
     RCL_SET_ERROR_MSG("jump callback was not found", clock->allocator);
     return RCL_RET_ERROR;
   }
-
-  // Shrink size of the callback array
-  if (clock->num_jump_callbacks == 1) {
-    clock->allocator.deallocate(clock->jump_callbacks, clock->allocator.state);
-    clock->jump_callbacks = NULL;
+  uintptr_t next = rcl_atomic_load_uintptr_t(&(node->next));
+  if (previous) {
+    rcl_atomic_store(&(previous->next), next);
   } else {
-    rcl_jump_callback_info_t * callbacks = clock->allocator.reallocate(
-      clock->jump_callbacks, sizeof(rcl_jump_callback_info_t) * (clock->num_jump_callbacks - 1),
-      clock->allocator.state);
-    if (NULL == callbacks) {
-      RCL_SET_ERROR_MSG("Failed to shrink jump callbacks", clock->allocator);
-      return RCL_RET_BAD_ALLOC;
-    }
-    clock->jump_callbacks = callbacks;
+    rcl_atomic_store(&(list->head), next);
+  }
+  if (list->tail == node) {
+    list->tail = previous;
   }
   --(clock->num_jump_callbacks);
+
+  // Free it once no call of the callbacks can still be on it
+  node->retired_next = list->retired;
+  list->retired = node;
+  uint64_t number_of_retired = ++(list->number_of_retired);
+  _rcl_jump_callback_list_reclaim(list, &(clock->allocator));
+  if (_rcl_jump_callback_list_is_called(list)) {
+    // Waiting for the readers would wait for this thread, the node is freed by a later change.
+    rcl_mutex_unlock(&(list->lock));
+    return RCL_RET_OK;
+  }
+  // Wait until no call of the callbacks can still be on it, letting callbacks change the list.
+  while (list->number_of_freed < number_of_retired) {
+    rcl_mutex_unlock(&(list->lock));
+    _rcl_jump_callback_list_yield();
+    rcl_mutex_lock(&(list->lock));
+    _rcl_jump_callback_list_reclaim(list, &(clock->allocator));
+  }
+  rcl_mutex_unlock(&(list->lock));
+  return RCL_RET_OK;
+}
+
+rcl_shared_time_authority_t
+rcl_get_zero_initialized_shared_time_authority(void)
+{
+  static rcl_shared_time_authority_t null_authority = {0};
+  return null_authority;
+}
+
+rcl_ret_t
+rcl_shared_time_authority_init(
+  rcl_shared_time_authority_t * authority,
+  const char * path,
+  rcl_allocator_t allocator)
+{
+  RCL_CHECK_ALLOCATOR_WITH_MSG(&allocator, "invalid allocator", return RCL_RET_INVALID_ARGUMENT);
+  RCL_CHECK_ARGUMENT_FOR_NULL(authority, RCL_RET_INVALID_ARGUMENT, allocator);
+  RCL_CHECK_ARGUMENT_FOR_NULL(path, RCL_RET_INVALID_ARGUMENT, allocator);
+  if (authority->impl) {
+    RCL_SET_ERROR_MSG("shared time authority already initialized, or memory was uninitialized",
+      allocator)
+    return RCL_RET_ALREADY_INIT;
+  }
+#if defined(_WIN32)
+  RCL_SET_ERROR_MSG("shared time is not supported on Windows", allocator)
+  return RCL_RET_ERROR;
+#else
+  int fd = open(path, O_RDWR | O_CREAT | O_CLOEXEC, 0644);
+  if (-1 == fd) {
+    RCL_SET_ERROR_MSG("failed to open the shared time file", allocator)
+    return RCL_RET_ERROR;
+  }
+  if (0 != flock(fd, LOCK_EX | LOCK_NB)) {
+    close(fd);
+    RCL_SET_ERROR_MSG("another authority holds the shared time file", allocator)
+    return RCL_RET_ERROR;
+  }
+  if (0 != ftruncate(fd, sizeof(atomic_int_least64_t))) {
+    close(fd);
+    RCL_SET_ERROR_MSG("failed to size the shared time file", allocator)
+    return RCL_RET_ERROR;
+  }
+  void * mapping = mmap(
+    NULL, sizeof(atomic_int_least64_t), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+  if (MAP_FAILED == mapping) {
+    close(fd);
+    RCL_SET_ERROR_MSG("failed to map the shared time file", allocator)
+    return RCL_RET_ERROR;
+  }
+  rcl_shared_time_authority_impl_t * impl = (rcl_shared_time_authority_impl_t *)allocator.allocate(
+    sizeof(rcl_shared_time_authority_impl_t), allocator.state);
+  if (!impl) {
+    munmap(mapping, sizeof(atomic_int_least64_t));
+    close(fd);
+    RCL_SET_ERROR_MSG("allocating memory failed", allocator)
+    return RCL_RET_BAD_ALLOC;
+  }
+  impl->fd = fd;
+  impl->shared_time = (atomic_int_least64_t *)mapping;
+  impl->allocator = allocator;
+  rcl_atomic_store(impl->shared_time, 0);
+  authority->impl = impl;
+  return RCL_RET_OK;
+#endif  // defined(_WIN32)
+}
+
+rcl_ret_t
+rcl_shared_time_authority_fini(rcl_shared_time_authority_t * authority)
+{
+  RCL_CHECK_ARGUMENT_FOR_NULL(authority, RCL_RET_INVALID_ARGUMENT, rcl_get_default_allocator());
+  if (!authority->impl) {
+    return RCL_RET_OK;
+  }
+  rcl_shared_time_authority_impl_t * impl = authority->impl;
+  rcl_allocator_t allocator = impl->allocator;
+  rcl_ret_t result = RCL_RET_OK;
+#if !defined(_WIN32)
+  if (0 != munmap((void *)impl->shared_time, sizeof(atomic_int_least64_t))) {
+    RCL_SET_ERROR_MSG("failed to unmap the shared time file", allocator)
+    result = RCL_RET_ERROR;
+  }
+  // Closing the file releases the lock.
+  if (0 != close(impl->fd)) {
+    RCL_SET_ERROR_MSG("failed to close the shared time file", allocator)
+    result = RCL_RET_ERROR;
+  }
+#endif  // !defined(_WIN32)
+  allocator.deallocate(impl, allocator.state);
+  authority->impl = NULL;
+  return result;
+}
+
+rcl_ret_t
+rcl_shared_time_authority_set(
+  rcl_shared_time_authority_t * authority, rcl_time_point_value_t time_value)
+{
+  RCL_CHECK_ARGUMENT_FOR_NULL(authority, RCL_RET_INVALID_ARGUMENT, rcl_get_default_allocator());
+  RCL_CHECK_FOR_NULL_WITH_MSG(
+    authority->impl, "shared time authority is not initialized",
+    return RCL_RET_INVALID_ARGUMENT, rcl_get_default_allocator());
+  rcl_atomic_store(authority->impl->shared_time, (int64_t)time_value);
+  return RCL_RET_OK;
+}
+
+rcl_ret_t
+rcl_ros_clock_attach_shared_time(rcl_clock_t * clock, const char * path)
+{
+  RCL_CHECK_ARGUMENT_FOR_NULL(clock, RCL_RET_INVALID_ARGUMENT, rcl_get_default_allocator());
+  RCL_CHECK_ARGUMENT_FOR_NULL(path, RCL_RET_INVALID_ARGUMENT, rcl_get_default_allocator());
+  if (clock->type != RCL_ROS_TIME) {
+    RCL_SET_ERROR_MSG(
+      "Clock is not of type RCL_ROS_TIME, cannot attach shared time.", rcl_get_default_allocator())
+    return RCL_RET_ERROR;
+  }
+  rcl_ros_clock_storage_t * storage = (rcl_ros_clock_storage_t *)clock->data;
+  if (!storage) {
+    RCL_SET_ERROR_MSG("Clock storage is not initialized, cannot attach shared time.",
+      rcl_get_default_allocator())
+    return RCL_RET_ERROR;
+  }
+  if (storage->shared_time) {
+    RCL_SET_ERROR_MSG("Clock is already attached to a shared time.", rcl_get_default_allocator())
+    return RCL_RET_ERROR;
+  }
+  if (storage->active) {
+    RCL_SET_ERROR_MSG(
+      "Clock has its ROS time override enabled, cannot attach shared time.",
+      rcl_get_default_allocator())
+    return RCL_RET_ERROR;
+  }
+#if defined(_WIN32)
+  RCL_SET_ERROR_MSG("shared time is not supported on Windows", rcl_get_default_allocator())
+  return RCL_RET_ERROR;
+#else
+  int fd = open(path, O_RDONLY | O_CLOEXEC);
+  if (-1 == fd) {
+    RCL_SET_ERROR_MSG("failed to open the shared time file", rcl_get_default_allocator())
+    return RCL_RET_ERROR;
+  }
+  struct stat file_stat;
+  if (0 != fstat(fd, &file_stat) || file_stat.st_size < (off_t)sizeof(atomic_int_least64_t)) {
+    close(fd);
+    RCL_SET_ERROR_MSG(
+      "shared time file was not created by a time authority", rcl_get_default_allocator())
+    return RCL_RET_ERROR;
+  }
+  void * mapping = mmap(NULL, sizeof(atomic_int_least64_t), PROT_READ, MAP_SHARED, fd, 0);
+  // The mapping stays valid after the file is closed.
+  close(fd);
+  if (MAP_FAILED == mapping) {
+    RCL_SET_ERROR_MSG("failed to map the shared time file", rcl_get_default_allocator())
+    return RCL_RET_ERROR;
+  }
+  storage->shared_time = (atomic_int_least64_t *)mapping;
+  rcl_atomic_store(
+    &(storage->last_shared_time), rcl_atomic_load_int64_t(storage->shared_time));
   return RCL_RET_OK;
+#endif  // defined(_WIN32)
 }
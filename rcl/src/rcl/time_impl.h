@@ -0,0 +1,62 @@
+// Copyright 2018 Open Source Robotics Foundation, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef RCL__TIME_IMPL_H_
+#define RCL__TIME_IMPL_H_
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+#include <stdbool.h>
+
+#include "rcl/time.h"
+
+/// Get the current time of the steady clocks.
+/* This is the time source of `RCL_STEADY_TIME` clocks, which may be the time
+ * stamp counter, so it must be used wherever a steady time is compared with
+ * the time of such a clock, like the next call time of a steady timer.
+ * The data argument is unused.
+ */
+rcl_ret_t
+rcl_get_steady_time(void * data, rcl_time_point_value_t * current_time);
+
+/// Return the steady duration the ROS time override of a clock takes to move by a duration.
+/* Return INT64_MAX if the override only moves when it is set, which calls the
+ * jump callbacks of the clock, so waits can rely on being woken up by them.
+ * The override of a clock attached to a shared time, which is set by another
+ * process, moves by itself, as does an extrapolated override, so waits need
+ * to time out after the duration scaled by the rate of the time.
+ * The rate of a shared time is measured between the changes seen when reading
+ * it, and the duration is only shortened by it, since a shared time which is
+ * paused or slow may speed up without waking anything.
+ * The clock must be a valid `RCL_ROS_TIME` clock, and the duration positive.
+ */
+int64_t
+rcl_ros_clock_get_steady_duration(const rcl_clock_t * clock, int64_t duration);
+
+/// Select the source of the steady time, calibrating the time stamp counter if requested.
+/* Only the first call selects the source, so that the steady time never jumps.
+ * A requested time stamp counter which cannot be used is logged, and the
+ * steady clock of the operating system is used instead.
+ */
+void
+rcl_steady_time_source_init(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif  // RCL__TIME_IMPL_H_
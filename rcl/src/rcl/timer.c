@@ -20,11 +20,19 @@ extern "C"
 #include "rcl/timer.h"
 
 #include <inttypes.h>
+#include <string.h>
+#if defined(__linux__)
+#include <sys/timerfd.h>
+#include <time.h>
+#include <unistd.h>
+#endif  // defined(__linux__)
 
 #include "./stdatomic_helper.h"
+#include "./timer_impl.h"
+#include "./timer_queue.h"
 #include "rcl/error_handling.h"
+#include "rcl/guard_condition.h"
 #include "rcutils/logging_macros.h"
-#include "rcutils/time.h"
 
 typedef struct rcl_timer_impl_t
 {
@@ -40,6 +48,20 @@ typedef struct rcl_timer_impl_t
   atomic_uint_least64_t next_call_time;
   // A flag which indicates if the timer is canceled.
   atomic_bool canceled;
+  // How late in nanoseconds the timer may be woken up, to share a wake up with other timers.
+  atomic_int_least64_t slack;
+  // Triggered when the time of a ROS clock jumps, only initialized for those clocks.
+  rcl_guard_condition_t guard_condition;
+  // Time until the next call before the latest jump of a ROS clock.
+  atomic_int_least64_t time_credit;
+  // Armed at the next call time by waits, -1 unless the timer was created with high_precision.
+  int timer_fd;
+  // Statistics of the calls, as described by rcl_timer_statistics_t.
+  atomic_uint_least64_t number_of_calls;
+  atomic_uint_least64_t missed_periods;
+  atomic_int_least64_t last_lateness;
+  atomic_int_least64_t max_lateness;
+  atomic_uint_least64_t lateness_histogram[RCL_TIMER_LATENESS_HISTOGRAM_SIZE];
   // The user supplied allocator.
   rcl_allocator_t allocator;
 } rcl_timer_impl_t;
@@ -51,6 +73,39 @@ rcl_get_zero_initialized_timer()
   return null_timer;
 }
 
+// Keep the timer on schedule across jumps of its ROS clock, and wake up waits on it.
+static void
+__timer_time_jump(const rcl_time_jump_t * time_jump, bool before_jump, void * user_data)
+{
+  rcl_timer_impl_t * impl = (rcl_timer_impl_t *)user_data;
+  rcl_time_point_value_t now;
+  if (rcl_clock_get_now(impl->clock, &now) != RCL_RET_OK) {
+    rcl_reset_error();
+    return;
+  }
+  int64_t next_call_time = rcl_atomic_load_uint64_t(&impl->next_call_time);
+  if (before_jump) {
+    rcl_atomic_store(&impl->time_credit, next_call_time - now);
+    return;
+  }
+  if (
+    RCL_ROS_TIME_ACTIVATED == time_jump->clock_change ||
+    RCL_ROS_TIME_DEACTIVATED == time_jump->clock_change ||
+    time_jump->delta.nanoseconds < 0)
+  {
+    // The time is not comparable to the one before the jump anymore, keep the time left.
+    int64_t time_credit = rcl_atomic_load_int64_t(&impl->time_credit);
+    rcl_atomic_store(&impl->next_call_time, now + time_credit);
+    rcl_timer_queue_notify_reschedule();
+  } else if (now < next_call_time) {
+    // Moving forward without reaching the timer, there is nothing to wake up for.
+    return;
+  }
+  if (rcl_trigger_guard_condition(&impl->guard_condition) != RCL_RET_OK) {
+    rcl_reset_error();
+  }
+}
+
 rcl_ret_t
 rcl_timer_init(
   rcl_timer_t * timer,
@@ -58,14 +113,32 @@ rcl_timer_init(
   int64_t period,
   const rcl_timer_callback_t callback,
   rcl_allocator_t allocator)
+{
+  rcl_timer_options_t options = rcl_timer_get_default_options();
+  return rcl_timer_init_with_options(timer, clock, period, callback, allocator, &options);
+}
+
+rcl_ret_t
+rcl_timer_init_with_options(
+  rcl_timer_t * timer,
+  rcl_clock_t * clock,
+  int64_t period,
+  const rcl_timer_callback_t callback,
+  rcl_allocator_t allocator,
+  const rcl_timer_options_t * options)
 {
   RCL_CHECK_ALLOCATOR_WITH_MSG(&allocator, "invalid allocator", return RCL_RET_INVALID_ARGUMENT);
   RCL_CHECK_ARGUMENT_FOR_NULL(timer, RCL_RET_INVALID_ARGUMENT, allocator);
   RCL_CHECK_ARGUMENT_FOR_NULL(clock, RCL_RET_INVALID_ARGUMENT, allocator);
+  RCL_CHECK_ARGUMENT_FOR_NULL(options, RCL_RET_INVALID_ARGUMENT, allocator);
   if (period < 0) {
     RCL_SET_ERROR_MSG("timer period must be non-negative", allocator);
     return RCL_RET_INVALID_ARGUMENT;
   }
+  if (options->high_precision && RCL_STEADY_TIME != clock->type) {
+    RCL_SET_ERROR_MSG("high precision timers must use a steady clock", allocator);
+    return RCL_RET_INVALID_ARGUMENT;
+  }
   RCUTILS_LOG_DEBUG_NAMED(ROS_PACKAGE_NAME, "Initializing timer with period: %" PRIu64 "ns", period)
   if (timer->impl) {
     RCL_SET_ERROR_MSG("timer already initailized, or memory was uninitialized", allocator);
@@ -83,14 +156,72 @@ rcl_timer_init(
   atomic_init(&impl.last_call_time, now);
   atomic_init(&impl.next_call_time, now + period);
   atomic_init(&impl.canceled, false);
+  atomic_init(&impl.slack, 0);
+  impl.guard_condition = rcl_get_zero_initialized_guard_condition();
+  atomic_init(&impl.time_credit, 0);
+  impl.timer_fd = -1;
+  atomic_init(&impl.number_of_calls, 0);
+  atomic_init(&impl.missed_periods, 0);
+  atomic_init(&impl.last_lateness, 0);
+  atomic_init(&impl.max_lateness, 0);
+  size_t i;
+  for (i = 0; i < RCL_TIMER_LATENESS_HISTOGRAM_SIZE; ++i) {
+    atomic_init(&impl.lateness_histogram[i], 0);
+  }
   impl.allocator = allocator;
   timer->impl = (rcl_timer_impl_t *)allocator.allocate(sizeof(rcl_timer_impl_t), allocator.state);
   RCL_CHECK_FOR_NULL_WITH_MSG(
     timer->impl, "allocating memory failed", return RCL_RET_BAD_ALLOC, allocator);
   *timer->impl = impl;
+  if (RCL_ROS_TIME == clock->type) {
+    // The time of a ROS clock may stand still or jump, so waits are woken up on jumps.
+    // It only gets an rmw guard condition once a wait set needs to go through rmw_wait.
+    rcl_guard_condition_options_t options = rcl_guard_condition_get_default_options();
+    options.allocator = allocator;
+    options.local_only = true;
+    rcl_ret_t ret = rcl_guard_condition_init(&timer->impl->guard_condition, options);
+    if (ret != RCL_RET_OK) {
+      allocator.deallocate(timer->impl, allocator.state);
+      timer->impl = NULL;
+      return ret;  // rcl error state should already be set.
+    }
+    rcl_jump_threshold_t threshold;
+    threshold.on_clock_change = true;
+    threshold.min_forward.nanoseconds = 1;
+    threshold.min_backward.nanoseconds = -1;
+    ret = rcl_clock_add_jump_callback(clock, threshold, __timer_time_jump, timer->impl);
+    if (ret != RCL_RET_OK) {
+      rcl_ret_t fini_ret = rcl_guard_condition_fini(&timer->impl->guard_condition);
+      (void)fini_ret;
+      allocator.deallocate(timer->impl, allocator.state);
+      timer->impl = NULL;
+      return ret;  // rcl error state should already be set.
+    }
+  }
+#if defined(__linux__)
+  if (options->high_precision) {
+    // CLOCK_MONOTONIC is the steady clock which timerfds support.
+    timer->impl->timer_fd = timerfd_create(CLOCK_MONOTONIC, TFD_CLOEXEC | TFD_NONBLOCK);
+    if (timer->impl->timer_fd < 0) {
+      allocator.deallocate(timer->impl, allocator.state);
+      timer->impl = NULL;
+      RCL_SET_ERROR_MSG("failed to create timerfd", allocator);
+      return RCL_RET_ERROR;
+    }
+  }
+#endif  // defined(__linux__)
   return RCL_RET_OK;
 }
 
+rcl_timer_options_t
+rcl_timer_get_default_options()
+{
+  // !!! MAKE SURE THAT CHANGES TO THESE DEFAULTS ARE REFLECTED IN THE HEADER DOC STRING
+  static rcl_timer_options_t default_options;
+  default_options.high_precision = false;
+  return default_options;
+}
+
 rcl_ret_t
 rcl_timer_fini(rcl_timer_t * timer)
 {
@@ -100,7 +231,24 @@ rcl_timer_fini(rcl_timer_t * timer)
   // Will return either RCL_RET_OK or RCL_RET_ERROR since the timer is valid.
   rcl_ret_t result = rcl_timer_cancel(timer);
   rcl_allocator_t allocator = timer->impl->allocator;
+  if (timer->impl->guard_condition.impl) {
+    rcl_ret_t ret = rcl_clock_remove_jump_callback(
+      timer->impl->clock, __timer_time_jump, timer->impl);
+    if (ret != RCL_RET_OK) {
+      result = RCL_RET_ERROR;
+    }
+    ret = rcl_guard_condition_fini(&timer->impl->guard_condition);
+    if (ret != RCL_RET_OK) {
+      result = RCL_RET_ERROR;
+    }
+  }
+#if defined(__linux__)
+  if (timer->impl->timer_fd >= 0) {
+    close(timer->impl->timer_fd);
+  }
+#endif  // defined(__linux__)
   allocator.deallocate(timer->impl, allocator.state);
+  timer->impl = NULL;
   return result;
 }
 
@@ -116,11 +264,72 @@ rcl_timer_clock(rcl_timer_t * timer, rcl_clock_t ** clock)
   return RCL_RET_OK;
 }
 
-rcl_ret_t
-rcl_timer_call(rcl_timer_t * timer)
+// Compute the next call time of a timer which is called at now.
+static uint64_t
+__timer_advance_next_call_time(
+  uint64_t next_call_time, uint64_t period, uint64_t unow, uint64_t * missed_periods)
+{
+  *missed_periods = 0;
+  // always move the next call time by exactly period forward
+  // don't use now as the base to avoid extending each cycle by the time
+  // between the timer being ready and the callback being triggered
+  next_call_time += period;
+  // in case the timer has missed at least once cycle
+  if (next_call_time < unow) {
+    if (0 == period) {
+      // a timer with a period of zero is considered always ready
+      next_call_time = unow;
+    } else {
+      // move the next call time forward by as many periods as necessary
+      uint64_t now_ahead = unow - next_call_time;
+      // rounding up without overflow
+      uint64_t periods_ahead = 1 + (now_ahead - 1) / period;
+      next_call_time += periods_ahead * period;
+      *missed_periods = periods_ahead;
+    }
+  }
+  return next_call_time;
+}
+
+// Return the lateness histogram bucket of the given lateness.
+static size_t
+__timer_lateness_bucket(int64_t lateness)
+{
+  uint64_t lateness_us = (uint64_t)lateness / 1000;
+  size_t bucket = 0;
+  while (lateness_us > 0 && bucket < RCL_TIMER_LATENESS_HISTOGRAM_SIZE - 1) {
+    lateness_us >>= 1;
+    ++bucket;
+  }
+  return bucket;
+}
+
+static void
+__timer_record_call(rcl_timer_impl_t * impl, int64_t lateness, uint64_t missed_periods)
+{
+  if (lateness < 0) {
+    lateness = 0;
+  }
+  rcl_atomic_fetch_add_uint64_t(&impl->number_of_calls, 1);
+  if (missed_periods > 0) {
+    rcl_atomic_fetch_add_uint64_t(&impl->missed_periods, missed_periods);
+  }
+  rcl_atomic_store(&impl->last_lateness, lateness);
+  int64_t max_lateness = rcl_atomic_load_int64_t(&impl->max_lateness);
+  while (lateness > max_lateness &&
+    !rcl_atomic_compare_exchange_strong_int_least64_t(
+      &impl->max_lateness, &max_lateness, lateness))
+  {
+  }
+  rcl_atomic_fetch_add_uint64_t(&impl->lateness_histogram[__timer_lateness_bucket(lateness)], 1);
+}
+
+// Claim one call of the timer, and call its callback if the claim succeeded.
+// The next call time is advanced with a compare exchange, so that concurrent
+// callers which read the same next call time can not both claim it.
+static rcl_ret_t
+__timer_call(rcl_timer_t * timer, bool only_if_ready, bool * called)
 {
-  RCUTILS_LOG_DEBUG_NAMED(ROS_PACKAGE_NAME, "Calling timer")
-  RCL_CHECK_ARGUMENT_FOR_NULL(timer, RCL_RET_INVALID_ARGUMENT, rcl_get_default_allocator());
   const rcl_allocator_t * allocator = rcl_timer_get_allocator(timer);
   if (!allocator) {
     return RCL_RET_TIMER_INVALID;
@@ -139,32 +348,27 @@ rcl_timer_call(rcl_timer_t * timer)
     return RCL_RET_ERROR;
   }
   uint64_t unow = (uint64_t)now;
+  uint64_t next_call_time = rcl_atomic_load_uint64_t(&timer->impl->next_call_time);
+  uint64_t new_next_call_time;
+  uint64_t missed_periods;
+  do {
+    if (only_if_ready && next_call_time > unow) {
+      *called = false;
+      return RCL_RET_OK;
+    }
+    uint64_t period = rcl_atomic_load_uint64_t(&timer->impl->period);
+    new_next_call_time =
+      __timer_advance_next_call_time(next_call_time, period, unow, &missed_periods);
+    // On failure next_call_time is updated to what another caller stored.
+  } while (!rcl_atomic_compare_exchange_strong_uint_least64_t(
+    &timer->impl->next_call_time, &next_call_time, new_next_call_time));
+  __timer_record_call(timer->impl, (int64_t)(unow - next_call_time), missed_periods);
+
   rcl_time_point_value_t previous_ns =
     rcl_atomic_exchange_uint64_t(&timer->impl->last_call_time, unow);
   rcl_timer_callback_t typed_callback =
     (rcl_timer_callback_t)rcl_atomic_load_uintptr_t(&timer->impl->callback);
-
-  uint64_t next_call_time = rcl_atomic_load_uint64_t(&timer->impl->next_call_time);
-  uint64_t period = rcl_atomic_load_uint64_t(&timer->impl->period);
-  // always move the next call time by exactly period forward
-  // don't use now as the base to avoid extending each cycle by the time
-  // between the timer being ready and the callback being triggered
-  next_call_time += period;
-  // in case the timer has missed at least once cycle
-  if (next_call_time < unow) {
-    if (0 == period) {
-      // a timer with a period of zero is considered always ready
-      next_call_time = unow;
-    } else {
-      // move the next call time forward by as many periods as necessary
-      uint64_t now_ahead = unow - next_call_time;
-      // rounding up without overflow
-      uint64_t periods_ahead = 1 + (now_ahead - 1) / period;
-      next_call_time += periods_ahead * period;
-    }
-  }
-  rcl_atomic_store(&timer->impl->next_call_time, next_call_time);
-
+  *called = true;
   if (typed_callback != NULL) {
     int64_t since_last_call = now - previous_ns;
     typed_callback(timer, since_last_call);
@@ -172,8 +376,44 @@ rcl_timer_call(rcl_timer_t * timer)
   return RCL_RET_OK;
 }
 
+rcl_ret_t
+rcl_timer_call(rcl_timer_t * timer)
+{
+  RCUTILS_LOG_DEBUG_NAMED(ROS_PACKAGE_NAME, "Calling timer")
+  RCL_CHECK_ARGUMENT_FOR_NULL(timer, RCL_RET_INVALID_ARGUMENT, rcl_get_default_allocator());
+  bool called;
+  return __timer_call(timer, false, &called);
+}
+
+rcl_ret_t
+rcl_timer_call_if_ready(rcl_timer_t * timer, bool * called)
+{
+  RCUTILS_LOG_DEBUG_NAMED(ROS_PACKAGE_NAME, "Calling timer if ready")
+  RCL_CHECK_ARGUMENT_FOR_NULL(timer, RCL_RET_INVALID_ARGUMENT, rcl_get_default_allocator());
+  RCL_CHECK_ARGUMENT_FOR_NULL(called, RCL_RET_INVALID_ARGUMENT, rcl_get_default_allocator());
+  *called = false;
+  return __timer_call(timer, true, called);
+}
+
 rcl_ret_t
 rcl_timer_is_ready(const rcl_timer_t * timer, bool * is_ready)
+{
+  RCL_CHECK_ARGUMENT_FOR_NULL(timer, RCL_RET_INVALID_ARGUMENT, rcl_get_default_allocator());
+  const rcl_allocator_t * allocator = rcl_timer_get_allocator(timer);
+  if (!allocator) {
+    return RCL_RET_TIMER_INVALID;
+  }
+  RCL_CHECK_ARGUMENT_FOR_NULL(is_ready, RCL_RET_INVALID_ARGUMENT, *allocator);
+  rcl_time_point_value_t now;
+  rcl_ret_t ret = rcl_clock_get_now(timer->impl->clock, &now);
+  if (ret != RCL_RET_OK) {
+    return ret;  // rcl error state should already be set.
+  }
+  return rcl_timer_is_ready_at(timer, now, is_ready);
+}
+
+rcl_ret_t
+rcl_timer_is_ready_at(const rcl_timer_t * timer, rcl_time_point_value_t now, bool * is_ready)
 {
   RCL_CHECK_ARGUMENT_FOR_NULL(timer, RCL_RET_INVALID_ARGUMENT, rcl_get_default_allocator());
   const rcl_allocator_t * allocator = rcl_timer_get_allocator(timer);
@@ -182,7 +422,7 @@ rcl_timer_is_ready(const rcl_timer_t * timer, bool * is_ready)
   }
   RCL_CHECK_ARGUMENT_FOR_NULL(is_ready, RCL_RET_INVALID_ARGUMENT, *allocator);
   int64_t time_until_next_call;
-  rcl_ret_t ret = rcl_timer_get_time_until_next_call(timer, &time_until_next_call);
+  rcl_ret_t ret = rcl_timer_get_time_until_next_call_at(timer, now, &time_until_next_call);
   if (ret != RCL_RET_OK) {
     return ret;  // rcl error state should already be set.
   }
@@ -200,15 +440,43 @@ rcl_timer_get_time_until_next_call(const rcl_timer_t * timer, int64_t * time_unt
   }
   RCL_CHECK_ARGUMENT_FOR_NULL(time_until_next_call, RCL_RET_INVALID_ARGUMENT, *allocator);
   rcl_time_point_value_t now;
-  rcl_ret_t ret = rcutils_steady_time_now(&now);
+  rcl_ret_t ret = rcl_clock_get_now(timer->impl->clock, &now);
   if (ret != RCL_RET_OK) {
     return ret;  // rcl error state should already be set.
   }
+  return rcl_timer_get_time_until_next_call_at(timer, now, time_until_next_call);
+}
+
+rcl_ret_t
+rcl_timer_get_time_until_next_call_at(
+  const rcl_timer_t * timer,
+  rcl_time_point_value_t now,
+  int64_t * time_until_next_call)
+{
+  RCL_CHECK_ARGUMENT_FOR_NULL(timer, RCL_RET_INVALID_ARGUMENT, rcl_get_default_allocator());
+  const rcl_allocator_t * allocator = rcl_timer_get_allocator(timer);
+  if (!allocator) {
+    return RCL_RET_TIMER_INVALID;
+  }
+  RCL_CHECK_ARGUMENT_FOR_NULL(time_until_next_call, RCL_RET_INVALID_ARGUMENT, *allocator);
   *time_until_next_call =
     rcl_atomic_load_uint64_t(&timer->impl->next_call_time) - now;
   return RCL_RET_OK;
 }
 
+rcl_ret_t
+rcl_timer_get_next_call_time(const rcl_timer_t * timer, int64_t * next_call_time)
+{
+  RCL_CHECK_ARGUMENT_FOR_NULL(timer, RCL_RET_INVALID_ARGUMENT, rcl_get_default_allocator());
+  const rcl_allocator_t * allocator = rcl_timer_get_allocator(timer);
+  if (!allocator) {
+    return RCL_RET_TIMER_INVALID;
+  }
+  RCL_CHECK_ARGUMENT_FOR_NULL(next_call_time, RCL_RET_INVALID_ARGUMENT, *allocator);
+  *next_call_time = rcl_atomic_load_uint64_t(&timer->impl->next_call_time);
+  return RCL_RET_OK;
+}
+
 rcl_ret_t
 rcl_timer_get_time_since_last_call(
   const rcl_timer_t * timer,
@@ -221,7 +489,7 @@ rcl_timer_get_time_since_last_call(
   }
   RCL_CHECK_ARGUMENT_FOR_NULL(time_since_last_call, RCL_RET_INVALID_ARGUMENT, *allocator);
   rcl_time_point_value_t now;
-  rcl_ret_t ret = rcutils_steady_time_now(&now);
+  rcl_ret_t ret = rcl_clock_get_now(timer->impl->clock, &now);
   if (ret != RCL_RET_OK) {
     return ret;  // rcl error state should already be set.
   }
@@ -310,17 +578,180 @@ rcl_timer_reset(rcl_timer_t * timer)
   RCL_CHECK_FOR_NULL_WITH_MSG(
     timer->impl, "timer is invalid", return RCL_RET_TIMER_INVALID, rcl_get_default_allocator());
   rcl_time_point_value_t now;
-  rcl_ret_t now_ret = rcutils_steady_time_now(&now);
+  rcl_ret_t now_ret = rcl_clock_get_now(timer->impl->clock, &now);
   if (now_ret != RCL_RET_OK) {
     return now_ret;  // rcl error state should already be set.
   }
   int64_t period = rcl_atomic_load_uint64_t(&timer->impl->period);
   rcl_atomic_store(&timer->impl->next_call_time, now + period);
   rcl_atomic_store(&timer->impl->canceled, false);
+  // The next call time may have moved backwards, which timer queues can not detect.
+  rcl_timer_queue_notify_reschedule();
   RCUTILS_LOG_DEBUG_NAMED(ROS_PACKAGE_NAME, "Timer successfully reset")
   return RCL_RET_OK;
 }
 
+rcl_ret_t
+rcl_timer_get_statistics(const rcl_timer_t * timer, rcl_timer_statistics_t * statistics)
+{
+  RCL_CHECK_ARGUMENT_FOR_NULL(timer, RCL_RET_INVALID_ARGUMENT, rcl_get_default_allocator());
+  const rcl_allocator_t * allocator = rcl_timer_get_allocator(timer);
+  if (!allocator) {
+    return RCL_RET_TIMER_INVALID;
+  }
+  RCL_CHECK_ARGUMENT_FOR_NULL(statistics, RCL_RET_INVALID_ARGUMENT, *allocator);
+  rcl_timer_impl_t * impl = timer->impl;
+  statistics->number_of_calls = rcl_atomic_load_uint64_t(&impl->number_of_calls);
+  statistics->missed_periods = rcl_atomic_load_uint64_t(&impl->missed_periods);
+  statistics->last_lateness = rcl_atomic_load_int64_t(&impl->last_lateness);
+  statistics->max_lateness = rcl_atomic_load_int64_t(&impl->max_lateness);
+  size_t i;
+  for (i = 0; i < RCL_TIMER_LATENESS_HISTOGRAM_SIZE; ++i) {
+    statistics->lateness_histogram[i] = rcl_atomic_load_uint64_t(&impl->lateness_histogram[i]);
+  }
+  return RCL_RET_OK;
+}
+
+rcl_ret_t
+rcl_timer_reset_statistics(rcl_timer_t * timer)
+{
+  RCL_CHECK_ARGUMENT_FOR_NULL(timer, RCL_RET_INVALID_ARGUMENT, rcl_get_default_allocator());
+  RCL_CHECK_FOR_NULL_WITH_MSG(
+    timer->impl, "timer is invalid", return RCL_RET_TIMER_INVALID, rcl_get_default_allocator());
+  rcl_timer_impl_t * impl = timer->impl;
+  rcl_atomic_store(&impl->number_of_calls, 0);
+  rcl_atomic_store(&impl->missed_periods, 0);
+  rcl_atomic_store(&impl->last_lateness, 0);
+  rcl_atomic_store(&impl->max_lateness, 0);
+  size_t i;
+  for (i = 0; i < RCL_TIMER_LATENESS_HISTOGRAM_SIZE; ++i) {
+    rcl_atomic_store(&impl->lateness_histogram[i], 0);
+  }
+  return RCL_RET_OK;
+}
+
+rcl_ret_t
+rcl_timer_get_slack(const rcl_timer_t * timer, int64_t * slack)
+{
+  RCL_CHECK_ARGUMENT_FOR_NULL(timer, RCL_RET_INVALID_ARGUMENT, rcl_get_default_allocator());
+  const rcl_allocator_t * allocator = rcl_timer_get_allocator(timer);
+  if (!allocator) {
+    return RCL_RET_TIMER_INVALID;
+  }
+  RCL_CHECK_ARGUMENT_FOR_NULL(slack, RCL_RET_INVALID_ARGUMENT, *allocator);
+  *slack = rcl_atomic_load_int64_t(&timer->impl->slack);
+  return RCL_RET_OK;
+}
+
+rcl_ret_t
+rcl_timer_set_slack(rcl_timer_t * timer, int64_t slack)
+{
+  RCL_CHECK_ARGUMENT_FOR_NULL(timer, RCL_RET_INVALID_ARGUMENT, rcl_get_default_allocator());
+  const rcl_allocator_t * allocator = rcl_timer_get_allocator(timer);
+  if (!allocator) {
+    return RCL_RET_TIMER_INVALID;
+  }
+  if (slack < 0) {
+    RCL_SET_ERROR_MSG("timer slack must be non-negative", *allocator);
+    return RCL_RET_INVALID_ARGUMENT;
+  }
+  rcl_atomic_store(&timer->impl->slack, slack);
+  RCUTILS_LOG_DEBUG_NAMED(ROS_PACKAGE_NAME, "Updated timer slack to '%" PRId64 "ns'", slack)
+  return RCL_RET_OK;
+}
+
+rcl_ret_t
+rcl_timer_align_phase(rcl_timer_t * timer, rcl_time_point_value_t epoch)
+{
+  RCL_CHECK_ARGUMENT_FOR_NULL(timer, RCL_RET_INVALID_ARGUMENT, rcl_get_default_allocator());
+  const rcl_allocator_t * allocator = rcl_timer_get_allocator(timer);
+  if (!allocator) {
+    return RCL_RET_TIMER_INVALID;
+  }
+  int64_t period = rcl_atomic_load_uint64_t(&timer->impl->period);
+  if (0 == period) {
+    // A timer with a period of zero is always ready, there is no phase to align.
+    return RCL_RET_OK;
+  }
+  rcl_time_point_value_t now;
+  rcl_ret_t now_ret = rcl_clock_get_now(timer->impl->clock, &now);
+  if (now_ret != RCL_RET_OK) {
+    return now_ret;  // rcl error state should already be set.
+  }
+  // The first time of the form epoch + k * period which is not before now,
+  // division truncating towards zero rounds up for negative values.
+  int64_t since_epoch = now - epoch;
+  int64_t periods = since_epoch > 0 ? 1 + (since_epoch - 1) / period : since_epoch / period;
+  rcl_atomic_store(&timer->impl->next_call_time, epoch + periods * period);
+  // The next call time may have moved backwards, which timer queues can not detect.
+  rcl_timer_queue_notify_reschedule();
+  RCUTILS_LOG_DEBUG_NAMED(
+    ROS_PACKAGE_NAME, "Aligned timer phase to '%" PRId64 "ns'", epoch + periods * period)
+  return RCL_RET_OK;
+}
+
+rcl_guard_condition_t *
+rcl_timer_get_guard_condition(const rcl_timer_t * timer)
+{
+  if (!timer || !timer->impl || !timer->impl->guard_condition.impl) {
+    return NULL;
+  }
+  return &timer->impl->guard_condition;
+}
+
+int
+rcl_timer_get_timer_fd(const rcl_timer_t * timer)
+{
+  return timer->impl->timer_fd;
+}
+
+rcl_ret_t
+rcl_timer_arm_timer_fd(const rcl_timer_t * timer)
+{
+#if defined(__linux__)
+  rcl_timer_impl_t * impl = timer->impl;
+  struct itimerspec expiration;
+  // A zero expiration time disarms the timerfd.
+  memset(&expiration, 0, sizeof(expiration));
+  if (!rcl_atomic_load_bool(&impl->canceled)) {
+    // The steady time of rcl is not necessarily CLOCK_MONOTONIC, so the next
+    // call time is moved onto CLOCK_MONOTONIC by the time left until it.
+    // Reading the steady time first errs on the side of expiring late.
+    rcl_time_point_value_t now;
+    rcl_ret_t ret = rcl_clock_get_now(impl->clock, &now);
+    if (ret != RCL_RET_OK) {
+      return ret;  // rcl error state should already be set.
+    }
+    struct timespec monotonic_now;
+    if (clock_gettime(CLOCK_MONOTONIC, &monotonic_now) != 0) {
+      RCL_SET_ERROR_MSG("failed to get the monotonic time", impl->allocator);
+      return RCL_RET_ERROR;
+    }
+    int64_t monotonic_now_ns = RCL_S_TO_NS((int64_t)monotonic_now.tv_sec) + monotonic_now.tv_nsec;
+    int64_t time_left = (int64_t)rcl_atomic_load_uint64_t(&impl->next_call_time) - now;
+    int64_t slack = rcl_atomic_load_int64_t(&impl->slack);
+    time_left = slack > INT64_MAX - time_left ? INT64_MAX : time_left + slack;
+    if (time_left < 0) {
+      time_left = 0;
+    } else if (time_left > INT64_MAX - monotonic_now_ns) {
+      time_left = INT64_MAX - monotonic_now_ns;
+    }
+    int64_t expiration_ns = monotonic_now_ns + time_left;
+    expiration.it_value.tv_sec = (time_t)RCL_NS_TO_S(expiration_ns);
+    expiration.it_value.tv_nsec = (long)(expiration_ns % 1000000000);
+  }
+  if (timerfd_settime(impl->timer_fd, TFD_TIMER_ABSTIME, &expiration, NULL) != 0) {
+    RCL_SET_ERROR_MSG("failed to arm timerfd", impl->allocator);
+    return RCL_RET_ERROR;
+  }
+  return RCL_RET_OK;
+#else
+  (void)timer;
+  RCL_SET_ERROR_MSG("timerfd is not supported on this platform", rcl_get_default_allocator());
+  return RCL_RET_ERROR;
+#endif  // defined(__linux__)
+}
+
 const rcl_allocator_t *
 rcl_timer_get_allocator(const rcl_timer_t * timer)
 {
@@ -0,0 +1,51 @@
+// Copyright 2018 Open Source Robotics Foundation, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef RCL__TIMER_IMPL_H_
+#define RCL__TIMER_IMPL_H_
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+#include "rcl/timer.h"
+#include "rcl/types.h"
+
+/// Return the timerfd of a timer created with the `high_precision` option.
+/* Return -1 if the timer has no timerfd, either because it was created
+ * without the option or because the platform has no timerfd.
+ * The timer must be valid.
+ */
+int
+rcl_timer_get_timer_fd(const rcl_timer_t * timer);
+
+/// Arm the timerfd of a timer at its next call time, plus its slack.
+/* The expiration time is absolute, so it does not depend on when the wait on
+ * the timerfd starts.
+ * Arming clears a previous expiration, so the timerfd never needs to be read.
+ * The timerfd of a canceled timer is disarmed instead.
+ * The timer must be valid and have a timerfd.
+ *
+ * \return RCL_RET_OK if the timerfd was armed successfully, or
+ *         RCL_RET_ERROR if an unspecified error occurs.
+ */
+rcl_ret_t
+rcl_timer_arm_timer_fd(const rcl_timer_t * timer);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif  // RCL__TIMER_IMPL_H_
@@ -0,0 +1,374 @@
+// Copyright 2018 Open Source Robotics Foundation, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+#include "./timer_queue.h"
+
+#include "./stdatomic_helper.h"
+#include "rcl/error_handling.h"
+
+// Incremented every time a next call time may have moved backwards.
+static atomic_uint_least64_t __rcl_timer_queue_reschedule_epoch = ATOMIC_VAR_INIT(0);
+
+rcl_timer_queue_t
+rcl_get_zero_initialized_timer_queue()
+{
+  static rcl_timer_queue_t null_queue = {
+    .entries = NULL,
+    .positions = NULL,
+    .size = 0,
+    .capacity = 0,
+    .reschedule_epoch = 0,
+  };
+  return null_queue;
+}
+
+rcl_ret_t
+rcl_timer_queue_resize(
+  rcl_timer_queue_t * queue,
+  size_t capacity,
+  rcl_allocator_t allocator)
+{
+  queue->size = 0;
+  if (0 == capacity) {
+    if (queue->entries) {
+      allocator.deallocate(queue->entries, allocator.state);
+      queue->entries = NULL;
+    }
+    if (queue->positions) {
+      allocator.deallocate(queue->positions, allocator.state);
+      queue->positions = NULL;
+    }
+    queue->capacity = 0;
+    return RCL_RET_OK;
+  }
+  rcl_timer_queue_entry_t * entries = (rcl_timer_queue_entry_t *)allocator.reallocate(
+    queue->entries, sizeof(rcl_timer_queue_entry_t) * capacity, allocator.state);
+  RCL_CHECK_FOR_NULL_WITH_MSG(
+    entries, "allocating memory failed", return RCL_RET_BAD_ALLOC, allocator);
+  queue->entries = entries;
+  size_t * positions = (size_t *)allocator.reallocate(
+    queue->positions, sizeof(size_t) * capacity, allocator.state);
+  RCL_CHECK_FOR_NULL_WITH_MSG(
+    positions, "allocating memory failed", return RCL_RET_BAD_ALLOC, allocator);
+  queue->positions = positions;
+  queue->capacity = capacity;
+  size_t i;
+  for (i = 0; i < capacity; ++i) {
+    queue->positions[i] = SIZE_MAX;
+  }
+  return RCL_RET_OK;
+}
+
+static void
+__place(rcl_timer_queue_t * queue, size_t position, rcl_timer_queue_entry_t entry)
+{
+  queue->entries[position] = entry;
+  queue->positions[entry.index] = position;
+}
+
+static void
+__sift_up(rcl_timer_queue_t * queue, size_t position)
+{
+  rcl_timer_queue_entry_t entry = queue->entries[position];
+  while (position > 0) {
+    size_t parent = (position - 1) / 2;
+    if (queue->entries[parent].next_call_time <= entry.next_call_time) {
+      break;
+    }
+    __place(queue, position, queue->entries[parent]);
+    position = parent;
+  }
+  __place(queue, position, entry);
+}
+
+static void
+__sift_down(rcl_timer_queue_t * queue, size_t position)
+{
+  rcl_timer_queue_entry_t entry = queue->entries[position];
+  for (;; ) {
+    size_t child = 2 * position + 1;
+    if (child >= queue->size) {
+      break;
+    }
+    if (
+      child + 1 < queue->size &&
+      queue->entries[child + 1].next_call_time < queue->entries[child].next_call_time)
+    {
+      ++child;
+    }
+    if (entry.next_call_time <= queue->entries[child].next_call_time) {
+      break;
+    }
+    __place(queue, position, queue->entries[child]);
+    position = child;
+  }
+  __place(queue, position, entry);
+}
+
+rcl_ret_t
+rcl_timer_queue_rebuild(
+  rcl_timer_queue_t * queue,
+  const rcl_timer_t * const * timers,
+  size_t count,
+  size_t * unqueued_indexes,
+  size_t * number_of_unqueued)
+{
+  if (count > queue->capacity) {
+    RCL_SET_ERROR_MSG("timer queue is too small", rcl_get_default_allocator());
+    return RCL_RET_ERROR;
+  }
+  // Read the epoch first, so that a concurrent reschedule makes the queue stale again.
+  queue->reschedule_epoch = rcl_atomic_load_uint64_t(&__rcl_timer_queue_reschedule_epoch);
+  queue->size = 0;
+  *number_of_unqueued = 0;
+  size_t i;
+  for (i = 0; i < queue->capacity; ++i) {
+    queue->positions[i] = SIZE_MAX;
+  }
+  for (i = 0; i < count; ++i) {
+    if (!timers[i]) {
+      continue;
+    }
+    bool is_canceled = false;
+    rcl_ret_t ret = rcl_timer_is_canceled(timers[i], &is_canceled);
+    if (ret != RCL_RET_OK) {
+      return ret;  // rcl error state should already be set.
+    }
+    if (is_canceled) {
+      continue;
+    }
+    rcl_clock_t * clock = NULL;
+    ret = rcl_timer_clock((rcl_timer_t *)timers[i], &clock);
+    if (ret != RCL_RET_OK) {
+      return ret;  // rcl error state should already be set.
+    }
+    if (RCL_STEADY_TIME != clock->type) {
+      unqueued_indexes[(*number_of_unqueued)++] = i;
+      continue;
+    }
+    int64_t next_call_time = 0;
+    ret = rcl_timer_get_next_call_time(timers[i], &next_call_time);
+    if (ret != RCL_RET_OK) {
+      return ret;  // rcl error state should already be set.
+    }
+    rcl_timer_queue_entry_t entry = {next_call_time, i};
+    __place(queue, queue->size++, entry);
+  }
+  // Heapify bottom up.
+  for (i = queue->size / 2; i > 0; --i) {
+    __sift_down(queue, i - 1);
+  }
+  return RCL_RET_OK;
+}
+
+rcl_ret_t
+rcl_timer_queue_insert(
+  rcl_timer_queue_t * queue,
+  const rcl_timer_t * const * timers,
+  size_t index,
+  bool * is_queued)
+{
+  *is_queued = false;
+  if (index >= queue->capacity || SIZE_MAX != queue->positions[index]) {
+    RCL_SET_ERROR_MSG("timer cannot be inserted in the queue", rcl_get_default_allocator());
+    return RCL_RET_ERROR;
+  }
+  bool is_canceled = false;
+  rcl_ret_t ret = rcl_timer_is_canceled(timers[index], &is_canceled);
+  if (ret != RCL_RET_OK) {
+    return ret;  // rcl error state should already be set.
+  }
+  if (is_canceled) {
+    return RCL_RET_OK;
+  }
+  rcl_clock_t * clock = NULL;
+  ret = rcl_timer_clock((rcl_timer_t *)timers[index], &clock);
+  if (ret != RCL_RET_OK) {
+    return ret;  // rcl error state should already be set.
+  }
+  if (RCL_STEADY_TIME != clock->type) {
+    return RCL_RET_OK;
+  }
+  int64_t next_call_time = 0;
+  ret = rcl_timer_get_next_call_time(timers[index], &next_call_time);
+  if (ret != RCL_RET_OK) {
+    return ret;  // rcl error state should already be set.
+  }
+  rcl_timer_queue_entry_t entry = {next_call_time, index};
+  __place(queue, queue->size, entry);
+  __sift_up(queue, queue->size++);
+  *is_queued = true;
+  return RCL_RET_OK;
+}
+
+void
+rcl_timer_queue_remove(rcl_timer_queue_t * queue, size_t index)
+{
+  if (index >= queue->capacity || SIZE_MAX == queue->positions[index]) {
+    return;
+  }
+  size_t position = queue->positions[index];
+  queue->positions[index] = SIZE_MAX;
+  size_t last = --queue->size;
+  if (position == last) {
+    return;
+  }
+  // The last entry fills the hole, and moves up or down from there.
+  size_t moved_index = queue->entries[last].index;
+  __place(queue, position, queue->entries[last]);
+  __sift_up(queue, position);
+  __sift_down(queue, queue->positions[moved_index]);
+}
+
+bool
+rcl_timer_queue_is_stale(const rcl_timer_queue_t * queue)
+{
+  return queue->reschedule_epoch != rcl_atomic_load_uint64_t(&__rcl_timer_queue_reschedule_epoch);
+}
+
+rcl_ret_t
+rcl_timer_queue_fix_top(
+  rcl_timer_queue_t * queue,
+  const rcl_timer_t * const * timers,
+  int64_t * next_call_time)
+{
+  while (queue->size > 0 && queue->entries[0].next_call_time != INT64_MAX) {
+    const rcl_timer_t * timer = timers[queue->entries[0].index];
+    bool is_canceled = false;
+    rcl_ret_t ret = rcl_timer_is_canceled(timer, &is_canceled);
+    if (ret != RCL_RET_OK) {
+      return ret;  // rcl error state should already be set.
+    }
+    int64_t actual_next_call_time = INT64_MAX;
+    if (!is_canceled) {
+      ret = rcl_timer_get_next_call_time(timer, &actual_next_call_time);
+      if (ret != RCL_RET_OK) {
+        return ret;  // rcl error state should already be set.
+      }
+    }
+    if (actual_next_call_time == queue->entries[0].next_call_time) {
+      break;
+    }
+    // The cached value can only be too early, so the root can only move down.
+    queue->entries[0].next_call_time = actual_next_call_time;
+    __sift_down(queue, 0);
+  }
+  *next_call_time = queue->size > 0 ? queue->entries[0].next_call_time : INT64_MAX;
+  return RCL_RET_OK;
+}
+
+rcl_ret_t
+rcl_timer_queue_get_wake_up_time(
+  const rcl_timer_queue_t * queue,
+  const rcl_timer_t * const * timers,
+  size_t * scratch,
+  int64_t * wake_up_time)
+{
+  // Breadth first walk of the part of the heap which can still lower the deadline.
+  // The cached next call times are lower bounds, so they are safe to prune with.
+  int64_t deadline = INT64_MAX;
+  size_t count = 0;
+  if (queue->size > 0 && queue->entries[0].next_call_time != INT64_MAX) {
+    scratch[count++] = 0;
+  }
+  size_t i;
+  for (i = 0; i < count; ++i) {
+    size_t position = scratch[i];
+    if (queue->entries[position].next_call_time >= deadline) {
+      continue;
+    }
+    const rcl_timer_t * timer = timers[queue->entries[position].index];
+    bool is_canceled = false;
+    rcl_ret_t ret = rcl_timer_is_canceled(timer, &is_canceled);
+    if (ret != RCL_RET_OK) {
+      return ret;  // rcl error state should already be set.
+    }
+    if (!is_canceled) {
+      int64_t next_call_time = 0;
+      ret = rcl_timer_get_next_call_time(timer, &next_call_time);
+      if (ret != RCL_RET_OK) {
+        return ret;  // rcl error state should already be set.
+      }
+      int64_t slack = 0;
+      ret = rcl_timer_get_slack(timer, &slack);
+      if (ret != RCL_RET_OK) {
+        return ret;  // rcl error state should already be set.
+      }
+      int64_t timer_deadline =
+        slack > INT64_MAX - next_call_time ? INT64_MAX : next_call_time + slack;
+      if (timer_deadline < deadline) {
+        deadline = timer_deadline;
+      }
+    }
+    size_t child = 2 * position + 1;
+    if (child < queue->size && queue->entries[child].next_call_time < deadline) {
+      scratch[count++] = child;
+    }
+    ++child;
+    if (child < queue->size && queue->entries[child].next_call_time < deadline) {
+      scratch[count++] = child;
+    }
+  }
+  *wake_up_time = deadline;
+  return RCL_RET_OK;
+}
+
+size_t
+rcl_timer_queue_collect_expired(
+  const rcl_timer_queue_t * queue,
+  int64_t now,
+  size_t * indexes)
+{
+  // Breadth first walk of the expired part of the heap, using the output as the work queue.
+  size_t count = 0;
+  if (queue->size > 0 && queue->entries[0].next_call_time <= now) {
+    indexes[count++] = 0;
+  }
+  size_t i;
+  for (i = 0; i < count; ++i) {
+    size_t child = 2 * indexes[i] + 1;
+    if (child < queue->size && queue->entries[child].next_call_time <= now) {
+      indexes[count++] = child;
+    }
+    ++child;
+    if (child < queue->size && queue->entries[child].next_call_time <= now) {
+      indexes[count++] = child;
+    }
+  }
+  // Translate the heap positions into timer indexes.
+  for (i = 0; i < count; ++i) {
+    indexes[i] = queue->entries[indexes[i]].index;
+  }
+  return count;
+}
+
+void
+rcl_timer_queue_notify_reschedule()
+{
+  uint64_t epoch = rcl_atomic_load_uint64_t(&__rcl_timer_queue_reschedule_epoch);
+  while (!rcl_atomic_compare_exchange_strong_uint_least64_t(
+      &__rcl_timer_queue_reschedule_epoch, &epoch, epoch + 1))
+  {
+    // epoch was updated with the current value, try again.
+  }
+}
+
+#ifdef __cplusplus
+}
+#endif
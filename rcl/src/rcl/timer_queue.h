@@ -0,0 +1,208 @@
+// Copyright 2018 Open Source Robotics Foundation, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef RCL__TIMER_QUEUE_H_
+#define RCL__TIMER_QUEUE_H_
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "rcl/allocator.h"
+#include "rcl/timer.h"
+#include "rcl/types.h"
+
+/// A timer in the queue, identified by its index in the caller's timer array.
+typedef struct rcl_timer_queue_entry_t
+{
+  // Cached next call time of the timer, never later than the actual one.
+  int64_t next_call_time;
+  size_t index;
+} rcl_timer_queue_entry_t;
+
+/// Binary min-heap of timers ordered by their next call time.
+/* The queue does not own the timers, it only refers to them by their index in
+ * an array of timer pointers owned by the caller, e.g. a wait set.
+ *
+ * The cached next call times may lag behind the actual ones, because calling
+ * a timer moves its next call time forward without notifying the queue.
+ * Since they can only lag behind, the root of the heap is always a lower bound
+ * for the next timer to become ready, and rcl_timer_queue_fix_top() refreshes
+ * the root until it is exact.
+ * Anything that may move a next call time backwards, like rcl_timer_reset(),
+ * calls rcl_timer_queue_notify_reschedule(), after which the queue must be
+ * rebuilt.
+ * The position of each timer in the heap is tracked, so that a single timer
+ * can be inserted or removed without rebuilding the queue.
+ */
+typedef struct rcl_timer_queue_t
+{
+  rcl_timer_queue_entry_t * entries;
+  // Position in entries of each timer index, or SIZE_MAX if the timer is not queued.
+  size_t * positions;
+  size_t size;
+  size_t capacity;
+  // Value of the reschedule epoch when the queue was last rebuilt.
+  uint64_t reschedule_epoch;
+} rcl_timer_queue_t;
+
+/// Return a rcl_timer_queue_t struct with members set to `NULL` or zero.
+rcl_timer_queue_t
+rcl_get_zero_initialized_timer_queue(void);
+
+/// Reallocate the queue so that it can hold up to capacity timers, and empty it.
+/* A capacity of 0 deallocates the storage of the queue.
+ *
+ * \param[inout] queue the queue to be resized
+ * \param[in] capacity the maximum number of timers in the queue
+ * \param[in] allocator the allocator to use for the storage of the queue
+ * \return RCL_RET_OK if the queue was resized successfully, or
+ *         RCL_RET_BAD_ALLOC if allocating memory failed.
+ */
+rcl_ret_t
+rcl_timer_queue_resize(
+  rcl_timer_queue_t * queue,
+  size_t capacity,
+  rcl_allocator_t allocator);
+
+/// Rebuild the queue from the first count timers of the given array.
+/* `NULL` and canceled timers are left out of the queue.
+ * Only timers on a RCL_STEADY_TIME clock are queued, since the next call times
+ * of timers on different clocks cannot be compared.
+ * The indexes of the other timers are returned in unqueued_indexes instead.
+ * Runs in O(count).
+ *
+ * \param[inout] queue the queue to be rebuilt, with a capacity of at least count
+ * \param[in] timers the array of timers, indexed by the entries of the queue
+ * \param[in] count the number of timers in the array
+ * \param[out] unqueued_indexes storage for at least count indexes of timers
+ *   which are not on a steady clock
+ * \param[out] number_of_unqueued the number of indexes in unqueued_indexes
+ * \return RCL_RET_OK if the queue was rebuilt successfully, or
+ *         RCL_RET_ERROR if the queue is too small, or
+ *         RCL_RET_TIMER_INVALID if one of the timers is invalid.
+ */
+rcl_ret_t
+rcl_timer_queue_rebuild(
+  rcl_timer_queue_t * queue,
+  const rcl_timer_t * const * timers,
+  size_t count,
+  size_t * unqueued_indexes,
+  size_t * number_of_unqueued);
+
+/// Insert a single timer of the given array into the queue.
+/* Like rcl_timer_queue_rebuild(), canceled timers and timers which are not on
+ * a RCL_STEADY_TIME clock are left out, in which case is_queued is false.
+ * Runs in O(log n).
+ *
+ * \param[inout] queue the queue to insert into, which must not hold the timer yet
+ * \param[in] timers the array of timers, indexed by the entries of the queue
+ * \param[in] index the index of the timer, lower than the capacity of the queue
+ * \param[out] is_queued true if the timer was inserted
+ * \return RCL_RET_OK if the timer was inserted or left out successfully, or
+ *         RCL_RET_ERROR if the timer is already queued, or
+ *         RCL_RET_TIMER_INVALID if the timer is invalid.
+ */
+rcl_ret_t
+rcl_timer_queue_insert(
+  rcl_timer_queue_t * queue,
+  const rcl_timer_t * const * timers,
+  size_t index,
+  bool * is_queued);
+
+/// Remove the timer with the given index from the queue, if it is queued.
+/* Runs in O(log n).
+ */
+void
+rcl_timer_queue_remove(rcl_timer_queue_t * queue, size_t index);
+
+/// Return true if the queue needs to be rebuilt because a timer was rescheduled.
+bool
+rcl_timer_queue_is_stale(const rcl_timer_queue_t * queue);
+
+/// Refresh the root of the queue until its cached next call time is exact.
+/* Timers which were called since they were last refreshed sink down the heap,
+ * and canceled timers are moved to the bottom, each in O(log n).
+ *
+ * \param[inout] queue the queue to be fixed
+ * \param[in] timers the array of timers, indexed by the entries of the queue
+ * \param[out] next_call_time the next call time of the earliest timer, or
+ *   INT64_MAX if the queue is empty or only holds canceled timers
+ * \return RCL_RET_OK if the root was fixed successfully, or
+ *         RCL_RET_TIMER_INVALID if one of the timers is invalid.
+ */
+rcl_ret_t
+rcl_timer_queue_fix_top(
+  rcl_timer_queue_t * queue,
+  const rcl_timer_t * const * timers,
+  int64_t * next_call_time);
+
+/// Compute the latest time to wake up at, without waking any timer later than its slack.
+/* This is the minimum over all timers of their next call time plus their
+ * slack, see rcl_timer_set_slack().
+ * Only the entries whose cached next call time is before the minimum found so
+ * far are visited, so this runs in O(k) for the k timers falling due within
+ * the slack of the first one.
+ * The root of the queue must have been fixed with rcl_timer_queue_fix_top().
+ *
+ * \param[in] queue the queue to be searched
+ * \param[in] timers the array of timers, indexed by the entries of the queue
+ * \param[out] scratch storage for at least as many positions as there are
+ *   timers in the queue
+ * \param[out] wake_up_time the time to wake up at, or INT64_MAX if the queue
+ *   is empty or only holds canceled timers
+ * \return RCL_RET_OK if the time was computed successfully, or
+ *         RCL_RET_TIMER_INVALID if one of the timers is invalid.
+ */
+rcl_ret_t
+rcl_timer_queue_get_wake_up_time(
+  const rcl_timer_queue_t * queue,
+  const rcl_timer_t * const * timers,
+  size_t * scratch,
+  int64_t * wake_up_time);
+
+/// Collect the indexes of the timers whose cached next call time is not after now.
+/* Only the part of the heap holding those timers is visited, so this runs in
+ * O(k) for k collected timers, independently of the size of the queue.
+ * Because the cached next call times may lag behind, the collected timers are
+ * candidates which still need to be checked with rcl_timer_is_ready(), but no
+ * ready timer is ever left out.
+ * The indexes are collected in no particular order.
+ *
+ * \param[in] queue the queue to be searched
+ * \param[in] now the current time, on the same clock as the next call times
+ * \param[out] indexes storage for at least as many indexes as there are timers
+ *   in the queue
+ * \return the number of collected indexes.
+ */
+size_t
+rcl_timer_queue_collect_expired(
+  const rcl_timer_queue_t * queue,
+  int64_t now,
+  size_t * indexes);
+
+/// Signal to all timer queues that a next call time may have moved backwards.
+void
+rcl_timer_queue_notify_reschedule(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif  // RCL__TIMER_QUEUE_H_
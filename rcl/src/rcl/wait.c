@@ -12,6 +12,10 @@
 // See the License for the specific language governing permissions and
 // limitations under the License.
 
+#if defined(__linux__) && !defined(_GNU_SOURCE)
+#define _GNU_SOURCE  // for ppoll()
+#endif
+
 #ifdef __cplusplus
 extern "C"
 {
@@ -23,8 +27,21 @@ extern "C"
 #include <inttypes.h>
 #include <stdbool.h>
 #include <string.h>
+#if !defined(_WIN32)
+#include <errno.h>
+#include <time.h>
+#endif  // !defined(_WIN32)
+#if defined(__linux__)
+#include <poll.h>
+#endif  // defined(__linux__)
 
+#include "./guard_condition_impl.h"
+#include "./intra_process.h"
 #include "./stdatomic_helper.h"
+#include "./subscription_impl.h"
+#include "./time_impl.h"
+#include "./timer_impl.h"
+#include "./timer_queue.h"
 #include "rcl/error_handling.h"
 #include "rcl/time.h"
 #include "rcutils/logging_macros.h"
@@ -36,18 +53,46 @@ typedef struct rcl_wait_set_impl_t
   // number of subscriptions that have been added to the wait set
   size_t subscription_index;
   rmw_subscriptions_t rmw_subscriptions;
+  // copy of the rmw subscription handles, which rmw_wait does not modify
+  void ** rmw_subscriptions_members;
   // number of guard_conditions that have been added to the wait set
   size_t guard_condition_index;
   rmw_guard_conditions_t rmw_guard_conditions;
+  // copy of the rmw guard condition handles, which rmw_wait does not modify
+  void ** rmw_guard_conditions_members;
+  // number of local guard conditions, which have a NULL member until rmw_wait needs them
+  size_t number_of_local_guard_conditions;
+#if defined(__linux__)
+  // eventfds of the local guard conditions followed by the timerfds of the timers,
+  // when waiting without rmw_wait
+  struct pollfd * local_guard_condition_pollfds;
+#endif  // defined(__linux__)
   // number of clients that have been added to the wait set
   size_t client_index;
   rmw_clients_t rmw_clients;
+  // copy of the rmw client handles, which rmw_wait does not modify
+  void ** rmw_clients_members;
   // number of services that have been added to the wait set
   size_t service_index;
   rmw_services_t rmw_services;
+  // copy of the rmw service handles, which rmw_wait does not modify
+  void ** rmw_services_members;
   rmw_wait_set_t * rmw_wait_set;
   // number of timers that have been added to the wait set
   size_t timer_index;
+  // timers ordered by next call time, only used by persistent wait sets
+  rcl_timer_queue_t timer_queue;
+  // true if the timers changed since the timer queue was last rebuilt
+  bool timer_queue_dirty;
+  // indexes of the timers which are not on a steady clock, and therefore not in the timer queue
+  size_t * unqueued_timer_indices;
+  size_t number_of_unqueued_timers;
+  // if true, rcl_wait only reports readiness through the ready flags
+  bool persistent;
+  // number of waits which found ready timers
+  uint64_t number_of_timer_wake_ups;
+  // number of ready timers beyond the first one, summed over those waits
+  uint64_t number_of_timer_wake_ups_saved;
   rcl_allocator_t allocator;
 } rcl_wait_set_impl_t;
 
@@ -65,6 +110,23 @@ rcl_get_zero_initialized_wait_set()
     .size_of_services = 0,
     .timers = NULL,
     .size_of_timers = 0,
+    .ready = {
+      .subscriptions = NULL,
+      .subscription_indices = NULL,
+      .number_of_ready_subscriptions = 0,
+      .guard_conditions = NULL,
+      .guard_condition_indices = NULL,
+      .number_of_ready_guard_conditions = 0,
+      .timers = NULL,
+      .timer_indices = NULL,
+      .number_of_ready_timers = 0,
+      .clients = NULL,
+      .client_indices = NULL,
+      .number_of_ready_clients = 0,
+      .services = NULL,
+      .service_indices = NULL,
+      .number_of_ready_services = 0,
+    },
     .impl = NULL,
   };
   return null_wait_set;
@@ -79,7 +141,7 @@ __wait_set_is_valid(const rcl_wait_set_t * wait_set)
 static void
 __wait_set_clean_up(rcl_wait_set_t * wait_set, rcl_allocator_t allocator)
 {
-  if (wait_set->subscriptions) {
+  if (wait_set->impl) {
     rcl_ret_t ret = rcl_wait_set_resize(wait_set, 0, 0, 0, 0, 0);
     (void)ret;  // NO LINT
     assert(RCL_RET_OK == ret);  // Defensive, shouldn't fail with size 0.
@@ -128,9 +190,10 @@ rcl_wait_set_init(
   wait_set->impl->rmw_services.services = NULL;
   wait_set->impl->rmw_services.service_count = 0;
 
+  // Timers on ROS clocks are waited on through their guard conditions.
   wait_set->impl->rmw_wait_set = rmw_create_wait_set(
-    2 * number_of_subscriptions + number_of_guard_conditions + number_of_clients +
-    number_of_services);
+    2 * number_of_subscriptions + number_of_guard_conditions + number_of_timers +
+    number_of_clients + number_of_services);
   if (!wait_set->impl->rmw_wait_set) {
     goto fail;
   }
@@ -199,16 +262,51 @@ rcl_wait_set_get_allocator(const rcl_wait_set_t * wait_set, rcl_allocator_t * al
     return RCL_RET_WAIT_SET_FULL; \
   } \
   size_t current_index = wait_set->impl->Type ## _index++; \
-  wait_set->Type ## s[current_index] = Type;
+  wait_set->Type ## s[current_index] = Type; \
+  wait_set->ready.Type ## s[current_index] = false;
 
-#define SET_ADD_RMW(Type, RMWStorage, RMWCount) \
+#define SET_ADD_RMW(Type, RMWStorage, RMWCount, RMWMembers) \
   /* Also place into rmw storage. */ \
   rmw_ ## Type ## _t * rmw_handle = rcl_ ## Type ## _get_rmw_handle(Type); \
   RCL_CHECK_FOR_NULL_WITH_MSG( \
     rmw_handle, rcl_get_error_string_safe(), return RCL_RET_ERROR, wait_set->impl->allocator); \
   wait_set->impl->RMWStorage[current_index] = rmw_handle->data; \
+  wait_set->impl->RMWMembers[current_index] = rmw_handle->data; \
   wait_set->impl->RMWCount++;
 
+#define SET_REMOVE(Type) \
+  RCL_CHECK_ARGUMENT_FOR_NULL(wait_set, RCL_RET_INVALID_ARGUMENT, rcl_get_default_allocator()); \
+  if (!__wait_set_is_valid(wait_set)) { \
+    RCL_SET_ERROR_MSG("wait set is invalid", rcl_get_default_allocator()); \
+    return RCL_RET_WAIT_SET_INVALID; \
+  } \
+  RCL_CHECK_ARGUMENT_FOR_NULL(Type, RCL_RET_INVALID_ARGUMENT, wait_set->impl->allocator); \
+  size_t removed_index = 0; \
+  while (removed_index < wait_set->impl->Type ## _index && \
+    wait_set->Type ## s[removed_index] != Type) \
+  { \
+    ++removed_index; \
+  } \
+  if (removed_index == wait_set->impl->Type ## _index) { \
+    RCL_SET_ERROR_MSG(#Type " is not in the wait set", wait_set->impl->allocator); \
+    return RCL_RET_INVALID_ARGUMENT; \
+  } \
+  /* Move the last entry into the freed slot to keep the set dense. */ \
+  size_t last_index = --wait_set->impl->Type ## _index; \
+  wait_set->Type ## s[removed_index] = wait_set->Type ## s[last_index]; \
+  wait_set->Type ## s[last_index] = NULL; \
+  /* The ready list refers to slots which may have moved, so it is reset. */ \
+  memset(wait_set->ready.Type ## s, 0, sizeof(bool) * wait_set->size_of_ ## Type ## s); \
+  wait_set->ready.number_of_ready_ ## Type ## s = 0;
+
+#define SET_REMOVE_RMW(RMWStorage, RMWCount, RMWMembers) \
+  /* Also remove from the rmw storage, which is indexed the same way. */ \
+  wait_set->impl->RMWStorage[removed_index] = wait_set->impl->RMWStorage[last_index]; \
+  wait_set->impl->RMWMembers[removed_index] = wait_set->impl->RMWMembers[last_index]; \
+  wait_set->impl->RMWStorage[last_index] = NULL; \
+  wait_set->impl->RMWMembers[last_index] = NULL; \
+  wait_set->impl->RMWCount--;
+
 #define SET_CLEAR(Type) \
   do { \
     if (NULL != wait_set->Type ## s) { \
@@ -216,11 +314,13 @@ rcl_wait_set_get_allocator(const rcl_wait_set_t * wait_set, rcl_allocator_t * al
         (void *)wait_set->Type ## s, \
         0, \
         sizeof(rcl_ ## Type ## _t *) * wait_set->size_of_ ## Type ## s); \
+      memset(wait_set->ready.Type ## s, 0, sizeof(bool) * wait_set->size_of_ ## Type ## s); \
+      wait_set->ready.number_of_ready_ ## Type ## s = 0; \
       wait_set->impl->Type ## _index = 0; \
     } \
   } while (false)
 
-#define SET_CLEAR_RMW(Type, RMWStorage, RMWCount) \
+#define SET_CLEAR_RMW(Type, RMWStorage, RMWCount, RMWMembers) \
   do { \
     if (NULL != wait_set->impl->RMWStorage) { \
       /* Also clear the rmw storage. */ \
@@ -228,6 +328,10 @@ rcl_wait_set_get_allocator(const rcl_wait_set_t * wait_set, rcl_allocator_t * al
         wait_set->impl->RMWStorage, \
         0, \
         sizeof(void *) * wait_set->impl->RMWCount); \
+      memset( \
+        wait_set->impl->RMWMembers, \
+        0, \
+        sizeof(void *) * wait_set->impl->RMWCount); \
       wait_set->impl->RMWCount = 0; \
     } \
   } while (false)
@@ -237,11 +341,20 @@ rcl_wait_set_get_allocator(const rcl_wait_set_t * wait_set, rcl_allocator_t * al
     rcl_allocator_t allocator = wait_set->impl->allocator; \
     wait_set->size_of_ ## Type ## s = 0; \
     wait_set->impl->Type ## _index = 0; \
+    wait_set->ready.number_of_ready_ ## Type ## s = 0; \
     if (0 == Type ## s_size) { \
       if (wait_set->Type ## s) { \
         allocator.deallocate((void *)wait_set->Type ## s, allocator.state); \
         wait_set->Type ## s = NULL; \
       } \
+      if (wait_set->ready.Type ## s) { \
+        allocator.deallocate(wait_set->ready.Type ## s, allocator.state); \
+        wait_set->ready.Type ## s = NULL; \
+      } \
+      if (wait_set->ready.Type ## _indices) { \
+        allocator.deallocate(wait_set->ready.Type ## _indices, allocator.state); \
+        wait_set->ready.Type ## _indices = NULL; \
+      } \
       ExtraDealloc \
     } else { \
       wait_set->Type ## s = (const rcl_ ## Type ## _t **)allocator.reallocate( \
@@ -251,31 +364,58 @@ rcl_wait_set_get_allocator(const rcl_wait_set_t * wait_set, rcl_allocator_t * al
         wait_set->Type ## s, "allocating memory failed", \
         return RCL_RET_BAD_ALLOC, wait_set->impl->allocator); \
       memset((void *)wait_set->Type ## s, 0, sizeof(rcl_ ## Type ## _t *) * Type ## s_size); \
+      wait_set->ready.Type ## s = (bool *)allocator.reallocate( \
+        wait_set->ready.Type ## s, sizeof(bool) * Type ## s_size, allocator.state); \
+      wait_set->ready.Type ## _indices = (size_t *)allocator.reallocate( \
+        wait_set->ready.Type ## _indices, sizeof(size_t) * Type ## s_size, allocator.state); \
+      if (!wait_set->ready.Type ## s || !wait_set->ready.Type ## _indices) { \
+        allocator.deallocate((void *)wait_set->Type ## s, allocator.state); \
+        wait_set->Type ## s = NULL; \
+        allocator.deallocate(wait_set->ready.Type ## s, allocator.state); \
+        wait_set->ready.Type ## s = NULL; \
+        allocator.deallocate(wait_set->ready.Type ## _indices, allocator.state); \
+        wait_set->ready.Type ## _indices = NULL; \
+        RCL_SET_ERROR_MSG("allocating memory failed", wait_set->impl->allocator); \
+        return RCL_RET_BAD_ALLOC; \
+      } \
+      memset(wait_set->ready.Type ## s, 0, sizeof(bool) * Type ## s_size); \
       wait_set->size_of_ ## Type ## s = Type ## s_size; \
       ExtraRealloc \
     } \
   } while (false)
 
-#define SET_RESIZE_RMW_DEALLOC(RMWStorage, RMWCount) \
+#define SET_RESIZE_RMW_DEALLOC(RMWStorage, RMWCount, RMWMembers) \
   /* Also deallocate the rmw storage. */ \
   if (wait_set->impl->RMWStorage) { \
     allocator.deallocate((void *)wait_set->impl->RMWStorage, allocator.state); \
     wait_set->impl->RMWStorage = NULL; \
     wait_set->impl->RMWCount = 0; \
+  } \
+  if (wait_set->impl->RMWMembers) { \
+    allocator.deallocate((void *)wait_set->impl->RMWMembers, allocator.state); \
+    wait_set->impl->RMWMembers = NULL; \
   }
 
-#define SET_RESIZE_RMW_REALLOC(Type, RMWStorage, RMWCount) \
+#define SET_RESIZE_RMW_REALLOC(Type, RMWStorage, RMWCount, RMWMembers) \
   /* Also resize the rmw storage. */ \
   wait_set->impl->RMWCount = 0; \
   wait_set->impl->RMWStorage = (void **)allocator.reallocate( \
     wait_set->impl->RMWStorage, sizeof(void *) * Type ## s_size, allocator.state); \
-  if (!wait_set->impl->RMWStorage) { \
+  wait_set->impl->RMWMembers = (void **)allocator.reallocate( \
+    wait_set->impl->RMWMembers, sizeof(void *) * Type ## s_size, allocator.state); \
+  if (!wait_set->impl->RMWStorage || !wait_set->impl->RMWMembers) { \
     allocator.deallocate((void *)wait_set->Type ## s, allocator.state); \
+    wait_set->Type ## s = NULL; \
+    allocator.deallocate(wait_set->ready.Type ## s, allocator.state); \
+    wait_set->ready.Type ## s = NULL; \
+    allocator.deallocate(wait_set->ready.Type ## _indices, allocator.state); \
+    wait_set->ready.Type ## _indices = NULL; \
     wait_set->size_of_ ## Type ## s = 0; \
     RCL_SET_ERROR_MSG("allocating memory failed", wait_set->impl->allocator); \
     return RCL_RET_BAD_ALLOC; \
   } \
-  memset(wait_set->impl->RMWStorage, 0, sizeof(void *) * Type ## s_size);
+  memset(wait_set->impl->RMWStorage, 0, sizeof(void *) * Type ## s_size); \
+  memset(wait_set->impl->RMWMembers, 0, sizeof(void *) * Type ## s_size);
 
 /* Implementation-specific notes:
  *
@@ -288,7 +428,8 @@ rcl_wait_set_add_subscription(
   const rcl_subscription_t * subscription)
 {
   SET_ADD(subscription)
-  SET_ADD_RMW(subscription, rmw_subscriptions.subscribers, rmw_subscriptions.subscriber_count)
+  SET_ADD_RMW(subscription, rmw_subscriptions.subscribers, rmw_subscriptions.subscriber_count,
+    rmw_subscriptions_members)
   return RCL_RET_OK;
 }
 
@@ -309,23 +450,29 @@ rcl_wait_set_clear(rcl_wait_set_t * wait_set)
   SET_CLEAR(client);
   SET_CLEAR(service);
   SET_CLEAR(timer);
+  wait_set->impl->timer_queue_dirty = true;
+  wait_set->impl->number_of_local_guard_conditions = 0;
 
   SET_CLEAR_RMW(
     subscription,
     rmw_subscriptions.subscribers,
-    rmw_subscriptions.subscriber_count);
+    rmw_subscriptions.subscriber_count,
+    rmw_subscriptions_members);
   SET_CLEAR_RMW(
     guard_condition,
     rmw_guard_conditions.guard_conditions,
-    rmw_guard_conditions.guard_condition_count);
+    rmw_guard_conditions.guard_condition_count,
+    rmw_guard_conditions_members);
   SET_CLEAR_RMW(
     clients,
     rmw_clients.clients,
-    rmw_clients.client_count);
+    rmw_clients.client_count,
+    rmw_clients_members);
   SET_CLEAR_RMW(
     services,
     rmw_services.services,
-    rmw_services.service_count);
+    rmw_services.service_count,
+    rmw_services_members);
 
   return RCL_RET_OK;
 }
@@ -350,32 +497,88 @@ rcl_wait_set_resize(
   SET_RESIZE(
     subscription,
     SET_RESIZE_RMW_DEALLOC(
-      rmw_subscriptions.subscribers, rmw_subscriptions.subscriber_count),
+      rmw_subscriptions.subscribers, rmw_subscriptions.subscriber_count,
+      rmw_subscriptions_members),
     SET_RESIZE_RMW_REALLOC(
-      subscription, rmw_subscriptions.subscribers, rmw_subscriptions.subscriber_count)
+      subscription, rmw_subscriptions.subscribers, rmw_subscriptions.subscriber_count,
+      rmw_subscriptions_members)
   );
   SET_RESIZE(
     guard_condition,
     SET_RESIZE_RMW_DEALLOC(
       rmw_guard_conditions.guard_conditions,
-      rmw_guard_conditions.guard_condition_count),
+      rmw_guard_conditions.guard_condition_count,
+      rmw_guard_conditions_members),
     SET_RESIZE_RMW_REALLOC(
       guard_condition,
       rmw_guard_conditions.guard_conditions,
-      rmw_guard_conditions.guard_condition_count)
+      rmw_guard_conditions.guard_condition_count,
+      rmw_guard_conditions_members)
   );
+  wait_set->impl->number_of_local_guard_conditions = 0;
+#if defined(__linux__)
+  if (0 == guard_conditions_size + timers_size) {
+    if (wait_set->impl->local_guard_condition_pollfds) {
+      wait_set->impl->allocator.deallocate(
+        wait_set->impl->local_guard_condition_pollfds, wait_set->impl->allocator.state);
+      wait_set->impl->local_guard_condition_pollfds = NULL;
+    }
+  } else {
+    // A timer may have both a timerfd and the eventfd of its guard condition.
+    struct pollfd * pollfds = (struct pollfd *)wait_set->impl->allocator.reallocate(
+      wait_set->impl->local_guard_condition_pollfds,
+      sizeof(struct pollfd) * (guard_conditions_size + 2u * timers_size),
+      wait_set->impl->allocator.state);
+    RCL_CHECK_FOR_NULL_WITH_MSG(
+      pollfds, "allocating memory failed", return RCL_RET_BAD_ALLOC, wait_set->impl->allocator);
+    wait_set->impl->local_guard_condition_pollfds = pollfds;
+  }
+#endif  // defined(__linux__)
   SET_RESIZE(timer,;,;);  // NOLINT
+  rcl_ret_t ret = rcl_timer_queue_resize(
+    &wait_set->impl->timer_queue, timers_size, wait_set->impl->allocator);
+  if (RCL_RET_OK != ret) {
+    return ret;  // The rcl error state should already be set.
+  }
+  wait_set->impl->timer_queue_dirty = true;
+  wait_set->impl->number_of_unqueued_timers = 0;
+  if (0 == timers_size) {
+    if (wait_set->impl->unqueued_timer_indices) {
+      wait_set->impl->allocator.deallocate(
+        wait_set->impl->unqueued_timer_indices, wait_set->impl->allocator.state);
+      wait_set->impl->unqueued_timer_indices = NULL;
+    }
+  } else {
+    size_t * indices = (size_t *)wait_set->impl->allocator.reallocate(
+      wait_set->impl->unqueued_timer_indices,
+      sizeof(size_t) * timers_size, wait_set->impl->allocator.state);
+    RCL_CHECK_FOR_NULL_WITH_MSG(
+      indices, "allocating memory failed", return RCL_RET_BAD_ALLOC, wait_set->impl->allocator);
+    wait_set->impl->unqueued_timer_indices = indices;
+  }
+  // The rmw guard conditions of the timers, and of the intra-process subscriptions,
+  // are appended to those of the guard conditions.
+  size_t rmw_guard_conditions_size = guard_conditions_size + timers_size + subscriptions_size;
+  if (rmw_guard_conditions_size > 0) {
+    void ** guard_conditions = (void **)wait_set->impl->allocator.reallocate(
+      wait_set->impl->rmw_guard_conditions.guard_conditions,
+      sizeof(void *) * rmw_guard_conditions_size, wait_set->impl->allocator.state);
+    RCL_CHECK_FOR_NULL_WITH_MSG(
+      guard_conditions, "allocating memory failed",
+      return RCL_RET_BAD_ALLOC, wait_set->impl->allocator);
+    wait_set->impl->rmw_guard_conditions.guard_conditions = guard_conditions;
+  }
   SET_RESIZE(client,
     SET_RESIZE_RMW_DEALLOC(
-      rmw_clients.clients, rmw_clients.client_count),
+      rmw_clients.clients, rmw_clients.client_count, rmw_clients_members),
     SET_RESIZE_RMW_REALLOC(
-      client, rmw_clients.clients, rmw_clients.client_count)
+      client, rmw_clients.clients, rmw_clients.client_count, rmw_clients_members)
   );
   SET_RESIZE(service,
     SET_RESIZE_RMW_DEALLOC(
-      rmw_services.services, rmw_services.service_count),
+      rmw_services.services, rmw_services.service_count, rmw_services_members),
     SET_RESIZE_RMW_REALLOC(
-      service, rmw_services.services, rmw_services.service_count)
+      service, rmw_services.services, rmw_services.service_count, rmw_services_members)
   );
   return RCL_RET_OK;
 }
@@ -386,8 +589,19 @@ rcl_wait_set_add_guard_condition(
   const rcl_guard_condition_t * guard_condition)
 {
   SET_ADD(guard_condition)
+  const rcl_guard_condition_options_t * options = rcl_guard_condition_get_options(guard_condition);
+  RCL_CHECK_FOR_NULL_WITH_MSG(
+    options, rcl_get_error_string_safe(), return RCL_RET_ERROR, wait_set->impl->allocator);
+  if (options->local_only) {
+    // Its rmw guard condition is only filled in if rmw_wait is used.
+    wait_set->impl->rmw_guard_conditions.guard_conditions[current_index] = NULL;
+    wait_set->impl->rmw_guard_conditions_members[current_index] = NULL;
+    wait_set->impl->rmw_guard_conditions.guard_condition_count++;
+    wait_set->impl->number_of_local_guard_conditions++;
+    return RCL_RET_OK;
+  }
   SET_ADD_RMW(guard_condition, rmw_guard_conditions.guard_conditions,
-    rmw_guard_conditions.guard_condition_count)
+    rmw_guard_conditions.guard_condition_count, rmw_guard_conditions_members)
   return RCL_RET_OK;
 }
 
@@ -397,6 +611,7 @@ rcl_wait_set_add_timer(
   const rcl_timer_t * timer)
 {
   SET_ADD(timer)
+  wait_set->impl->timer_queue_dirty = true;
   return RCL_RET_OK;
 }
 
@@ -406,7 +621,7 @@ rcl_wait_set_add_client(
   const rcl_client_t * client)
 {
   SET_ADD(client)
-  SET_ADD_RMW(client, rmw_clients.clients, rmw_clients.client_count)
+  SET_ADD_RMW(client, rmw_clients.clients, rmw_clients.client_count, rmw_clients_members)
   return RCL_RET_OK;
 }
 
@@ -416,10 +631,753 @@ rcl_wait_set_add_service(
   const rcl_service_t * service)
 {
   SET_ADD(service)
-  SET_ADD_RMW(service, rmw_services.services, rmw_services.service_count)
+  SET_ADD_RMW(service, rmw_services.services, rmw_services.service_count, rmw_services_members)
+  return RCL_RET_OK;
+}
+
+rcl_ret_t
+rcl_wait_set_set_persistent(rcl_wait_set_t * wait_set, bool persistent)
+{
+  RCL_CHECK_ARGUMENT_FOR_NULL(wait_set, RCL_RET_INVALID_ARGUMENT, rcl_get_default_allocator());
+  if (!__wait_set_is_valid(wait_set)) {
+    RCL_SET_ERROR_MSG("wait set is invalid", rcl_get_default_allocator());
+    return RCL_RET_WAIT_SET_INVALID;
+  }
+  wait_set->impl->persistent = persistent;
+  wait_set->impl->timer_queue_dirty = true;
+  return RCL_RET_OK;
+}
+
+bool
+rcl_wait_set_is_persistent(const rcl_wait_set_t * wait_set)
+{
+  return __wait_set_is_valid(wait_set) && wait_set->impl->persistent;
+}
+
+rcl_ret_t
+rcl_wait_set_get_timer_statistics(
+  const rcl_wait_set_t * wait_set,
+  rcl_wait_set_timer_statistics_t * statistics)
+{
+  RCL_CHECK_ARGUMENT_FOR_NULL(wait_set, RCL_RET_INVALID_ARGUMENT, rcl_get_default_allocator());
+  RCL_CHECK_ARGUMENT_FOR_NULL(statistics, RCL_RET_INVALID_ARGUMENT, rcl_get_default_allocator());
+  if (!__wait_set_is_valid(wait_set)) {
+    RCL_SET_ERROR_MSG("wait set is invalid", rcl_get_default_allocator());
+    return RCL_RET_WAIT_SET_INVALID;
+  }
+  statistics->number_of_timer_wake_ups = wait_set->impl->number_of_timer_wake_ups;
+  statistics->number_of_timer_wake_ups_saved = wait_set->impl->number_of_timer_wake_ups_saved;
+  return RCL_RET_OK;
+}
+
+/* Implementation-specific notes:
+ *
+ * Remove the rmw representation from the underlying rmw array and decrement
+ * the rmw array count.
+ */
+rcl_ret_t
+rcl_wait_set_remove_subscription(
+  rcl_wait_set_t * wait_set,
+  const rcl_subscription_t * subscription)
+{
+  SET_REMOVE(subscription)
+  SET_REMOVE_RMW(rmw_subscriptions.subscribers, rmw_subscriptions.subscriber_count,
+    rmw_subscriptions_members)
+  return RCL_RET_OK;
+}
+
+rcl_ret_t
+rcl_wait_set_remove_guard_condition(
+  rcl_wait_set_t * wait_set,
+  const rcl_guard_condition_t * guard_condition)
+{
+  SET_REMOVE(guard_condition)
+  SET_REMOVE_RMW(rmw_guard_conditions.guard_conditions,
+    rmw_guard_conditions.guard_condition_count, rmw_guard_conditions_members)
+  if (rcl_guard_condition_is_local(guard_condition)) {
+    wait_set->impl->number_of_local_guard_conditions--;
+  }
+  return RCL_RET_OK;
+}
+
+rcl_ret_t
+rcl_wait_set_remove_timer(
+  rcl_wait_set_t * wait_set,
+  const rcl_timer_t * timer)
+{
+  SET_REMOVE(timer)
+  wait_set->impl->timer_queue_dirty = true;
+  return RCL_RET_OK;
+}
+
+rcl_ret_t
+rcl_wait_set_remove_client(
+  rcl_wait_set_t * wait_set,
+  const rcl_client_t * client)
+{
+  SET_REMOVE(client)
+  SET_REMOVE_RMW(rmw_clients.clients, rmw_clients.client_count, rmw_clients_members)
+  return RCL_RET_OK;
+}
+
+rcl_ret_t
+rcl_wait_set_remove_service(
+  rcl_wait_set_t * wait_set,
+  const rcl_service_t * service)
+{
+  SET_REMOVE(service)
+  SET_REMOVE_RMW(rmw_services.services, rmw_services.service_count, rmw_services_members)
+  return RCL_RET_OK;
+}
+
+#define SET_CHECK_INDEX(Type, IsEnabled, State) \
+  RCL_CHECK_ARGUMENT_FOR_NULL(wait_set, RCL_RET_INVALID_ARGUMENT, rcl_get_default_allocator()); \
+  if (!__wait_set_is_valid(wait_set)) { \
+    RCL_SET_ERROR_MSG("wait set is invalid", rcl_get_default_allocator()); \
+    return RCL_RET_WAIT_SET_INVALID; \
+  } \
+  if (!wait_set->impl->persistent) { \
+    RCL_SET_ERROR_MSG("wait set is not persistent", wait_set->impl->allocator); \
+    return RCL_RET_INVALID_ARGUMENT; \
+  } \
+  if ( \
+    index >= wait_set->impl->Type ## _index || \
+    IsEnabled != (NULL != wait_set->Type ## s[index])) \
+  { \
+    RCL_SET_ERROR_MSG(#Type " at this index is not " State, wait_set->impl->allocator); \
+    return RCL_RET_INVALID_ARGUMENT; \
+  }
+
+/* Implementation-specific notes:
+ *
+ * A disabled entity has a NULL entry in the wait set, but keeps its rmw
+ * representation, which is left out of the rmw storage passed to rmw_wait.
+ */
+rcl_ret_t
+rcl_wait_set_disable_subscription(rcl_wait_set_t * wait_set, size_t index)
+{
+  SET_CHECK_INDEX(subscription, true, "enabled")
+  wait_set->subscriptions[index] = NULL;
+  return RCL_RET_OK;
+}
+
+rcl_ret_t
+rcl_wait_set_enable_subscription(
+  rcl_wait_set_t * wait_set,
+  const rcl_subscription_t * subscription,
+  size_t index)
+{
+  SET_CHECK_INDEX(subscription, false, "disabled")
+  RCL_CHECK_ARGUMENT_FOR_NULL(subscription, RCL_RET_INVALID_ARGUMENT, wait_set->impl->allocator);
+  wait_set->subscriptions[index] = subscription;
+  return RCL_RET_OK;
+}
+
+rcl_ret_t
+rcl_wait_set_disable_guard_condition(rcl_wait_set_t * wait_set, size_t index)
+{
+  SET_CHECK_INDEX(guard_condition, true, "enabled")
+  if (rcl_guard_condition_is_local(wait_set->guard_conditions[index])) {
+    wait_set->impl->number_of_local_guard_conditions--;
+  }
+  wait_set->guard_conditions[index] = NULL;
+  return RCL_RET_OK;
+}
+
+rcl_ret_t
+rcl_wait_set_enable_guard_condition(
+  rcl_wait_set_t * wait_set,
+  const rcl_guard_condition_t * guard_condition,
+  size_t index)
+{
+  SET_CHECK_INDEX(guard_condition, false, "disabled")
+  RCL_CHECK_ARGUMENT_FOR_NULL(
+    guard_condition, RCL_RET_INVALID_ARGUMENT, wait_set->impl->allocator);
+  if (rcl_guard_condition_is_local(guard_condition)) {
+    wait_set->impl->number_of_local_guard_conditions++;
+  }
+  wait_set->guard_conditions[index] = guard_condition;
+  return RCL_RET_OK;
+}
+
+/* Implementation-specific notes:
+ *
+ * The timer is taken out of the timer queue, or ignored by the next rebuild
+ * of the queue, so that the queue does not need to be rebuilt.
+ */
+rcl_ret_t
+rcl_wait_set_disable_timer(rcl_wait_set_t * wait_set, size_t index)
+{
+  SET_CHECK_INDEX(timer, true, "enabled")
+  wait_set->timers[index] = NULL;
+  rcl_timer_queue_remove(&wait_set->impl->timer_queue, index);
+  return RCL_RET_OK;
+}
+
+rcl_ret_t
+rcl_wait_set_enable_timer(
+  rcl_wait_set_t * wait_set,
+  const rcl_timer_t * timer,
+  size_t index)
+{
+  SET_CHECK_INDEX(timer, false, "disabled")
+  RCL_CHECK_ARGUMENT_FOR_NULL(timer, RCL_RET_INVALID_ARGUMENT, wait_set->impl->allocator);
+  wait_set->timers[index] = timer;
+  rcl_wait_set_impl_t * impl = wait_set->impl;
+  if (impl->timer_queue_dirty || rcl_timer_queue_is_stale(&impl->timer_queue)) {
+    // The timer is picked up when the queue is rebuilt before the next wait.
+    return RCL_RET_OK;
+  }
+  bool is_queued = false;
+  rcl_ret_t ret = rcl_timer_queue_insert(&impl->timer_queue, wait_set->timers, index, &is_queued);
+  if (ret != RCL_RET_OK) {
+    wait_set->timers[index] = NULL;
+    return ret;  // The rcl error state should already be set.
+  }
+  if (is_queued) {
+    return RCL_RET_OK;
+  }
+  // Timers on other clocks stay in the unqueued list while disabled, unless it was rebuilt.
+  size_t i;
+  for (i = 0; i < impl->number_of_unqueued_timers; ++i) {
+    if (impl->unqueued_timer_indices[i] == index) {
+      return RCL_RET_OK;
+    }
+  }
+  rcl_clock_t * clock = NULL;
+  ret = rcl_timer_clock((rcl_timer_t *)timer, &clock);
+  if (ret != RCL_RET_OK) {
+    wait_set->timers[index] = NULL;
+    return ret;  // The rcl error state should already be set.
+  }
+  if (RCL_STEADY_TIME != clock->type) {
+    impl->unqueued_timer_indices[impl->number_of_unqueued_timers++] = index;
+  }
+  return RCL_RET_OK;
+}
+
+rcl_ret_t
+rcl_wait_set_disable_client(rcl_wait_set_t * wait_set, size_t index)
+{
+  SET_CHECK_INDEX(client, true, "enabled")
+  wait_set->clients[index] = NULL;
+  return RCL_RET_OK;
+}
+
+rcl_ret_t
+rcl_wait_set_enable_client(
+  rcl_wait_set_t * wait_set,
+  const rcl_client_t * client,
+  size_t index)
+{
+  SET_CHECK_INDEX(client, false, "disabled")
+  RCL_CHECK_ARGUMENT_FOR_NULL(client, RCL_RET_INVALID_ARGUMENT, wait_set->impl->allocator);
+  wait_set->clients[index] = client;
   return RCL_RET_OK;
 }
 
+rcl_ret_t
+rcl_wait_set_disable_service(rcl_wait_set_t * wait_set, size_t index)
+{
+  SET_CHECK_INDEX(service, true, "enabled")
+  wait_set->services[index] = NULL;
+  return RCL_RET_OK;
+}
+
+rcl_ret_t
+rcl_wait_set_enable_service(
+  rcl_wait_set_t * wait_set,
+  const rcl_service_t * service,
+  size_t index)
+{
+  SET_CHECK_INDEX(service, false, "disabled")
+  RCL_CHECK_ARGUMENT_FOR_NULL(service, RCL_RET_INVALID_ARGUMENT, wait_set->impl->allocator);
+  wait_set->services[index] = service;
+  return RCL_RET_OK;
+}
+
+#define SET_RESTORE_RMW(Type, RMWStorage, RMWCount, RMWMembers) \
+  /* Undo the pruning done to the rmw storage by the last call to rmw_wait, */ \
+  /* leaving out the disabled entities. */ \
+  do { \
+    size_t number_enabled = 0; \
+    size_t k; \
+    for (k = 0; k < wait_set->impl->Type ## _index; ++k) { \
+      if (wait_set->Type ## s[k]) { \
+        wait_set->impl->RMWStorage[number_enabled++] = wait_set->impl->RMWMembers[k]; \
+      } \
+    } \
+    wait_set->impl->RMWCount = number_enabled; \
+  } while (false)
+
+#define SET_EXPAND_RMW(Type, RMWStorage, RMWCount) \
+  /* Move the results of rmw_wait back to the indexes of the wait set, */ \
+  /* the rmw storage of a disabled entity is only ever moved right. */ \
+  do { \
+    size_t number_enabled = wait_set->impl->RMWCount; \
+    size_t k; \
+    for (k = wait_set->impl->Type ## _index; number_enabled < k; --k) { \
+      wait_set->impl->RMWStorage[k - 1] = wait_set->Type ## s[k - 1] ? \
+        wait_set->impl->RMWStorage[--number_enabled] : NULL; \
+    } \
+    wait_set->impl->RMWCount = wait_set->impl->Type ## _index; \
+  } while (false)
+
+// Return the time at which the timers need the wait set to wake up,
+// taking their slack into account.
+static rcl_ret_t
+__wait_set_get_timer_wake_up_time(rcl_wait_set_t * wait_set, int64_t * wake_up_time)
+{
+  rcl_wait_set_impl_t * impl = wait_set->impl;
+  if (impl->timer_queue_dirty || rcl_timer_queue_is_stale(&impl->timer_queue)) {
+    rcl_ret_t ret = rcl_timer_queue_rebuild(
+      &impl->timer_queue, wait_set->timers, impl->timer_index,
+      impl->unqueued_timer_indices, &impl->number_of_unqueued_timers);
+    if (ret != RCL_RET_OK) {
+      return ret;  // The rcl error state should already be set.
+    }
+    impl->timer_queue_dirty = false;
+  }
+  int64_t next_call_time = INT64_MAX;
+  rcl_ret_t ret = rcl_timer_queue_fix_top(&impl->timer_queue, wait_set->timers, &next_call_time);
+  if (ret != RCL_RET_OK) {
+    return ret;  // The rcl error state should already be set.
+  }
+  // The ready timer indexes are free until the wait is over.
+  return rcl_timer_queue_get_wake_up_time(
+    &impl->timer_queue, wait_set->timers, wait_set->ready.timer_indices, wake_up_time);
+}
+
+// Get the current time on the clock of a timer, reusing the snapshot of the steady time.
+static rcl_ret_t
+__wait_set_get_timer_now(
+  const rcl_timer_t * timer,
+  rcl_time_point_value_t steady_now,
+  rcl_time_point_value_t * now,
+  bool * is_overridden)
+{
+  rcl_clock_t * clock = NULL;
+  rcl_ret_t ret = rcl_timer_clock((rcl_timer_t *)timer, &clock);
+  if (ret != RCL_RET_OK) {
+    return ret;  // The rcl error state should already be set.
+  }
+  *is_overridden = false;
+  if (RCL_STEADY_TIME == clock->type) {
+    *now = steady_now;
+    return RCL_RET_OK;
+  }
+  if (RCL_ROS_TIME == clock->type) {
+    ret = rcl_is_enabled_ros_time_override(clock, is_overridden);
+    if (ret != RCL_RET_OK) {
+      return ret;  // The rcl error state should already be set.
+    }
+  }
+  return rcl_clock_get_now(clock, now);
+}
+
+// Get how long a timer lets the wait last, taking its slack into account.
+static rcl_ret_t
+__wait_set_get_timer_timeout(
+  const rcl_timer_t * timer,
+  rcl_time_point_value_t steady_now,
+  int64_t * timer_timeout)
+{
+  rcl_time_point_value_t now = 0;
+  bool is_overridden = false;
+  rcl_ret_t ret = __wait_set_get_timer_now(timer, steady_now, &now, &is_overridden);
+  if (ret != RCL_RET_OK) {
+    return ret;  // The rcl error state should already be set.
+  }
+  ret = rcl_timer_get_time_until_next_call_at(timer, now, timer_timeout);
+  if (ret != RCL_RET_OK) {
+    return ret;  // The rcl error state should already be set.
+  }
+  if (is_overridden) {
+    // Unless it moves by itself, the time only moves when set, which triggers the timer.
+    if (*timer_timeout > 0) {
+      rcl_clock_t * clock = NULL;
+      ret = rcl_timer_clock((rcl_timer_t *)timer, &clock);
+      if (ret != RCL_RET_OK) {
+        return ret;  // The rcl error state should already be set.
+      }
+      *timer_timeout = rcl_ros_clock_get_steady_duration(clock, *timer_timeout);
+    }
+    return RCL_RET_OK;
+  }
+  // The timer may wake up late by its slack, to share the wake up with other timers.
+  int64_t slack = 0;
+  ret = rcl_timer_get_slack(timer, &slack);
+  if (ret != RCL_RET_OK) {
+    return ret;  // The rcl error state should already be set.
+  }
+  *timer_timeout = slack > INT64_MAX - *timer_timeout ? INT64_MAX : *timer_timeout + slack;
+  return RCL_RET_OK;
+}
+
+static rcl_ret_t
+__wait_set_is_timer_ready(
+  const rcl_timer_t * timer,
+  rcl_time_point_value_t steady_now,
+  bool * is_ready)
+{
+  rcl_time_point_value_t now = 0;
+  bool is_overridden = false;
+  rcl_ret_t ret = __wait_set_get_timer_now(timer, steady_now, &now, &is_overridden);
+  if (ret != RCL_RET_OK) {
+    return ret;  // The rcl error state should already be set.
+  }
+  return rcl_timer_is_ready_at(timer, now, is_ready);
+}
+
+static void
+__wait_set_set_timer_ready(rcl_wait_set_ready_t * ready, size_t index)
+{
+  RCUTILS_LOG_DEBUG_NAMED(ROS_PACKAGE_NAME, "Timer in wait set is ready")
+  ready->timers[index] = true;
+  // Insert in ascending order, there are usually only a few ready timers.
+  size_t position = ready->number_of_ready_timers++;
+  while (position > 0 && ready->timer_indices[position - 1] > index) {
+    ready->timer_indices[position] = ready->timer_indices[position - 1];
+    --position;
+  }
+  ready->timer_indices[position] = index;
+}
+
+static rcl_ret_t
+__wait_set_collect_ready_timers(rcl_wait_set_t * wait_set, rcl_time_point_value_t now)
+{
+  rcl_wait_set_ready_t * ready = &wait_set->ready;
+  rcl_ret_t ret = RCL_RET_OK;
+  // Only the timers which are due according to the queue can be ready.
+  size_t number_of_candidates = rcl_timer_queue_collect_expired(
+    &wait_set->impl->timer_queue, now, ready->timer_indices);
+  size_t i;
+  for (i = 0; i < number_of_candidates; ++i) {
+    size_t index = ready->timer_indices[i];
+    bool is_ready = false;
+    ret = rcl_timer_is_ready_at(wait_set->timers[index], now, &is_ready);
+    if (ret != RCL_RET_OK) {
+      return ret;  // The rcl error state should already be set.
+    }
+    if (is_ready) {
+      __wait_set_set_timer_ready(ready, index);
+    }
+  }
+  // The timers on other clocks are not in the queue, and are checked one by one.
+  for (i = 0; i < wait_set->impl->number_of_unqueued_timers; ++i) {
+    size_t index = wait_set->impl->unqueued_timer_indices[i];
+    if (!wait_set->timers[index]) {
+      continue;  // Skip disabled timers.
+    }
+    bool is_ready = false;
+    ret = __wait_set_is_timer_ready(wait_set->timers[index], now, &is_ready);
+    if (ret != RCL_RET_OK) {
+      return ret;  // The rcl error state should already be set.
+    }
+    if (is_ready) {
+      __wait_set_set_timer_ready(ready, index);
+    }
+  }
+  return RCL_RET_OK;
+}
+
+// Append the rmw guard conditions of the timers on ROS clocks, which are triggered on time jumps.
+static rcl_ret_t
+__wait_set_attach_timer_guard_conditions(rcl_wait_set_t * wait_set)
+{
+  rmw_guard_conditions_t * rmw_guard_conditions = &wait_set->impl->rmw_guard_conditions;
+  size_t i;
+  for (i = 0; i < wait_set->impl->timer_index; ++i) {
+    const rcl_guard_condition_t * guard_condition = NULL;
+    if (wait_set->timers[i]) {
+      guard_condition = rcl_timer_get_guard_condition(wait_set->timers[i]);
+    }
+    if (!guard_condition) {
+      continue;
+    }
+    rmw_guard_condition_t * rmw_handle = rcl_guard_condition_get_rmw_handle(guard_condition);
+    RCL_CHECK_FOR_NULL_WITH_MSG(
+      rmw_handle, rcl_get_error_string_safe(), return RCL_RET_ERROR, wait_set->impl->allocator);
+    rmw_guard_conditions->guard_conditions[rmw_guard_conditions->guard_condition_count++] =
+      rmw_handle->data;
+  }
+  return RCL_RET_OK;
+}
+
+// Consume the triggers of the guard conditions of the timers on ROS clocks.
+static void
+__wait_set_take_timer_guard_condition_triggers(rcl_wait_set_t * wait_set)
+{
+  size_t i;
+  for (i = 0; i < wait_set->impl->timer_index; ++i) {
+    const rcl_guard_condition_t * guard_condition = NULL;
+    if (wait_set->timers[i]) {
+      guard_condition = rcl_timer_get_guard_condition(wait_set->timers[i]);
+    }
+    if (guard_condition) {
+      rcl_guard_condition_take_trigger(guard_condition);
+    }
+  }
+}
+
+// Append the rmw guard conditions of the intra-process subscriptions, which are triggered
+// when a message is queued, and return true if a subscription already has one.
+static rcl_ret_t
+__wait_set_attach_intra_process_guard_conditions(
+  rcl_wait_set_t * wait_set, bool * has_intra_process_messages)
+{
+  rmw_guard_conditions_t * rmw_guard_conditions = &wait_set->impl->rmw_guard_conditions;
+  size_t i;
+  for (i = 0; i < wait_set->impl->subscription_index; ++i) {
+    if (!wait_set->subscriptions[i]) {
+      continue;
+    }
+    rcl_intra_process_subscription_t * intra_process =
+      rcl_subscription_get_intra_process(wait_set->subscriptions[i]);
+    if (!intra_process) {
+      continue;
+    }
+    const rcl_guard_condition_t * guard_condition =
+      rcl_intra_process_subscription_get_guard_condition(intra_process);
+    rmw_guard_condition_t * rmw_handle = rcl_guard_condition_get_rmw_handle(guard_condition);
+    RCL_CHECK_FOR_NULL_WITH_MSG(
+      rmw_handle, rcl_get_error_string_safe(), return RCL_RET_ERROR, wait_set->impl->allocator);
+    rmw_guard_conditions->guard_conditions[rmw_guard_conditions->guard_condition_count++] =
+      rmw_handle->data;
+    // Checked after attaching, since messages queued before that may not trigger rmw.
+    if (rcl_intra_process_subscription_has_messages(intra_process)) {
+      *has_intra_process_messages = true;
+    }
+  }
+  return RCL_RET_OK;
+}
+
+// Return true if a timer of the wait set is on a ROS clock, and so has a guard condition.
+static bool
+__wait_set_has_timer_guard_conditions(const rcl_wait_set_t * wait_set)
+{
+  size_t i;
+  for (i = 0; i < wait_set->impl->timer_index; ++i) {
+    if (wait_set->timers[i] && rcl_timer_get_guard_condition(wait_set->timers[i])) {
+      return true;
+    }
+  }
+  return false;
+}
+
+// Return true if only timers and local guard conditions are waited on, so rmw_wait can be skipped.
+static bool
+__wait_set_can_bypass_rmw(const rcl_wait_set_t * wait_set, const rmw_time_t * timeout_argument)
+{
+  const rcl_wait_set_impl_t * impl = wait_set->impl;
+  if (
+    0 != impl->rmw_subscriptions.subscriber_count ||
+    impl->number_of_local_guard_conditions != impl->rmw_guard_conditions.guard_condition_count ||
+    0 != impl->rmw_clients.client_count ||
+    0 != impl->rmw_services.service_count)
+  {
+    return false;
+  }
+#if defined(__linux__)
+  // Local guard conditions, those of the timers included, are waited on through their eventfds.
+  return timeout_argument || impl->number_of_local_guard_conditions > 0 ||
+         __wait_set_has_timer_guard_conditions(wait_set);
+#elif !defined(_WIN32)
+  return timeout_argument && 0 == impl->number_of_local_guard_conditions &&
+         !__wait_set_has_timer_guard_conditions(wait_set);
+#else
+  (void)timeout_argument;
+  return false;
+#endif  // defined(__linux__)
+}
+
+// Fill in the rmw guard conditions of the local guard conditions for rmw_wait.
+static rcl_ret_t
+__wait_set_attach_local_guard_conditions(rcl_wait_set_t * wait_set)
+{
+  // The disabled guard conditions are left out of the rmw storage.
+  size_t position = 0;
+  size_t i;
+  for (i = 0; i < wait_set->impl->guard_condition_index; ++i) {
+    const rcl_guard_condition_t * guard_condition = wait_set->guard_conditions[i];
+    if (!guard_condition) {
+      continue;
+    }
+    if (rcl_guard_condition_is_local(guard_condition)) {
+      rmw_guard_condition_t * rmw_handle = rcl_guard_condition_get_rmw_handle(guard_condition);
+      RCL_CHECK_FOR_NULL_WITH_MSG(
+        rmw_handle, rcl_get_error_string_safe(), return RCL_RET_ERROR,
+        wait_set->impl->allocator);
+      wait_set->impl->rmw_guard_conditions.guard_conditions[position] = rmw_handle->data;
+    }
+    ++position;
+  }
+  return RCL_RET_OK;
+}
+
+// Return true if a local guard condition of the wait set, or of one of its timers,
+// has a pending trigger.
+/* A trigger racing with the previous take may have left the flag set with its
+ * eventfd already drained, so the flags are checked before waiting.
+ */
+static bool
+__wait_set_has_triggered_local_guard_condition(const rcl_wait_set_t * wait_set)
+{
+  size_t i;
+  for (i = 0; i < wait_set->impl->guard_condition_index; ++i) {
+    const rcl_guard_condition_t * guard_condition = wait_set->guard_conditions[i];
+    if (
+      guard_condition && rcl_guard_condition_is_local(guard_condition) &&
+      rcl_guard_condition_is_triggered(guard_condition))
+    {
+      return true;
+    }
+  }
+  for (i = 0; i < wait_set->impl->timer_index; ++i) {
+    const rcl_guard_condition_t * guard_condition = NULL;
+    if (wait_set->timers[i]) {
+      guard_condition = rcl_timer_get_guard_condition(wait_set->timers[i]);
+    }
+    if (guard_condition && rcl_guard_condition_is_triggered(guard_condition)) {
+      return true;
+    }
+  }
+  return false;
+}
+
+// Sleep for the given duration, without involving the middleware.
+static bool
+__wait_set_sleep(const rmw_time_t * timeout_argument)
+{
+#if !defined(_WIN32)
+  // A relative sleep is used because the steady time of rcutils is not
+  // guaranteed to be on the clock used by clock_nanosleep().
+  if (0 == timeout_argument->sec && 0 == timeout_argument->nsec) {
+    return true;
+  }
+  struct timespec remaining;
+  remaining.tv_sec = (time_t)timeout_argument->sec;
+  remaining.tv_nsec = (long)timeout_argument->nsec;
+  while (0 != nanosleep(&remaining, &remaining)) {
+    if (EINTR != errno) {
+      return false;
+    }
+  }
+  return true;
+#else
+  (void)timeout_argument;
+  return false;
+#endif  // !defined(_WIN32)
+}
+
+#if defined(__linux__)
+// Drain the eventfds of the local guard conditions which polled readable.
+/* Their triggers are taken once the wait returns, so a trigger drained here is
+ * still reported, while an eventfd left readable without a trigger does not
+ * end the next waits at once.
+ */
+static void
+__wait_set_drain_local_guard_conditions(rcl_wait_set_t * wait_set)
+{
+  rcl_wait_set_impl_t * impl = wait_set->impl;
+  nfds_t fd_index = 0;
+  size_t i;
+  for (i = 0; i < impl->guard_condition_index; ++i) {
+    const rcl_guard_condition_t * guard_condition = wait_set->guard_conditions[i];
+    if (guard_condition && rcl_guard_condition_is_local(guard_condition)) {
+      if (impl->local_guard_condition_pollfds[fd_index++].revents & POLLIN) {
+        rcl_guard_condition_drain_event_fd(guard_condition);
+      }
+    }
+  }
+  for (i = 0; i < impl->timer_index; ++i) {
+    const rcl_guard_condition_t * guard_condition = NULL;
+    if (wait_set->timers[i]) {
+      guard_condition = rcl_timer_get_guard_condition(wait_set->timers[i]);
+    }
+    if (guard_condition && (impl->local_guard_condition_pollfds[fd_index++].revents & POLLIN)) {
+      rcl_guard_condition_drain_event_fd(guard_condition);
+    }
+  }
+}
+#endif  // defined(__linux__)
+
+// Wait for a local guard condition to be triggered or for the timeout, without rmw_wait.
+static bool
+__wait_set_wait_locally(
+  rcl_wait_set_t * wait_set, const rmw_time_t * timeout_argument, rmw_ret_t * rmw_ret)
+{
+  *rmw_ret = RMW_RET_TIMEOUT;
+#if defined(__linux__)
+  rcl_wait_set_impl_t * impl = wait_set->impl;
+  nfds_t number_of_fds = 0;
+  size_t i;
+  // The eventfds of the guard conditions come first, in the order of
+  // __wait_set_drain_local_guard_conditions().
+  for (i = 0; i < impl->guard_condition_index; ++i) {
+    const rcl_guard_condition_t * guard_condition = wait_set->guard_conditions[i];
+    if (guard_condition && rcl_guard_condition_is_local(guard_condition)) {
+      struct pollfd * pollfd = &impl->local_guard_condition_pollfds[number_of_fds++];
+      pollfd->fd = rcl_guard_condition_get_event_fd(guard_condition);
+      pollfd->events = POLLIN;
+      pollfd->revents = 0;
+    }
+  }
+  // Timers on ROS clocks are woken up by time jumps through their guard condition.
+  for (i = 0; i < impl->timer_index; ++i) {
+    const rcl_guard_condition_t * guard_condition = NULL;
+    if (wait_set->timers[i]) {
+      guard_condition = rcl_timer_get_guard_condition(wait_set->timers[i]);
+    }
+    if (!guard_condition) {
+      continue;
+    }
+    struct pollfd * pollfd = &impl->local_guard_condition_pollfds[number_of_fds++];
+    pollfd->fd = rcl_guard_condition_get_event_fd(guard_condition);
+    pollfd->events = POLLIN;
+    pollfd->revents = 0;
+  }
+  // High precision timers wake up the wait at their absolute next call time,
+  // before the relative timeout derived from it, which is subject to timer slack.
+  for (i = 0; i < impl->timer_index; ++i) {
+    const rcl_timer_t * timer = wait_set->timers[i];
+    if (!timer || rcl_timer_get_timer_fd(timer) < 0) {
+      continue;
+    }
+    if (rcl_timer_arm_timer_fd(timer) != RCL_RET_OK) {
+      return false;
+    }
+    struct pollfd * pollfd = &impl->local_guard_condition_pollfds[number_of_fds++];
+    pollfd->fd = rcl_timer_get_timer_fd(timer);
+    pollfd->events = POLLIN;
+    pollfd->revents = 0;
+  }
+  if (number_of_fds > 0) {
+    struct timespec timeout_storage;
+    struct timespec * poll_timeout = NULL;
+    if (timeout_argument) {
+      timeout_storage.tv_sec = (time_t)timeout_argument->sec;
+      timeout_storage.tv_nsec = (long)timeout_argument->nsec;
+      poll_timeout = &timeout_storage;
+    }
+    int poll_ret = ppoll(impl->local_guard_condition_pollfds, number_of_fds, poll_timeout, NULL);
+    if (poll_ret < 0) {
+      // An interrupted wait is reported like a spurious wake up.
+      return EINTR == errno;
+    }
+    if (poll_ret > 0) {
+      __wait_set_drain_local_guard_conditions(wait_set);
+      *rmw_ret = RMW_RET_OK;
+    }
+    return true;
+  }
+#else
+  (void)wait_set;
+#endif  // defined(__linux__)
+  // Only timers are waited on, so a plain sleep is enough.
+  return __wait_set_sleep(timeout_argument);
+}
+
 rcl_ret_t
 rcl_wait(rcl_wait_set_t * wait_set, int64_t timeout)
 {
@@ -438,14 +1396,59 @@ rcl_wait(rcl_wait_set_t * wait_set, int64_t timeout)
     RCL_SET_ERROR_MSG("wait set is empty", wait_set->impl->allocator);
     return RCL_RET_WAIT_SET_EMPTY;
   }
+  bool persistent = wait_set->impl->persistent;
+  if (persistent) {
+    // Only the timers which were ready after the last wait have their flag set.
+    size_t i;
+    for (i = 0; i < wait_set->ready.number_of_ready_timers; ++i) {
+      wait_set->ready.timers[wait_set->ready.timer_indices[i]] = false;
+    }
+  }
+  wait_set->ready.number_of_ready_subscriptions = 0;
+  wait_set->ready.number_of_ready_guard_conditions = 0;
+  wait_set->ready.number_of_ready_timers = 0;
+  wait_set->ready.number_of_ready_clients = 0;
+  wait_set->ready.number_of_ready_services = 0;
+  if (persistent) {
+    SET_RESTORE_RMW(
+      subscription,
+      rmw_subscriptions.subscribers,
+      rmw_subscriptions.subscriber_count,
+      rmw_subscriptions_members);
+    SET_RESTORE_RMW(
+      guard_condition,
+      rmw_guard_conditions.guard_conditions,
+      rmw_guard_conditions.guard_condition_count,
+      rmw_guard_conditions_members);
+    SET_RESTORE_RMW(
+      client,
+      rmw_clients.clients,
+      rmw_clients.client_count,
+      rmw_clients_members);
+    SET_RESTORE_RMW(
+      service,
+      rmw_services.services,
+      rmw_services.service_count,
+      rmw_services_members);
+  }
   // Calculate the timeout argument.
   // By default, set the timer to block indefinitely if none of the below conditions are met.
   rmw_time_t * timeout_argument = NULL;
   rmw_time_t temporary_timeout_storage;
 
   // calculate the number of valid (non-NULL and non-canceled) timers
-  size_t number_of_valid_timers = wait_set->size_of_timers;
-  {  // scope to prevent i from colliding below
+  size_t number_of_valid_timers = wait_set->impl->timer_index;
+  // time at which the timers need a wake up, only used by persistent wait sets
+  int64_t next_timer_call_time = INT64_MAX;
+  if (persistent) {
+    // The timer queue finds the first timer without looking at every timer.
+    rcl_ret_t ret = __wait_set_get_timer_wake_up_time(wait_set, &next_timer_call_time);
+    if (ret != RCL_RET_OK) {
+      return ret;  // The rcl error state should already be set.
+    }
+    number_of_valid_timers =
+      wait_set->impl->timer_queue.size + wait_set->impl->number_of_unqueued_timers;
+  } else {  // scope to prevent i from colliding below
     uint64_t i = 0;
     for (i = 0; i < wait_set->impl->timer_index; ++i) {
       if (!wait_set->timers[i]) {
@@ -464,6 +1467,16 @@ rcl_wait(rcl_wait_set_t * wait_set, int64_t timeout)
     }
   }
 
+  // A single snapshot of the time is used for all timers before waiting,
+  // and another one after waking up.
+  rcl_time_point_value_t now = 0;
+  if (number_of_valid_timers > 0) {
+    rcl_ret_t ret = rcl_get_steady_time(NULL, &now);
+    if (ret != RCL_RET_OK) {
+      return ret;  // The rcl error state should already be set.
+    }
+  }
+
   bool is_timer_timeout = false;
   if (timeout == 0) {
     // Then it is non-blocking, so set the temporary storage to 0, 0 and pass it.
@@ -472,17 +1485,28 @@ rcl_wait(rcl_wait_set_t * wait_set, int64_t timeout)
     timeout_argument = &temporary_timeout_storage;
   } else if (timeout > 0 || number_of_valid_timers > 0) {
     int64_t min_timeout = timeout > 0 ? timeout : INT64_MAX;
+    if (INT64_MAX != next_timer_call_time) {
+      int64_t timer_timeout = next_timer_call_time - now;
+      if (timer_timeout < min_timeout) {
+        is_timer_timeout = true;
+        min_timeout = timer_timeout;
+      }
+    }
     // Compare the timeout to the time until next callback for each timer.
     // Take the lowest and use that for the wait timeout.
-    uint64_t i = 0;
-    for (i = 0; i < wait_set->impl->timer_index; ++i) {
-      if (!wait_set->timers[i]) {
+    // Persistent wait sets only need to look at the timers which are not in the queue.
+    size_t number_of_timers_to_check = persistent ?
+      wait_set->impl->number_of_unqueued_timers : wait_set->impl->timer_index;
+    size_t i = 0;
+    for (i = 0; i < number_of_timers_to_check; ++i) {
+      size_t index = persistent ? wait_set->impl->unqueued_timer_indices[i] : i;
+      if (!wait_set->timers[index]) {
         continue;  // Skip NULL timers.
       }
       // at this point we know any non-NULL timers are also not canceled
 
       int64_t timer_timeout = INT64_MAX;
-      rcl_ret_t ret = rcl_timer_get_time_until_next_call(wait_set->timers[i], &timer_timeout);
+      rcl_ret_t ret = __wait_set_get_timer_timeout(wait_set->timers[index], now, &timer_timeout);
       if (ret != RCL_RET_OK) {
         return ret;  // The rcl error state should already be set.
       }
@@ -496,9 +1520,12 @@ rcl_wait(rcl_wait_set_t * wait_set, int64_t timeout)
     if (min_timeout < 0) {
       min_timeout = 0;
     }
-    temporary_timeout_storage.sec = RCL_NS_TO_S(min_timeout);
-    temporary_timeout_storage.nsec = min_timeout % 1000000000;
-    timeout_argument = &temporary_timeout_storage;
+    // Timers on an overridden ROS clock alone do not need a timeout.
+    if (INT64_MAX != min_timeout) {
+      temporary_timeout_storage.sec = RCL_NS_TO_S(min_timeout);
+      temporary_timeout_storage.nsec = min_timeout % 1000000000;
+      timeout_argument = &temporary_timeout_storage;
+    }
   }
   RCUTILS_LOG_DEBUG_EXPRESSION_NAMED(
     !timeout_argument, ROS_PACKAGE_NAME, "Waiting without timeout")
@@ -510,32 +1537,126 @@ rcl_wait(rcl_wait_set_t * wait_set, int64_t timeout)
     ROS_PACKAGE_NAME, "Timeout calculated based on next scheduled timer: %s",
     is_timer_timeout ? "true" : "false")
 
+  // The guard conditions of the timers and of the intra-process subscriptions
+  // are only attached for the duration of the wait.
+  size_t number_of_guard_conditions = wait_set->impl->rmw_guard_conditions.guard_condition_count;
+  bool has_intra_process_messages = false;
+  if (wait_set->impl->rmw_subscriptions.subscriber_count > 0) {
+    rcl_ret_t ret =
+      __wait_set_attach_intra_process_guard_conditions(wait_set, &has_intra_process_messages);
+    if (ret != RCL_RET_OK) {
+      wait_set->impl->rmw_guard_conditions.guard_condition_count = number_of_guard_conditions;
+      return ret;  // The rcl error state should already be set.
+    }
+  }
+  if (has_intra_process_messages) {
+    temporary_timeout_storage.sec = 0;
+    temporary_timeout_storage.nsec = 0;
+    timeout_argument = &temporary_timeout_storage;
+  }
+  // Decided before attaching the guard conditions of the timers, which are local and
+  // only need to reach rmw when rmw_wait is used.
+  bool bypass_rmw = __wait_set_can_bypass_rmw(wait_set, timeout_argument);
+  if (number_of_valid_timers > 0 && !bypass_rmw) {
+    rcl_ret_t ret = __wait_set_attach_timer_guard_conditions(wait_set);
+    if (ret != RCL_RET_OK) {
+      wait_set->impl->rmw_guard_conditions.guard_condition_count = number_of_guard_conditions;
+      return ret;  // The rcl error state should already be set.
+    }
+  }
+  size_t number_of_attached_guard_conditions =
+    wait_set->impl->rmw_guard_conditions.guard_condition_count - number_of_guard_conditions;
+
+  bool has_local_guard_conditions = wait_set->impl->number_of_local_guard_conditions > 0;
+  if (has_local_guard_conditions && !bypass_rmw) {
+    rcl_ret_t ret = __wait_set_attach_local_guard_conditions(wait_set);
+    if (ret != RCL_RET_OK) {
+      return ret;  // The rcl error state should already be set.
+    }
+  }
+  // Checked after attaching, since triggers before that may not reach rmw.
+  if (
+    (has_local_guard_conditions || number_of_valid_timers > 0) &&
+    __wait_set_has_triggered_local_guard_condition(wait_set))
+  {
+    temporary_timeout_storage.sec = 0;
+    temporary_timeout_storage.nsec = 0;
+    timeout_argument = &temporary_timeout_storage;
+  }
+
   // Wait.
-  rmw_ret_t ret = rmw_wait(
-    &wait_set->impl->rmw_subscriptions,
-    &wait_set->impl->rmw_guard_conditions,
-    &wait_set->impl->rmw_services,
-    &wait_set->impl->rmw_clients,
-    wait_set->impl->rmw_wait_set,
-    timeout_argument);
+  rmw_ret_t ret = RMW_RET_TIMEOUT;
+  if (bypass_rmw) {
+    // Only timers and local guard conditions are waited on, which is much cheaper
+    // than going through rmw_wait.
+    if (!__wait_set_wait_locally(wait_set, timeout_argument, &ret)) {
+      RCL_SET_ERROR_MSG("failed to wait without the middleware", wait_set->impl->allocator);
+      return RCL_RET_ERROR;
+    }
+  } else {
+    ret = rmw_wait(
+      &wait_set->impl->rmw_subscriptions,
+      &wait_set->impl->rmw_guard_conditions,
+      &wait_set->impl->rmw_services,
+      &wait_set->impl->rmw_clients,
+      wait_set->impl->rmw_wait_set,
+      timeout_argument);
+  }
+  if (number_of_attached_guard_conditions > 0) {
+    // Detach the guard conditions of the timers and subscriptions, they only made rmw_wait return.
+    memset(
+      &wait_set->impl->rmw_guard_conditions.guard_conditions[number_of_guard_conditions], 0,
+      sizeof(void *) * number_of_attached_guard_conditions);
+    wait_set->impl->rmw_guard_conditions.guard_condition_count = number_of_guard_conditions;
+  }
+  if (persistent) {
+    SET_EXPAND_RMW(subscription, rmw_subscriptions.subscribers, rmw_subscriptions.subscriber_count);
+    SET_EXPAND_RMW(
+      guard_condition,
+      rmw_guard_conditions.guard_conditions,
+      rmw_guard_conditions.guard_condition_count);
+    SET_EXPAND_RMW(client, rmw_clients.clients, rmw_clients.client_count);
+    SET_EXPAND_RMW(service, rmw_services.services, rmw_services.service_count);
+  }
+
+  // The pending time jumps of the timers are consumed, so the next ones wake up waits again.
+  if (number_of_valid_timers > 0) {
+    __wait_set_take_timer_guard_condition_triggers(wait_set);
+  }
 
   // Items that are not ready will have been set to NULL by rmw_wait.
   // We now update our handles accordingly.
 
   // Check for ready timers
   // and set not ready timers (which includes canceled timers) to NULL.
+  if (number_of_valid_timers > 0) {
+    rcl_ret_t ret = rcl_get_steady_time(NULL, &now);
+    if (ret != RCL_RET_OK) {
+      return ret;  // The rcl error state should already be set.
+    }
+  }
+  if (persistent) {
+    rcl_ret_t ret = __wait_set_collect_ready_timers(wait_set, now);
+    if (ret != RCL_RET_OK) {
+      return ret;  // The rcl error state should already be set.
+    }
+  }
   size_t i;
-  for (i = 0; i < wait_set->impl->timer_index; ++i) {
-    if (!wait_set->timers[i]) {
+  for (i = 0; !persistent && i < wait_set->size_of_timers; ++i) {
+    wait_set->ready.timers[i] = false;
+    if (i >= wait_set->impl->timer_index || !wait_set->timers[i]) {
       continue;
     }
     bool is_ready = false;
-    rcl_ret_t ret = rcl_timer_is_ready(wait_set->timers[i], &is_ready);
+    rcl_ret_t ret = __wait_set_is_timer_ready(wait_set->timers[i], now, &is_ready);
     if (ret != RCL_RET_OK) {
       return ret;  // The rcl error state should already be set.
     }
     RCUTILS_LOG_DEBUG_EXPRESSION_NAMED(is_ready, ROS_PACKAGE_NAME, "Timer in wait set is ready")
-    if (!is_ready) {
+    wait_set->ready.timers[i] = is_ready;
+    if (is_ready) {
+      wait_set->ready.timer_indices[wait_set->ready.number_of_ready_timers++] = i;
+    } else {
       wait_set->timers[i] = NULL;
     }
   }
@@ -547,18 +1668,45 @@ rcl_wait(rcl_wait_set_t * wait_set, int64_t timeout)
   // Set corresponding rcl subscription handles NULL.
   for (i = 0; i < wait_set->size_of_subscriptions; ++i) {
     bool is_ready = wait_set->impl->rmw_subscriptions.subscribers[i] != NULL;
+    rcl_intra_process_subscription_t * intra_process = NULL;
+    if (i < wait_set->impl->subscription_index && wait_set->subscriptions[i]) {
+      intra_process = rcl_subscription_get_intra_process(wait_set->subscriptions[i]);
+    }
+    if (intra_process) {
+      // The trigger is consumed before looking at the queue, so no message is missed.
+      rcl_guard_condition_take_trigger(
+        rcl_intra_process_subscription_get_guard_condition(intra_process));
+      is_ready = is_ready || rcl_intra_process_subscription_has_messages(intra_process);
+    }
     RCUTILS_LOG_DEBUG_EXPRESSION_NAMED(
       is_ready, ROS_PACKAGE_NAME, "Subscription in wait set is ready")
-    if (!is_ready) {
+    wait_set->ready.subscriptions[i] = is_ready;
+    if (is_ready) {
+      wait_set->ready.subscription_indices[wait_set->ready.number_of_ready_subscriptions++] = i;
+    } else if (!persistent) {
       wait_set->subscriptions[i] = NULL;
     }
   }
   // Set corresponding rcl guard_condition handles NULL.
   for (i = 0; i < wait_set->size_of_guard_conditions; ++i) {
-    bool is_ready = wait_set->impl->rmw_guard_conditions.guard_conditions[i] != NULL;
+    const rcl_guard_condition_t * guard_condition = wait_set->guard_conditions[i];
+    bool is_ready = false;
+    if (
+      has_local_guard_conditions && guard_condition &&
+      rcl_guard_condition_is_local(guard_condition))
+    {
+      // The trigger is consumed here, whether rmw_wait was used or not.
+      is_ready = rcl_guard_condition_take_trigger(guard_condition);
+    } else {
+      is_ready = wait_set->impl->rmw_guard_conditions.guard_conditions[i] != NULL;
+    }
     RCUTILS_LOG_DEBUG_EXPRESSION_NAMED(
       is_ready, ROS_PACKAGE_NAME, "Guard condition in wait set is ready")
-    if (!is_ready) {
+    wait_set->ready.guard_conditions[i] = is_ready;
+    if (is_ready) {
+      size_t ready_index = wait_set->ready.number_of_ready_guard_conditions++;
+      wait_set->ready.guard_condition_indices[ready_index] = i;
+    } else if (!persistent) {
       wait_set->guard_conditions[i] = NULL;
     }
   }
@@ -566,7 +1714,10 @@ rcl_wait(rcl_wait_set_t * wait_set, int64_t timeout)
   for (i = 0; i < wait_set->size_of_clients; ++i) {
     bool is_ready = wait_set->impl->rmw_clients.clients[i] != NULL;
     RCUTILS_LOG_DEBUG_EXPRESSION_NAMED(is_ready, ROS_PACKAGE_NAME, "Client in wait set is ready")
-    if (!is_ready) {
+    wait_set->ready.clients[i] = is_ready;
+    if (is_ready) {
+      wait_set->ready.client_indices[wait_set->ready.number_of_ready_clients++] = i;
+    } else if (!persistent) {
       wait_set->clients[i] = NULL;
     }
   }
@@ -574,12 +1725,27 @@ rcl_wait(rcl_wait_set_t * wait_set, int64_t timeout)
   for (i = 0; i < wait_set->size_of_services; ++i) {
     bool is_ready = wait_set->impl->rmw_services.services[i] != NULL;
     RCUTILS_LOG_DEBUG_EXPRESSION_NAMED(is_ready, ROS_PACKAGE_NAME, "Service in wait set is ready")
-    if (!is_ready) {
+    wait_set->ready.services[i] = is_ready;
+    if (is_ready) {
+      wait_set->ready.service_indices[wait_set->ready.number_of_ready_services++] = i;
+    } else if (!persistent) {
       wait_set->services[i] = NULL;
     }
   }
 
-  if (RMW_RET_TIMEOUT == ret && !is_timer_timeout) {
+  if (wait_set->ready.number_of_ready_timers > 0) {
+    // Without slack or phase alignment, each ready timer could have needed a wake up of its own.
+    wait_set->impl->number_of_timer_wake_ups++;
+    wait_set->impl->number_of_timer_wake_ups_saved += wait_set->ready.number_of_ready_timers - 1;
+  }
+
+  // A local guard condition, or an intra-process subscription with queued
+  // messages, may be ready even if rmw_wait timed out.
+  if (
+    RMW_RET_TIMEOUT == ret && !is_timer_timeout &&
+    0 == wait_set->ready.number_of_ready_guard_conditions &&
+    0 == wait_set->ready.number_of_ready_subscriptions)
+  {
     return RCL_RET_TIMEOUT;
   }
   return RCL_RET_OK;
@@ -0,0 +1,777 @@
+// Copyright 2018 Open Source Robotics Foundation, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+#include "rcl/work_stealing_executor.h"
+
+#include <stdint.h>
+#include <string.h>
+
+#include "./stdatomic_helper.h"
+#include "rcl/error_handling.h"
+#include "rcl/rcl.h"
+#include "rcl/wait.h"
+#include "rcutils/logging_macros.h"
+
+typedef enum rcl_ws_entity_type_t
+{
+  RCL_WS_SUBSCRIPTION = 0,
+  RCL_WS_GUARD_CONDITION,
+  RCL_WS_TIMER,
+  RCL_WS_CLIENT,
+  RCL_WS_SERVICE,
+  RCL_WS_NUMBER_OF_TYPES
+} rcl_ws_entity_type_t;
+
+typedef struct rcl_ws_entity_t
+{
+  rcl_ws_entity_type_t type;
+  // the rcl subscription, guard condition, timer, client or service
+  const void * handle;
+  // message storage: the message, request or response taken
+  void * message;
+  // response storage of a service
+  void * response;
+  union
+  {
+    rcl_executor_subscription_callback_t subscription;
+    rcl_executor_guard_condition_callback_t guard_condition;
+    rcl_executor_client_callback_t client;
+    rcl_executor_service_callback_t service;
+  } callback;
+  void * context;
+  // index of the shard, and so of the worker, which waits on the entity
+  size_t shard;
+  // index of the entity in the wait set of its shard
+  size_t slot;
+  // next entity in the finished stack of its shard
+  atomic_uintptr_t next_finished;
+} rcl_ws_entity_t;
+
+/// Bounded Chase-Lev deque of entities.
+/* The owner pushes and pops at the bottom, other workers steal from the top.
+ * Since an entity is in at most one deque at a time, a capacity equal to the
+ * number of entities of the shard is enough.
+ */
+typedef struct rcl_ws_deque_t
+{
+  atomic_int_least64_t top;
+  atomic_int_least64_t bottom;
+  atomic_uintptr_t * buffer;
+  size_t capacity;
+} rcl_ws_deque_t;
+
+typedef struct rcl_ws_shard_t
+{
+  // persistent wait set with the entities of the shard, disabled while they are being handled
+  rcl_wait_set_t wait_set;
+  // local guard condition used to wake up the worker while it waits
+  rcl_guard_condition_t wake_up;
+  // entities by wait set slot, NULL for the wake up guard condition
+  rcl_ws_entity_t ** slots[RCL_WS_NUMBER_OF_TYPES];
+  size_t number_of_slots_used[RCL_WS_NUMBER_OF_TYPES];
+  // scratch space for the entities found ready by a wait
+  rcl_ws_entity_t ** ready_entities;
+  rcl_ws_deque_t deque;
+  // stack of entities handled by other workers, to be enabled again in the wait set
+  atomic_uintptr_t finished;
+  // true while the worker is about to wait or waiting
+  atomic_bool waiting;
+} rcl_ws_shard_t;
+
+typedef struct rcl_work_stealing_executor_impl_t
+{
+  rcl_ws_shard_t * shards;
+  size_t number_of_workers;
+  rcl_ws_entity_t * entities;
+  size_t number_of_entities;
+  size_t capacity_of_entities;
+  // number of entities added and maximum number of entities, per type
+  size_t number_added[RCL_WS_NUMBER_OF_TYPES];
+  size_t maximum_number[RCL_WS_NUMBER_OF_TYPES];
+  rcl_allocator_t allocator;
+} rcl_work_stealing_executor_impl_t;
+
+rcl_work_stealing_executor_t
+rcl_get_zero_initialized_work_stealing_executor()
+{
+  static rcl_work_stealing_executor_t null_executor = {0};
+  return null_executor;
+}
+
+static void
+__deque_push(rcl_ws_deque_t * deque, rcl_ws_entity_t * entity)
+{
+  int64_t bottom = rcl_atomic_load_int64_t(&deque->bottom);
+  rcl_atomic_store(&deque->buffer[(size_t)bottom % deque->capacity], (uintptr_t)entity);
+  rcl_atomic_store(&deque->bottom, bottom + 1);
+}
+
+static rcl_ws_entity_t *
+__deque_pop(rcl_ws_deque_t * deque)
+{
+  int64_t bottom = rcl_atomic_load_int64_t(&deque->bottom) - 1;
+  rcl_atomic_store(&deque->bottom, bottom);
+  int64_t top = rcl_atomic_load_int64_t(&deque->top);
+  if (top > bottom) {
+    // Empty, undo the reservation.
+    rcl_atomic_store(&deque->bottom, bottom + 1);
+    return NULL;
+  }
+  rcl_ws_entity_t * entity = (rcl_ws_entity_t *)rcl_atomic_load_uintptr_t(
+    &deque->buffer[(size_t)bottom % deque->capacity]);
+  if (top == bottom) {
+    // Last entity, thieves may be competing for it.
+    if (!rcl_atomic_compare_exchange_strong_int_least64_t(&deque->top, &top, top + 1)) {
+      entity = NULL;
+    }
+    rcl_atomic_store(&deque->bottom, bottom + 1);
+  }
+  return entity;
+}
+
+static rcl_ws_entity_t *
+__deque_steal(rcl_ws_deque_t * deque)
+{
+  int64_t top = rcl_atomic_load_int64_t(&deque->top);
+  while (top < rcl_atomic_load_int64_t(&deque->bottom)) {
+    rcl_ws_entity_t * entity = (rcl_ws_entity_t *)rcl_atomic_load_uintptr_t(
+      &deque->buffer[(size_t)top % deque->capacity]);
+    // On failure top is updated, and what was read must be discarded.
+    if (rcl_atomic_compare_exchange_strong_int_least64_t(&deque->top, &top, top + 1)) {
+      return entity;
+    }
+  }
+  return NULL;
+}
+
+static rcl_ret_t
+__shard_add(rcl_ws_shard_t * shard, rcl_ws_entity_t * entity)
+{
+  rcl_ret_t ret = RCL_RET_ERROR;
+  switch (entity->type) {
+    case RCL_WS_SUBSCRIPTION:
+      ret = rcl_wait_set_add_subscription(&shard->wait_set, entity->handle);
+      break;
+    case RCL_WS_GUARD_CONDITION:
+      ret = rcl_wait_set_add_guard_condition(&shard->wait_set, entity->handle);
+      break;
+    case RCL_WS_TIMER:
+      ret = rcl_wait_set_add_timer(&shard->wait_set, entity->handle);
+      break;
+    case RCL_WS_CLIENT:
+      ret = rcl_wait_set_add_client(&shard->wait_set, entity->handle);
+      break;
+    case RCL_WS_SERVICE:
+      ret = rcl_wait_set_add_service(&shard->wait_set, entity->handle);
+      break;
+    default:
+      break;
+  }
+  if (ret != RCL_RET_OK) {
+    return ret;  // The rcl error state should already be set.
+  }
+  // The wait set appends to the end, mirror it.
+  entity->slot = shard->number_of_slots_used[entity->type]++;
+  shard->slots[entity->type][entity->slot] = entity;
+  return RCL_RET_OK;
+}
+
+// Leave the entity out of the waits of its shard, keeping its slot.
+static rcl_ret_t
+__shard_disable(rcl_ws_shard_t * shard, rcl_ws_entity_t * entity)
+{
+  switch (entity->type) {
+    case RCL_WS_SUBSCRIPTION:
+      return rcl_wait_set_disable_subscription(&shard->wait_set, entity->slot);
+    case RCL_WS_GUARD_CONDITION:
+      return rcl_wait_set_disable_guard_condition(&shard->wait_set, entity->slot);
+    case RCL_WS_TIMER:
+      return rcl_wait_set_disable_timer(&shard->wait_set, entity->slot);
+    case RCL_WS_CLIENT:
+      return rcl_wait_set_disable_client(&shard->wait_set, entity->slot);
+    case RCL_WS_SERVICE:
+      return rcl_wait_set_disable_service(&shard->wait_set, entity->slot);
+    default:
+      return RCL_RET_ERROR;
+  }
+}
+
+// Wait on a disabled entity again, in the slot it kept.
+static rcl_ret_t
+__shard_enable(rcl_ws_shard_t * shard, rcl_ws_entity_t * entity)
+{
+  switch (entity->type) {
+    case RCL_WS_SUBSCRIPTION:
+      return rcl_wait_set_enable_subscription(&shard->wait_set, entity->handle, entity->slot);
+    case RCL_WS_GUARD_CONDITION:
+      return rcl_wait_set_enable_guard_condition(&shard->wait_set, entity->handle, entity->slot);
+    case RCL_WS_TIMER:
+      return rcl_wait_set_enable_timer(&shard->wait_set, entity->handle, entity->slot);
+    case RCL_WS_CLIENT:
+      return rcl_wait_set_enable_client(&shard->wait_set, entity->handle, entity->slot);
+    case RCL_WS_SERVICE:
+      return rcl_wait_set_enable_service(&shard->wait_set, entity->handle, entity->slot);
+    default:
+      return RCL_RET_ERROR;
+  }
+}
+
+// Put the entities handled by other workers back into the wait set.
+static rcl_ret_t
+__shard_take_back_finished(rcl_ws_shard_t * shard)
+{
+  rcl_ws_entity_t * entity =
+    (rcl_ws_entity_t *)rcl_atomic_exchange_uintptr_t(&shard->finished, (uintptr_t)0);
+  while (entity) {
+    rcl_ws_entity_t * next =
+      (rcl_ws_entity_t *)rcl_atomic_load_uintptr_t(&entity->next_finished);
+    rcl_ret_t ret = __shard_enable(shard, entity);
+    if (ret != RCL_RET_OK) {
+      return ret;  // The rcl error state should already be set.
+    }
+    entity = next;
+  }
+  return RCL_RET_OK;
+}
+
+// Move the ready entities from the wait set into the deque, return how many.
+static rcl_ret_t
+__shard_queue_ready(rcl_ws_shard_t * shard, size_t * number_queued)
+{
+  const rcl_wait_set_ready_t * ready = &shard->wait_set.ready;
+  const size_t * ready_indices[RCL_WS_NUMBER_OF_TYPES] = {
+    ready->subscription_indices, ready->guard_condition_indices, ready->timer_indices,
+    ready->client_indices, ready->service_indices,
+  };
+  const size_t number_of_ready[RCL_WS_NUMBER_OF_TYPES] = {
+    ready->number_of_ready_subscriptions, ready->number_of_ready_guard_conditions,
+    ready->number_of_ready_timers, ready->number_of_ready_clients,
+    ready->number_of_ready_services,
+  };
+  // Disabling an entity keeps the slots and the ready lists of the wait set intact.
+  size_t count = 0;
+  size_t type;
+  for (type = 0; type < RCL_WS_NUMBER_OF_TYPES; ++type) {
+    size_t i;
+    for (i = 0; i < number_of_ready[type]; ++i) {
+      rcl_ws_entity_t * entity = shard->slots[type][ready_indices[type][i]];
+      if (!entity) {
+        continue;
+      }
+      // An entity is disabled before it can be stolen, so that the worker
+      // handling it can rely on enabling it again.
+      rcl_ret_t ret = __shard_disable(shard, entity);
+      if (ret != RCL_RET_OK) {
+        return ret;  // The rcl error state should already be set.
+      }
+      shard->ready_entities[count++] = entity;
+    }
+  }
+  // Push in reverse, so that the owner pops them in the order of the wait set.
+  size_t i;
+  for (i = count; i > 0; --i) {
+    __deque_push(&shard->deque, shard->ready_entities[i - 1]);
+  }
+  *number_queued = count;
+  return RCL_RET_OK;
+}
+
+// Wake up to the given number of waiting workers, so that they steal work.
+static rcl_ret_t
+__wake_up_idle_workers(
+  rcl_work_stealing_executor_impl_t * impl, size_t worker_index, size_t number_to_wake_up)
+{
+  size_t k;
+  for (k = 1; k < impl->number_of_workers && number_to_wake_up > 0; ++k) {
+    rcl_ws_shard_t * other = &impl->shards[(worker_index + k) % impl->number_of_workers];
+    if (rcl_atomic_load_bool(&other->waiting)) {
+      rcl_ret_t ret = rcl_trigger_guard_condition(&other->wake_up);
+      if (ret != RCL_RET_OK) {
+        return ret;  // The rcl error state should already be set.
+      }
+      --number_to_wake_up;
+    }
+  }
+  return RCL_RET_OK;
+}
+
+static rcl_ws_entity_t *
+__next_work(rcl_work_stealing_executor_impl_t * impl, size_t worker_index)
+{
+  rcl_ws_entity_t * entity = __deque_pop(&impl->shards[worker_index].deque);
+  size_t k;
+  for (k = 1; !entity && k < impl->number_of_workers; ++k) {
+    entity = __deque_steal(&impl->shards[(worker_index + k) % impl->number_of_workers].deque);
+  }
+  return entity;
+}
+
+static rcl_ret_t
+__dispatch(rcl_ws_entity_t * entity)
+{
+  rcl_ret_t ret = RCL_RET_OK;
+  rmw_request_id_t request_header;
+  switch (entity->type) {
+    case RCL_WS_SUBSCRIPTION:
+      ret = rcl_take(entity->handle, entity->message, NULL);
+      if (ret == RCL_RET_SUBSCRIPTION_TAKE_FAILED) {
+        return RCL_RET_OK;
+      }
+      if (ret == RCL_RET_OK) {
+        entity->callback.subscription(entity->message, entity->context);
+      }
+      return ret;
+    case RCL_WS_GUARD_CONDITION:
+      if (entity->callback.guard_condition) {
+        entity->callback.guard_condition(entity->context);
+      }
+      return RCL_RET_OK;
+    case RCL_WS_TIMER:
+      {
+        bool called;
+        ret = rcl_timer_call_if_ready((rcl_timer_t *)entity->handle, &called);
+      }
+      return ret == RCL_RET_TIMER_CANCELED ? RCL_RET_OK : ret;
+    case RCL_WS_CLIENT:
+      ret = rcl_take_response(entity->handle, &request_header, entity->message);
+      if (ret == RCL_RET_CLIENT_TAKE_FAILED) {
+        return RCL_RET_OK;
+      }
+      if (ret == RCL_RET_OK) {
+        entity->callback.client(&request_header, entity->message, entity->context);
+      }
+      return ret;
+    case RCL_WS_SERVICE:
+      ret = rcl_take_request(entity->handle, &request_header, entity->message);
+      if (ret == RCL_RET_SERVICE_TAKE_FAILED) {
+        return RCL_RET_OK;
+      }
+      if (ret != RCL_RET_OK) {
+        return ret;
+      }
+      entity->callback.service(
+        &request_header, entity->message, entity->response, entity->context);
+      return rcl_send_response(entity->handle, &request_header, entity->response);
+    default:
+      return RCL_RET_ERROR;
+  }
+}
+
+static rcl_ret_t
+__execute(
+  rcl_work_stealing_executor_impl_t * impl, size_t worker_index, rcl_ws_entity_t * entity)
+{
+  rcl_ret_t ret = __dispatch(entity);
+  // Whatever happened, the entity goes back to be waited on by its worker.
+  rcl_ret_t finish_ret = RCL_RET_OK;
+  rcl_ws_shard_t * owner = &impl->shards[entity->shard];
+  if (entity->shard == worker_index) {
+    finish_ret = __shard_enable(owner, entity);
+  } else {
+    uintptr_t head = rcl_atomic_load_uintptr_t(&owner->finished);
+    do {
+      rcl_atomic_store(&entity->next_finished, head);
+    } while (!rcl_atomic_compare_exchange_strong_uintptr_t(
+      &owner->finished, &head, (uintptr_t)entity));
+    // The owner may be waiting without this entity, so it has to be told.
+    finish_ret = rcl_trigger_guard_condition(&owner->wake_up);
+  }
+  return ret != RCL_RET_OK ? ret : finish_ret;
+}
+
+static void *
+__allocate_zeroed(size_t size, rcl_allocator_t allocator)
+{
+  if (0 == size) {
+    return NULL;
+  }
+  void * memory = allocator.allocate(size, allocator.state);
+  if (memory) {
+    memset(memory, 0, size);
+  }
+  return memory;
+}
+
+static rcl_ret_t
+__clean_up(rcl_work_stealing_executor_t * executor)
+{
+  rcl_work_stealing_executor_impl_t * impl = executor->impl;
+  rcl_allocator_t allocator = impl->allocator;
+  rcl_ret_t result = RCL_RET_OK;
+  size_t i;
+  for (i = 0; impl->shards && i < impl->number_of_workers; ++i) {
+    rcl_ws_shard_t * shard = &impl->shards[i];
+    if (rcl_wait_set_fini(&shard->wait_set) != RCL_RET_OK) {
+      result = RCL_RET_ERROR;
+    }
+    if (rcl_guard_condition_fini(&shard->wake_up) != RCL_RET_OK) {
+      result = RCL_RET_ERROR;
+    }
+    size_t type;
+    for (type = 0; type < RCL_WS_NUMBER_OF_TYPES; ++type) {
+      allocator.deallocate(shard->slots[type], allocator.state);
+    }
+    allocator.deallocate(shard->ready_entities, allocator.state);
+    allocator.deallocate(shard->deque.buffer, allocator.state);
+  }
+  allocator.deallocate(impl->shards, allocator.state);
+  allocator.deallocate(impl->entities, allocator.state);
+  allocator.deallocate(impl, allocator.state);
+  executor->impl = NULL;
+  return result;
+}
+
+static rcl_ret_t
+__shard_init(rcl_ws_shard_t * shard, const size_t * capacity, rcl_allocator_t allocator)
+{
+  atomic_init(&shard->deque.top, 0);
+  atomic_init(&shard->deque.bottom, 0);
+  atomic_init(&shard->finished, (uintptr_t)0);
+  atomic_init(&shard->waiting, false);
+  size_t number_of_entities = 0;
+  size_t type;
+  for (type = 0; type < RCL_WS_NUMBER_OF_TYPES; ++type) {
+    number_of_entities += capacity[type];
+    // One more guard condition slot for the wake up guard condition.
+    size_t number_of_slots = capacity[type] + (RCL_WS_GUARD_CONDITION == type ? 1 : 0);
+    shard->slots[type] = (rcl_ws_entity_t **)__allocate_zeroed(
+      sizeof(rcl_ws_entity_t *) * number_of_slots, allocator);
+    if (number_of_slots > 0 && !shard->slots[type]) {
+      RCL_SET_ERROR_MSG("allocating memory failed", allocator);
+      return RCL_RET_BAD_ALLOC;
+    }
+  }
+  shard->deque.capacity = number_of_entities;
+  shard->deque.buffer = (atomic_uintptr_t *)__allocate_zeroed(
+    sizeof(atomic_uintptr_t) * number_of_entities, allocator);
+  shard->ready_entities = (rcl_ws_entity_t **)__allocate_zeroed(
+    sizeof(rcl_ws_entity_t *) * number_of_entities, allocator);
+  if (number_of_entities > 0 && (!shard->deque.buffer || !shard->ready_entities)) {
+    RCL_SET_ERROR_MSG("allocating memory failed", allocator);
+    return RCL_RET_BAD_ALLOC;
+  }
+  rcl_guard_condition_options_t wake_up_options = rcl_guard_condition_get_default_options();
+  wake_up_options.allocator = allocator;
+  wake_up_options.local_only = true;
+  rcl_ret_t ret = rcl_guard_condition_init(&shard->wake_up, wake_up_options);
+  if (ret != RCL_RET_OK) {
+    return ret;  // The rcl error state should already be set.
+  }
+  ret = rcl_wait_set_init(
+    &shard->wait_set, capacity[RCL_WS_SUBSCRIPTION], capacity[RCL_WS_GUARD_CONDITION] + 1,
+    capacity[RCL_WS_TIMER], capacity[RCL_WS_CLIENT], capacity[RCL_WS_SERVICE], allocator);
+  if (ret != RCL_RET_OK) {
+    return ret;  // The rcl error state should already be set.
+  }
+  ret = rcl_wait_set_set_persistent(&shard->wait_set, true);
+  if (ret != RCL_RET_OK) {
+    return ret;  // The rcl error state should already be set.
+  }
+  ret = rcl_wait_set_add_guard_condition(&shard->wait_set, &shard->wake_up);
+  if (ret != RCL_RET_OK) {
+    return ret;  // The rcl error state should already be set.
+  }
+  // Its slot is left NULL, it has no entity.
+  shard->number_of_slots_used[RCL_WS_GUARD_CONDITION] = 1;
+  return RCL_RET_OK;
+}
+
+rcl_ret_t
+rcl_work_stealing_executor_init(
+  rcl_work_stealing_executor_t * executor,
+  size_t number_of_workers,
+  size_t number_of_subscriptions,
+  size_t number_of_guard_conditions,
+  size_t number_of_timers,
+  size_t number_of_clients,
+  size_t number_of_services,
+  rcl_allocator_t allocator)
+{
+  RCL_CHECK_ALLOCATOR_WITH_MSG(&allocator, "invalid allocator", return RCL_RET_INVALID_ARGUMENT);
+  RCL_CHECK_ARGUMENT_FOR_NULL(executor, RCL_RET_INVALID_ARGUMENT, allocator);
+  if (executor->impl) {
+    RCL_SET_ERROR_MSG("executor already initialized, or memory was uninitialized", allocator);
+    return RCL_RET_ALREADY_INIT;
+  }
+  if (0 == number_of_workers) {
+    RCL_SET_ERROR_MSG("number of workers must be positive", allocator);
+    return RCL_RET_INVALID_ARGUMENT;
+  }
+  if (!rcl_ok()) {
+    RCL_SET_ERROR_MSG("rcl_init() has not been called", allocator);
+    return RCL_RET_NOT_INIT;
+  }
+  RCUTILS_LOG_DEBUG_NAMED(
+    ROS_PACKAGE_NAME, "Initializing work stealing executor with '%zu' workers", number_of_workers)
+  rcl_work_stealing_executor_impl_t * impl =
+    (rcl_work_stealing_executor_impl_t *)__allocate_zeroed(
+    sizeof(rcl_work_stealing_executor_impl_t), allocator);
+  RCL_CHECK_FOR_NULL_WITH_MSG(
+    impl, "allocating memory failed", return RCL_RET_BAD_ALLOC, allocator);
+  impl->allocator = allocator;
+  executor->impl = impl;
+  impl->maximum_number[RCL_WS_SUBSCRIPTION] = number_of_subscriptions;
+  impl->maximum_number[RCL_WS_GUARD_CONDITION] = number_of_guard_conditions;
+  impl->maximum_number[RCL_WS_TIMER] = number_of_timers;
+  impl->maximum_number[RCL_WS_CLIENT] = number_of_clients;
+  impl->maximum_number[RCL_WS_SERVICE] = number_of_services;
+  // Entities are dealt round-robin, so each shard gets at most its share rounded up.
+  size_t shard_capacity[RCL_WS_NUMBER_OF_TYPES];
+  size_t type;
+  for (type = 0; type < RCL_WS_NUMBER_OF_TYPES; ++type) {
+    impl->capacity_of_entities += impl->maximum_number[type];
+    shard_capacity[type] = (impl->maximum_number[type] + number_of_workers - 1) / number_of_workers;
+  }
+  impl->entities = (rcl_ws_entity_t *)__allocate_zeroed(
+    sizeof(rcl_ws_entity_t) * impl->capacity_of_entities, allocator);
+  impl->shards = (rcl_ws_shard_t *)__allocate_zeroed(
+    sizeof(rcl_ws_shard_t) * number_of_workers, allocator);
+  if ((impl->capacity_of_entities > 0 && !impl->entities) || !impl->shards) {
+    rcl_ret_t ret = __clean_up(executor);
+    (void)ret;
+    RCL_SET_ERROR_MSG("allocating memory failed", allocator);
+    return RCL_RET_BAD_ALLOC;
+  }
+  impl->number_of_workers = number_of_workers;
+  size_t i;
+  for (i = 0; i < number_of_workers; ++i) {
+    rcl_ret_t ret = __shard_init(&impl->shards[i], shard_capacity, allocator);
+    if (ret != RCL_RET_OK) {
+      rcl_ret_t clean_up_ret = __clean_up(executor);
+      (void)clean_up_ret;
+      return ret;  // The rcl error state should already be set.
+    }
+  }
+  return RCL_RET_OK;
+}
+
+rcl_ret_t
+rcl_work_stealing_executor_fini(rcl_work_stealing_executor_t * executor)
+{
+  RCL_CHECK_ARGUMENT_FOR_NULL(executor, RCL_RET_INVALID_ARGUMENT, rcl_get_default_allocator());
+  if (!executor->impl) {
+    return RCL_RET_OK;
+  }
+  return __clean_up(executor);
+}
+
+#define WORK_STEALING_EXECUTOR_CHECK(executor) \
+  RCL_CHECK_ARGUMENT_FOR_NULL(executor, RCL_RET_INVALID_ARGUMENT, rcl_get_default_allocator()); \
+  if (!executor->impl) { \
+    RCL_SET_ERROR_MSG("executor is invalid", rcl_get_default_allocator()); \
+    return RCL_RET_EXECUTOR_INVALID; \
+  }
+
+// Add an entity to the shard whose turn it is for its type.
+static rcl_ret_t
+__add_entity(rcl_work_stealing_executor_impl_t * impl, const rcl_ws_entity_t * new_entity)
+{
+  RCL_CHECK_ARGUMENT_FOR_NULL(new_entity->handle, RCL_RET_INVALID_ARGUMENT, impl->allocator);
+  rcl_ws_entity_type_t type = new_entity->type;
+  if (impl->number_added[type] >= impl->maximum_number[type]) {
+    RCL_SET_ERROR_MSG("executor is full", impl->allocator);
+    return RCL_RET_WAIT_SET_FULL;
+  }
+  rcl_ws_entity_t * entity = &impl->entities[impl->number_of_entities];
+  *entity = *new_entity;
+  entity->shard = impl->number_added[type] % impl->number_of_workers;
+  atomic_init(&entity->next_finished, (uintptr_t)0);
+  rcl_ret_t ret = __shard_add(&impl->shards[entity->shard], entity);
+  if (ret != RCL_RET_OK) {
+    return ret;  // The rcl error state should already be set.
+  }
+  impl->number_added[type]++;
+  impl->number_of_entities++;
+  return RCL_RET_OK;
+}
+
+rcl_ret_t
+rcl_work_stealing_executor_add_subscription(
+  rcl_work_stealing_executor_t * executor,
+  const rcl_subscription_t * subscription,
+  void * message,
+  rcl_executor_subscription_callback_t callback,
+  void * context)
+{
+  WORK_STEALING_EXECUTOR_CHECK(executor)
+  RCL_CHECK_ARGUMENT_FOR_NULL(message, RCL_RET_INVALID_ARGUMENT, executor->impl->allocator);
+  RCL_CHECK_ARGUMENT_FOR_NULL(callback, RCL_RET_INVALID_ARGUMENT, executor->impl->allocator);
+  rcl_ws_entity_t entity;
+  memset(&entity, 0, sizeof(entity));
+  entity.type = RCL_WS_SUBSCRIPTION;
+  entity.handle = subscription;
+  entity.message = message;
+  entity.callback.subscription = callback;
+  entity.context = context;
+  return __add_entity(executor->impl, &entity);
+}
+
+rcl_ret_t
+rcl_work_stealing_executor_add_timer(
+  rcl_work_stealing_executor_t * executor,
+  const rcl_timer_t * timer)
+{
+  WORK_STEALING_EXECUTOR_CHECK(executor)
+  rcl_ws_entity_t entity;
+  memset(&entity, 0, sizeof(entity));
+  entity.type = RCL_WS_TIMER;
+  entity.handle = timer;
+  return __add_entity(executor->impl, &entity);
+}
+
+rcl_ret_t
+rcl_work_stealing_executor_add_guard_condition(
+  rcl_work_stealing_executor_t * executor,
+  const rcl_guard_condition_t * guard_condition,
+  rcl_executor_guard_condition_callback_t callback,
+  void * context)
+{
+  WORK_STEALING_EXECUTOR_CHECK(executor)
+  rcl_ws_entity_t entity;
+  memset(&entity, 0, sizeof(entity));
+  entity.type = RCL_WS_GUARD_CONDITION;
+  entity.handle = guard_condition;
+  entity.callback.guard_condition = callback;
+  entity.context = context;
+  return __add_entity(executor->impl, &entity);
+}
+
+rcl_ret_t
+rcl_work_stealing_executor_add_client(
+  rcl_work_stealing_executor_t * executor,
+  const rcl_client_t * client,
+  void * response,
+  rcl_executor_client_callback_t callback,
+  void * context)
+{
+  WORK_STEALING_EXECUTOR_CHECK(executor)
+  RCL_CHECK_ARGUMENT_FOR_NULL(response, RCL_RET_INVALID_ARGUMENT, executor->impl->allocator);
+  RCL_CHECK_ARGUMENT_FOR_NULL(callback, RCL_RET_INVALID_ARGUMENT, executor->impl->allocator);
+  rcl_ws_entity_t entity;
+  memset(&entity, 0, sizeof(entity));
+  entity.type = RCL_WS_CLIENT;
+  entity.handle = client;
+  entity.message = response;
+  entity.callback.client = callback;
+  entity.context = context;
+  return __add_entity(executor->impl, &entity);
+}
+
+rcl_ret_t
+rcl_work_stealing_executor_add_service(
+  rcl_work_stealing_executor_t * executor,
+  const rcl_service_t * service,
+  void * request,
+  void * response,
+  rcl_executor_service_callback_t callback,
+  void * context)
+{
+  WORK_STEALING_EXECUTOR_CHECK(executor)
+  RCL_CHECK_ARGUMENT_FOR_NULL(request, RCL_RET_INVALID_ARGUMENT, executor->impl->allocator);
+  RCL_CHECK_ARGUMENT_FOR_NULL(response, RCL_RET_INVALID_ARGUMENT, executor->impl->allocator);
+  RCL_CHECK_ARGUMENT_FOR_NULL(callback, RCL_RET_INVALID_ARGUMENT, executor->impl->allocator);
+  rcl_ws_entity_t entity;
+  memset(&entity, 0, sizeof(entity));
+  entity.type = RCL_WS_SERVICE;
+  entity.handle = service;
+  entity.message = request;
+  entity.response = response;
+  entity.callback.service = callback;
+  entity.context = context;
+  return __add_entity(executor->impl, &entity);
+}
+
+rcl_ret_t
+rcl_work_stealing_executor_spin_some(
+  rcl_work_stealing_executor_t * executor,
+  size_t worker_index,
+  int64_t timeout)
+{
+  WORK_STEALING_EXECUTOR_CHECK(executor)
+  rcl_work_stealing_executor_impl_t * impl = executor->impl;
+  if (worker_index >= impl->number_of_workers) {
+    RCL_SET_ERROR_MSG("worker index out of range", impl->allocator);
+    return RCL_RET_INVALID_ARGUMENT;
+  }
+  rcl_ws_shard_t * shard = &impl->shards[worker_index];
+  rcl_ret_t ret = __shard_take_back_finished(shard);
+  if (ret != RCL_RET_OK) {
+    return ret;  // The rcl error state should already be set.
+  }
+  rcl_ws_entity_t * entity = __next_work(impl, worker_index);
+  if (!entity) {
+    // Look once more after announcing the wait, since a worker which queued
+    // work before that could not have woken this one up.
+    rcl_atomic_store(&shard->waiting, true);
+    entity = __next_work(impl, worker_index);
+  }
+  if (!entity) {
+    ret = rcl_wait(&shard->wait_set, timeout);
+    rcl_atomic_store(&shard->waiting, false);
+    if (ret != RCL_RET_OK) {
+      return ret;  // The rcl error state should already be set, unless it is a timeout.
+    }
+    size_t number_queued = 0;
+    ret = __shard_queue_ready(shard, &number_queued);
+    if (ret != RCL_RET_OK) {
+      return ret;  // The rcl error state should already be set.
+    }
+    if (number_queued > 1) {
+      ret = __wake_up_idle_workers(impl, worker_index, number_queued - 1);
+      if (ret != RCL_RET_OK) {
+        return ret;  // The rcl error state should already be set.
+      }
+    }
+    // The wait may have been ended by other workers handing entities back.
+    ret = __shard_take_back_finished(shard);
+    if (ret != RCL_RET_OK) {
+      return ret;  // The rcl error state should already be set.
+    }
+    entity = __next_work(impl, worker_index);
+    if (!entity) {
+      return RCL_RET_OK;
+    }
+  } else {
+    rcl_atomic_store(&shard->waiting, false);
+  }
+  return __execute(impl, worker_index, entity);
+}
+
+rcl_ret_t
+rcl_work_stealing_executor_spin(
+  rcl_work_stealing_executor_t * executor,
+  size_t worker_index,
+  int64_t timeout)
+{
+  WORK_STEALING_EXECUTOR_CHECK(executor)
+  while (rcl_ok()) {
+    rcl_ret_t ret = rcl_work_stealing_executor_spin_some(executor, worker_index, timeout);
+    if (ret == RCL_RET_TIMEOUT) {
+      continue;
+    }
+    if (ret != RCL_RET_OK) {
+      return ret;  // The rcl error state should already be set.
+    }
+  }
+  return RCL_RET_OK;
+}
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,240 @@
+// Copyright 2018 Open Source Robotics Foundation, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// Compare rcl_executor_spin_some() to the usual hand written executor loop.
+//
+// The naive loop clears and refills the wait set before every rcl_wait() and
+// then scans every slot for the entities which were not set to NULL.
+// Both dispatch the same guard conditions, a quarter of which are triggered
+// per iteration, and the same always ready timers.
+
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+
+#include "rcutils/logging_macros.h"
+
+#include "rcl/error_handling.h"
+#include "rcl/executor.h"
+#include "rcl/rcl.h"
+
+#include "osrf_testing_tools_cpp/scope_exit.hpp"
+
+#include "./benchmark_utils.hpp"
+
+static const size_t kNumberOfGuardConditions = 64;
+static const size_t kNumberOfTimers = 8;
+
+static size_t g_dispatched = 0;
+
+static void
+on_timer(rcl_timer_t *, int64_t)
+{
+  ++g_dispatched;
+}
+
+static void
+on_guard_condition(void *)
+{
+  ++g_dispatched;
+}
+
+static bool
+trigger_some(std::vector<rcl_guard_condition_t> & guard_conditions)
+{
+  for (size_t i = 0; i < guard_conditions.size(); i += 4) {
+    if (rcl_trigger_guard_condition(&guard_conditions[i]) != RCL_RET_OK) {
+      return false;
+    }
+  }
+  return true;
+}
+
+static bool
+run_naive(
+  std::vector<rcl_guard_condition_t> & guard_conditions, std::vector<rcl_timer_t> & timers,
+  size_t iterations)
+{
+  rcl_wait_set_t wait_set = rcl_get_zero_initialized_wait_set();
+  if (rcl_wait_set_init(
+      &wait_set, 0, guard_conditions.size(), timers.size(), 0, 0,
+      rcl_get_default_allocator()) != RCL_RET_OK)
+  {
+    return false;
+  }
+  OSRF_TESTING_TOOLS_CPP_SCOPE_EXIT({
+    rcl_ret_t ret = rcl_wait_set_fini(&wait_set);
+    (void)ret;
+  });
+  std::vector<int64_t> samples;
+  samples.reserve(iterations);
+  g_dispatched = 0;
+  for (size_t i = 0; i < iterations; ++i) {
+    if (!trigger_some(guard_conditions)) {
+      return false;
+    }
+    int64_t start = benchmark_utils::steady_now_ns();
+    if (rcl_wait_set_clear(&wait_set) != RCL_RET_OK) {
+      return false;
+    }
+    for (auto & guard_condition : guard_conditions) {
+      if (rcl_wait_set_add_guard_condition(&wait_set, &guard_condition) != RCL_RET_OK) {
+        return false;
+      }
+    }
+    for (auto & timer : timers) {
+      if (rcl_wait_set_add_timer(&wait_set, &timer) != RCL_RET_OK) {
+        return false;
+      }
+    }
+    if (rcl_wait(&wait_set, 0) != RCL_RET_OK) {
+      return false;
+    }
+    for (size_t j = 0; j < wait_set.size_of_timers; ++j) {
+      if (wait_set.timers[j] && rcl_timer_call(&timers[j]) != RCL_RET_OK) {
+        return false;
+      }
+    }
+    for (size_t j = 0; j < wait_set.size_of_guard_conditions; ++j) {
+      if (wait_set.guard_conditions[j]) {
+        on_guard_condition(nullptr);
+      }
+    }
+    samples.push_back(benchmark_utils::steady_now_ns() - start);
+  }
+  printf("naive loop, %zu callbacks:\n", g_dispatched);
+  benchmark_utils::print_summary("  wait and dispatch", samples);
+  return true;
+}
+
+static bool
+run_executor(
+  std::vector<rcl_guard_condition_t> & guard_conditions, std::vector<rcl_timer_t> & timers,
+  size_t iterations)
+{
+  rcl_executor_t executor = rcl_get_zero_initialized_executor();
+  if (rcl_executor_init(
+      &executor, 0, guard_conditions.size(), timers.size(), 0, 0,
+      rcl_get_default_allocator()) != RCL_RET_OK)
+  {
+    return false;
+  }
+  OSRF_TESTING_TOOLS_CPP_SCOPE_EXIT({
+    rcl_ret_t ret = rcl_executor_fini(&executor);
+    (void)ret;
+  });
+  for (auto & guard_condition : guard_conditions) {
+    if (rcl_executor_add_guard_condition(
+        &executor, &guard_condition, on_guard_condition, nullptr) != RCL_RET_OK)
+    {
+      return false;
+    }
+  }
+  for (auto & timer : timers) {
+    if (rcl_executor_add_timer(&executor, &timer) != RCL_RET_OK) {
+      return false;
+    }
+  }
+  std::vector<int64_t> samples;
+  samples.reserve(iterations);
+  g_dispatched = 0;
+  for (size_t i = 0; i < iterations; ++i) {
+    if (!trigger_some(guard_conditions)) {
+      return false;
+    }
+    int64_t start = benchmark_utils::steady_now_ns();
+    if (rcl_executor_spin_some(&executor, 0) != RCL_RET_OK) {
+      return false;
+    }
+    samples.push_back(benchmark_utils::steady_now_ns() - start);
+  }
+  printf("rcl_executor, %zu callbacks:\n", g_dispatched);
+  benchmark_utils::print_summary("  wait and dispatch", samples);
+  return true;
+}
+
+static bool
+run(size_t iterations)
+{
+  rcl_allocator_t allocator = rcl_get_default_allocator();
+  rcl_clock_t clock;
+  if (rcl_clock_init(RCL_STEADY_TIME, &clock, &allocator) != RCL_RET_OK) {
+    RCUTILS_LOG_ERROR_NAMED(
+      ROS_PACKAGE_NAME, "Error in clock init: %s", rcl_get_error_string_safe())
+    return false;
+  }
+  std::vector<rcl_guard_condition_t> guard_conditions(
+    kNumberOfGuardConditions, rcl_get_zero_initialized_guard_condition());
+  std::vector<rcl_timer_t> timers(kNumberOfTimers, rcl_get_zero_initialized_timer());
+  OSRF_TESTING_TOOLS_CPP_SCOPE_EXIT({
+    rcl_ret_t ret;
+    for (auto & guard_condition : guard_conditions) {
+      ret = rcl_guard_condition_fini(&guard_condition);
+    }
+    for (auto & timer : timers) {
+      ret = rcl_timer_fini(&timer);
+    }
+    ret = rcl_clock_fini(&clock);
+    (void)ret;
+  });
+  for (auto & guard_condition : guard_conditions) {
+    if (rcl_guard_condition_init(
+        &guard_condition, rcl_guard_condition_get_default_options()) != RCL_RET_OK)
+    {
+      RCUTILS_LOG_ERROR_NAMED(
+        ROS_PACKAGE_NAME, "Error in guard condition init: %s", rcl_get_error_string_safe())
+      return false;
+    }
+  }
+  for (auto & timer : timers) {
+    // A period of zero makes the timer ready at every wait.
+    if (rcl_timer_init(&timer, &clock, 0, on_timer, allocator) != RCL_RET_OK) {
+      RCUTILS_LOG_ERROR_NAMED(
+        ROS_PACKAGE_NAME, "Error in timer init: %s", rcl_get_error_string_safe())
+      return false;
+    }
+  }
+  if (!run_naive(guard_conditions, timers, iterations)) {
+    RCUTILS_LOG_ERROR_NAMED(
+      ROS_PACKAGE_NAME, "Error in naive loop: %s", rcl_get_error_string_safe())
+    return false;
+  }
+  if (!run_executor(guard_conditions, timers, iterations)) {
+    RCUTILS_LOG_ERROR_NAMED(
+      ROS_PACKAGE_NAME, "Error in executor: %s", rcl_get_error_string_safe())
+    return false;
+  }
+  return true;
+}
+
+int main(int argc, char ** argv)
+{
+  size_t iterations = 10000;
+  if (argc > 1) {
+    iterations = static_cast<size_t>(strtoul(argv[1], nullptr, 10));
+  }
+  if (rcl_init(argc, argv, rcl_get_default_allocator()) != RCL_RET_OK) {
+    RCUTILS_LOG_ERROR_NAMED(
+      ROS_PACKAGE_NAME, "Error in rcl init: %s", rcl_get_error_string_safe())
+    return -1;
+  }
+  int main_ret = 0;
+  if (!run(iterations)) {
+    main_ret = -1;
+  }
+  if (rcl_shutdown() != RCL_RET_OK) {
+    main_ret = -1;
+  }
+  return main_ret;
+}
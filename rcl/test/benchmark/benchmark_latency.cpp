@@ -0,0 +1,196 @@
+// Copyright 2018 Open Source Robotics Foundation, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// Measure the publish to take latency of messages of increasing sizes.
+//
+// For each size, a thread publishes messages with a string of that size at a
+// fixed period, through an intra-process publisher, while the main thread
+// waits on the subscription with rcl_wait() and takes each message with
+// rcl_take().
+// The latencies are the ones the subscription measures itself, with the
+// `measure_latency` option, from the time the messages were published at.
+
+#include <atomic>
+#include <chrono>
+#include <cinttypes>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <thread>
+
+#include "rcutils/logging_macros.h"
+
+#include "rcl/error_handling.h"
+#include "rcl/rcl.h"
+#include "rosidl_generator_c/string_functions.h"
+#include "test_msgs/msg/primitives.h"
+
+#include "osrf_testing_tools_cpp/scope_exit.hpp"
+
+#include "./benchmark_utils.hpp"
+
+static const size_t message_sizes[] = {16, 1024, 64 * 1024, 1024 * 1024};
+static const std::chrono::microseconds publish_period(1000);
+
+static bool
+measure(rcl_node_t * node, size_t message_size, size_t number_of_messages)
+{
+  const rosidl_message_type_support_t * ts =
+    ROSIDL_GET_MSG_TYPE_SUPPORT(test_msgs, msg, Primitives);
+  std::string topic = "benchmark_latency_" + std::to_string(message_size);
+  rcl_publisher_t publisher = rcl_get_zero_initialized_publisher();
+  rcl_publisher_options_t publisher_options = rcl_publisher_get_default_options();
+  publisher_options.intra_process = true;
+  if (rcl_publisher_init(
+      &publisher, node, ts, topic.c_str(), &publisher_options) != RCL_RET_OK)
+  {
+    RCUTILS_LOG_ERROR_NAMED(
+      ROS_PACKAGE_NAME, "Error in publisher init: %s", rcl_get_error_string_safe())
+    return false;
+  }
+  OSRF_TESTING_TOOLS_CPP_SCOPE_EXIT({
+    rcl_ret_t ret = rcl_publisher_fini(&publisher, node);
+    (void)ret;
+  });
+  rcl_subscription_t subscription = rcl_get_zero_initialized_subscription();
+  rcl_subscription_options_t subscription_options = rcl_subscription_get_default_options();
+  subscription_options.intra_process = true;
+  subscription_options.measure_latency = true;
+  subscription_options.qos.depth = number_of_messages;
+  if (rcl_subscription_init(
+      &subscription, node, ts, topic.c_str(), &subscription_options) != RCL_RET_OK)
+  {
+    RCUTILS_LOG_ERROR_NAMED(
+      ROS_PACKAGE_NAME, "Error in subscription init: %s", rcl_get_error_string_safe())
+    return false;
+  }
+  OSRF_TESTING_TOOLS_CPP_SCOPE_EXIT({
+    rcl_ret_t ret = rcl_subscription_fini(&subscription, node);
+    (void)ret;
+  });
+  rcl_wait_set_t wait_set = rcl_get_zero_initialized_wait_set();
+  if (rcl_wait_set_init(&wait_set, 1, 0, 0, 0, 0, rcl_get_default_allocator()) != RCL_RET_OK) {
+    RCUTILS_LOG_ERROR_NAMED(
+      ROS_PACKAGE_NAME, "Error in wait set init: %s", rcl_get_error_string_safe())
+    return false;
+  }
+  OSRF_TESTING_TOOLS_CPP_SCOPE_EXIT({
+    rcl_ret_t ret = rcl_wait_set_fini(&wait_set);
+    (void)ret;
+  });
+
+  std::atomic<bool> publish_failed(false);
+  std::thread publisher_thread([&]() {
+      test_msgs__msg__Primitives msg;
+      test_msgs__msg__Primitives__init(&msg);
+      std::string data(message_size, 'x');
+      rosidl_generator_c__String__assignn(&msg.string_value, data.c_str(), data.size());
+      auto next_publish_time = std::chrono::steady_clock::now();
+      for (size_t i = 0; i < number_of_messages; ++i) {
+        next_publish_time += publish_period;
+        std::this_thread::sleep_until(next_publish_time);
+        if (rcl_publish(&publisher, &msg) != RCL_RET_OK) {
+          publish_failed = true;
+          break;
+        }
+      }
+      test_msgs__msg__Primitives__fini(&msg);
+    });
+
+  test_msgs__msg__Primitives msg;
+  test_msgs__msg__Primitives__init(&msg);
+  size_t taken = 0;
+  bool ok = true;
+  while (ok && taken < number_of_messages && !publish_failed) {
+    ok = rcl_wait_set_clear(&wait_set) == RCL_RET_OK &&
+      rcl_wait_set_add_subscription(&wait_set, &subscription) == RCL_RET_OK;
+    rcl_ret_t ret = ok ? rcl_wait(&wait_set, RCL_MS_TO_NS(100)) : RCL_RET_ERROR;
+    if (RCL_RET_TIMEOUT == ret) {
+      continue;
+    }
+    ok = RCL_RET_OK == ret;
+    while (ok && (ret = rcl_take(&subscription, &msg, nullptr)) == RCL_RET_OK) {
+      ++taken;
+    }
+    ok = ok && RCL_RET_SUBSCRIPTION_TAKE_FAILED == ret;
+  }
+  test_msgs__msg__Primitives__fini(&msg);
+  publisher_thread.join();
+  if (!ok || publish_failed) {
+    RCUTILS_LOG_ERROR_NAMED(
+      ROS_PACKAGE_NAME, "Error after %zu messages: %s", taken, rcl_get_error_string_safe())
+    return false;
+  }
+
+  rcl_subscription_latency_statistics_t statistics;
+  int64_t p50 = 0;
+  int64_t p99 = 0;
+  int64_t p999 = 0;
+  if (
+    rcl_subscription_get_latency_statistics(&subscription, &statistics) != RCL_RET_OK ||
+    rcl_subscription_get_latency_percentile(&subscription, 50.0, &p50) != RCL_RET_OK ||
+    rcl_subscription_get_latency_percentile(&subscription, 99.0, &p99) != RCL_RET_OK ||
+    rcl_subscription_get_latency_percentile(&subscription, 99.9, &p999) != RCL_RET_OK)
+  {
+    RCUTILS_LOG_ERROR_NAMED(
+      ROS_PACKAGE_NAME, "Error in latency query: %s", rcl_get_error_string_safe())
+    return false;
+  }
+  printf(
+    "  %8zu bytes n=%" PRIu64 " mean=%" PRId64 "ns p50=%" PRId64 "ns p99=%" PRId64
+    "ns p99.9=%" PRId64 "ns max=%" PRId64 "ns\n",
+    message_size, statistics.number_of_samples, statistics.mean_latency, p50, p99, p999,
+    statistics.max_latency);
+  return true;
+}
+
+int main(int argc, char ** argv)
+{
+  size_t number_of_messages = 1000;
+  if (argc > 1) {
+    number_of_messages = static_cast<size_t>(strtoul(argv[1], nullptr, 10));
+  }
+  if (rcl_init(argc, argv, rcl_get_default_allocator()) != RCL_RET_OK) {
+    RCUTILS_LOG_ERROR_NAMED(
+      ROS_PACKAGE_NAME, "Error in rcl init: %s", rcl_get_error_string_safe())
+    return -1;
+  }
+  int main_ret = 0;
+  {
+    rcl_node_t node = rcl_get_zero_initialized_node();
+    rcl_node_options_t node_options = rcl_node_get_default_options();
+    if (rcl_node_init(&node, "benchmark_latency_node", "", &node_options) != RCL_RET_OK) {
+      RCUTILS_LOG_ERROR_NAMED(
+        ROS_PACKAGE_NAME, "Error in node init: %s", rcl_get_error_string_safe())
+      main_ret = -1;
+    } else {
+      printf(
+        "publish to take latency of intra-process messages, published every %" PRId64 "us:\n",
+        static_cast<int64_t>(publish_period.count()));
+      for (size_t message_size : message_sizes) {
+        if (!measure(&node, message_size, number_of_messages)) {
+          main_ret = -1;
+          break;
+        }
+      }
+      if (rcl_node_fini(&node) != RCL_RET_OK) {
+        main_ret = -1;
+      }
+    }
+  }
+  if (rcl_shutdown() != RCL_RET_OK) {
+    main_ret = -1;
+  }
+  return main_ret;
+}
@@ -0,0 +1,137 @@
+// Copyright 2018 Open Source Robotics Foundation, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// Measure the cost rcl adds on top of rmw_publish() for each message.
+//
+// Each sample is the mean time per call over a batch of publishes of the same
+// message, for:
+// - rmw_publish() on the publisher's rmw handle,
+// - rcl_publish(),
+// - the checks rcl_publish() used to do on every call, i.e. a debug log
+//   statement and rcl_publisher_is_valid(), followed by rmw_publish().
+
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+
+#include "rcutils/logging_macros.h"
+
+#include "rcl/error_handling.h"
+#include "rcl/rcl.h"
+#include "rmw/rmw.h"
+#include "test_msgs/msg/primitives.h"
+
+#include "osrf_testing_tools_cpp/scope_exit.hpp"
+
+#include "./benchmark_utils.hpp"
+
+static const size_t batch_size = 1000;
+
+template<typename PublishFunction>
+static bool
+measure(const char * name, size_t batches, PublishFunction publish)
+{
+  std::vector<int64_t> samples;
+  samples.reserve(batches);
+  for (size_t i = 0; i < batches; ++i) {
+    int64_t start = benchmark_utils::steady_now_ns();
+    for (size_t j = 0; j < batch_size; ++j) {
+      if (!publish()) {
+        RCUTILS_LOG_ERROR_NAMED(
+          ROS_PACKAGE_NAME, "Error in %s: %s", name, rcl_get_error_string_safe())
+        return false;
+      }
+    }
+    samples.push_back((benchmark_utils::steady_now_ns() - start) / batch_size);
+  }
+  benchmark_utils::print_summary(name, samples);
+  return true;
+}
+
+static bool
+run(rcl_node_t * node, size_t batches)
+{
+  const rosidl_message_type_support_t * ts =
+    ROSIDL_GET_MSG_TYPE_SUPPORT(test_msgs, msg, Primitives);
+  rcl_publisher_t publisher = rcl_get_zero_initialized_publisher();
+  rcl_publisher_options_t publisher_options = rcl_publisher_get_default_options();
+  if (rcl_publisher_init(
+      &publisher, node, ts, "benchmark_publish", &publisher_options) != RCL_RET_OK)
+  {
+    RCUTILS_LOG_ERROR_NAMED(
+      ROS_PACKAGE_NAME, "Error in publisher init: %s", rcl_get_error_string_safe())
+    return false;
+  }
+  OSRF_TESTING_TOOLS_CPP_SCOPE_EXIT({
+    rcl_ret_t ret = rcl_publisher_fini(&publisher, node);
+    (void)ret;
+  });
+  test_msgs__msg__Primitives msg;
+  test_msgs__msg__Primitives__init(&msg);
+  OSRF_TESTING_TOOLS_CPP_SCOPE_EXIT({
+    test_msgs__msg__Primitives__fini(&msg);
+  });
+  msg.int64_value = 42;
+  rmw_publisher_t * rmw_publisher = rcl_publisher_get_rmw_handle(&publisher);
+
+  printf("per call cost, mean of batches of %zu publishes:\n", batch_size);
+  bool ok = measure("  rmw_publish", batches, [&]() {
+        return rmw_publish(rmw_publisher, &msg) == RMW_RET_OK;
+      });
+  ok = ok && measure("  rcl_publish", batches, [&]() {
+        return rcl_publish(&publisher, &msg) == RCL_RET_OK;
+      });
+  ok = ok && measure("  log + is_valid + rmw_publish", batches, [&]() {
+        RCUTILS_LOG_DEBUG_NAMED(ROS_PACKAGE_NAME, "Publisher publishing message")
+        if (!rcl_publisher_is_valid(&publisher, nullptr)) {
+          return false;
+        }
+        return rmw_publish(rcl_publisher_get_rmw_handle(&publisher), &msg) == RMW_RET_OK;
+      });
+  return ok;
+}
+
+int main(int argc, char ** argv)
+{
+  size_t batches = 1000;
+  if (argc > 1) {
+    batches = static_cast<size_t>(strtoul(argv[1], nullptr, 10));
+  }
+  if (rcl_init(argc, argv, rcl_get_default_allocator()) != RCL_RET_OK) {
+    RCUTILS_LOG_ERROR_NAMED(
+      ROS_PACKAGE_NAME, "Error in rcl init: %s", rcl_get_error_string_safe())
+    return -1;
+  }
+  int main_ret = 0;
+  {
+    rcl_node_t node = rcl_get_zero_initialized_node();
+    rcl_node_options_t node_options = rcl_node_get_default_options();
+    if (rcl_node_init(&node, "benchmark_publish_node", "", &node_options) != RCL_RET_OK) {
+      RCUTILS_LOG_ERROR_NAMED(
+        ROS_PACKAGE_NAME, "Error in node init: %s", rcl_get_error_string_safe())
+      main_ret = -1;
+    } else {
+      if (!run(&node, batches)) {
+        main_ret = -1;
+      }
+      if (rcl_node_fini(&node) != RCL_RET_OK) {
+        main_ret = -1;
+      }
+    }
+  }
+  if (rcl_shutdown() != RCL_RET_OK) {
+    main_ret = -1;
+  }
+  return main_ret;
+}
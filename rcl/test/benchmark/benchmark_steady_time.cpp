@@ -0,0 +1,120 @@
+// Copyright 2018 Open Source Robotics Foundation, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// Measure the cost of reading the steady time, through a RCL_STEADY_TIME
+// clock backed by the time stamp counter, and directly with clock_gettime()
+// on CLOCK_MONOTONIC and CLOCK_MONOTONIC_COARSE.
+//
+// Each sample is the mean cost of a batch of reads, since a single read is
+// shorter than the resolution of the clock timing it.
+// The time stamp counter is requested through RCL_STEADY_TIME_SOURCE, unless
+// it is already set, and the source actually used is printed.
+
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+
+#include "rcutils/logging_macros.h"
+
+#include "rcl/error_handling.h"
+#include "rcl/rcl.h"
+
+#include "./benchmark_utils.hpp"
+
+#if defined(__linux__)
+#include <time.h>
+#endif
+
+static const size_t batch_size = 1000;
+
+template<typename ReadFunction>
+static std::vector<int64_t>
+measure(size_t iterations, ReadFunction read)
+{
+  std::vector<int64_t> samples;
+  samples.reserve(iterations);
+  volatile int64_t sink = 0;
+  for (size_t i = 0; i < iterations; ++i) {
+    int64_t start = benchmark_utils::steady_now_ns();
+    for (size_t j = 0; j < batch_size; ++j) {
+      sink = read();
+    }
+    int64_t elapsed = benchmark_utils::steady_now_ns() - start;
+    samples.push_back(elapsed / static_cast<int64_t>(batch_size));
+  }
+  (void)sink;
+  return samples;
+}
+
+static bool
+run(size_t iterations)
+{
+  rcl_allocator_t allocator = rcl_get_default_allocator();
+  rcl_clock_t clock;
+  if (rcl_clock_init(RCL_STEADY_TIME, &clock, &allocator) != RCL_RET_OK) {
+    RCUTILS_LOG_ERROR_NAMED(
+      ROS_PACKAGE_NAME, "Error in clock init: %s", rcl_get_error_string_safe())
+    return false;
+  }
+  printf(
+    "steady time source: %s\n",
+    RCL_STEADY_TIME_SOURCE_TSC == rcl_get_steady_time_source() ? "tsc" : "system");
+  benchmark_utils::print_summary(
+    "rcl_clock_get_now(RCL_STEADY_TIME)", measure(iterations, [&clock]() {
+      rcl_time_point_value_t now = 0;
+      rcl_ret_t ret = rcl_clock_get_now(&clock, &now);
+      (void)ret;
+      return now;
+    }));
+#if defined(__linux__)
+  benchmark_utils::print_summary(
+    "clock_gettime(CLOCK_MONOTONIC)", measure(iterations, []() {
+      struct timespec now;
+      clock_gettime(CLOCK_MONOTONIC, &now);
+      return static_cast<int64_t>(now.tv_nsec);
+    }));
+  benchmark_utils::print_summary(
+    "clock_gettime(CLOCK_MONOTONIC_COARSE)", measure(iterations, []() {
+      struct timespec now;
+      clock_gettime(CLOCK_MONOTONIC_COARSE, &now);
+      return static_cast<int64_t>(now.tv_nsec);
+    }));
+#endif
+  return rcl_clock_fini(&clock) == RCL_RET_OK;
+}
+
+int main(int argc, char ** argv)
+{
+  size_t iterations = 10000;
+  if (argc > 1) {
+    iterations = static_cast<size_t>(strtoul(argv[1], nullptr, 10));
+  }
+#if !defined(_WIN32)
+  // Keep a source chosen by the caller.
+  setenv("RCL_STEADY_TIME_SOURCE", "tsc", 0);
+#endif
+  if (rcl_init(argc, argv, rcl_get_default_allocator()) != RCL_RET_OK) {
+    RCUTILS_LOG_ERROR_NAMED(
+      ROS_PACKAGE_NAME, "Error in rcl init: %s", rcl_get_error_string_safe())
+    return -1;
+  }
+  int main_ret = 0;
+  if (!run(iterations)) {
+    main_ret = -1;
+  }
+  if (rcl_shutdown() != RCL_RET_OK) {
+    main_ret = -1;
+  }
+  return main_ret;
+}
@@ -0,0 +1,147 @@
+// Copyright 2018 Open Source Robotics Foundation, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// Measure the activation lateness of a 1 kHz timer under background load,
+// with and without the high_precision timer option.
+//
+// One busy thread per hardware thread competes with the waiting thread for
+// the processors.
+// The lateness is the time at which rcl_wait() returned the timer as ready
+// minus its next call time.
+
+#include <algorithm>
+#include <atomic>
+#include <cstdio>
+#include <cstdlib>
+#include <thread>
+#include <vector>
+
+#include "rcutils/logging_macros.h"
+
+#include "rcl/error_handling.h"
+#include "rcl/rcl.h"
+
+#include "osrf_testing_tools_cpp/scope_exit.hpp"
+
+#include "./benchmark_utils.hpp"
+
+static bool
+run(bool high_precision, size_t iterations)
+{
+  rcl_allocator_t allocator = rcl_get_default_allocator();
+  rcl_clock_t clock;
+  if (rcl_clock_init(RCL_STEADY_TIME, &clock, &allocator) != RCL_RET_OK) {
+    RCUTILS_LOG_ERROR_NAMED(
+      ROS_PACKAGE_NAME, "Error in clock init: %s", rcl_get_error_string_safe())
+    return false;
+  }
+  rcl_timer_options_t options = rcl_timer_get_default_options();
+  options.high_precision = high_precision;
+  rcl_timer_t timer = rcl_get_zero_initialized_timer();
+  if (rcl_timer_init_with_options(
+      &timer, &clock, RCL_MS_TO_NS(1), nullptr, allocator, &options) != RCL_RET_OK)
+  {
+    RCUTILS_LOG_ERROR_NAMED(
+      ROS_PACKAGE_NAME, "Error in timer init: %s", rcl_get_error_string_safe())
+    return false;
+  }
+  rcl_wait_set_t wait_set = rcl_get_zero_initialized_wait_set();
+  if (rcl_wait_set_init(&wait_set, 0, 0, 1, 0, 0, allocator) != RCL_RET_OK) {
+    RCUTILS_LOG_ERROR_NAMED(
+      ROS_PACKAGE_NAME, "Error in wait set init: %s", rcl_get_error_string_safe())
+    return false;
+  }
+  OSRF_TESTING_TOOLS_CPP_SCOPE_EXIT({
+    rcl_ret_t ret = rcl_wait_set_fini(&wait_set);
+    ret = rcl_timer_fini(&timer);
+    ret = rcl_clock_fini(&clock);
+    (void)ret;
+  });
+  if (rcl_wait_set_set_persistent(&wait_set, true) != RCL_RET_OK ||
+    rcl_wait_set_add_timer(&wait_set, &timer) != RCL_RET_OK)
+  {
+    RCUTILS_LOG_ERROR_NAMED(
+      ROS_PACKAGE_NAME, "Error filling the wait set: %s", rcl_get_error_string_safe())
+    return false;
+  }
+
+  std::atomic<bool> done(false);
+  std::vector<std::thread> load;
+  size_t number_of_load_threads = std::max(1u, std::thread::hardware_concurrency());
+  for (size_t i = 0; i < number_of_load_threads; ++i) {
+    load.emplace_back([&done]() {
+        volatile uint64_t counter = 0;
+        while (!done) {
+          counter = counter + 1;
+        }
+      });
+  }
+  OSRF_TESTING_TOOLS_CPP_SCOPE_EXIT({
+    done = true;
+    for (auto & thread : load) {
+      thread.join();
+    }
+  });
+
+  std::vector<int64_t> lateness;
+  lateness.reserve(iterations);
+  while (lateness.size() < iterations) {
+    int64_t next_call_time = 0;
+    if (rcl_timer_get_next_call_time(&timer, &next_call_time) != RCL_RET_OK) {
+      return false;
+    }
+    rcl_ret_t ret = rcl_wait(&wait_set, RCL_S_TO_NS(1));
+    if (ret != RCL_RET_OK) {
+      RCUTILS_LOG_ERROR_NAMED(ROS_PACKAGE_NAME, "Error in wait: %s", rcl_get_error_string_safe())
+      return false;
+    }
+    rcl_time_point_value_t now = 0;
+    if (rcl_clock_get_now(&clock, &now) != RCL_RET_OK) {
+      return false;
+    }
+    if (wait_set.ready.timers[0]) {
+      lateness.push_back(now - next_call_time);
+      if (rcl_timer_call(&timer) != RCL_RET_OK) {
+        return false;
+      }
+    }
+  }
+
+  printf(
+    "%s, %zu busy threads:\n", high_precision ? "high precision" : "relative timeout",
+    number_of_load_threads);
+  benchmark_utils::print_summary("  1 kHz timer activation lateness", lateness);
+  return true;
+}
+
+int main(int argc, char ** argv)
+{
+  size_t iterations = 5000;
+  if (argc > 1) {
+    iterations = static_cast<size_t>(strtoul(argv[1], nullptr, 10));
+  }
+  if (rcl_init(argc, argv, rcl_get_default_allocator()) != RCL_RET_OK) {
+    RCUTILS_LOG_ERROR_NAMED(
+      ROS_PACKAGE_NAME, "Error in rcl init: %s", rcl_get_error_string_safe())
+    return -1;
+  }
+  int main_ret = 0;
+  if (!run(false, iterations) || !run(true, iterations)) {
+    main_ret = -1;
+  }
+  if (rcl_shutdown() != RCL_RET_OK) {
+    main_ret = -1;
+  }
+  return main_ret;
+}
@@ -0,0 +1,60 @@
+// Copyright 2018 Open Source Robotics Foundation, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef BENCHMARK__BENCHMARK_UTILS_HPP_
+#define BENCHMARK__BENCHMARK_UTILS_HPP_
+
+#include <algorithm>
+#include <chrono>
+#include <cinttypes>
+#include <cstdio>
+#include <vector>
+
+namespace benchmark_utils
+{
+
+inline int64_t
+steady_now_ns()
+{
+  return std::chrono::duration_cast<std::chrono::nanoseconds>(
+    std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+/// Print the mean and a few percentiles of the given samples, in nanoseconds.
+inline void
+print_summary(const char * name, std::vector<int64_t> samples)
+{
+  if (samples.empty()) {
+    printf("%-40s no samples\n", name);
+    return;
+  }
+  std::sort(samples.begin(), samples.end());
+  int64_t sum = 0;
+  for (int64_t sample : samples) {
+    sum += sample;
+  }
+  auto percentile = [&samples](double p) {
+      size_t index = static_cast<size_t>(p * static_cast<double>(samples.size() - 1));
+      return samples[index];
+    };
+  printf(
+    "%-40s n=%zu mean=%" PRId64 "ns p50=%" PRId64 "ns p99=%" PRId64 "ns p99.9=%" PRId64
+    "ns max=%" PRId64 "ns\n",
+    name, samples.size(), sum / static_cast<int64_t>(samples.size()),
+    percentile(0.5), percentile(0.99), percentile(0.999), samples.back());
+}
+
+}  // namespace benchmark_utils
+
+#endif  // BENCHMARK__BENCHMARK_UTILS_HPP_
@@ -0,0 +1,161 @@
+// Copyright 2018 Open Source Robotics Foundation, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// Measure how the callback throughput of the work stealing executor scales
+// with the number of workers.
+//
+// Always ready timers run a callback which busy waits for a fixed time, so
+// that the throughput is bound by the callbacks and not by rcl_wait().
+// The number of workers doubles from one up to the hardware concurrency.
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <thread>
+#include <vector>
+
+#include "rcutils/logging_macros.h"
+
+#include "rcl/error_handling.h"
+#include "rcl/rcl.h"
+#include "rcl/work_stealing_executor.h"
+
+#include "osrf_testing_tools_cpp/scope_exit.hpp"
+
+#include "./benchmark_utils.hpp"
+
+static const size_t kNumberOfTimers = 64;
+static const int64_t kCallbackDurationNs = 20000;
+
+static std::atomic<size_t> g_dispatched(0);
+
+static void
+on_timer(rcl_timer_t *, int64_t)
+{
+  int64_t end = benchmark_utils::steady_now_ns() + kCallbackDurationNs;
+  while (benchmark_utils::steady_now_ns() < end) {
+  }
+  ++g_dispatched;
+}
+
+static bool
+run_workers(std::vector<rcl_timer_t> & timers, size_t number_of_workers, int64_t duration_ns)
+{
+  rcl_work_stealing_executor_t executor = rcl_get_zero_initialized_work_stealing_executor();
+  if (rcl_work_stealing_executor_init(
+      &executor, number_of_workers, 0, 0, timers.size(), 0, 0,
+      rcl_get_default_allocator()) != RCL_RET_OK)
+  {
+    return false;
+  }
+  OSRF_TESTING_TOOLS_CPP_SCOPE_EXIT({
+    rcl_ret_t ret = rcl_work_stealing_executor_fini(&executor);
+    (void)ret;
+  });
+  for (auto & timer : timers) {
+    if (rcl_work_stealing_executor_add_timer(&executor, &timer) != RCL_RET_OK) {
+      return false;
+    }
+  }
+  std::atomic<bool> done(false);
+  std::atomic<bool> failed(false);
+  g_dispatched = 0;
+  int64_t start = benchmark_utils::steady_now_ns();
+  std::vector<std::thread> workers;
+  for (size_t i = 0; i < number_of_workers; ++i) {
+    workers.emplace_back([&executor, &done, &failed, i]() {
+        while (!done) {
+          rcl_ret_t ret = rcl_work_stealing_executor_spin_some(&executor, i, RCL_MS_TO_NS(10));
+          if (ret != RCL_RET_OK && ret != RCL_RET_TIMEOUT) {
+            failed = true;
+            return;
+          }
+        }
+      });
+  }
+  std::this_thread::sleep_for(std::chrono::nanoseconds(duration_ns));
+  done = true;
+  for (auto & worker : workers) {
+    worker.join();
+  }
+  double elapsed_s = static_cast<double>(benchmark_utils::steady_now_ns() - start) / 1e9;
+  printf(
+    "%2zu workers: %10.0f callbacks/s (%zu callbacks)\n", number_of_workers,
+    static_cast<double>(g_dispatched) / elapsed_s, g_dispatched.load());
+  return !failed;
+}
+
+static bool
+run(int64_t duration_ns)
+{
+  rcl_allocator_t allocator = rcl_get_default_allocator();
+  rcl_clock_t clock;
+  if (rcl_clock_init(RCL_STEADY_TIME, &clock, &allocator) != RCL_RET_OK) {
+    RCUTILS_LOG_ERROR_NAMED(
+      ROS_PACKAGE_NAME, "Error in clock init: %s", rcl_get_error_string_safe())
+    return false;
+  }
+  std::vector<rcl_timer_t> timers(kNumberOfTimers, rcl_get_zero_initialized_timer());
+  OSRF_TESTING_TOOLS_CPP_SCOPE_EXIT({
+    rcl_ret_t ret;
+    for (auto & timer : timers) {
+      ret = rcl_timer_fini(&timer);
+    }
+    ret = rcl_clock_fini(&clock);
+    (void)ret;
+  });
+  for (auto & timer : timers) {
+    // A period of zero makes the timer ready at every wait.
+    if (rcl_timer_init(&timer, &clock, 0, on_timer, allocator) != RCL_RET_OK) {
+      RCUTILS_LOG_ERROR_NAMED(
+        ROS_PACKAGE_NAME, "Error in timer init: %s", rcl_get_error_string_safe())
+      return false;
+    }
+  }
+  printf(
+    "%zu always ready timers, %lld us per callback:\n", kNumberOfTimers,
+    static_cast<long long>(kCallbackDurationNs / 1000));
+  size_t maximum_workers = std::max(1u, std::thread::hardware_concurrency());
+  for (size_t workers = 1; workers <= maximum_workers; workers *= 2) {
+    if (!run_workers(timers, workers, duration_ns)) {
+      RCUTILS_LOG_ERROR_NAMED(
+        ROS_PACKAGE_NAME, "Error in executor: %s", rcl_get_error_string_safe())
+      return false;
+    }
+  }
+  return true;
+}
+
+int main(int argc, char ** argv)
+{
+  int64_t duration_ms = 1000;
+  if (argc > 1) {
+    duration_ms = static_cast<int64_t>(strtol(argv[1], nullptr, 10));
+  }
+  if (rcl_init(argc, argv, rcl_get_default_allocator()) != RCL_RET_OK) {
+    RCUTILS_LOG_ERROR_NAMED(
+      ROS_PACKAGE_NAME, "Error in rcl init: %s", rcl_get_error_string_safe())
+    return -1;
+  }
+  int main_ret = 0;
+  if (!run(RCL_MS_TO_NS(duration_ms))) {
+    main_ret = -1;
+  }
+  if (rcl_shutdown() != RCL_RET_OK) {
+    main_ret = -1;
+  }
+  return main_ret;
+}
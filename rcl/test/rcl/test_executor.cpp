@@ -0,0 +1,232 @@
+// Copyright 2018 Open Source Robotics Foundation, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <gtest/gtest.h>
+
+#include <chrono>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "rcl/executor.h"
+
+#include "rcl/rcl.h"
+#include "test_msgs/msg/primitives.h"
+
+#include "osrf_testing_tools_cpp/scope_exit.hpp"
+#include "rcl/error_handling.h"
+
+#ifdef RMW_IMPLEMENTATION
+# define CLASSNAME_(NAME, SUFFIX) NAME ## __ ## SUFFIX
+# define CLASSNAME(NAME, SUFFIX) CLASSNAME_(NAME, SUFFIX)
+#else
+# define CLASSNAME(NAME, SUFFIX) NAME
+#endif
+
+class CLASSNAME (TestExecutorFixture, RMW_IMPLEMENTATION) : public ::testing::Test
+{
+public:
+  rcl_node_t * node_ptr;
+  void SetUp()
+  {
+    rcl_ret_t ret;
+    ret = rcl_init(0, nullptr, rcl_get_default_allocator());
+    ASSERT_EQ(RCL_RET_OK, ret) << rcl_get_error_string_safe();
+    this->node_ptr = new rcl_node_t;
+    *this->node_ptr = rcl_get_zero_initialized_node();
+    const char * name = "test_executor_node";
+    rcl_node_options_t node_options = rcl_node_get_default_options();
+    ret = rcl_node_init(this->node_ptr, name, "", &node_options);
+    ASSERT_EQ(RCL_RET_OK, ret) << rcl_get_error_string_safe();
+  }
+
+  void TearDown()
+  {
+    rcl_ret_t ret = rcl_node_fini(this->node_ptr);
+    delete this->node_ptr;
+    EXPECT_EQ(RCL_RET_OK, ret) << rcl_get_error_string_safe();
+    ret = rcl_shutdown();
+    EXPECT_EQ(RCL_RET_OK, ret) << rcl_get_error_string_safe();
+  }
+};
+
+// Records the order in which the callbacks are called.
+static std::vector<std::string> g_calls;
+
+static void timer_callback(rcl_timer_t *, int64_t)
+{
+  g_calls.push_back("timer");
+}
+
+static void guard_condition_callback(void * context)
+{
+  g_calls.push_back(static_cast<const char *>(context));
+}
+
+static void subscription_callback(const void * message, void * context)
+{
+  const auto * msg = static_cast<const test_msgs__msg__Primitives *>(message);
+  *static_cast<int64_t *>(context) = msg->int64_value;
+  g_calls.push_back("subscription");
+}
+
+/* Test the argument checks and the capacity of an executor.
+ */
+TEST_F(CLASSNAME(TestExecutorFixture, RMW_IMPLEMENTATION), test_executor_init_fini) {
+  rcl_executor_t executor = rcl_get_zero_initialized_executor();
+  rcl_ret_t ret = rcl_executor_spin_some(&executor, 0);
+  EXPECT_EQ(RCL_RET_EXECUTOR_INVALID, ret);
+  rcl_reset_error();
+  ret = rcl_executor_init(nullptr, 0, 1, 0, 0, 0, rcl_get_default_allocator());
+  EXPECT_EQ(RCL_RET_INVALID_ARGUMENT, ret);
+  rcl_reset_error();
+  ret = rcl_executor_init(&executor, 0, 1, 0, 0, 0, rcl_get_default_allocator());
+  ASSERT_EQ(RCL_RET_OK, ret) << rcl_get_error_string_safe();
+  ret = rcl_executor_init(&executor, 0, 1, 0, 0, 0, rcl_get_default_allocator());
+  EXPECT_EQ(RCL_RET_ALREADY_INIT, ret);
+  rcl_reset_error();
+
+  rcl_guard_condition_t guard_conditions[2];
+  for (auto & guard_condition : guard_conditions) {
+    guard_condition = rcl_get_zero_initialized_guard_condition();
+    ret = rcl_guard_condition_init(&guard_condition, rcl_guard_condition_get_default_options());
+    ASSERT_EQ(RCL_RET_OK, ret) << rcl_get_error_string_safe();
+  }
+  OSRF_TESTING_TOOLS_CPP_SCOPE_EXIT({
+    for (auto & guard_condition : guard_conditions) {
+      EXPECT_EQ(RCL_RET_OK, rcl_guard_condition_fini(&guard_condition));
+    }
+  });
+  ret = rcl_executor_add_guard_condition(&executor, &guard_conditions[0], nullptr, nullptr);
+  EXPECT_EQ(RCL_RET_OK, ret) << rcl_get_error_string_safe();
+  ret = rcl_executor_add_guard_condition(&executor, &guard_conditions[1], nullptr, nullptr);
+  EXPECT_EQ(RCL_RET_WAIT_SET_FULL, ret);
+  rcl_reset_error();
+
+  ret = rcl_executor_spin_some(&executor, 0);
+  EXPECT_EQ(RCL_RET_TIMEOUT, ret);
+  ret = rcl_trigger_guard_condition(&guard_conditions[0]);
+  ASSERT_EQ(RCL_RET_OK, ret) << rcl_get_error_string_safe();
+  ret = rcl_executor_spin_some(&executor, RCL_S_TO_NS(1));
+  EXPECT_EQ(RCL_RET_OK, ret) << rcl_get_error_string_safe();
+
+  ret = rcl_executor_fini(&executor);
+  EXPECT_EQ(RCL_RET_OK, ret) << rcl_get_error_string_safe();
+  ret = rcl_executor_fini(&executor);
+  EXPECT_EQ(RCL_RET_OK, ret) << rcl_get_error_string_safe();
+}
+
+/* Test that ready entities are dispatched by type and then in the order they were added.
+ */
+TEST_F(CLASSNAME(TestExecutorFixture, RMW_IMPLEMENTATION), test_executor_dispatch_order) {
+  rcl_ret_t ret;
+  const rosidl_message_type_support_t * ts =
+    ROSIDL_GET_MSG_TYPE_SUPPORT(test_msgs, msg, Primitives);
+  const char * topic = "rcl_test_executor_chatter";
+  rcl_publisher_t publisher = rcl_get_zero_initialized_publisher();
+  rcl_publisher_options_t publisher_options = rcl_publisher_get_default_options();
+  ret = rcl_publisher_init(&publisher, this->node_ptr, ts, topic, &publisher_options);
+  ASSERT_EQ(RCL_RET_OK, ret) << rcl_get_error_string_safe();
+  OSRF_TESTING_TOOLS_CPP_SCOPE_EXIT({
+    EXPECT_EQ(RCL_RET_OK, rcl_publisher_fini(&publisher, this->node_ptr));
+  });
+  rcl_subscription_t subscription = rcl_get_zero_initialized_subscription();
+  rcl_subscription_options_t subscription_options = rcl_subscription_get_default_options();
+  ret = rcl_subscription_init(&subscription, this->node_ptr, ts, topic, &subscription_options);
+  ASSERT_EQ(RCL_RET_OK, ret) << rcl_get_error_string_safe();
+  OSRF_TESTING_TOOLS_CPP_SCOPE_EXIT({
+    EXPECT_EQ(RCL_RET_OK, rcl_subscription_fini(&subscription, this->node_ptr));
+  });
+
+  rcl_clock_t clock;
+  rcl_allocator_t allocator = rcl_get_default_allocator();
+  ret = rcl_clock_init(RCL_STEADY_TIME, &clock, &allocator);
+  ASSERT_EQ(RCL_RET_OK, ret) << rcl_get_error_string_safe();
+  OSRF_TESTING_TOOLS_CPP_SCOPE_EXIT({
+    EXPECT_EQ(RCL_RET_OK, rcl_clock_fini(&clock));
+  });
+  rcl_timer_t timer = rcl_get_zero_initialized_timer();
+  ret = rcl_timer_init(&timer, &clock, RCL_MS_TO_NS(1), timer_callback, allocator);
+  ASSERT_EQ(RCL_RET_OK, ret) << rcl_get_error_string_safe();
+  OSRF_TESTING_TOOLS_CPP_SCOPE_EXIT({
+    EXPECT_EQ(RCL_RET_OK, rcl_timer_fini(&timer));
+  });
+
+  rcl_guard_condition_t first_guard_condition = rcl_get_zero_initialized_guard_condition();
+  ret = rcl_guard_condition_init(
+    &first_guard_condition, rcl_guard_condition_get_default_options());
+  ASSERT_EQ(RCL_RET_OK, ret) << rcl_get_error_string_safe();
+  rcl_guard_condition_t second_guard_condition = rcl_get_zero_initialized_guard_condition();
+  ret = rcl_guard_condition_init(
+    &second_guard_condition, rcl_guard_condition_get_default_options());
+  ASSERT_EQ(RCL_RET_OK, ret) << rcl_get_error_string_safe();
+  OSRF_TESTING_TOOLS_CPP_SCOPE_EXIT({
+    EXPECT_EQ(RCL_RET_OK, rcl_guard_condition_fini(&first_guard_condition));
+    EXPECT_EQ(RCL_RET_OK, rcl_guard_condition_fini(&second_guard_condition));
+  });
+
+  test_msgs__msg__Primitives msg;
+  test_msgs__msg__Primitives__init(&msg);
+  OSRF_TESTING_TOOLS_CPP_SCOPE_EXIT({
+    test_msgs__msg__Primitives__fini(&msg);
+  });
+  int64_t received_value = 0;
+
+  rcl_executor_t executor = rcl_get_zero_initialized_executor();
+  ret = rcl_executor_init(&executor, 1, 2, 1, 0, 0, rcl_get_default_allocator());
+  ASSERT_EQ(RCL_RET_OK, ret) << rcl_get_error_string_safe();
+  OSRF_TESTING_TOOLS_CPP_SCOPE_EXIT({
+    EXPECT_EQ(RCL_RET_OK, rcl_executor_fini(&executor));
+  });
+  // Guard conditions are added first, but are still dispatched after the others.
+  char first_name[] = "first";
+  char second_name[] = "second";
+  ret = rcl_executor_add_guard_condition(
+    &executor, &second_guard_condition, guard_condition_callback, second_name);
+  ASSERT_EQ(RCL_RET_OK, ret) << rcl_get_error_string_safe();
+  ret = rcl_executor_add_guard_condition(
+    &executor, &first_guard_condition, guard_condition_callback, first_name);
+  ASSERT_EQ(RCL_RET_OK, ret) << rcl_get_error_string_safe();
+  ret = rcl_executor_add_subscription(
+    &executor, &subscription, &msg, subscription_callback, &received_value);
+  ASSERT_EQ(RCL_RET_OK, ret) << rcl_get_error_string_safe();
+  ret = rcl_executor_add_timer(&executor, &timer);
+  ASSERT_EQ(RCL_RET_OK, ret) << rcl_get_error_string_safe();
+
+  // TODO(wjwwood): add logic to wait for the connection to be established
+  //                probably using the count_subscriptions busy wait mechanism
+  //                until then we will sleep for a short period of time
+  std::this_thread::sleep_for(std::chrono::milliseconds(1000));
+  {
+    test_msgs__msg__Primitives pub_msg;
+    test_msgs__msg__Primitives__init(&pub_msg);
+    pub_msg.int64_value = 42;
+    ret = rcl_publish(&publisher, &pub_msg);
+    test_msgs__msg__Primitives__fini(&pub_msg);
+    ASSERT_EQ(RCL_RET_OK, ret) << rcl_get_error_string_safe();
+  }
+  ret = rcl_trigger_guard_condition(&first_guard_condition);
+  ASSERT_EQ(RCL_RET_OK, ret) << rcl_get_error_string_safe();
+  ret = rcl_trigger_guard_condition(&second_guard_condition);
+  ASSERT_EQ(RCL_RET_OK, ret) << rcl_get_error_string_safe();
+  // Give the message some time to arrive, the timer is overdue by then too.
+  std::this_thread::sleep_for(std::chrono::milliseconds(100));
+
+  g_calls.clear();
+  ret = rcl_executor_spin_some(&executor, RCL_S_TO_NS(1));
+  ASSERT_EQ(RCL_RET_OK, ret) << rcl_get_error_string_safe();
+  std::vector<std::string> expected_calls = {"timer", "subscription", "second", "first"};
+  EXPECT_EQ(expected_calls, g_calls);
+  EXPECT_EQ(42, received_value);
+}
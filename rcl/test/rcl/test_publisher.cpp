@@ -253,3 +253,157 @@ TEST_F(CLASSNAME(TestPublisherFixture, RMW_IMPLEMENTATION), test_publisher_init_
   EXPECT_EQ(RCL_RET_BAD_ALLOC, ret) << rcl_get_error_string_safe();
   rcl_reset_error();
 }
+
+/* Publishing with an invalid publisher fails and sets the error message.
+ */
+TEST_F(CLASSNAME(TestPublisherFixture, RMW_IMPLEMENTATION), test_publish_invalid_publisher) {
+  rcl_ret_t ret;
+  test_msgs__msg__Primitives msg;
+  test_msgs__msg__Primitives__init(&msg);
+  OSRF_TESTING_TOOLS_CPP_SCOPE_EXIT({
+    test_msgs__msg__Primitives__fini(&msg);
+  });
+  ret = rcl_publish(nullptr, &msg);
+  EXPECT_EQ(RCL_RET_PUBLISHER_INVALID, ret);
+  EXPECT_TRUE(rcl_error_is_set());
+  rcl_reset_error();
+  rcl_publisher_t publisher = rcl_get_zero_initialized_publisher();
+  ret = rcl_publish(&publisher, &msg);
+  EXPECT_EQ(RCL_RET_PUBLISHER_INVALID, ret);
+  EXPECT_TRUE(rcl_error_is_set());
+  rcl_reset_error();
+  rcl_serialized_message_t serialized_msg = rmw_get_zero_initialized_serialized_message();
+  ret = rcl_publish_serialized_message(&publisher, &serialized_msg);
+  EXPECT_EQ(RCL_RET_PUBLISHER_INVALID, ret);
+  EXPECT_TRUE(rcl_error_is_set());
+  rcl_reset_error();
+}
+
+/* Publishing a batch of messages with a single call.
+ */
+TEST_F(CLASSNAME(TestPublisherFixture, RMW_IMPLEMENTATION), test_publish_batch) {
+  rcl_ret_t ret;
+  rcl_publisher_t publisher = rcl_get_zero_initialized_publisher();
+  const rosidl_message_type_support_t * ts =
+    ROSIDL_GET_MSG_TYPE_SUPPORT(test_msgs, msg, Primitives);
+  rcl_publisher_options_t publisher_options = rcl_publisher_get_default_options();
+  publisher_options.enable_statistics = true;
+  ret = rcl_publisher_init(&publisher, this->node_ptr, ts, "chatter", &publisher_options);
+  ASSERT_EQ(RCL_RET_OK, ret) << rcl_get_error_string_safe();
+  OSRF_TESTING_TOOLS_CPP_SCOPE_EXIT({
+    rcl_ret_t ret = rcl_publisher_fini(&publisher, this->node_ptr);
+    EXPECT_EQ(RCL_RET_OK, ret) << rcl_get_error_string_safe();
+  });
+  test_msgs__msg__Primitives msgs[3];
+  const void * msg_ptrs[3];
+  for (size_t i = 0; i < 3; ++i) {
+    test_msgs__msg__Primitives__init(&msgs[i]);
+    msgs[i].int64_value = static_cast<int64_t>(i);
+    msg_ptrs[i] = &msgs[i];
+  }
+  OSRF_TESTING_TOOLS_CPP_SCOPE_EXIT({
+    for (size_t i = 0; i < 3; ++i) {
+      test_msgs__msg__Primitives__fini(&msgs[i]);
+    }
+  });
+  size_t published = 42;
+  ret = rcl_publish_batch(&publisher, msg_ptrs, 3, &published);
+  ASSERT_EQ(RCL_RET_OK, ret) << rcl_get_error_string_safe();
+  EXPECT_EQ(3u, published);
+  // Each message but the very first one has an interval, of zero within the batch.
+  rcl_publisher_statistics_t statistics;
+  ret = rcl_publisher_get_statistics(&publisher, &statistics);
+  ASSERT_EQ(RCL_RET_OK, ret) << rcl_get_error_string_safe();
+  EXPECT_EQ(3u, statistics.number_of_messages);
+  EXPECT_EQ(2u, statistics.interval_histogram[0]);
+  // An empty batch does not need messages.
+  ret = rcl_publish_batch(&publisher, nullptr, 0, &published);
+  ASSERT_EQ(RCL_RET_OK, ret) << rcl_get_error_string_safe();
+  EXPECT_EQ(0u, published);
+  ret = rcl_publish_batch(&publisher, nullptr, 3, &published);
+  EXPECT_EQ(RCL_RET_INVALID_ARGUMENT, ret);
+  EXPECT_EQ(0u, published);
+  rcl_reset_error();
+  ret = rcl_publish_batch(&publisher, msg_ptrs, 3, nullptr);
+  EXPECT_EQ(RCL_RET_INVALID_ARGUMENT, ret);
+  rcl_reset_error();
+  ret = rcl_publish_serialized_message_batch(&publisher, nullptr, 3, &published);
+  EXPECT_EQ(RCL_RET_INVALID_ARGUMENT, ret);
+  EXPECT_EQ(0u, published);
+  rcl_reset_error();
+  rcl_publisher_t invalid_publisher = rcl_get_zero_initialized_publisher();
+  ret = rcl_publish_batch(&invalid_publisher, msg_ptrs, 3, &published);
+  EXPECT_EQ(RCL_RET_PUBLISHER_INVALID, ret);
+  EXPECT_EQ(0u, published);
+  rcl_reset_error();
+  ret = rcl_publish_serialized_message_batch(&invalid_publisher, nullptr, 0, &published);
+  EXPECT_EQ(RCL_RET_PUBLISHER_INVALID, ret);
+  rcl_reset_error();
+}
+
+/* Loaned messages come from a fixed size pool preallocated by the publisher.
+ */
+TEST_F(CLASSNAME(TestPublisherFixture, RMW_IMPLEMENTATION), test_publisher_loaned_messages) {
+  rcl_ret_t ret;
+  const rosidl_message_type_support_t * ts =
+    ROSIDL_GET_MSG_TYPE_SUPPORT(test_msgs, msg, Primitives);
+  void * loaned_message = nullptr;
+  {
+    // Without a pool, no message can be loaned.
+    rcl_publisher_t publisher = rcl_get_zero_initialized_publisher();
+    rcl_publisher_options_t publisher_options = rcl_publisher_get_default_options();
+    EXPECT_EQ(0u, publisher_options.loaned_message_pool_size);
+    ret = rcl_publisher_init(&publisher, this->node_ptr, ts, "chatter", &publisher_options);
+    ASSERT_EQ(RCL_RET_OK, ret) << rcl_get_error_string_safe();
+    ret = rcl_borrow_loaned_message(&publisher, &loaned_message);
+    EXPECT_EQ(RCL_RET_PUBLISHER_LOAN_FAILED, ret);
+    rcl_reset_error();
+    ret = rcl_publisher_fini(&publisher, this->node_ptr);
+    EXPECT_EQ(RCL_RET_OK, ret) << rcl_get_error_string_safe();
+  }
+  rcl_publisher_t publisher = rcl_get_zero_initialized_publisher();
+  rcl_publisher_options_t publisher_options = rcl_publisher_get_default_options();
+  publisher_options.loaned_message_pool_size = 2;
+  ret = rcl_publisher_init(&publisher, this->node_ptr, ts, "chatter", &publisher_options);
+  ASSERT_EQ(RCL_RET_OK, ret) << rcl_get_error_string_safe();
+  OSRF_TESTING_TOOLS_CPP_SCOPE_EXIT({
+    rcl_ret_t ret = rcl_publisher_fini(&publisher, this->node_ptr);
+    EXPECT_EQ(RCL_RET_OK, ret) << rcl_get_error_string_safe();
+  });
+  void * other_loaned_message = nullptr;
+  ret = rcl_borrow_loaned_message(&publisher, &loaned_message);
+  ASSERT_EQ(RCL_RET_OK, ret) << rcl_get_error_string_safe();
+  ret = rcl_borrow_loaned_message(&publisher, &other_loaned_message);
+  ASSERT_EQ(RCL_RET_OK, ret) << rcl_get_error_string_safe();
+  EXPECT_NE(loaned_message, other_loaned_message);
+  void * no_message = nullptr;
+  ret = rcl_borrow_loaned_message(&publisher, &no_message);
+  EXPECT_EQ(RCL_RET_PUBLISHER_LOAN_FAILED, ret);
+  rcl_reset_error();
+  // Messages are initialized, with empty strings.
+  auto msg = static_cast<test_msgs__msg__Primitives *>(loaned_message);
+  ASSERT_NE(nullptr, msg->string_value.data);
+  EXPECT_EQ(0u, msg->string_value.size);
+  msg->int64_value = 42;
+  ASSERT_TRUE(rosidl_generator_c__String__assign(&msg->string_value, "loaned"));
+  ret = rcl_publish_loaned_message(&publisher, loaned_message);
+  ASSERT_EQ(RCL_RET_OK, ret) << rcl_get_error_string_safe();
+  ret = rcl_return_loaned_message_from_publisher(&publisher, other_loaned_message);
+  ASSERT_EQ(RCL_RET_OK, ret) << rcl_get_error_string_safe();
+  // A message cannot be given back twice.
+  ret = rcl_return_loaned_message_from_publisher(&publisher, other_loaned_message);
+  EXPECT_EQ(RCL_RET_INVALID_ARGUMENT, ret);
+  rcl_reset_error();
+  // Nor can a message which was never loaned.
+  test_msgs__msg__Primitives not_loaned_message;
+  ret = rcl_return_loaned_message_from_publisher(&publisher, &not_loaned_message);
+  EXPECT_EQ(RCL_RET_INVALID_ARGUMENT, ret);
+  rcl_reset_error();
+  ret = rcl_borrow_loaned_message(&publisher, &loaned_message);
+  ASSERT_EQ(RCL_RET_OK, ret) << rcl_get_error_string_safe();
+  ret = rcl_return_loaned_message_from_publisher(&publisher, loaned_message);
+  ASSERT_EQ(RCL_RET_OK, ret) << rcl_get_error_string_safe();
+  ret = rcl_borrow_loaned_message(&publisher, nullptr);
+  EXPECT_EQ(RCL_RET_INVALID_ARGUMENT, ret);
+  rcl_reset_error();
+}
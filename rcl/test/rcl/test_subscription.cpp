@@ -26,6 +26,7 @@
 
 #include "osrf_testing_tools_cpp/scope_exit.hpp"
 #include "rcl/error_handling.h"
+#include "rmw/serialized_message.h"
 
 #ifdef RMW_IMPLEMENTATION
 # define CLASSNAME_(NAME, SUFFIX) NAME ## __ ## SUFFIX
@@ -216,3 +217,706 @@ TEST_F(CLASSNAME(TestSubscriptionFixture, RMW_IMPLEMENTATION), test_subscription
     ASSERT_EQ(std::string(test_string), std::string(msg.string_value.data, msg.string_value.size));
   }
 }
+
+/* Draining several messages with a single take call.
+ */
+TEST_F(CLASSNAME(TestSubscriptionFixture, RMW_IMPLEMENTATION), test_subscription_take_batch) {
+  rcl_ret_t ret;
+  rcl_publisher_t publisher = rcl_get_zero_initialized_publisher();
+  const rosidl_message_type_support_t * ts =
+    ROSIDL_GET_MSG_TYPE_SUPPORT(test_msgs, msg, Primitives);
+  const char * topic = "chatter_batch";
+  rcl_publisher_options_t publisher_options = rcl_publisher_get_default_options();
+  ret = rcl_publisher_init(&publisher, this->node_ptr, ts, topic, &publisher_options);
+  ASSERT_EQ(RCL_RET_OK, ret) << rcl_get_error_string_safe();
+  OSRF_TESTING_TOOLS_CPP_SCOPE_EXIT({
+    rcl_ret_t ret = rcl_publisher_fini(&publisher, this->node_ptr);
+    EXPECT_EQ(RCL_RET_OK, ret) << rcl_get_error_string_safe();
+  });
+  rcl_subscription_t subscription = rcl_get_zero_initialized_subscription();
+  rcl_subscription_options_t subscription_options = rcl_subscription_get_default_options();
+  ret = rcl_subscription_init(&subscription, this->node_ptr, ts, topic, &subscription_options);
+  ASSERT_EQ(RCL_RET_OK, ret) << rcl_get_error_string_safe();
+  OSRF_TESTING_TOOLS_CPP_SCOPE_EXIT({
+    rcl_ret_t ret = rcl_subscription_fini(&subscription, this->node_ptr);
+    EXPECT_EQ(RCL_RET_OK, ret) << rcl_get_error_string_safe();
+  });
+  const size_t capacity = 5;
+  test_msgs__msg__Primitives msgs[capacity];
+  void * msg_ptrs[capacity];
+  for (size_t i = 0; i < capacity; ++i) {
+    test_msgs__msg__Primitives__init(&msgs[i]);
+    msgs[i].int64_value = static_cast<int64_t>(i);
+    msg_ptrs[i] = &msgs[i];
+  }
+  OSRF_TESTING_TOOLS_CPP_SCOPE_EXIT({
+    for (size_t i = 0; i < capacity; ++i) {
+      test_msgs__msg__Primitives__fini(&msgs[i]);
+    }
+  });
+  rmw_message_info_t infos[capacity];
+  size_t taken = 42;
+  // Nothing has been published yet.
+  ret = rcl_take_batch(&subscription, msg_ptrs, infos, capacity, &taken);
+  EXPECT_EQ(RCL_RET_SUBSCRIPTION_TAKE_FAILED, ret) << rcl_get_error_string_safe();
+  EXPECT_EQ(0u, taken);
+  ret = rcl_take_batch(&subscription, nullptr, infos, capacity, &taken);
+  EXPECT_EQ(RCL_RET_INVALID_ARGUMENT, ret);
+  rcl_reset_error();
+  ret = rcl_take_batch(&subscription, msg_ptrs, infos, capacity, nullptr);
+  EXPECT_EQ(RCL_RET_INVALID_ARGUMENT, ret);
+  rcl_reset_error();
+  rcl_subscription_t invalid_subscription = rcl_get_zero_initialized_subscription();
+  ret = rcl_take_batch(&invalid_subscription, msg_ptrs, infos, capacity, &taken);
+  EXPECT_EQ(RCL_RET_SUBSCRIPTION_INVALID, ret);
+  rcl_reset_error();
+  ret = rcl_take_serialized_message_batch(&invalid_subscription, nullptr, nullptr, 1, &taken);
+  EXPECT_EQ(RCL_RET_SUBSCRIPTION_INVALID, ret);
+  rcl_reset_error();
+
+  // TODO(wjwwood): add logic to wait for the connection to be established
+  //                probably using the count_subscriptions busy wait mechanism
+  //                until then we will sleep for a short period of time
+  std::this_thread::sleep_for(std::chrono::milliseconds(1000));
+  const size_t published_count = 3;
+  size_t published = 0;
+  ret = rcl_publish_batch(&publisher, msg_ptrs, published_count, &published);
+  ASSERT_EQ(RCL_RET_OK, ret) << rcl_get_error_string_safe();
+  ASSERT_EQ(published_count, published);
+  for (size_t i = 0; i < capacity; ++i) {
+    msgs[i].int64_value = -1;
+  }
+  // The messages may not all arrive at once, so take until all were received.
+  size_t total_taken = 0;
+  for (size_t attempt = 0; attempt < 10 && total_taken < published_count; ++attempt) {
+    bool success;
+    wait_for_subscription_to_be_ready(&subscription, 10, 100, success);
+    ASSERT_TRUE(success);
+    ret = rcl_take_batch(
+      &subscription, msg_ptrs + total_taken, infos + total_taken, capacity - total_taken, &taken);
+    ASSERT_EQ(RCL_RET_OK, ret) << rcl_get_error_string_safe();
+    total_taken += taken;
+  }
+  ASSERT_EQ(published_count, total_taken);
+  for (size_t i = 0; i < published_count; ++i) {
+    EXPECT_EQ(static_cast<int64_t>(i), msgs[i].int64_value);
+  }
+  EXPECT_EQ(-1, msgs[published_count].int64_value);
+  ret = rcl_take_batch(&subscription, msg_ptrs, nullptr, capacity, &taken);
+  EXPECT_EQ(RCL_RET_SUBSCRIPTION_TAKE_FAILED, ret) << rcl_get_error_string_safe();
+  EXPECT_EQ(0u, taken);
+}
+
+/* Taking into messages loaned by the subscription.
+ */
+TEST_F(CLASSNAME(TestSubscriptionFixture, RMW_IMPLEMENTATION), test_subscription_loaned_messages) {
+  rcl_ret_t ret;
+  rcl_publisher_t publisher = rcl_get_zero_initialized_publisher();
+  const rosidl_message_type_support_t * ts =
+    ROSIDL_GET_MSG_TYPE_SUPPORT(test_msgs, msg, Primitives);
+  const char * topic = "chatter_loaned";
+  rcl_publisher_options_t publisher_options = rcl_publisher_get_default_options();
+  ret = rcl_publisher_init(&publisher, this->node_ptr, ts, topic, &publisher_options);
+  ASSERT_EQ(RCL_RET_OK, ret) << rcl_get_error_string_safe();
+  OSRF_TESTING_TOOLS_CPP_SCOPE_EXIT({
+    rcl_ret_t ret = rcl_publisher_fini(&publisher, this->node_ptr);
+    EXPECT_EQ(RCL_RET_OK, ret) << rcl_get_error_string_safe();
+  });
+  rcl_subscription_t subscription = rcl_get_zero_initialized_subscription();
+  rcl_subscription_options_t subscription_options = rcl_subscription_get_default_options();
+  ret = rcl_subscription_init(&subscription, this->node_ptr, ts, topic, &subscription_options);
+  ASSERT_EQ(RCL_RET_OK, ret) << rcl_get_error_string_safe();
+  OSRF_TESTING_TOOLS_CPP_SCOPE_EXIT({
+    rcl_ret_t ret = rcl_subscription_fini(&subscription, this->node_ptr);
+    EXPECT_EQ(RCL_RET_OK, ret) << rcl_get_error_string_safe();
+  });
+  void * loaned_message = nullptr;
+  ret = rcl_take_loaned_message(&subscription, &loaned_message, nullptr);
+  EXPECT_EQ(RCL_RET_SUBSCRIPTION_TAKE_FAILED, ret) << rcl_get_error_string_safe();
+  EXPECT_EQ(nullptr, loaned_message);
+  rcl_reset_error();
+
+  // TODO(wjwwood): add logic to wait for the connection to be established
+  //                probably using the count_subscriptions busy wait mechanism
+  //                until then we will sleep for a short period of time
+  std::this_thread::sleep_for(std::chrono::milliseconds(1000));
+  {
+    test_msgs__msg__Primitives msg;
+    test_msgs__msg__Primitives__init(&msg);
+    msg.int64_value = 42;
+    ASSERT_TRUE(rosidl_generator_c__String__assign(&msg.string_value, "loaned"));
+    ret = rcl_publish(&publisher, &msg);
+    test_msgs__msg__Primitives__fini(&msg);
+    ASSERT_EQ(RCL_RET_OK, ret) << rcl_get_error_string_safe();
+  }
+  bool success;
+  wait_for_subscription_to_be_ready(&subscription, 10, 100, success);
+  ASSERT_TRUE(success);
+  ret = rcl_take_loaned_message(&subscription, &loaned_message, nullptr);
+  ASSERT_EQ(RCL_RET_OK, ret) << rcl_get_error_string_safe();
+  ASSERT_NE(nullptr, loaned_message);
+  auto msg = static_cast<test_msgs__msg__Primitives *>(loaned_message);
+  EXPECT_EQ(42, msg->int64_value);
+  EXPECT_EQ(std::string("loaned"), std::string(msg->string_value.data, msg->string_value.size));
+  ret = rcl_return_loaned_message_from_subscription(&subscription, loaned_message);
+  ASSERT_EQ(RCL_RET_OK, ret) << rcl_get_error_string_safe();
+  ret = rcl_return_loaned_message_from_subscription(&subscription, loaned_message);
+  EXPECT_EQ(RCL_RET_INVALID_ARGUMENT, ret);
+  rcl_reset_error();
+}
+
+/* A preallocated message pool has a fixed size.
+ */
+TEST_F(CLASSNAME(TestSubscriptionFixture, RMW_IMPLEMENTATION), test_subscription_message_pool) {
+  rcl_ret_t ret;
+  rcl_publisher_t publisher = rcl_get_zero_initialized_publisher();
+  const rosidl_message_type_support_t * ts =
+    ROSIDL_GET_MSG_TYPE_SUPPORT(test_msgs, msg, Primitives);
+  const char * topic = "chatter_pool";
+  rcl_publisher_options_t publisher_options = rcl_publisher_get_default_options();
+  ret = rcl_publisher_init(&publisher, this->node_ptr, ts, topic, &publisher_options);
+  ASSERT_EQ(RCL_RET_OK, ret) << rcl_get_error_string_safe();
+  OSRF_TESTING_TOOLS_CPP_SCOPE_EXIT({
+    rcl_ret_t ret = rcl_publisher_fini(&publisher, this->node_ptr);
+    EXPECT_EQ(RCL_RET_OK, ret) << rcl_get_error_string_safe();
+  });
+  rcl_subscription_t subscription = rcl_get_zero_initialized_subscription();
+  rcl_subscription_options_t subscription_options = rcl_subscription_get_default_options();
+  EXPECT_EQ(0u, subscription_options.message_pool_size);
+  subscription_options.message_pool_size = 1;
+  ret = rcl_subscription_init(&subscription, this->node_ptr, ts, topic, &subscription_options);
+  ASSERT_EQ(RCL_RET_OK, ret) << rcl_get_error_string_safe();
+  OSRF_TESTING_TOOLS_CPP_SCOPE_EXIT({
+    rcl_ret_t ret = rcl_subscription_fini(&subscription, this->node_ptr);
+    EXPECT_EQ(RCL_RET_OK, ret) << rcl_get_error_string_safe();
+  });
+
+  // TODO(wjwwood): add logic to wait for the connection to be established
+  //                probably using the count_subscriptions busy wait mechanism
+  //                until then we will sleep for a short period of time
+  std::this_thread::sleep_for(std::chrono::milliseconds(1000));
+  for (int64_t i = 1; i <= 2; ++i) {
+    test_msgs__msg__Primitives msg;
+    test_msgs__msg__Primitives__init(&msg);
+    msg.int64_value = i;
+    ret = rcl_publish(&publisher, &msg);
+    test_msgs__msg__Primitives__fini(&msg);
+    ASSERT_EQ(RCL_RET_OK, ret) << rcl_get_error_string_safe();
+  }
+  bool success;
+  wait_for_subscription_to_be_ready(&subscription, 10, 100, success);
+  ASSERT_TRUE(success);
+  void * loaned_message = nullptr;
+  ret = rcl_take_loaned_message(&subscription, &loaned_message, nullptr);
+  ASSERT_EQ(RCL_RET_OK, ret) << rcl_get_error_string_safe();
+  EXPECT_EQ(1, static_cast<test_msgs__msg__Primitives *>(loaned_message)->int64_value);
+  // The only message of the pool is loaned, so nothing is taken.
+  void * other_loaned_message = nullptr;
+  ret = rcl_take_loaned_message(&subscription, &other_loaned_message, nullptr);
+  EXPECT_EQ(RCL_RET_SUBSCRIPTION_LOAN_FAILED, ret);
+  rcl_reset_error();
+  ret = rcl_return_loaned_message_from_subscription(&subscription, loaned_message);
+  ASSERT_EQ(RCL_RET_OK, ret) << rcl_get_error_string_safe();
+  // The second message is still there once the message is given back.
+  wait_for_subscription_to_be_ready(&subscription, 10, 100, success);
+  ASSERT_TRUE(success);
+  ret = rcl_take_loaned_message(&subscription, &other_loaned_message, nullptr);
+  ASSERT_EQ(RCL_RET_OK, ret) << rcl_get_error_string_safe();
+  EXPECT_EQ(loaned_message, other_loaned_message);
+  EXPECT_EQ(2, static_cast<test_msgs__msg__Primitives *>(other_loaned_message)->int64_value);
+  ret = rcl_return_loaned_message_from_subscription(&subscription, other_loaned_message);
+  ASSERT_EQ(RCL_RET_OK, ret) << rcl_get_error_string_safe();
+}
+
+/* Publishers and subscriptions of the same process exchange messages without the middleware.
+ */
+TEST_F(CLASSNAME(TestSubscriptionFixture, RMW_IMPLEMENTATION), test_subscription_intra_process) {
+  rcl_ret_t ret;
+  rcl_publisher_t publisher = rcl_get_zero_initialized_publisher();
+  const rosidl_message_type_support_t * ts =
+    ROSIDL_GET_MSG_TYPE_SUPPORT(test_msgs, msg, Primitives);
+  const char * topic = "chatter_intra_process";
+  rcl_publisher_options_t publisher_options = rcl_publisher_get_default_options();
+  EXPECT_FALSE(publisher_options.intra_process);
+  publisher_options.intra_process = true;
+  ret = rcl_publisher_init(&publisher, this->node_ptr, ts, topic, &publisher_options);
+  ASSERT_EQ(RCL_RET_OK, ret) << rcl_get_error_string_safe();
+  OSRF_TESTING_TOOLS_CPP_SCOPE_EXIT({
+    rcl_ret_t ret = rcl_publisher_fini(&publisher, this->node_ptr);
+    EXPECT_EQ(RCL_RET_OK, ret) << rcl_get_error_string_safe();
+  });
+  rcl_subscription_t subscription = rcl_get_zero_initialized_subscription();
+  rcl_subscription_options_t subscription_options = rcl_subscription_get_default_options();
+  EXPECT_FALSE(subscription_options.intra_process);
+  subscription_options.intra_process = true;
+  ret = rcl_subscription_init(&subscription, this->node_ptr, ts, topic, &subscription_options);
+  ASSERT_EQ(RCL_RET_OK, ret) << rcl_get_error_string_safe();
+  OSRF_TESTING_TOOLS_CPP_SCOPE_EXIT({
+    rcl_ret_t ret = rcl_subscription_fini(&subscription, this->node_ptr);
+    EXPECT_EQ(RCL_RET_OK, ret) << rcl_get_error_string_safe();
+  });
+
+  // A loaned message is handed to the subscription as is.
+  void * published_message = nullptr;
+  ret = rcl_borrow_loaned_message(&publisher, &published_message);
+  ASSERT_EQ(RCL_RET_OK, ret) << rcl_get_error_string_safe();
+  {
+    auto msg = static_cast<test_msgs__msg__Primitives *>(published_message);
+    msg->int64_value = 42;
+    ASSERT_TRUE(rosidl_generator_c__String__assign(&msg->string_value, "intra"));
+  }
+  ret = rcl_publish_loaned_message(&publisher, published_message);
+  ASSERT_EQ(RCL_RET_OK, ret) << rcl_get_error_string_safe();
+  bool success;
+  wait_for_subscription_to_be_ready(&subscription, 10, 100, success);
+  ASSERT_TRUE(success);
+  void * loaned_message = nullptr;
+  rmw_message_info_t message_info;
+  ret = rcl_take_loaned_message(&subscription, &loaned_message, &message_info);
+  ASSERT_EQ(RCL_RET_OK, ret) << rcl_get_error_string_safe();
+  EXPECT_EQ(published_message, loaned_message);
+  EXPECT_TRUE(message_info.from_intra_process);
+  auto msg = static_cast<test_msgs__msg__Primitives *>(loaned_message);
+  EXPECT_EQ(42, msg->int64_value);
+  EXPECT_EQ(std::string("intra"), std::string(msg->string_value.data, msg->string_value.size));
+  ret = rcl_return_loaned_message_from_subscription(&subscription, loaned_message);
+  ASSERT_EQ(RCL_RET_OK, ret) << rcl_get_error_string_safe();
+
+  // A published message is copied once, and is not received again through the middleware.
+  {
+    test_msgs__msg__Primitives msg;
+    test_msgs__msg__Primitives__init(&msg);
+    msg.int64_value = 7;
+    ASSERT_TRUE(rosidl_generator_c__String__assign(&msg.string_value, "copied"));
+    ret = rcl_publish(&publisher, &msg);
+    test_msgs__msg__Primitives__fini(&msg);
+    ASSERT_EQ(RCL_RET_OK, ret) << rcl_get_error_string_safe();
+  }
+  wait_for_subscription_to_be_ready(&subscription, 10, 100, success);
+  ASSERT_TRUE(success);
+  {
+    test_msgs__msg__Primitives msg;
+    test_msgs__msg__Primitives__init(&msg);
+    OSRF_TESTING_TOOLS_CPP_SCOPE_EXIT({
+      test_msgs__msg__Primitives__fini(&msg);
+    });
+    ret = rcl_take(&subscription, &msg, nullptr);
+    ASSERT_EQ(RCL_RET_OK, ret) << rcl_get_error_string_safe();
+    EXPECT_EQ(7, msg.int64_value);
+    EXPECT_EQ(std::string("copied"), std::string(msg.string_value.data, msg.string_value.size));
+    ret = rcl_take(&subscription, &msg, nullptr);
+    EXPECT_EQ(RCL_RET_SUBSCRIPTION_TAKE_FAILED, ret) << rcl_get_error_string_safe();
+  }
+}
+
+/* Serialized messages are received by the linked subscriptions, and only once.
+ */
+TEST_F(
+  CLASSNAME(TestSubscriptionFixture, RMW_IMPLEMENTATION),
+  test_subscription_intra_process_serialized)
+{
+  rcl_ret_t ret;
+  rcl_publisher_t publisher = rcl_get_zero_initialized_publisher();
+  const rosidl_message_type_support_t * ts =
+    ROSIDL_GET_MSG_TYPE_SUPPORT(test_msgs, msg, Primitives);
+  const char * topic = "chatter_intra_process_serialized";
+  rcl_publisher_options_t publisher_options = rcl_publisher_get_default_options();
+  publisher_options.intra_process = true;
+  ret = rcl_publisher_init(&publisher, this->node_ptr, ts, topic, &publisher_options);
+  ASSERT_EQ(RCL_RET_OK, ret) << rcl_get_error_string_safe();
+  OSRF_TESTING_TOOLS_CPP_SCOPE_EXIT({
+    rcl_ret_t ret = rcl_publisher_fini(&publisher, this->node_ptr);
+    EXPECT_EQ(RCL_RET_OK, ret) << rcl_get_error_string_safe();
+  });
+  rcl_subscription_t subscription = rcl_get_zero_initialized_subscription();
+  rcl_subscription_options_t subscription_options = rcl_subscription_get_default_options();
+  subscription_options.intra_process = true;
+  ret = rcl_subscription_init(&subscription, this->node_ptr, ts, topic, &subscription_options);
+  ASSERT_EQ(RCL_RET_OK, ret) << rcl_get_error_string_safe();
+  OSRF_TESTING_TOOLS_CPP_SCOPE_EXIT({
+    rcl_ret_t ret = rcl_subscription_fini(&subscription, this->node_ptr);
+    EXPECT_EQ(RCL_RET_OK, ret) << rcl_get_error_string_safe();
+  });
+
+  rcl_allocator_t allocator = rcl_get_default_allocator();
+  rcl_serialized_message_t serialized_msg = rmw_get_zero_initialized_serialized_message();
+  ASSERT_EQ(RMW_RET_OK, rmw_serialized_message_init(&serialized_msg, 0u, &allocator));
+  OSRF_TESTING_TOOLS_CPP_SCOPE_EXIT({
+    EXPECT_EQ(RMW_RET_OK, rmw_serialized_message_fini(&serialized_msg));
+  });
+  {
+    test_msgs__msg__Primitives msg;
+    test_msgs__msg__Primitives__init(&msg);
+    msg.int64_value = 13;
+    ASSERT_TRUE(rosidl_generator_c__String__assign(&msg.string_value, "serialized"));
+    rmw_ret_t rmw_ret = rmw_serialize(&msg, ts, &serialized_msg);
+    test_msgs__msg__Primitives__fini(&msg);
+    ASSERT_EQ(RMW_RET_OK, rmw_ret) << rmw_get_error_string_safe();
+  }
+  ret = rcl_publish_serialized_message(&publisher, &serialized_msg);
+  ASSERT_EQ(RCL_RET_OK, ret) << rcl_get_error_string_safe();
+  bool success;
+  wait_for_subscription_to_be_ready(&subscription, 10, 100, success);
+  ASSERT_TRUE(success);
+  test_msgs__msg__Primitives msg;
+  test_msgs__msg__Primitives__init(&msg);
+  OSRF_TESTING_TOOLS_CPP_SCOPE_EXIT({
+    test_msgs__msg__Primitives__fini(&msg);
+  });
+  rmw_message_info_t message_info;
+  ret = rcl_take(&subscription, &msg, &message_info);
+  ASSERT_EQ(RCL_RET_OK, ret) << rcl_get_error_string_safe();
+  EXPECT_TRUE(message_info.from_intra_process);
+  EXPECT_EQ(13, msg.int64_value);
+  EXPECT_EQ(
+    std::string("serialized"), std::string(msg.string_value.data, msg.string_value.size));
+  // A copy published through the middleware, if any, is not taken again.
+  std::this_thread::sleep_for(std::chrono::milliseconds(100));
+  ret = rcl_take(&subscription, &msg, nullptr);
+  EXPECT_EQ(RCL_RET_SUBSCRIPTION_TAKE_FAILED, ret) << rcl_get_error_string_safe();
+}
+
+/* Intra-process messages queued before waiting each make rcl_wait() return.
+ */
+TEST_F(
+  CLASSNAME(TestSubscriptionFixture, RMW_IMPLEMENTATION), test_subscription_intra_process_queued)
+{
+  rcl_ret_t ret;
+  rcl_publisher_t publisher = rcl_get_zero_initialized_publisher();
+  const rosidl_message_type_support_t * ts =
+    ROSIDL_GET_MSG_TYPE_SUPPORT(test_msgs, msg, Primitives);
+  const char * topic = "chatter_intra_process_queued";
+  rcl_publisher_options_t publisher_options = rcl_publisher_get_default_options();
+  publisher_options.intra_process = true;
+  ret = rcl_publisher_init(&publisher, this->node_ptr, ts, topic, &publisher_options);
+  ASSERT_EQ(RCL_RET_OK, ret) << rcl_get_error_string_safe();
+  OSRF_TESTING_TOOLS_CPP_SCOPE_EXIT({
+    rcl_ret_t ret = rcl_publisher_fini(&publisher, this->node_ptr);
+    EXPECT_EQ(RCL_RET_OK, ret) << rcl_get_error_string_safe();
+  });
+  rcl_subscription_t subscription = rcl_get_zero_initialized_subscription();
+  rcl_subscription_options_t subscription_options = rcl_subscription_get_default_options();
+  subscription_options.intra_process = true;
+  ret = rcl_subscription_init(&subscription, this->node_ptr, ts, topic, &subscription_options);
+  ASSERT_EQ(RCL_RET_OK, ret) << rcl_get_error_string_safe();
+  OSRF_TESTING_TOOLS_CPP_SCOPE_EXIT({
+    rcl_ret_t ret = rcl_subscription_fini(&subscription, this->node_ptr);
+    EXPECT_EQ(RCL_RET_OK, ret) << rcl_get_error_string_safe();
+  });
+  rcl_wait_set_t wait_set = rcl_get_zero_initialized_wait_set();
+  ret = rcl_wait_set_init(&wait_set, 1, 0, 0, 0, 0, rcl_get_default_allocator());
+  ASSERT_EQ(RCL_RET_OK, ret) << rcl_get_error_string_safe();
+  OSRF_TESTING_TOOLS_CPP_SCOPE_EXIT({
+    rcl_ret_t ret = rcl_wait_set_fini(&wait_set);
+    EXPECT_EQ(RCL_RET_OK, ret) << rcl_get_error_string_safe();
+  });
+
+  test_msgs__msg__Primitives msg;
+  test_msgs__msg__Primitives__init(&msg);
+  OSRF_TESTING_TOOLS_CPP_SCOPE_EXIT({
+    test_msgs__msg__Primitives__fini(&msg);
+  });
+  const int64_t number_of_messages = 3;
+  for (int64_t i = 0; i < number_of_messages; ++i) {
+    msg.int64_value = i;
+    ret = rcl_publish(&publisher, &msg);
+    ASSERT_EQ(RCL_RET_OK, ret) << rcl_get_error_string_safe();
+  }
+  // The guard condition was triggered before waiting, but each wait must
+  // still report the subscription as long as messages are queued.
+  for (int64_t i = 0; i < number_of_messages; ++i) {
+    ret = rcl_wait_set_clear(&wait_set);
+    ASSERT_EQ(RCL_RET_OK, ret) << rcl_get_error_string_safe();
+    ret = rcl_wait_set_add_subscription(&wait_set, &subscription);
+    ASSERT_EQ(RCL_RET_OK, ret) << rcl_get_error_string_safe();
+    ret = rcl_wait(&wait_set, RCL_MS_TO_NS(100));
+    ASSERT_EQ(RCL_RET_OK, ret) << rcl_get_error_string_safe();
+    ASSERT_EQ(&subscription, wait_set.subscriptions[0]);
+    ret = rcl_take(&subscription, &msg, nullptr);
+    ASSERT_EQ(RCL_RET_OK, ret) << rcl_get_error_string_safe();
+    EXPECT_EQ(i, msg.int64_value);
+  }
+  ret = rcl_wait_set_clear(&wait_set);
+  ASSERT_EQ(RCL_RET_OK, ret) << rcl_get_error_string_safe();
+  ret = rcl_wait_set_add_subscription(&wait_set, &subscription);
+  ASSERT_EQ(RCL_RET_OK, ret) << rcl_get_error_string_safe();
+  ret = rcl_wait(&wait_set, RCL_MS_TO_NS(10));
+  EXPECT_EQ(RCL_RET_TIMEOUT, ret) << rcl_get_error_string_safe();
+}
+
+/* Publishers and subscriptions count their traffic when asked to.
+ */
+TEST_F(CLASSNAME(TestSubscriptionFixture, RMW_IMPLEMENTATION), test_subscription_statistics) {
+  rcl_ret_t ret;
+  rcl_publisher_t publisher = rcl_get_zero_initialized_publisher();
+  const rosidl_message_type_support_t * ts =
+    ROSIDL_GET_MSG_TYPE_SUPPORT(test_msgs, msg, Primitives);
+  const char * topic = "chatter_statistics";
+  rcl_publisher_options_t publisher_options = rcl_publisher_get_default_options();
+  EXPECT_FALSE(publisher_options.enable_statistics);
+  publisher_options.enable_statistics = true;
+  ret = rcl_publisher_init(&publisher, this->node_ptr, ts, topic, &publisher_options);
+  ASSERT_EQ(RCL_RET_OK, ret) << rcl_get_error_string_safe();
+  OSRF_TESTING_TOOLS_CPP_SCOPE_EXIT({
+    rcl_ret_t ret = rcl_publisher_fini(&publisher, this->node_ptr);
+    EXPECT_EQ(RCL_RET_OK, ret) << rcl_get_error_string_safe();
+  });
+  rcl_subscription_t subscription = rcl_get_zero_initialized_subscription();
+  rcl_subscription_options_t subscription_options = rcl_subscription_get_default_options();
+  ret = rcl_subscription_init(&subscription, this->node_ptr, ts, topic, &subscription_options);
+  ASSERT_EQ(RCL_RET_OK, ret) << rcl_get_error_string_safe();
+  // Statistics are only kept when enabled.
+  rcl_subscription_statistics_t subscription_statistics;
+  ret = rcl_subscription_get_statistics(&subscription, &subscription_statistics);
+  EXPECT_EQ(RCL_RET_ERROR, ret);
+  rcl_reset_error();
+  ret = rcl_subscription_fini(&subscription, this->node_ptr);
+  ASSERT_EQ(RCL_RET_OK, ret) << rcl_get_error_string_safe();
+  subscription = rcl_get_zero_initialized_subscription();
+  subscription_options.enable_statistics = true;
+  ret = rcl_subscription_init(&subscription, this->node_ptr, ts, topic, &subscription_options);
+  ASSERT_EQ(RCL_RET_OK, ret) << rcl_get_error_string_safe();
+  OSRF_TESTING_TOOLS_CPP_SCOPE_EXIT({
+    rcl_ret_t ret = rcl_subscription_fini(&subscription, this->node_ptr);
+    EXPECT_EQ(RCL_RET_OK, ret) << rcl_get_error_string_safe();
+  });
+
+  // TODO(wjwwood): add logic to wait for the connection to be established
+  //                probably using the count_subscriptions busy wait mechanism
+  //                until then we will sleep for a short period of time
+  std::this_thread::sleep_for(std::chrono::milliseconds(1000));
+  test_msgs__msg__Primitives msg;
+  test_msgs__msg__Primitives__init(&msg);
+  OSRF_TESTING_TOOLS_CPP_SCOPE_EXIT({
+    test_msgs__msg__Primitives__fini(&msg);
+  });
+  for (int64_t i = 0; i < 2; ++i) {
+    msg.int64_value = i;
+    ret = rcl_publish(&publisher, &msg);
+    ASSERT_EQ(RCL_RET_OK, ret) << rcl_get_error_string_safe();
+  }
+  rcl_publisher_statistics_t publisher_statistics;
+  ret = rcl_publisher_get_statistics(&publisher, &publisher_statistics);
+  ASSERT_EQ(RCL_RET_OK, ret) << rcl_get_error_string_safe();
+  EXPECT_EQ(2u, publisher_statistics.number_of_messages);
+  EXPECT_EQ(0u, publisher_statistics.serialized_bytes);
+  EXPECT_EQ(0u, publisher_statistics.number_of_failed_publishes);
+  uint64_t number_of_intervals = 0;
+  for (size_t i = 0; i < RCL_PUBLISHER_INTERVAL_HISTOGRAM_SIZE; ++i) {
+    number_of_intervals += publisher_statistics.interval_histogram[i];
+  }
+  EXPECT_EQ(1u, number_of_intervals);
+
+  size_t taken = 0;
+  for (size_t attempt = 0; taken < 2 && attempt < 10; ++attempt) {
+    bool success;
+    wait_for_subscription_to_be_ready(&subscription, 10, 100, success);
+    ASSERT_TRUE(success);
+    ret = rcl_take(&subscription, &msg, nullptr);
+    if (RCL_RET_OK == ret) {
+      ++taken;
+    } else {
+      ASSERT_EQ(RCL_RET_SUBSCRIPTION_TAKE_FAILED, ret) << rcl_get_error_string_safe();
+    }
+  }
+  ASSERT_EQ(2u, taken);
+  ret = rcl_take(&subscription, &msg, nullptr);
+  EXPECT_EQ(RCL_RET_SUBSCRIPTION_TAKE_FAILED, ret) << rcl_get_error_string_safe();
+  ret = rcl_subscription_get_statistics(&subscription, &subscription_statistics);
+  ASSERT_EQ(RCL_RET_OK, ret) << rcl_get_error_string_safe();
+  EXPECT_EQ(2u, subscription_statistics.number_of_messages);
+  EXPECT_GE(subscription_statistics.number_of_failed_takes, 1u);
+  EXPECT_EQ(0u, subscription_statistics.number_of_dropped_messages);
+
+  ret = rcl_subscription_reset_statistics(&subscription);
+  ASSERT_EQ(RCL_RET_OK, ret) << rcl_get_error_string_safe();
+  ret = rcl_subscription_get_statistics(&subscription, &subscription_statistics);
+  ASSERT_EQ(RCL_RET_OK, ret) << rcl_get_error_string_safe();
+  EXPECT_EQ(0u, subscription_statistics.number_of_messages);
+  EXPECT_EQ(0u, subscription_statistics.number_of_failed_takes);
+}
+
+/* Intra-process messages dropped from a full queue, and failed publishes, are counted.
+ */
+TEST_F(
+  CLASSNAME(TestSubscriptionFixture, RMW_IMPLEMENTATION), test_subscription_intra_process_drops)
+{
+  rcl_ret_t ret;
+  rcl_publisher_t publisher = rcl_get_zero_initialized_publisher();
+  const rosidl_message_type_support_t * ts =
+    ROSIDL_GET_MSG_TYPE_SUPPORT(test_msgs, msg, Primitives);
+  const char * topic = "chatter_intra_process_drops";
+  rcl_publisher_options_t publisher_options = rcl_publisher_get_default_options();
+  publisher_options.intra_process = true;
+  publisher_options.enable_statistics = true;
+  ret = rcl_publisher_init(&publisher, this->node_ptr, ts, topic, &publisher_options);
+  ASSERT_EQ(RCL_RET_OK, ret) << rcl_get_error_string_safe();
+  OSRF_TESTING_TOOLS_CPP_SCOPE_EXIT({
+    rcl_ret_t ret = rcl_publisher_fini(&publisher, this->node_ptr);
+    EXPECT_EQ(RCL_RET_OK, ret) << rcl_get_error_string_safe();
+  });
+  rcl_subscription_t subscription = rcl_get_zero_initialized_subscription();
+  rcl_subscription_options_t subscription_options = rcl_subscription_get_default_options();
+  subscription_options.qos.history = RMW_QOS_POLICY_HISTORY_KEEP_LAST;
+  subscription_options.qos.depth = 2;
+  subscription_options.intra_process = true;
+  subscription_options.enable_statistics = true;
+  ret = rcl_subscription_init(&subscription, this->node_ptr, ts, topic, &subscription_options);
+  ASSERT_EQ(RCL_RET_OK, ret) << rcl_get_error_string_safe();
+  OSRF_TESTING_TOOLS_CPP_SCOPE_EXIT({
+    rcl_ret_t ret = rcl_subscription_fini(&subscription, this->node_ptr);
+    EXPECT_EQ(RCL_RET_OK, ret) << rcl_get_error_string_safe();
+  });
+
+  // The queue keeps the two last messages, the older ones are dropped.
+  test_msgs__msg__Primitives msg;
+  test_msgs__msg__Primitives__init(&msg);
+  OSRF_TESTING_TOOLS_CPP_SCOPE_EXIT({
+    test_msgs__msg__Primitives__fini(&msg);
+  });
+  for (int64_t i = 0; i < 5; ++i) {
+    msg.int64_value = i;
+    ret = rcl_publish(&publisher, &msg);
+    ASSERT_EQ(RCL_RET_OK, ret) << rcl_get_error_string_safe();
+  }
+  for (int64_t i = 3; i < 5; ++i) {
+    ret = rcl_take(&subscription, &msg, nullptr);
+    ASSERT_EQ(RCL_RET_OK, ret) << rcl_get_error_string_safe();
+    EXPECT_EQ(i, msg.int64_value);
+  }
+  rcl_subscription_statistics_t subscription_statistics;
+  ret = rcl_subscription_get_statistics(&subscription, &subscription_statistics);
+  ASSERT_EQ(RCL_RET_OK, ret) << rcl_get_error_string_safe();
+  EXPECT_EQ(2u, subscription_statistics.number_of_messages);
+  EXPECT_EQ(3u, subscription_statistics.number_of_dropped_messages);
+  ret = rcl_subscription_reset_statistics(&subscription);
+  ASSERT_EQ(RCL_RET_OK, ret) << rcl_get_error_string_safe();
+  ret = rcl_subscription_get_statistics(&subscription, &subscription_statistics);
+  ASSERT_EQ(RCL_RET_OK, ret) << rcl_get_error_string_safe();
+  EXPECT_EQ(0u, subscription_statistics.number_of_dropped_messages);
+
+  // A message which is not loaned from the topic cannot be published as a loaned message.
+  ret = rcl_publish_loaned_message(&publisher, &msg);
+  EXPECT_EQ(RCL_RET_INVALID_ARGUMENT, ret);
+  rcl_reset_error();
+  rcl_publisher_statistics_t publisher_statistics;
+  ret = rcl_publisher_get_statistics(&publisher, &publisher_statistics);
+  ASSERT_EQ(RCL_RET_OK, ret) << rcl_get_error_string_safe();
+  EXPECT_EQ(5u, publisher_statistics.number_of_messages);
+  EXPECT_EQ(1u, publisher_statistics.number_of_failed_publishes);
+  ret = rcl_publisher_reset_statistics(&publisher);
+  ASSERT_EQ(RCL_RET_OK, ret) << rcl_get_error_string_safe();
+  ret = rcl_publisher_get_statistics(&publisher, &publisher_statistics);
+  ASSERT_EQ(RCL_RET_OK, ret) << rcl_get_error_string_safe();
+  EXPECT_EQ(0u, publisher_statistics.number_of_failed_publishes);
+}
+
+/* Subscriptions measure the latency of the messages with a timestamp.
+ */
+TEST_F(CLASSNAME(TestSubscriptionFixture, RMW_IMPLEMENTATION), test_subscription_latency) {
+  rcl_ret_t ret;
+  rcl_publisher_t publisher = rcl_get_zero_initialized_publisher();
+  const rosidl_message_type_support_t * ts =
+    ROSIDL_GET_MSG_TYPE_SUPPORT(test_msgs, msg, Primitives);
+  const char * topic = "chatter_latency";
+  rcl_publisher_options_t publisher_options = rcl_publisher_get_default_options();
+  // The message type has no header to stamp.
+  EXPECT_FALSE(publisher_options.stamp_header);
+  publisher_options.stamp_header = true;
+  ret = rcl_publisher_init(&publisher, this->node_ptr, ts, topic, &publisher_options);
+  EXPECT_EQ(RCL_RET_INVALID_ARGUMENT, ret);
+  rcl_reset_error();
+  publisher_options.stamp_header = false;
+  publisher_options.intra_process = true;
+  ret = rcl_publisher_init(&publisher, this->node_ptr, ts, topic, &publisher_options);
+  ASSERT_EQ(RCL_RET_OK, ret) << rcl_get_error_string_safe();
+  OSRF_TESTING_TOOLS_CPP_SCOPE_EXIT({
+    rcl_ret_t ret = rcl_publisher_fini(&publisher, this->node_ptr);
+    EXPECT_EQ(RCL_RET_OK, ret) << rcl_get_error_string_safe();
+  });
+  rcl_subscription_t subscription = rcl_get_zero_initialized_subscription();
+  rcl_subscription_options_t subscription_options = rcl_subscription_get_default_options();
+  EXPECT_FALSE(subscription_options.measure_latency);
+  subscription_options.measure_latency = true;
+  subscription_options.intra_process = true;
+  // The message type has no header stamp to measure.
+  EXPECT_FALSE(subscription_options.measure_header_stamp);
+  subscription_options.measure_header_stamp = true;
+  ret = rcl_subscription_init(&subscription, this->node_ptr, ts, topic, &subscription_options);
+  EXPECT_EQ(RCL_RET_INVALID_ARGUMENT, ret);
+  rcl_reset_error();
+  subscription_options.measure_header_stamp = false;
+  ret = rcl_subscription_init(&subscription, this->node_ptr, ts, topic, &subscription_options);
+  ASSERT_EQ(RCL_RET_OK, ret) << rcl_get_error_string_safe();
+  OSRF_TESTING_TOOLS_CPP_SCOPE_EXIT({
+    rcl_ret_t ret = rcl_subscription_fini(&subscription, this->node_ptr);
+    EXPECT_EQ(RCL_RET_OK, ret) << rcl_get_error_string_safe();
+  });
+
+  // Intra-process messages carry the time they were published at.
+  test_msgs__msg__Primitives msg;
+  test_msgs__msg__Primitives__init(&msg);
+  OSRF_TESTING_TOOLS_CPP_SCOPE_EXIT({
+    test_msgs__msg__Primitives__fini(&msg);
+  });
+  const size_t number_of_messages = 3;
+  for (size_t i = 0; i < number_of_messages; ++i) {
+    ret = rcl_publish(&publisher, &msg);
+    ASSERT_EQ(RCL_RET_OK, ret) << rcl_get_error_string_safe();
+  }
+  for (size_t i = 0; i < number_of_messages; ++i) {
+    ret = rcl_take(&subscription, &msg, nullptr);
+    ASSERT_EQ(RCL_RET_OK, ret) << rcl_get_error_string_safe();
+  }
+  rcl_subscription_latency_statistics_t statistics;
+  ret = rcl_subscription_get_latency_statistics(&subscription, &statistics);
+  ASSERT_EQ(RCL_RET_OK, ret) << rcl_get_error_string_safe();
+  EXPECT_EQ(number_of_messages, statistics.number_of_samples);
+  EXPECT_EQ(0u, statistics.number_of_unstamped_messages);
+  EXPECT_LE(statistics.min_latency, statistics.mean_latency);
+  EXPECT_LE(statistics.mean_latency, statistics.max_latency);
+  int64_t p50 = 0;
+  ret = rcl_subscription_get_latency_percentile(&subscription, 50.0, &p50);
+  ASSERT_EQ(RCL_RET_OK, ret) << rcl_get_error_string_safe();
+  int64_t p100 = 0;
+  ret = rcl_subscription_get_latency_percentile(&subscription, 100.0, &p100);
+  ASSERT_EQ(RCL_RET_OK, ret) << rcl_get_error_string_safe();
+  EXPECT_LE(statistics.min_latency, p50);
+  EXPECT_LE(p50, p100);
+  EXPECT_EQ(statistics.max_latency, p100);
+  ret = rcl_subscription_get_latency_percentile(&subscription, 101.0, &p100);
+  EXPECT_EQ(RCL_RET_INVALID_ARGUMENT, ret);
+  rcl_reset_error();
+
+  ret = rcl_subscription_reset_latency_statistics(&subscription);
+  ASSERT_EQ(RCL_RET_OK, ret) << rcl_get_error_string_safe();
+  ret = rcl_subscription_get_latency_statistics(&subscription, &statistics);
+  ASSERT_EQ(RCL_RET_OK, ret) << rcl_get_error_string_safe();
+  EXPECT_EQ(0u, statistics.number_of_samples);
+  ret = rcl_subscription_get_latency_percentile(&subscription, 50.0, &p50);
+  ASSERT_EQ(RCL_RET_OK, ret) << rcl_get_error_string_safe();
+  EXPECT_EQ(0, p50);
+
+  // Messages from the middleware are not measured without the measure_header_stamp option.
+  rcl_publisher_t other_publisher = rcl_get_zero_initialized_publisher();
+  publisher_options = rcl_publisher_get_default_options();
+  ret = rcl_publisher_init(&other_publisher, this->node_ptr, ts, topic, &publisher_options);
+  ASSERT_EQ(RCL_RET_OK, ret) << rcl_get_error_string_safe();
+  OSRF_TESTING_TOOLS_CPP_SCOPE_EXIT({
+    rcl_ret_t ret = rcl_publisher_fini(&other_publisher, this->node_ptr);
+    EXPECT_EQ(RCL_RET_OK, ret) << rcl_get_error_string_safe();
+  });
+  // Give the middleware time to connect the new publisher.
+  std::this_thread::sleep_for(std::chrono::milliseconds(1000));
+  ret = rcl_publish(&other_publisher, &msg);
+  ASSERT_EQ(RCL_RET_OK, ret) << rcl_get_error_string_safe();
+  bool success;
+  wait_for_subscription_to_be_ready(&subscription, 10, 100, success);
+  ASSERT_TRUE(success);
+  ret = rcl_take(&subscription, &msg, nullptr);
+  ASSERT_EQ(RCL_RET_OK, ret) << rcl_get_error_string_safe();
+  ret = rcl_subscription_get_latency_statistics(&subscription, &statistics);
+  ASSERT_EQ(RCL_RET_OK, ret) << rcl_get_error_string_safe();
+  EXPECT_EQ(0u, statistics.number_of_samples);
+  EXPECT_EQ(1u, statistics.number_of_unstamped_messages);
+}
@@ -15,13 +15,22 @@
 #include <gtest/gtest.h>
 
 #include <inttypes.h>
+#ifndef _WIN32
+#include <unistd.h>
+#endif
 
+#include <atomic>
 #include <chrono>
+#include <cstdio>
+#include <random>
+#include <string>
 #include <thread>
+#include <vector>
 
 #include "osrf_testing_tools_cpp/memory_tools/memory_tools.hpp"
 #include "osrf_testing_tools_cpp/scope_exit.hpp"
 #include "rcl/error_handling.h"
+#include "rcl/rcl.h"
 #include "rcl/time.h"
 
 #ifdef RMW_IMPLEMENTATION
@@ -700,3 +709,371 @@ TEST(CLASSNAME(rcl_time, RMW_IMPLEMENTATION), add_remove_add_jump_callback) {
     rcl_get_error_string_safe();
   EXPECT_EQ(1u, clock->num_jump_callbacks);
 }
+
+static void counting_callback(const rcl_time_jump_t *, bool before_jump, void * user_data)
+{
+  if (!before_jump) {
+    ++*static_cast<std::atomic<size_t> *>(user_data);
+  }
+}
+
+TEST(CLASSNAME(rcl_time, RMW_IMPLEMENTATION), jump_callbacks_changed_while_called) {
+  rcl_allocator_t allocator = rcl_get_default_allocator();
+  rcl_clock_t ros_clock;
+  ASSERT_EQ(RCL_RET_OK, rcl_ros_clock_init(&ros_clock, &allocator)) <<
+    rcl_get_error_string_safe();
+  OSRF_TESTING_TOOLS_CPP_SCOPE_EXIT({
+    EXPECT_EQ(RCL_RET_OK, rcl_clock_fini(&ros_clock));
+  });
+  ASSERT_EQ(RCL_RET_OK, rcl_enable_ros_time_override(&ros_clock)) << rcl_get_error_string_safe();
+
+  rcl_jump_threshold_t threshold;
+  threshold.on_clock_change = false;
+  threshold.min_forward.nanoseconds = 1;
+  threshold.min_backward.nanoseconds = 0;
+  // A callback which stays added for the whole test.
+  std::atomic<size_t> steady_calls(0);
+  ASSERT_EQ(RCL_RET_OK,
+    rcl_clock_add_jump_callback(&ros_clock, threshold, counting_callback, &steady_calls)) <<
+    rcl_get_error_string_safe();
+
+  // Keep moving the time forward while other threads add and remove a thousand callbacks.
+  std::atomic<bool> done(false);
+  size_t number_of_jumps = 0;
+  std::thread jumping_thread([&ros_clock, &done, &number_of_jumps]() {
+      rcl_time_point_value_t time = 0;
+      while (!done) {
+        EXPECT_EQ(RCL_RET_OK, rcl_set_ros_time_override(&ros_clock, ++time));
+        ++number_of_jumps;
+      }
+    });
+  size_t number_of_threads = 4;
+  size_t callbacks_per_thread = 250;
+  std::vector<std::atomic<size_t>> counters(number_of_threads * callbacks_per_thread);
+  std::vector<std::thread> changing_threads;
+  for (size_t t = 0; t < number_of_threads; ++t) {
+    changing_threads.emplace_back([&ros_clock, &counters, threshold, t, callbacks_per_thread]() {
+        for (size_t i = t * callbacks_per_thread; i < (t + 1) * callbacks_per_thread; ++i) {
+          EXPECT_EQ(RCL_RET_OK, rcl_clock_add_jump_callback(
+              &ros_clock, threshold, counting_callback, &counters[i]));
+        }
+        for (size_t i = t * callbacks_per_thread; i < (t + 1) * callbacks_per_thread; ++i) {
+          EXPECT_EQ(RCL_RET_OK, rcl_clock_remove_jump_callback(
+              &ros_clock, counting_callback, &counters[i]));
+          // Removed callbacks are not called anymore.
+          size_t calls = counters[i];
+          std::this_thread::yield();
+          EXPECT_EQ(calls, counters[i]);
+        }
+      });
+  }
+  for (auto & thread : changing_threads) {
+    thread.join();
+  }
+  done = true;
+  jumping_thread.join();
+
+  EXPECT_EQ(1u, ros_clock.num_jump_callbacks);
+  EXPECT_EQ(number_of_jumps, steady_calls);
+  EXPECT_EQ(RCL_RET_OK,
+    rcl_clock_remove_jump_callback(&ros_clock, counting_callback, &steady_calls));
+}
+
+struct self_removing_callback_data
+{
+  rcl_clock_t * clock;
+  size_t calls;
+  rcl_ret_t ret;
+};
+
+static void self_removing_callback(const rcl_time_jump_t *, bool before_jump, void * user_data)
+{
+  if (before_jump) {
+    return;
+  }
+  auto data = static_cast<self_removing_callback_data *>(user_data);
+  ++data->calls;
+  data->ret = rcl_clock_remove_jump_callback(data->clock, self_removing_callback, user_data);
+}
+
+TEST(CLASSNAME(rcl_time, RMW_IMPLEMENTATION), jump_callback_removed_from_jump_callback) {
+  rcl_allocator_t allocator = rcl_get_default_allocator();
+  rcl_clock_t ros_clock;
+  ASSERT_EQ(RCL_RET_OK, rcl_ros_clock_init(&ros_clock, &allocator)) <<
+    rcl_get_error_string_safe();
+  OSRF_TESTING_TOOLS_CPP_SCOPE_EXIT({
+    EXPECT_EQ(RCL_RET_OK, rcl_clock_fini(&ros_clock));
+  });
+  ASSERT_EQ(RCL_RET_OK, rcl_enable_ros_time_override(&ros_clock)) << rcl_get_error_string_safe();
+
+  rcl_jump_threshold_t threshold;
+  threshold.on_clock_change = false;
+  threshold.min_forward.nanoseconds = 1;
+  threshold.min_backward.nanoseconds = 0;
+  self_removing_callback_data first = {&ros_clock, 0u, RCL_RET_ERROR};
+  self_removing_callback_data second = {&ros_clock, 0u, RCL_RET_ERROR};
+  ASSERT_EQ(RCL_RET_OK,
+    rcl_clock_add_jump_callback(&ros_clock, threshold, self_removing_callback, &first)) <<
+    rcl_get_error_string_safe();
+  ASSERT_EQ(RCL_RET_OK,
+    rcl_clock_add_jump_callback(&ros_clock, threshold, self_removing_callback, &second)) <<
+    rcl_get_error_string_safe();
+
+  // Removing callbacks of the clock from its own callbacks returns instead of waiting for them.
+  EXPECT_EQ(RCL_RET_OK, rcl_set_ros_time_override(&ros_clock, 1)) << rcl_get_error_string_safe();
+  EXPECT_EQ(1u, first.calls);
+  EXPECT_EQ(RCL_RET_OK, first.ret);
+  EXPECT_EQ(1u, second.calls);
+  EXPECT_EQ(RCL_RET_OK, second.ret);
+  EXPECT_EQ(0u, ros_clock.num_jump_callbacks);
+
+  // The removed callbacks are not called anymore, and their nodes are freed by later changes.
+  std::atomic<size_t> calls(0);
+  EXPECT_EQ(RCL_RET_OK, rcl_set_ros_time_override(&ros_clock, 2)) << rcl_get_error_string_safe();
+  EXPECT_EQ(1u, first.calls);
+  EXPECT_EQ(1u, second.calls);
+  ASSERT_EQ(RCL_RET_OK,
+    rcl_clock_add_jump_callback(&ros_clock, threshold, counting_callback, &calls)) <<
+    rcl_get_error_string_safe();
+  EXPECT_EQ(RCL_RET_OK, rcl_set_ros_time_override(&ros_clock, 3)) << rcl_get_error_string_safe();
+  EXPECT_EQ(1u, calls);
+  EXPECT_EQ(RCL_RET_OK, rcl_clock_remove_jump_callback(&ros_clock, counting_callback, &calls));
+}
+
+TEST(CLASSNAME(rcl_time, RMW_IMPLEMENTATION), extrapolated_ros_time) {
+  rcl_allocator_t allocator = rcl_get_default_allocator();
+  rcl_clock_t ros_clock;
+  ASSERT_EQ(RCL_RET_OK, rcl_ros_clock_init(&ros_clock, &allocator)) <<
+    rcl_get_error_string_safe();
+  OSRF_TESTING_TOOLS_CPP_SCOPE_EXIT({
+    EXPECT_EQ(RCL_RET_OK, rcl_clock_fini(&ros_clock));
+  });
+  ASSERT_EQ(RCL_RET_OK, rcl_ros_clock_set_extrapolation(&ros_clock, true)) <<
+    rcl_get_error_string_safe();
+  ASSERT_EQ(RCL_RET_OK, rcl_enable_ros_time_override(&ros_clock)) << rcl_get_error_string_safe();
+
+  rcl_time_jump_t time_jump;
+  rcl_jump_threshold_t threshold;
+  threshold.on_clock_change = false;
+  threshold.min_forward.nanoseconds = 1;
+  threshold.min_backward.nanoseconds = -1;
+  ASSERT_EQ(RCL_RET_OK,
+    rcl_clock_add_jump_callback(&ros_clock, threshold, clock_callback, &time_jump)) <<
+    rcl_get_error_string_safe();
+
+  // A single update gives no rate, so the time is not extrapolated yet.
+  const int64_t update_period = RCL_MS_TO_NS(10);
+  rcl_time_point_value_t set_point = RCL_S_TO_NS(1);
+  ASSERT_EQ(RCL_RET_OK, rcl_set_ros_time_override(&ros_clock, set_point));
+  std::this_thread::sleep_for(std::chrono::nanoseconds(update_period));
+  rcl_time_point_value_t query_now = 0;
+  ASSERT_EQ(RCL_RET_OK, rcl_clock_get_now(&ros_clock, &query_now)) << rcl_get_error_string_safe();
+  EXPECT_EQ(set_point, query_now);
+
+  // The second update gives the rate, and the time moves up to where the next update would be.
+  set_point += update_period;
+  reset_callback_triggers();
+  ASSERT_EQ(RCL_RET_OK, rcl_set_ros_time_override(&ros_clock, set_point));
+  EXPECT_TRUE(post_callback_called);
+  rcl_time_point_value_t last = set_point;
+  auto start = std::chrono::steady_clock::now();
+  while (std::chrono::steady_clock::now() - start < std::chrono::nanoseconds(3 * update_period)) {
+    ASSERT_EQ(RCL_RET_OK, rcl_clock_get_now(&ros_clock, &query_now)) <<
+      rcl_get_error_string_safe();
+    ASSERT_LE(last, query_now);
+    last = query_now;
+  }
+  EXPECT_LT(set_point, query_now);
+  EXPECT_GE(set_point + update_period, query_now);
+  EXPECT_LE(set_point + update_period - 1000, query_now);
+
+  // An update behind the extrapolated time is not a jump, and the time stays put.
+  reset_callback_triggers();
+  ASSERT_EQ(RCL_RET_OK, rcl_set_ros_time_override(&ros_clock, set_point + update_period / 2));
+  EXPECT_FALSE(pre_callback_called);
+  ASSERT_EQ(RCL_RET_OK, rcl_clock_get_now(&ros_clock, &query_now)) << rcl_get_error_string_safe();
+  EXPECT_LE(last, query_now);
+
+  // But the time can be set backward.
+  reset_callback_triggers();
+  ASSERT_EQ(RCL_RET_OK, rcl_set_ros_time_override(&ros_clock, RCL_MS_TO_NS(500)));
+  EXPECT_TRUE(post_callback_called);
+  EXPECT_GT(0, time_jump.delta.nanoseconds);
+  ASSERT_EQ(RCL_RET_OK, rcl_clock_get_now(&ros_clock, &query_now)) << rcl_get_error_string_safe();
+  EXPECT_EQ(RCL_MS_TO_NS(500), query_now);
+
+  EXPECT_EQ(RCL_RET_OK, rcl_clock_remove_jump_callback(&ros_clock, clock_callback, &time_jump));
+}
+
+TEST(CLASSNAME(rcl_time, RMW_IMPLEMENTATION), extrapolated_ros_time_jittered_updates) {
+  rcl_allocator_t allocator = rcl_get_default_allocator();
+  rcl_clock_t ros_clock;
+  ASSERT_EQ(RCL_RET_OK, rcl_ros_clock_init(&ros_clock, &allocator)) <<
+    rcl_get_error_string_safe();
+  OSRF_TESTING_TOOLS_CPP_SCOPE_EXIT({
+    EXPECT_EQ(RCL_RET_OK, rcl_clock_fini(&ros_clock));
+  });
+  ASSERT_EQ(RCL_RET_OK, rcl_ros_clock_set_extrapolation(&ros_clock, true)) <<
+    rcl_get_error_string_safe();
+  ASSERT_EQ(RCL_RET_OK, rcl_enable_ros_time_override(&ros_clock)) << rcl_get_error_string_safe();
+
+  // Both the steps of the time and the steady intervals between the updates vary, so the
+  // extrapolated time often overshoots the next update.
+  const int64_t max_step = RCL_MS_TO_NS(10);
+  std::mt19937 generator(42);
+  std::uniform_int_distribution<int64_t> steps(RCL_MS_TO_NS(1), max_step);
+  rcl_time_point_value_t set_point = RCL_S_TO_NS(1);
+  rcl_time_point_value_t last = set_point;
+  rcl_time_point_value_t query_now = 0;
+  for (size_t i = 0; i < 200; ++i) {
+    set_point += steps(generator);
+    ASSERT_EQ(RCL_RET_OK, rcl_set_ros_time_override(&ros_clock, set_point));
+    auto interval = std::chrono::nanoseconds(steps(generator));
+    auto start = std::chrono::steady_clock::now();
+    do {
+      ASSERT_EQ(RCL_RET_OK, rcl_clock_get_now(&ros_clock, &query_now)) <<
+        rcl_get_error_string_safe();
+      // The time never goes backward, and slews back instead of leading further and further.
+      ASSERT_LE(last, query_now);
+      ASSERT_GE(set_point + max_step + 1000, query_now) << "after " << i << " updates";
+      last = query_now;
+      std::this_thread::sleep_for(std::chrono::microseconds(100));
+    } while (std::chrono::steady_clock::now() - start < interval);
+  }
+}
+
+#ifndef _WIN32
+TEST(CLASSNAME(rcl_time, RMW_IMPLEMENTATION), shared_time) {
+  rcl_allocator_t allocator = rcl_get_default_allocator();
+  std::string path = "/tmp/rcl_test_shared_time_" + std::to_string(getpid());
+  OSRF_TESTING_TOOLS_CPP_SCOPE_EXIT({
+    std::remove(path.c_str());
+  });
+  rcl_shared_time_authority_t authority = rcl_get_zero_initialized_shared_time_authority();
+  ASSERT_EQ(RCL_RET_OK, rcl_shared_time_authority_init(&authority, path.c_str(), allocator)) <<
+    rcl_get_error_string_safe();
+  OSRF_TESTING_TOOLS_CPP_SCOPE_EXIT({
+    EXPECT_EQ(RCL_RET_OK, rcl_shared_time_authority_fini(&authority));
+  });
+  // There is a single authority per file.
+  rcl_shared_time_authority_t other_authority = rcl_get_zero_initialized_shared_time_authority();
+  EXPECT_EQ(
+    RCL_RET_ERROR, rcl_shared_time_authority_init(&other_authority, path.c_str(), allocator));
+  rcl_reset_error();
+
+  rcl_clock_t * ros_clock =
+    reinterpret_cast<rcl_clock_t *>(allocator.allocate(sizeof(rcl_clock_t), allocator.state));
+  OSRF_TESTING_TOOLS_CPP_SCOPE_EXIT({
+    allocator.deallocate(ros_clock, allocator.state);
+  });
+  ASSERT_EQ(RCL_RET_OK, rcl_ros_clock_init(ros_clock, &allocator)) << rcl_get_error_string_safe();
+  OSRF_TESTING_TOOLS_CPP_SCOPE_EXIT({
+    EXPECT_EQ(RCL_RET_OK, rcl_clock_fini(ros_clock));
+  });
+  ASSERT_EQ(RCL_RET_OK, rcl_ros_clock_attach_shared_time(ros_clock, path.c_str())) <<
+    rcl_get_error_string_safe();
+  EXPECT_EQ(RCL_RET_ERROR, rcl_ros_clock_attach_shared_time(ros_clock, path.c_str()));
+  rcl_reset_error();
+
+  rcl_time_point_value_t set_point1 = 1000L * 1000L * 1000L;
+  rcl_time_point_value_t set_point2 = 2L * 1000L * 1000L * 1000L;
+  ASSERT_EQ(RCL_RET_OK, rcl_shared_time_authority_set(&authority, set_point1));
+
+  rcl_time_jump_t time_jump;
+  rcl_jump_threshold_t threshold;
+  threshold.on_clock_change = false;
+  threshold.min_forward.nanoseconds = 1;
+  threshold.min_backward.nanoseconds = -1;
+  ASSERT_EQ(RCL_RET_OK,
+    rcl_clock_add_jump_callback(ros_clock, threshold, clock_callback, &time_jump)) <<
+    rcl_get_error_string_safe();
+  reset_callback_triggers();
+
+  // The time set before the override is enabled is not a jump.
+  ASSERT_EQ(RCL_RET_OK, rcl_enable_ros_time_override(ros_clock)) << rcl_get_error_string_safe();
+  rcl_time_point_value_t query_now = 0;
+  EXPECT_EQ(RCL_RET_OK, rcl_clock_get_now(ros_clock, &query_now)) << rcl_get_error_string_safe();
+  EXPECT_EQ(set_point1, query_now);
+  EXPECT_FALSE(pre_callback_called);
+  EXPECT_FALSE(post_callback_called);
+
+  // The time is only set by the authority.
+  EXPECT_EQ(RCL_RET_ERROR, rcl_set_ros_time_override(ros_clock, set_point2));
+  rcl_reset_error();
+
+  // A forward jump is noticed when the clock is queried.
+  ASSERT_EQ(RCL_RET_OK, rcl_shared_time_authority_set(&authority, set_point2));
+  EXPECT_FALSE(pre_callback_called);
+  EXPECT_EQ(RCL_RET_OK, rcl_clock_get_now(ros_clock, &query_now)) << rcl_get_error_string_safe();
+  EXPECT_EQ(set_point2, query_now);
+  EXPECT_TRUE(pre_callback_called);
+  EXPECT_TRUE(post_callback_called);
+  EXPECT_EQ(set_point2 - set_point1, time_jump.delta.nanoseconds);
+  EXPECT_EQ(RCL_ROS_TIME_NO_CHANGE, time_jump.clock_change);
+  reset_callback_triggers();
+
+  // Querying again is not a jump.
+  EXPECT_EQ(RCL_RET_OK, rcl_clock_get_now(ros_clock, &query_now)) << rcl_get_error_string_safe();
+  EXPECT_EQ(set_point2, query_now);
+  EXPECT_FALSE(pre_callback_called);
+  EXPECT_FALSE(post_callback_called);
+
+  // A backward jump.
+  ASSERT_EQ(RCL_RET_OK, rcl_shared_time_authority_set(&authority, set_point1));
+  EXPECT_EQ(RCL_RET_OK, rcl_clock_get_now(ros_clock, &query_now)) << rcl_get_error_string_safe();
+  EXPECT_EQ(set_point1, query_now);
+  EXPECT_TRUE(pre_callback_called);
+  EXPECT_TRUE(post_callback_called);
+  EXPECT_EQ(set_point1 - set_point2, time_jump.delta.nanoseconds);
+  reset_callback_triggers();
+
+  EXPECT_EQ(RCL_RET_OK, rcl_clock_remove_jump_callback(ros_clock, clock_callback, &time_jump));
+}
+#endif  // _WIN32
+
+#ifndef _WIN32
+TEST(CLASSNAME(rcl_time, RMW_IMPLEMENTATION), steady_time_source_tsc) {
+  // The time stamp counter is used if it is reliable, the system steady clock otherwise.
+  ASSERT_EQ(0, setenv("RCL_STEADY_TIME_SOURCE", "tsc", 1));
+  ASSERT_EQ(RCL_RET_OK, rcl_init(0, nullptr, rcl_get_default_allocator())) <<
+    rcl_get_error_string_safe();
+  OSRF_TESTING_TOOLS_CPP_SCOPE_EXIT({
+    EXPECT_EQ(RCL_RET_OK, rcl_shutdown());
+    unsetenv("RCL_STEADY_TIME_SOURCE");
+  });
+  rcl_steady_time_source_t source = rcl_get_steady_time_source();
+  EXPECT_TRUE(
+    RCL_STEADY_TIME_SOURCE_TSC == source || RCL_STEADY_TIME_SOURCE_SYSTEM == source);
+
+  rcl_allocator_t allocator = rcl_get_default_allocator();
+  rcl_clock_t steady_clock;
+  ASSERT_EQ(RCL_RET_OK, rcl_steady_clock_init(&steady_clock, &allocator)) <<
+    rcl_get_error_string_safe();
+  OSRF_TESTING_TOOLS_CPP_SCOPE_EXIT({
+    EXPECT_EQ(RCL_RET_OK, rcl_clock_fini(&steady_clock));
+  });
+
+  // The steady time never goes backward.
+  rcl_time_point_value_t start = 0;
+  ASSERT_EQ(RCL_RET_OK, rcl_clock_get_now(&steady_clock, &start)) << rcl_get_error_string_safe();
+  rcl_time_point_value_t last = start;
+  for (int i = 0; i < 100000; ++i) {
+    rcl_time_point_value_t now = 0;
+    ASSERT_EQ(RCL_RET_OK, rcl_clock_get_now(&steady_clock, &now)) << rcl_get_error_string_safe();
+    ASSERT_LE(last, now);
+    last = now;
+  }
+
+  // And it moves at the rate of the steady clock of the system, within 1%.
+  auto chrono_start = std::chrono::steady_clock::now();
+  ASSERT_EQ(RCL_RET_OK, rcl_clock_get_now(&steady_clock, &start)) << rcl_get_error_string_safe();
+  std::this_thread::sleep_for(std::chrono::milliseconds(200));
+  rcl_time_point_value_t end = 0;
+  ASSERT_EQ(RCL_RET_OK, rcl_clock_get_now(&steady_clock, &end)) << rcl_get_error_string_safe();
+  int64_t chrono_elapsed = std::chrono::duration_cast<std::chrono::nanoseconds>(
+    std::chrono::steady_clock::now() - chrono_start).count();
+  EXPECT_NEAR(
+    static_cast<double>(chrono_elapsed), static_cast<double>(end - start),
+    static_cast<double>(chrono_elapsed) * 0.01);
+}
+#endif  // _WIN32
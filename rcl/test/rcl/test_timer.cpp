@@ -14,6 +14,11 @@
 
 #include <gtest/gtest.h>
 
+#include <atomic>
+#include <chrono>
+#include <thread>
+#include <vector>
+
 #include "rcl/timer.h"
 
 #include "rcl/rcl.h"
@@ -246,3 +251,446 @@ TEST_F(TestTimerFixture, test_canceled_timer) {
   ret = rcl_clock_fini(&clock);
   EXPECT_EQ(RCL_RET_OK, ret) << rcl_get_error_string_safe();
 }
+
+TEST_F(TestTimerFixture, test_persistent_wait_set_timers) {
+  rcl_ret_t ret;
+
+  rcl_clock_t clock;
+  rcl_allocator_t allocator = rcl_get_default_allocator();
+  ret = rcl_clock_init(RCL_STEADY_TIME, &clock, &allocator);
+  ASSERT_EQ(RCL_RET_OK, ret) << rcl_get_error_string_safe();
+
+  const int64_t periods[] = {RCL_MS_TO_NS(5), RCL_MS_TO_NS(12), RCL_S_TO_NS(10)};
+  rcl_timer_t timers[3];
+  for (size_t i = 0; i < 3; ++i) {
+    timers[i] = rcl_get_zero_initialized_timer();
+    ret = rcl_timer_init(&timers[i], &clock, periods[i], nullptr, rcl_get_default_allocator());
+    ASSERT_EQ(RCL_RET_OK, ret) << rcl_get_error_string_safe();
+  }
+
+  rcl_wait_set_t wait_set = rcl_get_zero_initialized_wait_set();
+  ret = rcl_wait_set_init(&wait_set, 0, 0, 3, 0, 0, rcl_get_default_allocator());
+  EXPECT_EQ(RCL_RET_OK, ret) << rcl_get_error_string_safe();
+  ret = rcl_wait_set_set_persistent(&wait_set, true);
+  EXPECT_EQ(RCL_RET_OK, ret) << rcl_get_error_string_safe();
+  for (size_t i = 0; i < 3; ++i) {
+    ret = rcl_wait_set_add_timer(&wait_set, &timers[i]);
+    EXPECT_EQ(RCL_RET_OK, ret) << rcl_get_error_string_safe();
+  }
+  OSRF_TESTING_TOOLS_CPP_SCOPE_EXIT({
+    for (size_t i = 0; i < 3; ++i) {
+      rcl_ret_t ret = rcl_timer_fini(&timers[i]);
+      EXPECT_EQ(RCL_RET_OK, ret) << rcl_get_error_string_safe();
+    }
+    rcl_ret_t ret = rcl_wait_set_fini(&wait_set);
+    EXPECT_EQ(RCL_RET_OK, ret) << rcl_get_error_string_safe();
+  });
+
+  // Call the timers as they become ready, until the second one was called once.
+  size_t calls[3] = {0, 0, 0};
+  while (0 == calls[1]) {
+    ret = rcl_wait(&wait_set, RCL_S_TO_NS(1));
+    ASSERT_EQ(RCL_RET_OK, ret) << rcl_get_error_string_safe();
+    ASSERT_LT(0u, wait_set.ready.number_of_ready_timers);
+    for (size_t i = 0; i < wait_set.ready.number_of_ready_timers; ++i) {
+      size_t index = wait_set.ready.timer_indices[i];
+      if (i > 0) {
+        EXPECT_LT(wait_set.ready.timer_indices[i - 1], index);
+      }
+      EXPECT_TRUE(wait_set.ready.timers[index]);
+      ret = rcl_timer_call(&timers[index]);
+      ASSERT_EQ(RCL_RET_OK, ret) << rcl_get_error_string_safe();
+      ++calls[index];
+    }
+    for (size_t i = 0; i < 3; ++i) {
+      EXPECT_EQ(&timers[i], wait_set.timers[i]);
+    }
+  }
+  EXPECT_LE(2u, calls[0]);
+  EXPECT_EQ(0u, calls[2]);
+
+  // Rescheduling a timer to an earlier time must be picked up by the wait set.
+  ret = rcl_timer_cancel(&timers[0]);
+  EXPECT_EQ(RCL_RET_OK, ret) << rcl_get_error_string_safe();
+  ret = rcl_timer_cancel(&timers[1]);
+  EXPECT_EQ(RCL_RET_OK, ret) << rcl_get_error_string_safe();
+  int64_t old_period = 0;
+  ret = rcl_timer_exchange_period(&timers[2], RCL_MS_TO_NS(5), &old_period);
+  EXPECT_EQ(RCL_RET_OK, ret) << rcl_get_error_string_safe();
+  ret = rcl_timer_reset(&timers[2]);
+  EXPECT_EQ(RCL_RET_OK, ret) << rcl_get_error_string_safe();
+  int64_t next_call_time = 0;
+  ret = rcl_timer_get_next_call_time(&timers[2], &next_call_time);
+  EXPECT_EQ(RCL_RET_OK, ret) << rcl_get_error_string_safe();
+
+  ret = rcl_wait(&wait_set, RCL_S_TO_NS(1));
+  ASSERT_EQ(RCL_RET_OK, ret) << rcl_get_error_string_safe();
+  rcl_time_point_value_t now = 0;
+  ret = rcl_clock_get_now(&clock, &now);
+  EXPECT_EQ(RCL_RET_OK, ret) << rcl_get_error_string_safe();
+  EXPECT_LE(next_call_time, now);
+  EXPECT_GT(next_call_time + RCL_MS_TO_NS(100), now);
+  ASSERT_EQ(1u, wait_set.ready.number_of_ready_timers);
+  EXPECT_EQ(2u, wait_set.ready.timer_indices[0]);
+  EXPECT_FALSE(wait_set.ready.timers[0]);
+  EXPECT_FALSE(wait_set.ready.timers[1]);
+
+  ret = rcl_clock_fini(&clock);
+  EXPECT_EQ(RCL_RET_OK, ret) << rcl_get_error_string_safe();
+}
+
+TEST_F(TestTimerFixture, test_timer_queries_at_given_time) {
+  rcl_ret_t ret;
+
+  rcl_clock_t clock;
+  rcl_allocator_t allocator = rcl_get_default_allocator();
+  ret = rcl_clock_init(RCL_STEADY_TIME, &clock, &allocator);
+  ASSERT_EQ(RCL_RET_OK, ret) << rcl_get_error_string_safe();
+
+  rcl_timer_t timer = rcl_get_zero_initialized_timer();
+  ret = rcl_timer_init(&timer, &clock, RCL_MS_TO_NS(100), nullptr, rcl_get_default_allocator());
+  ASSERT_EQ(RCL_RET_OK, ret) << rcl_get_error_string_safe();
+  OSRF_TESTING_TOOLS_CPP_SCOPE_EXIT({
+    rcl_ret_t ret = rcl_timer_fini(&timer);
+    EXPECT_EQ(RCL_RET_OK, ret) << rcl_get_error_string_safe();
+    ret = rcl_clock_fini(&clock);
+    EXPECT_EQ(RCL_RET_OK, ret) << rcl_get_error_string_safe();
+  });
+
+  int64_t next_call_time = 0;
+  ret = rcl_timer_get_next_call_time(&timer, &next_call_time);
+  ASSERT_EQ(RCL_RET_OK, ret) << rcl_get_error_string_safe();
+
+  int64_t time_until_next_call = 0;
+  ret = rcl_timer_get_time_until_next_call_at(
+    &timer, next_call_time - RCL_MS_TO_NS(10), &time_until_next_call);
+  EXPECT_EQ(RCL_RET_OK, ret) << rcl_get_error_string_safe();
+  EXPECT_EQ(RCL_MS_TO_NS(10), time_until_next_call);
+
+  bool is_ready = true;
+  ret = rcl_timer_is_ready_at(&timer, next_call_time - 1, &is_ready);
+  EXPECT_EQ(RCL_RET_OK, ret) << rcl_get_error_string_safe();
+  EXPECT_FALSE(is_ready);
+  ret = rcl_timer_is_ready_at(&timer, next_call_time, &is_ready);
+  EXPECT_EQ(RCL_RET_OK, ret) << rcl_get_error_string_safe();
+  EXPECT_TRUE(is_ready);
+
+  ret = rcl_timer_cancel(&timer);
+  EXPECT_EQ(RCL_RET_OK, ret) << rcl_get_error_string_safe();
+  ret = rcl_timer_is_ready_at(&timer, next_call_time, &is_ready);
+  EXPECT_EQ(RCL_RET_OK, ret) << rcl_get_error_string_safe();
+  EXPECT_FALSE(is_ready);
+
+  ret = rcl_timer_is_ready_at(&timer, next_call_time, nullptr);
+  EXPECT_EQ(RCL_RET_INVALID_ARGUMENT, ret);
+  rcl_reset_error();
+}
+
+static std::atomic<int> g_claimed_calls(0);
+
+static void claimed_timer_callback(rcl_timer_t *, int64_t)
+{
+  ++g_claimed_calls;
+}
+
+TEST_F(TestTimerFixture, test_timer_call_if_ready_from_many_threads) {
+  rcl_ret_t ret;
+
+  // A ROS clock with the time overridden, so that the timer is ready exactly when told.
+  rcl_clock_t clock;
+  rcl_allocator_t allocator = rcl_get_default_allocator();
+  ret = rcl_ros_clock_init(&clock, &allocator);
+  ASSERT_EQ(RCL_RET_OK, ret) << rcl_get_error_string_safe();
+  ret = rcl_enable_ros_time_override(&clock);
+  ASSERT_EQ(RCL_RET_OK, ret) << rcl_get_error_string_safe();
+  ret = rcl_set_ros_time_override(&clock, RCL_S_TO_NS(1));
+  ASSERT_EQ(RCL_RET_OK, ret) << rcl_get_error_string_safe();
+
+  rcl_timer_t timer = rcl_get_zero_initialized_timer();
+  ret = rcl_timer_init(
+    &timer, &clock, RCL_S_TO_NS(1), claimed_timer_callback, rcl_get_default_allocator());
+  ASSERT_EQ(RCL_RET_OK, ret) << rcl_get_error_string_safe();
+  OSRF_TESTING_TOOLS_CPP_SCOPE_EXIT({
+    rcl_ret_t ret = rcl_timer_fini(&timer);
+    EXPECT_EQ(RCL_RET_OK, ret) << rcl_get_error_string_safe();
+    ret = rcl_ros_clock_fini(&clock);
+    EXPECT_EQ(RCL_RET_OK, ret) << rcl_get_error_string_safe();
+  });
+
+  bool called = true;
+  ret = rcl_timer_call_if_ready(&timer, &called);
+  EXPECT_EQ(RCL_RET_OK, ret) << rcl_get_error_string_safe();
+  EXPECT_FALSE(called);
+  ret = rcl_timer_call_if_ready(&timer, nullptr);
+  EXPECT_EQ(RCL_RET_INVALID_ARGUMENT, ret);
+  rcl_reset_error();
+
+  const int number_of_threads = 4;
+  const int number_of_periods = 50;
+  g_claimed_calls = 0;
+  std::atomic<int> claims(0);
+  std::atomic<int> failures(0);
+  for (int period = 1; period <= number_of_periods; ++period) {
+    ret = rcl_set_ros_time_override(&clock, RCL_S_TO_NS(1 + period));
+    ASSERT_EQ(RCL_RET_OK, ret) << rcl_get_error_string_safe();
+    // Every thread sees the timer ready, only one of them may claim the period.
+    std::atomic<int> waiting(number_of_threads);
+    std::vector<std::thread> threads;
+    for (int i = 0; i < number_of_threads; ++i) {
+      threads.emplace_back([&timer, &waiting, &claims, &failures]() {
+          --waiting;
+          while (waiting > 0) {
+          }
+          bool called = false;
+          if (rcl_timer_call_if_ready(&timer, &called) != RCL_RET_OK) {
+            ++failures;
+          }
+          if (called) {
+            ++claims;
+          }
+        });
+    }
+    for (auto & thread : threads) {
+      thread.join();
+    }
+    ASSERT_EQ(period, claims);
+  }
+  EXPECT_EQ(0, failures);
+  EXPECT_EQ(number_of_periods, g_claimed_calls);
+
+  ret = rcl_timer_cancel(&timer);
+  EXPECT_EQ(RCL_RET_OK, ret) << rcl_get_error_string_safe();
+  ret = rcl_timer_call_if_ready(&timer, &called);
+  EXPECT_EQ(RCL_RET_TIMER_CANCELED, ret);
+  rcl_reset_error();
+  EXPECT_FALSE(called);
+}
+
+TEST_F(TestTimerFixture, test_timer_statistics) {
+  rcl_ret_t ret;
+
+  rcl_clock_t clock;
+  rcl_allocator_t allocator = rcl_get_default_allocator();
+  ret = rcl_ros_clock_init(&clock, &allocator);
+  ASSERT_EQ(RCL_RET_OK, ret) << rcl_get_error_string_safe();
+  ret = rcl_enable_ros_time_override(&clock);
+  ASSERT_EQ(RCL_RET_OK, ret) << rcl_get_error_string_safe();
+  ret = rcl_set_ros_time_override(&clock, RCL_S_TO_NS(1));
+  ASSERT_EQ(RCL_RET_OK, ret) << rcl_get_error_string_safe();
+
+  // First scheduled at 2s, then every second.
+  rcl_timer_t timer = rcl_get_zero_initialized_timer();
+  ret = rcl_timer_init(&timer, &clock, RCL_S_TO_NS(1), nullptr, rcl_get_default_allocator());
+  ASSERT_EQ(RCL_RET_OK, ret) << rcl_get_error_string_safe();
+  OSRF_TESTING_TOOLS_CPP_SCOPE_EXIT({
+    rcl_ret_t ret = rcl_timer_fini(&timer);
+    EXPECT_EQ(RCL_RET_OK, ret) << rcl_get_error_string_safe();
+    ret = rcl_ros_clock_fini(&clock);
+    EXPECT_EQ(RCL_RET_OK, ret) << rcl_get_error_string_safe();
+  });
+
+  rcl_timer_statistics_t statistics;
+  ret = rcl_timer_get_statistics(&timer, nullptr);
+  EXPECT_EQ(RCL_RET_INVALID_ARGUMENT, ret);
+  rcl_reset_error();
+  ret = rcl_timer_get_statistics(&timer, &statistics);
+  ASSERT_EQ(RCL_RET_OK, ret) << rcl_get_error_string_safe();
+  EXPECT_EQ(0u, statistics.number_of_calls);
+
+  // Half a second late, lands in the last bucket.
+  ret = rcl_set_ros_time_override(&clock, RCL_MS_TO_NS(2500));
+  ASSERT_EQ(RCL_RET_OK, ret) << rcl_get_error_string_safe();
+  ret = rcl_timer_call(&timer);
+  ASSERT_EQ(RCL_RET_OK, ret) << rcl_get_error_string_safe();
+  // Scheduled at 3s, called at 5.2s: the calls at 4s and 5s are skipped.
+  ret = rcl_set_ros_time_override(&clock, RCL_MS_TO_NS(5200));
+  ASSERT_EQ(RCL_RET_OK, ret) << rcl_get_error_string_safe();
+  ret = rcl_timer_call(&timer);
+  ASSERT_EQ(RCL_RET_OK, ret) << rcl_get_error_string_safe();
+  // Scheduled at 6s, 1.5us late.
+  ret = rcl_set_ros_time_override(&clock, RCL_S_TO_NS(6) + 1500);
+  ASSERT_EQ(RCL_RET_OK, ret) << rcl_get_error_string_safe();
+  ret = rcl_timer_call(&timer);
+  ASSERT_EQ(RCL_RET_OK, ret) << rcl_get_error_string_safe();
+
+  ret = rcl_timer_get_statistics(&timer, &statistics);
+  ASSERT_EQ(RCL_RET_OK, ret) << rcl_get_error_string_safe();
+  EXPECT_EQ(3u, statistics.number_of_calls);
+  EXPECT_EQ(2u, statistics.missed_periods);
+  EXPECT_EQ(1500, statistics.last_lateness);
+  EXPECT_EQ(RCL_MS_TO_NS(2200), statistics.max_lateness);
+  EXPECT_EQ(1u, statistics.lateness_histogram[1]);
+  EXPECT_EQ(2u, statistics.lateness_histogram[RCL_TIMER_LATENESS_HISTOGRAM_SIZE - 1]);
+
+  ret = rcl_timer_reset_statistics(&timer);
+  EXPECT_EQ(RCL_RET_OK, ret) << rcl_get_error_string_safe();
+  ret = rcl_timer_get_statistics(&timer, &statistics);
+  ASSERT_EQ(RCL_RET_OK, ret) << rcl_get_error_string_safe();
+  EXPECT_EQ(0u, statistics.number_of_calls);
+  EXPECT_EQ(0u, statistics.missed_periods);
+  EXPECT_EQ(0, statistics.max_lateness);
+  for (size_t i = 0; i < RCL_TIMER_LATENESS_HISTOGRAM_SIZE; ++i) {
+    EXPECT_EQ(0u, statistics.lateness_histogram[i]);
+  }
+}
+
+TEST_F(TestTimerFixture, test_ros_time_timer_woken_up_by_time_jump) {
+  rcl_ret_t ret;
+
+  rcl_clock_t clock;
+  rcl_allocator_t allocator = rcl_get_default_allocator();
+  ret = rcl_ros_clock_init(&clock, &allocator);
+  ASSERT_EQ(RCL_RET_OK, ret) << rcl_get_error_string_safe();
+  ret = rcl_enable_ros_time_override(&clock);
+  ASSERT_EQ(RCL_RET_OK, ret) << rcl_get_error_string_safe();
+  ret = rcl_set_ros_time_override(&clock, RCL_S_TO_NS(1));
+  ASSERT_EQ(RCL_RET_OK, ret) << rcl_get_error_string_safe();
+
+  // First scheduled at 2s of ROS time.
+  rcl_timer_t timer = rcl_get_zero_initialized_timer();
+  ret = rcl_timer_init(&timer, &clock, RCL_S_TO_NS(1), nullptr, rcl_get_default_allocator());
+  ASSERT_EQ(RCL_RET_OK, ret) << rcl_get_error_string_safe();
+  ASSERT_NE(nullptr, rcl_timer_get_guard_condition(&timer));
+  // The guard condition does not need the middleware unless a wait set goes through it.
+  EXPECT_TRUE(rcl_guard_condition_get_options(rcl_timer_get_guard_condition(&timer))->local_only);
+  rcl_wait_set_t wait_set = rcl_get_zero_initialized_wait_set();
+  ret = rcl_wait_set_init(&wait_set, 0, 0, 1, 0, 0, rcl_get_default_allocator());
+  ASSERT_EQ(RCL_RET_OK, ret) << rcl_get_error_string_safe();
+  OSRF_TESTING_TOOLS_CPP_SCOPE_EXIT({
+    rcl_ret_t ret = rcl_wait_set_fini(&wait_set);
+    EXPECT_EQ(RCL_RET_OK, ret) << rcl_get_error_string_safe();
+    ret = rcl_timer_fini(&timer);
+    EXPECT_EQ(RCL_RET_OK, ret) << rcl_get_error_string_safe();
+    ret = rcl_ros_clock_fini(&clock);
+    EXPECT_EQ(RCL_RET_OK, ret) << rcl_get_error_string_safe();
+  });
+
+  // The ROS time stands still, so the timer does not end the wait early.
+  ret = rcl_wait_set_add_timer(&wait_set, &timer);
+  ASSERT_EQ(RCL_RET_OK, ret) << rcl_get_error_string_safe();
+  ret = rcl_wait(&wait_set, RCL_MS_TO_NS(50));
+  EXPECT_EQ(RCL_RET_TIMEOUT, ret) << rcl_get_error_string_safe();
+
+  // Setting the time past the next call from another thread wakes up the wait.
+  ret = rcl_wait_set_clear(&wait_set);
+  ASSERT_EQ(RCL_RET_OK, ret) << rcl_get_error_string_safe();
+  ret = rcl_wait_set_add_timer(&wait_set, &timer);
+  ASSERT_EQ(RCL_RET_OK, ret) << rcl_get_error_string_safe();
+  std::thread setter([&clock]() {
+      std::this_thread::sleep_for(std::chrono::milliseconds(100));
+      rcl_ret_t ret = rcl_set_ros_time_override(&clock, RCL_MS_TO_NS(2500));
+      EXPECT_EQ(RCL_RET_OK, ret) << rcl_get_error_string_safe();
+    });
+  auto start = std::chrono::steady_clock::now();
+  ret = rcl_wait(&wait_set, RCL_S_TO_NS(10));
+  auto waited = std::chrono::steady_clock::now() - start;
+  setter.join();
+  EXPECT_EQ(RCL_RET_OK, ret) << rcl_get_error_string_safe();
+  EXPECT_LT(waited, std::chrono::seconds(5));
+  ASSERT_EQ(1u, wait_set.ready.number_of_ready_timers);
+  EXPECT_EQ(&timer, wait_set.timers[0]);
+  ret = rcl_timer_call(&timer);
+  ASSERT_EQ(RCL_RET_OK, ret) << rcl_get_error_string_safe();
+
+  // Jumping backwards keeps the time left until the next call, at 3s before the jump.
+  ret = rcl_set_ros_time_override(&clock, 0);
+  ASSERT_EQ(RCL_RET_OK, ret) << rcl_get_error_string_safe();
+  int64_t time_until_next_call = 0;
+  ret = rcl_timer_get_time_until_next_call(&timer, &time_until_next_call);
+  EXPECT_EQ(RCL_RET_OK, ret) << rcl_get_error_string_safe();
+  EXPECT_EQ(RCL_MS_TO_NS(500), time_until_next_call);
+
+  // The previous jumps were consumed, so the next one wakes up a wait again.
+  ret = rcl_wait_set_clear(&wait_set);
+  ASSERT_EQ(RCL_RET_OK, ret) << rcl_get_error_string_safe();
+  ret = rcl_wait_set_add_timer(&wait_set, &timer);
+  ASSERT_EQ(RCL_RET_OK, ret) << rcl_get_error_string_safe();
+  std::thread other_setter([&clock]() {
+      std::this_thread::sleep_for(std::chrono::milliseconds(100));
+      rcl_ret_t ret = rcl_set_ros_time_override(&clock, RCL_MS_TO_NS(1000));
+      EXPECT_EQ(RCL_RET_OK, ret) << rcl_get_error_string_safe();
+    });
+  start = std::chrono::steady_clock::now();
+  ret = rcl_wait(&wait_set, RCL_S_TO_NS(10));
+  waited = std::chrono::steady_clock::now() - start;
+  other_setter.join();
+  EXPECT_EQ(RCL_RET_OK, ret) << rcl_get_error_string_safe();
+  EXPECT_LT(waited, std::chrono::seconds(5));
+  EXPECT_EQ(1u, wait_set.ready.number_of_ready_timers);
+}
+
+TEST_F(TestTimerFixture, test_high_precision_timer) {
+  rcl_ret_t ret;
+
+  rcl_clock_t ros_clock;
+  rcl_clock_t steady_clock;
+  rcl_allocator_t allocator = rcl_get_default_allocator();
+  ret = rcl_ros_clock_init(&ros_clock, &allocator);
+  ASSERT_EQ(RCL_RET_OK, ret) << rcl_get_error_string_safe();
+  ret = rcl_steady_clock_init(&steady_clock, &allocator);
+  ASSERT_EQ(RCL_RET_OK, ret) << rcl_get_error_string_safe();
+  OSRF_TESTING_TOOLS_CPP_SCOPE_EXIT({
+    rcl_ret_t ret = rcl_ros_clock_fini(&ros_clock);
+    EXPECT_EQ(RCL_RET_OK, ret) << rcl_get_error_string_safe();
+    ret = rcl_steady_clock_fini(&steady_clock);
+    EXPECT_EQ(RCL_RET_OK, ret) << rcl_get_error_string_safe();
+  });
+
+  rcl_timer_options_t options = rcl_timer_get_default_options();
+  EXPECT_FALSE(options.high_precision);
+  options.high_precision = true;
+  rcl_timer_t timer = rcl_get_zero_initialized_timer();
+  ret = rcl_timer_init_with_options(
+    &timer, &ros_clock, RCL_MS_TO_NS(5), nullptr, allocator, &options);
+  EXPECT_EQ(RCL_RET_INVALID_ARGUMENT, ret);
+  rcl_reset_error();
+  ret = rcl_timer_init_with_options(
+    &timer, &steady_clock, RCL_MS_TO_NS(5), nullptr, allocator, nullptr);
+  EXPECT_EQ(RCL_RET_INVALID_ARGUMENT, ret);
+  rcl_reset_error();
+  ret = rcl_timer_init_with_options(
+    &timer, &steady_clock, RCL_MS_TO_NS(5), nullptr, allocator, &options);
+  ASSERT_EQ(RCL_RET_OK, ret) << rcl_get_error_string_safe();
+  rcl_wait_set_t wait_set = rcl_get_zero_initialized_wait_set();
+  ret = rcl_wait_set_init(&wait_set, 0, 0, 1, 0, 0, rcl_get_default_allocator());
+  ASSERT_EQ(RCL_RET_OK, ret) << rcl_get_error_string_safe();
+  OSRF_TESTING_TOOLS_CPP_SCOPE_EXIT({
+    rcl_ret_t ret = rcl_wait_set_fini(&wait_set);
+    EXPECT_EQ(RCL_RET_OK, ret) << rcl_get_error_string_safe();
+    ret = rcl_timer_fini(&timer);
+    EXPECT_EQ(RCL_RET_OK, ret) << rcl_get_error_string_safe();
+  });
+  ret = rcl_wait_set_set_persistent(&wait_set, true);
+  ASSERT_EQ(RCL_RET_OK, ret) << rcl_get_error_string_safe();
+  ret = rcl_wait_set_add_timer(&wait_set, &timer);
+  ASSERT_EQ(RCL_RET_OK, ret) << rcl_get_error_string_safe();
+
+  // The timer is reported ready once per period, never before its next call time.
+  int number_of_calls = 0;
+  auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(5);
+  while (number_of_calls < 5 && std::chrono::steady_clock::now() < deadline) {
+    int64_t next_call_time = 0;
+    ret = rcl_timer_get_next_call_time(&timer, &next_call_time);
+    ASSERT_EQ(RCL_RET_OK, ret) << rcl_get_error_string_safe();
+    ret = rcl_wait(&wait_set, RCL_S_TO_NS(1));
+    ASSERT_EQ(RCL_RET_OK, ret) << rcl_get_error_string_safe();
+    if (wait_set.ready.number_of_ready_timers == 0) {
+      continue;  // The timerfd may fire marginally early, if its clock is slewed.
+    }
+    rcl_time_point_value_t now = 0;
+    ret = rcl_clock_get_now(&steady_clock, &now);
+    ASSERT_EQ(RCL_RET_OK, ret) << rcl_get_error_string_safe();
+    EXPECT_LE(next_call_time, now);
+    ret = rcl_timer_call(&timer);
+    ASSERT_EQ(RCL_RET_OK, ret) << rcl_get_error_string_safe();
+    ++number_of_calls;
+  }
+  EXPECT_EQ(5, number_of_calls);
+
+  // The timerfd of a canceled timer is disarmed.
+  ret = rcl_timer_cancel(&timer);
+  ASSERT_EQ(RCL_RET_OK, ret) << rcl_get_error_string_safe();
+  ret = rcl_wait(&wait_set, RCL_MS_TO_NS(20));
+  EXPECT_EQ(RCL_RET_TIMEOUT, ret) << rcl_get_error_string_safe();
+  EXPECT_EQ(0u, wait_set.ready.number_of_ready_timers);
+}
@@ -435,3 +435,431 @@ TEST_F(CLASSNAME(WaitSetTestFixture, RMW_IMPLEMENTATION), guard_condition) {
   EXPECT_EQ(RCL_RET_OK, f.get());
   EXPECT_LE(std::abs(diff - trigger_diff.count()), TOLERANCE);
 }
+
+// Check that a persistent wait set keeps its entities and reports readiness separately.
+TEST_F(CLASSNAME(WaitSetTestFixture, RMW_IMPLEMENTATION), persistent_membership) {
+  rcl_wait_set_t wait_set = rcl_get_zero_initialized_wait_set();
+  rcl_ret_t ret = rcl_wait_set_init(&wait_set, 0, 2, 0, 0, 0, rcl_get_default_allocator());
+  ASSERT_EQ(RCL_RET_OK, ret) << rcl_get_error_string_safe();
+  EXPECT_FALSE(rcl_wait_set_is_persistent(&wait_set));
+  ret = rcl_wait_set_set_persistent(&wait_set, true);
+  ASSERT_EQ(RCL_RET_OK, ret) << rcl_get_error_string_safe();
+  EXPECT_TRUE(rcl_wait_set_is_persistent(&wait_set));
+
+  rcl_guard_condition_t guard_cond1 = rcl_get_zero_initialized_guard_condition();
+  ret = rcl_guard_condition_init(&guard_cond1, rcl_guard_condition_get_default_options());
+  ASSERT_EQ(RCL_RET_OK, ret) << rcl_get_error_string_safe();
+  rcl_guard_condition_t guard_cond2 = rcl_get_zero_initialized_guard_condition();
+  ret = rcl_guard_condition_init(&guard_cond2, rcl_guard_condition_get_default_options());
+  ASSERT_EQ(RCL_RET_OK, ret) << rcl_get_error_string_safe();
+
+  OSRF_TESTING_TOOLS_CPP_SCOPE_EXIT({
+    rcl_ret_t ret = rcl_wait_set_fini(&wait_set);
+    EXPECT_EQ(RCL_RET_OK, ret) << rcl_get_error_string_safe();
+    ret = rcl_guard_condition_fini(&guard_cond1);
+    EXPECT_EQ(RCL_RET_OK, ret) << rcl_get_error_string_safe();
+    ret = rcl_guard_condition_fini(&guard_cond2);
+    EXPECT_EQ(RCL_RET_OK, ret) << rcl_get_error_string_safe();
+  });
+
+  ret = rcl_wait_set_add_guard_condition(&wait_set, &guard_cond1);
+  ASSERT_EQ(RCL_RET_OK, ret) << rcl_get_error_string_safe();
+  ret = rcl_wait_set_add_guard_condition(&wait_set, &guard_cond2);
+  ASSERT_EQ(RCL_RET_OK, ret) << rcl_get_error_string_safe();
+
+  // Only the triggered guard condition is ready, but both stay in the wait set.
+  ret = rcl_trigger_guard_condition(&guard_cond2);
+  ASSERT_EQ(RCL_RET_OK, ret) << rcl_get_error_string_safe();
+  ret = rcl_wait(&wait_set, RCL_MS_TO_NS(10));
+  ASSERT_EQ(RCL_RET_OK, ret) << rcl_get_error_string_safe();
+  EXPECT_EQ(&guard_cond1, wait_set.guard_conditions[0]);
+  EXPECT_EQ(&guard_cond2, wait_set.guard_conditions[1]);
+  EXPECT_FALSE(wait_set.ready.guard_conditions[0]);
+  EXPECT_TRUE(wait_set.ready.guard_conditions[1]);
+  ASSERT_EQ(1u, wait_set.ready.number_of_ready_guard_conditions);
+  EXPECT_EQ(1u, wait_set.ready.guard_condition_indices[0]);
+
+  // Waiting again without clearing must work, with the membership unchanged.
+  ret = rcl_trigger_guard_condition(&guard_cond1);
+  ASSERT_EQ(RCL_RET_OK, ret) << rcl_get_error_string_safe();
+  ret = rcl_wait(&wait_set, RCL_MS_TO_NS(10));
+  ASSERT_EQ(RCL_RET_OK, ret) << rcl_get_error_string_safe();
+  EXPECT_EQ(&guard_cond1, wait_set.guard_conditions[0]);
+  EXPECT_EQ(&guard_cond2, wait_set.guard_conditions[1]);
+  EXPECT_TRUE(wait_set.ready.guard_conditions[0]);
+  EXPECT_FALSE(wait_set.ready.guard_conditions[1]);
+  ASSERT_EQ(1u, wait_set.ready.number_of_ready_guard_conditions);
+  EXPECT_EQ(0u, wait_set.ready.guard_condition_indices[0]);
+
+  // Removing the first guard condition moves the last one into its slot.
+  ret = rcl_wait_set_remove_guard_condition(&wait_set, &guard_cond1);
+  ASSERT_EQ(RCL_RET_OK, ret) << rcl_get_error_string_safe();
+  EXPECT_EQ(&guard_cond2, wait_set.guard_conditions[0]);
+  EXPECT_EQ(nullptr, wait_set.guard_conditions[1]);
+  ret = rcl_wait_set_remove_guard_condition(&wait_set, &guard_cond1);
+  EXPECT_EQ(RCL_RET_INVALID_ARGUMENT, ret);
+  rcl_reset_error();
+
+  ret = rcl_trigger_guard_condition(&guard_cond1);
+  ASSERT_EQ(RCL_RET_OK, ret) << rcl_get_error_string_safe();
+  ret = rcl_wait(&wait_set, RCL_MS_TO_NS(10));
+  EXPECT_EQ(RCL_RET_TIMEOUT, ret) << rcl_get_error_string_safe();
+  EXPECT_FALSE(wait_set.ready.guard_conditions[0]);
+  EXPECT_EQ(0u, wait_set.ready.number_of_ready_guard_conditions);
+
+  ret = rcl_trigger_guard_condition(&guard_cond2);
+  ASSERT_EQ(RCL_RET_OK, ret) << rcl_get_error_string_safe();
+  ret = rcl_wait(&wait_set, RCL_MS_TO_NS(10));
+  ASSERT_EQ(RCL_RET_OK, ret) << rcl_get_error_string_safe();
+  EXPECT_EQ(&guard_cond2, wait_set.guard_conditions[0]);
+  EXPECT_TRUE(wait_set.ready.guard_conditions[0]);
+}
+
+// Check that disabled entities of a persistent wait set keep their index and are not waited on.
+TEST_F(CLASSNAME(WaitSetTestFixture, RMW_IMPLEMENTATION), persistent_disable) {
+  rcl_allocator_t allocator = rcl_get_default_allocator();
+  rcl_clock_t clock;
+  rcl_ret_t ret = rcl_clock_init(RCL_STEADY_TIME, &clock, &allocator);
+  ASSERT_EQ(RCL_RET_OK, ret) << rcl_get_error_string_safe();
+  rcl_timer_t timer = rcl_get_zero_initialized_timer();
+  ret = rcl_timer_init(&timer, &clock, RCL_MS_TO_NS(1), nullptr, allocator);
+  ASSERT_EQ(RCL_RET_OK, ret) << rcl_get_error_string_safe();
+  rcl_guard_condition_t guard_cond1 = rcl_get_zero_initialized_guard_condition();
+  ret = rcl_guard_condition_init(&guard_cond1, rcl_guard_condition_get_default_options());
+  ASSERT_EQ(RCL_RET_OK, ret) << rcl_get_error_string_safe();
+  rcl_guard_condition_t guard_cond2 = rcl_get_zero_initialized_guard_condition();
+  ret = rcl_guard_condition_init(&guard_cond2, rcl_guard_condition_get_default_options());
+  ASSERT_EQ(RCL_RET_OK, ret) << rcl_get_error_string_safe();
+  rcl_wait_set_t wait_set = rcl_get_zero_initialized_wait_set();
+  ret = rcl_wait_set_init(&wait_set, 0, 2, 1, 0, 0, allocator);
+  ASSERT_EQ(RCL_RET_OK, ret) << rcl_get_error_string_safe();
+  OSRF_TESTING_TOOLS_CPP_SCOPE_EXIT({
+    EXPECT_EQ(RCL_RET_OK, rcl_wait_set_fini(&wait_set)) << rcl_get_error_string_safe();
+    EXPECT_EQ(RCL_RET_OK, rcl_guard_condition_fini(&guard_cond1)) << rcl_get_error_string_safe();
+    EXPECT_EQ(RCL_RET_OK, rcl_guard_condition_fini(&guard_cond2)) << rcl_get_error_string_safe();
+    EXPECT_EQ(RCL_RET_OK, rcl_timer_fini(&timer)) << rcl_get_error_string_safe();
+    EXPECT_EQ(RCL_RET_OK, rcl_clock_fini(&clock)) << rcl_get_error_string_safe();
+  });
+
+  // Only persistent wait sets can disable entities.
+  ret = rcl_wait_set_add_guard_condition(&wait_set, &guard_cond1);
+  ASSERT_EQ(RCL_RET_OK, ret) << rcl_get_error_string_safe();
+  ret = rcl_wait_set_disable_guard_condition(&wait_set, 0);
+  EXPECT_EQ(RCL_RET_INVALID_ARGUMENT, ret);
+  rcl_reset_error();
+  ret = rcl_wait_set_set_persistent(&wait_set, true);
+  ASSERT_EQ(RCL_RET_OK, ret) << rcl_get_error_string_safe();
+  ret = rcl_wait_set_add_guard_condition(&wait_set, &guard_cond2);
+  ASSERT_EQ(RCL_RET_OK, ret) << rcl_get_error_string_safe();
+  ret = rcl_wait_set_add_timer(&wait_set, &timer);
+  ASSERT_EQ(RCL_RET_OK, ret) << rcl_get_error_string_safe();
+
+  // The disabled entities are neither waited on nor ready, the others keep their index.
+  ret = rcl_wait_set_disable_guard_condition(&wait_set, 0);
+  ASSERT_EQ(RCL_RET_OK, ret) << rcl_get_error_string_safe();
+  ret = rcl_wait_set_disable_guard_condition(&wait_set, 0);
+  EXPECT_EQ(RCL_RET_INVALID_ARGUMENT, ret);
+  rcl_reset_error();
+  ret = rcl_wait_set_disable_timer(&wait_set, 0);
+  ASSERT_EQ(RCL_RET_OK, ret) << rcl_get_error_string_safe();
+  EXPECT_EQ(nullptr, wait_set.guard_conditions[0]);
+  EXPECT_EQ(&guard_cond2, wait_set.guard_conditions[1]);
+  ret = rcl_trigger_guard_condition(&guard_cond1);
+  ASSERT_EQ(RCL_RET_OK, ret) << rcl_get_error_string_safe();
+  ret = rcl_wait(&wait_set, RCL_MS_TO_NS(10));
+  EXPECT_EQ(RCL_RET_TIMEOUT, ret) << rcl_get_error_string_safe();
+  EXPECT_EQ(0u, wait_set.ready.number_of_ready_guard_conditions);
+  EXPECT_EQ(0u, wait_set.ready.number_of_ready_timers);
+  ret = rcl_trigger_guard_condition(&guard_cond2);
+  ASSERT_EQ(RCL_RET_OK, ret) << rcl_get_error_string_safe();
+  ret = rcl_wait(&wait_set, RCL_MS_TO_NS(10));
+  ASSERT_EQ(RCL_RET_OK, ret) << rcl_get_error_string_safe();
+  ASSERT_EQ(1u, wait_set.ready.number_of_ready_guard_conditions);
+  EXPECT_EQ(1u, wait_set.ready.guard_condition_indices[0]);
+
+  // Once enabled again, they are waited on at the same index.
+  ret = rcl_wait_set_enable_guard_condition(&wait_set, &guard_cond1, 0);
+  ASSERT_EQ(RCL_RET_OK, ret) << rcl_get_error_string_safe();
+  ret = rcl_wait_set_enable_timer(&wait_set, &timer, 0);
+  ASSERT_EQ(RCL_RET_OK, ret) << rcl_get_error_string_safe();
+  ret = rcl_wait_set_enable_timer(&wait_set, &timer, 0);
+  EXPECT_EQ(RCL_RET_INVALID_ARGUMENT, ret);
+  rcl_reset_error();
+  ret = rcl_trigger_guard_condition(&guard_cond1);
+  ASSERT_EQ(RCL_RET_OK, ret) << rcl_get_error_string_safe();
+  ret = rcl_wait(&wait_set, RCL_MS_TO_NS(10));
+  ASSERT_EQ(RCL_RET_OK, ret) << rcl_get_error_string_safe();
+  EXPECT_EQ(&guard_cond1, wait_set.guard_conditions[0]);
+  ASSERT_EQ(1u, wait_set.ready.number_of_ready_guard_conditions);
+  EXPECT_EQ(0u, wait_set.ready.guard_condition_indices[0]);
+  ASSERT_EQ(1u, wait_set.ready.number_of_ready_timers);
+  EXPECT_EQ(0u, wait_set.ready.timer_indices[0]);
+}
+
+// Check that rcl_wait fills the compact list of ready entities in a non-persistent wait set.
+TEST_F(CLASSNAME(WaitSetTestFixture, RMW_IMPLEMENTATION), ready_indices) {
+  const size_t number_of_guard_conditions = 4;
+  rcl_wait_set_t wait_set = rcl_get_zero_initialized_wait_set();
+  rcl_ret_t ret = rcl_wait_set_init(
+    &wait_set, 0, number_of_guard_conditions, 0, 0, 0, rcl_get_default_allocator());
+  ASSERT_EQ(RCL_RET_OK, ret) << rcl_get_error_string_safe();
+  std::vector<rcl_guard_condition_t> guard_conds(number_of_guard_conditions);
+  for (auto & guard_cond : guard_conds) {
+    guard_cond = rcl_get_zero_initialized_guard_condition();
+    ret = rcl_guard_condition_init(&guard_cond, rcl_guard_condition_get_default_options());
+    ASSERT_EQ(RCL_RET_OK, ret) << rcl_get_error_string_safe();
+    ret = rcl_wait_set_add_guard_condition(&wait_set, &guard_cond);
+    ASSERT_EQ(RCL_RET_OK, ret) << rcl_get_error_string_safe();
+  }
+
+  OSRF_TESTING_TOOLS_CPP_SCOPE_EXIT({
+    rcl_ret_t ret = rcl_wait_set_fini(&wait_set);
+    EXPECT_EQ(RCL_RET_OK, ret) << rcl_get_error_string_safe();
+    for (auto & guard_cond : guard_conds) {
+      ret = rcl_guard_condition_fini(&guard_cond);
+      EXPECT_EQ(RCL_RET_OK, ret) << rcl_get_error_string_safe();
+    }
+  });
+
+  ret = rcl_trigger_guard_condition(&guard_conds[3]);
+  ASSERT_EQ(RCL_RET_OK, ret) << rcl_get_error_string_safe();
+  ret = rcl_trigger_guard_condition(&guard_conds[1]);
+  ASSERT_EQ(RCL_RET_OK, ret) << rcl_get_error_string_safe();
+  ret = rcl_wait(&wait_set, RCL_MS_TO_NS(10));
+  ASSERT_EQ(RCL_RET_OK, ret) << rcl_get_error_string_safe();
+  ASSERT_EQ(2u, wait_set.ready.number_of_ready_guard_conditions);
+  EXPECT_EQ(1u, wait_set.ready.guard_condition_indices[0]);
+  EXPECT_EQ(3u, wait_set.ready.guard_condition_indices[1]);
+  for (size_t i = 0; i < wait_set.ready.number_of_ready_guard_conditions; ++i) {
+    size_t index = wait_set.ready.guard_condition_indices[i];
+    EXPECT_EQ(&guard_conds[index], wait_set.guard_conditions[index]);
+  }
+  EXPECT_EQ(0u, wait_set.ready.number_of_ready_subscriptions);
+  EXPECT_EQ(0u, wait_set.ready.number_of_ready_timers);
+}
+
+// Check that local guard conditions coalesce triggers and wake up waits with or without rmw.
+TEST_F(CLASSNAME(WaitSetTestFixture, RMW_IMPLEMENTATION), local_guard_condition) {
+  rcl_guard_condition_options_t local_options = rcl_guard_condition_get_default_options();
+  local_options.local_only = true;
+  rcl_guard_condition_t local_guard_cond = rcl_get_zero_initialized_guard_condition();
+  rcl_ret_t ret = rcl_guard_condition_init(&local_guard_cond, local_options);
+  ASSERT_EQ(RCL_RET_OK, ret) << rcl_get_error_string_safe();
+  rcl_guard_condition_t guard_cond = rcl_get_zero_initialized_guard_condition();
+  ret = rcl_guard_condition_init(&guard_cond, rcl_guard_condition_get_default_options());
+  ASSERT_EQ(RCL_RET_OK, ret) << rcl_get_error_string_safe();
+  rcl_wait_set_t wait_set = rcl_get_zero_initialized_wait_set();
+  ret = rcl_wait_set_init(&wait_set, 0, 2, 0, 0, 0, rcl_get_default_allocator());
+  ASSERT_EQ(RCL_RET_OK, ret) << rcl_get_error_string_safe();
+  OSRF_TESTING_TOOLS_CPP_SCOPE_EXIT({
+    rcl_ret_t ret = rcl_wait_set_fini(&wait_set);
+    EXPECT_EQ(RCL_RET_OK, ret) << rcl_get_error_string_safe();
+    ret = rcl_guard_condition_fini(&guard_cond);
+    EXPECT_EQ(RCL_RET_OK, ret) << rcl_get_error_string_safe();
+    ret = rcl_guard_condition_fini(&local_guard_cond);
+    EXPECT_EQ(RCL_RET_OK, ret) << rcl_get_error_string_safe();
+  });
+  ret = rcl_wait_set_set_persistent(&wait_set, true);
+  ASSERT_EQ(RCL_RET_OK, ret) << rcl_get_error_string_safe();
+  ret = rcl_wait_set_add_guard_condition(&wait_set, &local_guard_cond);
+  ASSERT_EQ(RCL_RET_OK, ret) << rcl_get_error_string_safe();
+
+  // Repeated triggers are reported once.
+  ret = rcl_trigger_guard_condition(&local_guard_cond);
+  ASSERT_EQ(RCL_RET_OK, ret) << rcl_get_error_string_safe();
+  ret = rcl_trigger_guard_condition(&local_guard_cond);
+  ASSERT_EQ(RCL_RET_OK, ret) << rcl_get_error_string_safe();
+  ret = rcl_wait(&wait_set, 0);
+  ASSERT_EQ(RCL_RET_OK, ret) << rcl_get_error_string_safe();
+  ASSERT_EQ(1u, wait_set.ready.number_of_ready_guard_conditions);
+  EXPECT_TRUE(wait_set.ready.guard_conditions[0]);
+  ret = rcl_wait(&wait_set, 0);
+  EXPECT_EQ(RCL_RET_TIMEOUT, ret) << rcl_get_error_string_safe();
+  EXPECT_EQ(0u, wait_set.ready.number_of_ready_guard_conditions);
+  rcl_reset_error();
+
+  auto wait_for_trigger = [&wait_set, &local_guard_cond]() {
+      std::promise<rcl_ret_t> p;
+      std::thread trigger_thread(
+        [&p, &local_guard_cond]() {
+          std::this_thread::sleep_for(std::chrono::milliseconds(10));
+          p.set_value(rcl_trigger_guard_condition(&local_guard_cond));
+        });
+      std::chrono::steady_clock::time_point before = std::chrono::steady_clock::now();
+      rcl_ret_t ret = rcl_wait(&wait_set, RCL_S_TO_NS(10));
+      std::chrono::steady_clock::time_point after = std::chrono::steady_clock::now();
+      trigger_thread.join();
+      EXPECT_EQ(RCL_RET_OK, p.get_future().get());
+      EXPECT_EQ(RCL_RET_OK, ret) << rcl_get_error_string_safe();
+      EXPECT_LT(after - before, std::chrono::seconds(5));
+      EXPECT_TRUE(wait_set.ready.guard_conditions[0]);
+    };
+
+  // Only a local guard condition, so the wait does not need rmw.
+  wait_for_trigger();
+
+  // Together with a regular guard condition, the wait goes through rmw.
+  ret = rcl_wait_set_add_guard_condition(&wait_set, &guard_cond);
+  ASSERT_EQ(RCL_RET_OK, ret) << rcl_get_error_string_safe();
+  wait_for_trigger();
+  EXPECT_FALSE(wait_set.ready.guard_conditions[1]);
+  EXPECT_EQ(1u, wait_set.ready.number_of_ready_guard_conditions);
+
+  // A local guard condition cannot reuse an rmw guard condition.
+  rcl_guard_condition_t other_guard_cond = rcl_get_zero_initialized_guard_condition();
+  ret = rcl_guard_condition_init_from_rmw(
+    &other_guard_cond, rcl_guard_condition_get_rmw_handle(&guard_cond), local_options);
+  EXPECT_EQ(RCL_RET_INVALID_ARGUMENT, ret);
+  rcl_reset_error();
+}
+
+// Triggers racing with waits never leave the eventfd readable with nothing to report.
+TEST_F(CLASSNAME(WaitSetTestFixture, RMW_IMPLEMENTATION), concurrent_local_trigger) {
+  rcl_guard_condition_options_t local_options = rcl_guard_condition_get_default_options();
+  local_options.local_only = true;
+  rcl_guard_condition_t local_guard_cond = rcl_get_zero_initialized_guard_condition();
+  rcl_ret_t ret = rcl_guard_condition_init(&local_guard_cond, local_options);
+  ASSERT_EQ(RCL_RET_OK, ret) << rcl_get_error_string_safe();
+  rcl_wait_set_t wait_set = rcl_get_zero_initialized_wait_set();
+  ret = rcl_wait_set_init(&wait_set, 0, 1, 0, 0, 0, rcl_get_default_allocator());
+  ASSERT_EQ(RCL_RET_OK, ret) << rcl_get_error_string_safe();
+  OSRF_TESTING_TOOLS_CPP_SCOPE_EXIT({
+    rcl_ret_t ret = rcl_wait_set_fini(&wait_set);
+    EXPECT_EQ(RCL_RET_OK, ret) << rcl_get_error_string_safe();
+    ret = rcl_guard_condition_fini(&local_guard_cond);
+    EXPECT_EQ(RCL_RET_OK, ret) << rcl_get_error_string_safe();
+  });
+  ret = rcl_wait_set_set_persistent(&wait_set, true);
+  ASSERT_EQ(RCL_RET_OK, ret) << rcl_get_error_string_safe();
+  ret = rcl_wait_set_add_guard_condition(&wait_set, &local_guard_cond);
+  ASSERT_EQ(RCL_RET_OK, ret) << rcl_get_error_string_safe();
+
+  std::atomic<bool> done(false);
+  std::thread trigger_thread([&local_guard_cond, &done]() {
+      for (size_t i = 0; i < 100000; ++i) {
+        rcl_ret_t ret = rcl_trigger_guard_condition(&local_guard_cond);
+        EXPECT_EQ(RCL_RET_OK, ret) << rcl_get_error_string_safe();
+      }
+      done = true;
+    });
+  size_t number_of_triggered_waits = 0;
+  while (!done) {
+    ret = rcl_wait(&wait_set, RCL_MS_TO_NS(100));
+    if (RCL_RET_OK == ret && wait_set.ready.guard_conditions[0]) {
+      ++number_of_triggered_waits;
+    }
+    rcl_reset_error();
+  }
+  trigger_thread.join();
+  EXPECT_GT(number_of_triggered_waits, 0u);
+
+  // The last trigger is still reported, after which waits block until the timeout,
+  // instead of returning at once with nothing ready.
+  ret = rcl_wait(&wait_set, 0);
+  rcl_reset_error();
+  size_t number_of_empty_wake_ups = 0;
+  for (size_t i = 0; i < 3; ++i) {
+    std::chrono::steady_clock::time_point before = std::chrono::steady_clock::now();
+    ret = rcl_wait(&wait_set, RCL_MS_TO_NS(20));
+    std::chrono::steady_clock::time_point after = std::chrono::steady_clock::now();
+    if (RCL_RET_OK == ret) {
+      EXPECT_EQ(0u, wait_set.ready.number_of_ready_guard_conditions);
+      ++number_of_empty_wake_ups;
+    } else {
+      EXPECT_EQ(RCL_RET_TIMEOUT, ret) << rcl_get_error_string_safe();
+      EXPECT_GE(after - before, std::chrono::milliseconds(10));
+    }
+    rcl_reset_error();
+  }
+  EXPECT_LE(number_of_empty_wake_ups, 1u);
+}
+
+// Check that aligned timers and timers with slack share a single wake up.
+TEST_F(CLASSNAME(WaitSetTestFixture, RMW_IMPLEMENTATION), coalesced_timers) {
+  rcl_clock_t clock;
+  rcl_allocator_t allocator = rcl_get_default_allocator();
+  rcl_ret_t ret = rcl_clock_init(RCL_STEADY_TIME, &clock, &allocator);
+  ASSERT_EQ(RCL_RET_OK, ret) << rcl_get_error_string_safe();
+  rcl_timer_t timers[4];
+  for (auto & timer : timers) {
+    timer = rcl_get_zero_initialized_timer();
+  }
+  OSRF_TESTING_TOOLS_CPP_SCOPE_EXIT({
+    for (auto & timer : timers) {
+      EXPECT_EQ(RCL_RET_OK, rcl_timer_fini(&timer)) << rcl_get_error_string_safe();
+    }
+    EXPECT_EQ(RCL_RET_OK, rcl_clock_fini(&clock)) << rcl_get_error_string_safe();
+  });
+
+  // Two timers initialized at different times, aligned to the same grid.
+  ret = rcl_timer_init(&timers[0], &clock, RCL_MS_TO_NS(50), nullptr, allocator);
+  ASSERT_EQ(RCL_RET_OK, ret) << rcl_get_error_string_safe();
+  std::this_thread::sleep_for(std::chrono::milliseconds(5));
+  ret = rcl_timer_init(&timers[1], &clock, RCL_MS_TO_NS(50), nullptr, allocator);
+  ASSERT_EQ(RCL_RET_OK, ret) << rcl_get_error_string_safe();
+  for (size_t i = 0; i < 2; ++i) {
+    ret = rcl_timer_align_phase(&timers[i], 0);
+    ASSERT_EQ(RCL_RET_OK, ret) << rcl_get_error_string_safe();
+  }
+  int64_t next_call_times[2];
+  for (size_t i = 0; i < 2; ++i) {
+    ret = rcl_timer_get_next_call_time(&timers[i], &next_call_times[i]);
+    ASSERT_EQ(RCL_RET_OK, ret) << rcl_get_error_string_safe();
+    EXPECT_EQ(0, next_call_times[i] % RCL_MS_TO_NS(50));
+  }
+  EXPECT_EQ(next_call_times[0], next_call_times[1]);
+
+  rcl_wait_set_t wait_set = rcl_get_zero_initialized_wait_set();
+  ret = rcl_wait_set_init(&wait_set, 0, 0, 2, 0, 0, allocator);
+  ASSERT_EQ(RCL_RET_OK, ret) << rcl_get_error_string_safe();
+  OSRF_TESTING_TOOLS_CPP_SCOPE_EXIT({
+    EXPECT_EQ(RCL_RET_OK, rcl_wait_set_fini(&wait_set)) << rcl_get_error_string_safe();
+  });
+  ret = rcl_wait_set_set_persistent(&wait_set, true);
+  ASSERT_EQ(RCL_RET_OK, ret) << rcl_get_error_string_safe();
+  for (size_t i = 0; i < 2; ++i) {
+    ret = rcl_wait_set_add_timer(&wait_set, &timers[i]);
+    ASSERT_EQ(RCL_RET_OK, ret) << rcl_get_error_string_safe();
+  }
+  ret = rcl_wait(&wait_set, RCL_S_TO_NS(1));
+  ASSERT_EQ(RCL_RET_OK, ret) << rcl_get_error_string_safe();
+  EXPECT_EQ(2u, wait_set.ready.number_of_ready_timers);
+  rcl_wait_set_timer_statistics_t statistics;
+  ret = rcl_wait_set_get_timer_statistics(&wait_set, &statistics);
+  ASSERT_EQ(RCL_RET_OK, ret) << rcl_get_error_string_safe();
+  EXPECT_EQ(1u, statistics.number_of_timer_wake_ups);
+  EXPECT_EQ(1u, statistics.number_of_timer_wake_ups_saved);
+
+  // The first timer may wait for the second one, which is due a little later.
+  ret = rcl_timer_init(&timers[2], &clock, RCL_MS_TO_NS(300), nullptr, allocator);
+  ASSERT_EQ(RCL_RET_OK, ret) << rcl_get_error_string_safe();
+  ret = rcl_timer_set_slack(&timers[2], RCL_MS_TO_NS(200));
+  ASSERT_EQ(RCL_RET_OK, ret) << rcl_get_error_string_safe();
+  ret = rcl_timer_set_slack(&timers[2], -1);
+  EXPECT_EQ(RCL_RET_INVALID_ARGUMENT, ret);
+  rcl_reset_error();
+  std::this_thread::sleep_for(std::chrono::milliseconds(10));
+  ret = rcl_timer_init(&timers[3], &clock, RCL_MS_TO_NS(300), nullptr, allocator);
+  ASSERT_EQ(RCL_RET_OK, ret) << rcl_get_error_string_safe();
+  for (bool persistent : {false, true}) {
+    ret = rcl_wait_set_clear(&wait_set);
+    ASSERT_EQ(RCL_RET_OK, ret) << rcl_get_error_string_safe();
+    ret = rcl_wait_set_set_persistent(&wait_set, persistent);
+    ASSERT_EQ(RCL_RET_OK, ret) << rcl_get_error_string_safe();
+    for (size_t i = 2; i < 4; ++i) {
+      ret = rcl_wait_set_add_timer(&wait_set, &timers[i]);
+      ASSERT_EQ(RCL_RET_OK, ret) << rcl_get_error_string_safe();
+    }
+    ret = rcl_wait(&wait_set, RCL_S_TO_NS(1));
+    ASSERT_EQ(RCL_RET_OK, ret) << rcl_get_error_string_safe();
+    EXPECT_EQ(2u, wait_set.ready.number_of_ready_timers) << "persistent: " << persistent;
+    for (size_t i = 2; i < 4; ++i) {
+      ret = rcl_timer_call(&timers[i]);
+      ASSERT_EQ(RCL_RET_OK, ret) << rcl_get_error_string_safe();
+    }
+  }
+  ret = rcl_wait_set_get_timer_statistics(&wait_set, &statistics);
+  ASSERT_EQ(RCL_RET_OK, ret) << rcl_get_error_string_safe();
+  EXPECT_EQ(3u, statistics.number_of_timer_wake_ups);
+  EXPECT_EQ(3u, statistics.number_of_timer_wake_ups_saved);
+}
@@ -0,0 +1,251 @@
+// Copyright 2018 Open Source Robotics Foundation, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <chrono>
+#include <thread>
+#include <vector>
+
+#include "rcl/work_stealing_executor.h"
+
+#include "rcl/rcl.h"
+
+#include "osrf_testing_tools_cpp/scope_exit.hpp"
+#include "rcl/error_handling.h"
+
+#ifdef RMW_IMPLEMENTATION
+# define CLASSNAME_(NAME, SUFFIX) NAME ## __ ## SUFFIX
+# define CLASSNAME(NAME, SUFFIX) CLASSNAME_(NAME, SUFFIX)
+#else
+# define CLASSNAME(NAME, SUFFIX) NAME
+#endif
+
+class CLASSNAME (TestWorkStealingExecutorFixture, RMW_IMPLEMENTATION) : public ::testing::Test
+{
+public:
+  void SetUp()
+  {
+    rcl_ret_t ret;
+    ret = rcl_init(0, nullptr, rcl_get_default_allocator());
+    ASSERT_EQ(RCL_RET_OK, ret) << rcl_get_error_string_safe();
+  }
+
+  void TearDown()
+  {
+    rcl_ret_t ret = rcl_shutdown();
+    EXPECT_EQ(RCL_RET_OK, ret) << rcl_get_error_string_safe();
+  }
+};
+
+// Tracks the calls of one entity, and whether two workers ever handled it at once.
+struct CallRecord
+{
+  std::atomic<int> in_flight{0};
+  std::atomic<int> calls{0};
+  std::atomic<bool> overlapped{false};
+};
+
+static void record_call(CallRecord * record)
+{
+  if (record->in_flight.fetch_add(1) != 0) {
+    record->overlapped = true;
+  }
+  // Long enough for the other workers to try their luck with the same entity.
+  std::this_thread::sleep_for(std::chrono::microseconds(50));
+  record->in_flight.fetch_sub(1);
+  record->calls.fetch_add(1);
+}
+
+static void guard_condition_callback(void * context)
+{
+  record_call(static_cast<CallRecord *>(context));
+}
+
+static const size_t kNumberOfTimers = 4;
+static rcl_timer_t g_timers[kNumberOfTimers];
+static CallRecord g_timer_records[kNumberOfTimers];
+
+static void timer_callback(rcl_timer_t * timer, int64_t)
+{
+  record_call(&g_timer_records[timer - g_timers]);
+}
+
+/* Test the argument checks and the capacity of a work stealing executor.
+ */
+TEST_F(
+  CLASSNAME(TestWorkStealingExecutorFixture, RMW_IMPLEMENTATION),
+  test_work_stealing_executor_init_fini)
+{
+  rcl_work_stealing_executor_t executor = rcl_get_zero_initialized_work_stealing_executor();
+  rcl_ret_t ret = rcl_work_stealing_executor_spin_some(&executor, 0, 0);
+  EXPECT_EQ(RCL_RET_EXECUTOR_INVALID, ret);
+  rcl_reset_error();
+  ret = rcl_work_stealing_executor_init(&executor, 0, 0, 3, 0, 0, 0, rcl_get_default_allocator());
+  EXPECT_EQ(RCL_RET_INVALID_ARGUMENT, ret);
+  rcl_reset_error();
+  ret = rcl_work_stealing_executor_init(&executor, 2, 0, 3, 0, 0, 0, rcl_get_default_allocator());
+  ASSERT_EQ(RCL_RET_OK, ret) << rcl_get_error_string_safe();
+  ret = rcl_work_stealing_executor_init(&executor, 2, 0, 3, 0, 0, 0, rcl_get_default_allocator());
+  EXPECT_EQ(RCL_RET_ALREADY_INIT, ret);
+  rcl_reset_error();
+
+  rcl_guard_condition_t guard_conditions[4];
+  for (auto & guard_condition : guard_conditions) {
+    guard_condition = rcl_get_zero_initialized_guard_condition();
+    ret = rcl_guard_condition_init(&guard_condition, rcl_guard_condition_get_default_options());
+    ASSERT_EQ(RCL_RET_OK, ret) << rcl_get_error_string_safe();
+  }
+  OSRF_TESTING_TOOLS_CPP_SCOPE_EXIT({
+    for (auto & guard_condition : guard_conditions) {
+      EXPECT_EQ(RCL_RET_OK, rcl_guard_condition_fini(&guard_condition));
+    }
+  });
+  for (size_t i = 0; i < 3; ++i) {
+    ret = rcl_work_stealing_executor_add_guard_condition(
+      &executor, &guard_conditions[i], nullptr, nullptr);
+    EXPECT_EQ(RCL_RET_OK, ret) << rcl_get_error_string_safe();
+  }
+  ret = rcl_work_stealing_executor_add_guard_condition(
+    &executor, &guard_conditions[3], nullptr, nullptr);
+  EXPECT_EQ(RCL_RET_WAIT_SET_FULL, ret);
+  rcl_reset_error();
+
+  ret = rcl_work_stealing_executor_spin_some(&executor, 2, 0);
+  EXPECT_EQ(RCL_RET_INVALID_ARGUMENT, ret);
+  rcl_reset_error();
+  ret = rcl_work_stealing_executor_spin_some(&executor, 0, 0);
+  EXPECT_EQ(RCL_RET_TIMEOUT, ret);
+  // Entities are dealt round-robin, so the second guard condition is waited on by worker 1.
+  ret = rcl_trigger_guard_condition(&guard_conditions[1]);
+  ASSERT_EQ(RCL_RET_OK, ret) << rcl_get_error_string_safe();
+  ret = rcl_work_stealing_executor_spin_some(&executor, 1, RCL_S_TO_NS(1));
+  EXPECT_EQ(RCL_RET_OK, ret) << rcl_get_error_string_safe();
+
+  ret = rcl_work_stealing_executor_fini(&executor);
+  EXPECT_EQ(RCL_RET_OK, ret) << rcl_get_error_string_safe();
+  ret = rcl_work_stealing_executor_fini(&executor);
+  EXPECT_EQ(RCL_RET_OK, ret) << rcl_get_error_string_safe();
+}
+
+/* Test that with several workers every trigger is handled once, and never concurrently.
+ */
+TEST_F(
+  CLASSNAME(TestWorkStealingExecutorFixture, RMW_IMPLEMENTATION),
+  test_work_stealing_executor_no_double_handling)
+{
+  const size_t number_of_workers = 3;
+  const size_t number_of_guard_conditions = 8;
+  const int number_of_rounds = 20;
+  rcl_ret_t ret;
+  rcl_clock_t clock;
+  rcl_allocator_t allocator = rcl_get_default_allocator();
+  ret = rcl_clock_init(RCL_STEADY_TIME, &clock, &allocator);
+  ASSERT_EQ(RCL_RET_OK, ret) << rcl_get_error_string_safe();
+  OSRF_TESTING_TOOLS_CPP_SCOPE_EXIT({
+    EXPECT_EQ(RCL_RET_OK, rcl_clock_fini(&clock));
+  });
+  for (auto & timer : g_timers) {
+    timer = rcl_get_zero_initialized_timer();
+    // A period of zero keeps the timers ready, so they are always up for grabs.
+    ret = rcl_timer_init(&timer, &clock, 0, timer_callback, allocator);
+    ASSERT_EQ(RCL_RET_OK, ret) << rcl_get_error_string_safe();
+  }
+  OSRF_TESTING_TOOLS_CPP_SCOPE_EXIT({
+    for (auto & timer : g_timers) {
+      EXPECT_EQ(RCL_RET_OK, rcl_timer_fini(&timer));
+    }
+  });
+  std::vector<rcl_guard_condition_t> guard_conditions(
+    number_of_guard_conditions, rcl_get_zero_initialized_guard_condition());
+  for (auto & guard_condition : guard_conditions) {
+    ret = rcl_guard_condition_init(&guard_condition, rcl_guard_condition_get_default_options());
+    ASSERT_EQ(RCL_RET_OK, ret) << rcl_get_error_string_safe();
+  }
+  OSRF_TESTING_TOOLS_CPP_SCOPE_EXIT({
+    for (auto & guard_condition : guard_conditions) {
+      EXPECT_EQ(RCL_RET_OK, rcl_guard_condition_fini(&guard_condition));
+    }
+  });
+  std::vector<CallRecord> guard_condition_records(number_of_guard_conditions);
+
+  rcl_work_stealing_executor_t executor = rcl_get_zero_initialized_work_stealing_executor();
+  ret = rcl_work_stealing_executor_init(
+    &executor, number_of_workers, 0, number_of_guard_conditions, kNumberOfTimers, 0, 0,
+    rcl_get_default_allocator());
+  ASSERT_EQ(RCL_RET_OK, ret) << rcl_get_error_string_safe();
+  OSRF_TESTING_TOOLS_CPP_SCOPE_EXIT({
+    EXPECT_EQ(RCL_RET_OK, rcl_work_stealing_executor_fini(&executor));
+  });
+  for (size_t i = 0; i < number_of_guard_conditions; ++i) {
+    ret = rcl_work_stealing_executor_add_guard_condition(
+      &executor, &guard_conditions[i], guard_condition_callback, &guard_condition_records[i]);
+    ASSERT_EQ(RCL_RET_OK, ret) << rcl_get_error_string_safe();
+  }
+  for (auto & timer : g_timers) {
+    ret = rcl_work_stealing_executor_add_timer(&executor, &timer);
+    ASSERT_EQ(RCL_RET_OK, ret) << rcl_get_error_string_safe();
+  }
+
+  std::atomic<bool> done(false);
+  std::atomic<int> failures(0);
+  std::vector<std::thread> workers;
+  for (size_t i = 0; i < number_of_workers; ++i) {
+    workers.emplace_back([&executor, &done, &failures, i]() {
+        while (!done) {
+          rcl_ret_t ret = rcl_work_stealing_executor_spin_some(&executor, i, RCL_MS_TO_NS(10));
+          if (ret != RCL_RET_OK && ret != RCL_RET_TIMEOUT) {
+            ++failures;
+          }
+        }
+      });
+  }
+  OSRF_TESTING_TOOLS_CPP_SCOPE_EXIT({
+    done = true;
+    for (auto & worker : workers) {
+      worker.join();
+    }
+  });
+
+  // Trigger every guard condition once per round, and wait for all of them to be handled.
+  for (int round = 1; round <= number_of_rounds; ++round) {
+    for (auto & guard_condition : guard_conditions) {
+      ret = rcl_trigger_guard_condition(&guard_condition);
+      ASSERT_EQ(RCL_RET_OK, ret) << rcl_get_error_string_safe();
+    }
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(5);
+    for (auto & record : guard_condition_records) {
+      while (record.calls < round && std::chrono::steady_clock::now() < deadline) {
+        std::this_thread::sleep_for(std::chrono::microseconds(100));
+      }
+      ASSERT_EQ(round, record.calls);
+    }
+  }
+  done = true;
+  for (auto & worker : workers) {
+    worker.join();
+  }
+  workers.clear();
+
+  EXPECT_EQ(0, failures);
+  for (auto & record : guard_condition_records) {
+    EXPECT_EQ(number_of_rounds, record.calls);
+    EXPECT_FALSE(record.overlapped);
+  }
+  for (auto & record : g_timer_records) {
+    EXPECT_LT(0, record.calls);
+    EXPECT_FALSE(record.overlapped);
+  }
+}